@@ -0,0 +1,91 @@
+#include "display_list.h"
+
+#include <pbkit/pbkit.h>
+
+#include <cstring>
+
+#include "debug_output.h"
+#include "pushbuffer_trace.h"
+
+void DisplayList::Clear() {
+  commands_.clear();
+  segment_ends_.clear();
+}
+
+bool DisplayList::Assign(const uint32_t *start, const uint32_t *end) {
+  Clear();
+  if (end <= start) {
+    return end == start;
+  }
+
+  const uint32_t size = end - start;
+  uint32_t segment_start = 0;
+  uint32_t offset = 0;
+  while (offset < size) {
+    const uint32_t header = start[offset];
+    if (TraceCommandIsControlFlow(header)) {
+      PrintMsg("Display list may not contain jumps (0x%08X).\n", header);
+      segment_ends_.clear();
+      return false;
+    }
+
+    const uint32_t packet_size = 1 + TraceCommandCount(header);
+    if (offset > segment_start && offset + packet_size - segment_start > kMaxSegmentDWORDs) {
+      segment_ends_.push_back(offset);
+      segment_start = offset;
+    }
+    offset += packet_size;
+  }
+
+  if (offset != size) {
+    PrintMsg("Display list ends in the middle of a packet.\n");
+    segment_ends_.clear();
+    return false;
+  }
+
+  segment_ends_.push_back(size);
+  commands_.assign(start, end);
+  return true;
+}
+
+DisplayList::PatchPoint DisplayList::FindPatchPoint(uint32_t method, uint32_t occurrence, uint32_t subchannel) const {
+  const uint32_t size = commands_.size();
+  uint32_t offset = 0;
+  while (offset < size) {
+    const uint32_t header = commands_[offset++];
+    const uint32_t count = TraceCommandCount(header);
+    if (TraceCommandSubchannel(header) != subchannel) {
+      offset += count;
+      continue;
+    }
+
+    uint32_t packet_method = TraceCommandMethod(header);
+    const uint32_t increment = TraceCommandIsNonIncreasing(header) ? 0 : 4;
+    for (uint32_t i = 0; i < count; ++i, packet_method += increment) {
+      if (packet_method == method && !occurrence--) {
+        return offset + i;
+      }
+    }
+    offset += count;
+  }
+
+  return kInvalidPatchPoint;
+}
+
+void DisplayList::Patch(PatchPoint point, uint32_t value) {
+  ASSERT(point < commands_.size() && "Invalid display list patch point.");
+  commands_[point] = value;
+}
+
+void DisplayList::Patchf(PatchPoint point, float value) { Patch(point, *reinterpret_cast<uint32_t *>(&value)); }
+
+void DisplayList::Replay() const {
+  uint32_t segment_start = 0;
+  for (auto segment_end : segment_ends_) {
+    const uint32_t num_dwords = segment_end - segment_start;
+    auto p = pb_begin();
+    memcpy(p, commands_.data() + segment_start, num_dwords * sizeof(uint32_t));
+    pb_end(p + num_dwords);
+    segment_start = segment_end;
+  }
+}
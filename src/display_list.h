@@ -0,0 +1,51 @@
+#ifndef NXDK_PGRAPH_TESTS_DISPLAY_LIST_H
+#define NXDK_PGRAPH_TESTS_DISPLAY_LIST_H
+
+#include <cstdint>
+#include <vector>
+
+#include "pushbuffer_writer.h"
+
+// A span of push buffer commands that is recorded once and replayed by copying it directly into the push buffer.
+//
+// Display lists are recorded via TestHost::BeginDisplayList/EndDisplayList and replayed via
+// TestHost::CallDisplayList. Individual parameters may be modified between replays via patch points, allowing a
+// single recording to be reused for state that differs only in a handful of values (e.g., a fog mode or color).
+class DisplayList {
+ public:
+  // Index of a parameter DWORD within the recorded commands.
+  typedef uint32_t PatchPoint;
+  static constexpr PatchPoint kInvalidPatchPoint = 0xFFFFFFFF;
+
+ public:
+  bool IsRecorded() const { return !commands_.empty(); }
+  void Clear();
+
+  // Copies the complete packets in [start, end) into this list. Returns false if the span contains jumps or calls or
+  // ends in the middle of a packet.
+  bool Assign(const uint32_t *start, const uint32_t *end);
+
+  // Returns the patch point of the `occurrence`th parameter written to `method` on `subchannel`, or kInvalidPatchPoint
+  // if there is no such parameter.
+  PatchPoint FindPatchPoint(uint32_t method, uint32_t occurrence = 0, uint32_t subchannel = 0) const;
+
+  // Replaces the value of a parameter in the recorded commands.
+  void Patch(PatchPoint point, uint32_t value);
+  void Patchf(PatchPoint point, float value);
+
+  // Copies the recorded commands into the push buffer.
+  void Replay() const;
+
+  const uint32_t *GetCommands() const { return commands_.data(); }
+  uint32_t GetSize() const { return commands_.size(); }
+
+ private:
+  // Replay is split at packet boundaries so that a single pb_begin/pb_end span never exceeds this many DWORDs.
+  static constexpr uint32_t kMaxSegmentDWORDs = PushBufferWriter::kMaxSpanDWORDs;
+
+  std::vector<uint32_t> commands_;
+  // Offset one past the last DWORD of each replay segment.
+  std::vector<uint32_t> segment_ends_;
+};
+
+#endif  // NXDK_PGRAPH_TESTS_DISPLAY_LIST_H
@@ -0,0 +1,103 @@
+#include "gpu_wait.h"
+
+#include <pbkit/pbkit.h>
+#include <xboxkrnl/xboxkrnl.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "debug_output.h"
+
+// PFIFO register holding the address of the next push buffer DWORD to be fetched by the GPU.
+static constexpr uint32_t kDMAGetRegister = 0xFD003244;
+// Mask applied to push buffer pointers to produce the addresses seen by the GPU.
+static constexpr uint32_t kPushBufferAddressMask = 0x03FFFFFF;
+
+std::vector<GPUWait::Record> GPUWait::records_;
+
+static uint32_t CurrentPushBufferAddress() {
+  // An empty span gives the current write position without emitting any commands.
+  auto p = pb_begin();
+  pb_end(p);
+  return reinterpret_cast<uint32_t>(p) & kPushBufferAddressMask;
+}
+
+void GPUWait::WaitForIdle(const char *file, uint32_t line) {
+  const uint64_t start = KeQueryPerformanceCounter();
+  while (pb_busy()) {
+    /* Wait for completion... */
+  }
+  AddRecord(file, line, WAIT_IDLE, KeQueryPerformanceCounter() - start);
+}
+
+void GPUWait::WaitForFlip(const char *file, uint32_t line) {
+  const uint64_t start = KeQueryPerformanceCounter();
+  while (pb_finished()) {
+    /* Not ready to swap yet */
+  }
+  AddRecord(file, line, WAIT_FLIP, KeQueryPerformanceCounter() - start);
+}
+
+GPUWait::Fence GPUWait::InsertFence() { return CurrentPushBufferAddress(); }
+
+bool GPUWait::IsFenceComplete(Fence fence) {
+  if (!pb_busy()) {
+    return true;
+  }
+
+  const uint32_t get = *reinterpret_cast<volatile uint32_t *>(kDMAGetRegister) & kPushBufferAddressMask;
+  const uint32_t put = CurrentPushBufferAddress();
+
+  // The GPU is somewhere between the fence and the write position once it has passed the fence, taking into account
+  // that the push buffer may have wrapped after the fence was inserted.
+  if (fence <= put) {
+    return get >= fence && get <= put;
+  }
+  return get >= fence || get <= put;
+}
+
+void GPUWait::WaitForFence(Fence fence, const char *file, uint32_t line) {
+  const uint64_t start = KeQueryPerformanceCounter();
+  while (!IsFenceComplete(fence)) {
+    /* Wait for the GPU to pass the fence... */
+  }
+  AddRecord(file, line, WAIT_FENCE, KeQueryPerformanceCounter() - start);
+}
+
+void GPUWait::PrintReport(const std::string &test_name) {
+  if (records_.empty()) {
+    return;
+  }
+
+  static constexpr const char *kTypeNames[] = {"idle", "flip", "fence"};
+  const uint64_t ticks_per_microsecond = std::max<uint64_t>(KeQueryPerformanceFrequency() / 1000000, 1);
+
+  uint64_t total_ticks = 0;
+  for (auto &record : records_) {
+    total_ticks += record.total_ticks;
+  }
+  PrintMsg("GPU waits for %s: %u us\n", test_name.c_str(), static_cast<uint32_t>(total_ticks / ticks_per_microsecond));
+
+  for (auto &record : records_) {
+    const char *filename = strrchr(record.file, '/');
+    filename = filename ? filename + 1 : record.file;
+    PrintMsg("  %s:%u %s x%u: %u us (max %u us)\n", filename, record.line, kTypeNames[record.type], record.count,
+             static_cast<uint32_t>(record.total_ticks / ticks_per_microsecond),
+             static_cast<uint32_t>(record.max_ticks / ticks_per_microsecond));
+  }
+
+  records_.clear();
+}
+
+void GPUWait::AddRecord(const char *file, uint32_t line, WaitType type, uint64_t ticks) {
+  for (auto &record : records_) {
+    if (record.line == line && record.type == type && !strcmp(record.file, file)) {
+      ++record.count;
+      record.total_ticks += ticks;
+      record.max_ticks = std::max(record.max_ticks, ticks);
+      return;
+    }
+  }
+
+  records_.push_back({file, line, type, 1, ticks, ticks});
+}
@@ -0,0 +1,63 @@
+#ifndef NXDK_PGRAPH_TESTS_GPU_WAIT_H
+#define NXDK_PGRAPH_TESTS_GPU_WAIT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Blocks until the GPU has finished processing every command in the push buffer.
+#define WAIT_FOR_GPU_IDLE() GPUWait::WaitForIdle(__FILE__, __LINE__)
+// Blocks until pbkit has queued a swap of the back buffer.
+#define WAIT_FOR_FLIP() GPUWait::WaitForFlip(__FILE__, __LINE__)
+// Blocks until the GPU has passed the given fence (see GPUWait::InsertFence).
+#define WAIT_FOR_FENCE(fence) GPUWait::WaitForFence(fence, __FILE__, __LINE__)
+
+// Instrumented replacements for spinning on pb_busy() and pb_finished().
+//
+// Every wait records the time spent blocked against the call site that issued it. The records accumulate until
+// PrintReport() is called, which TestHost::FinishDraw does for each test.
+class GPUWait {
+ public:
+  // Position in the push buffer that the GPU can be waited on to pass.
+  typedef uint32_t Fence;
+
+  enum WaitType {
+    WAIT_IDLE,
+    WAIT_FLIP,
+    WAIT_FENCE,
+  };
+
+  struct Record {
+    const char *file;
+    uint32_t line;
+    WaitType type;
+    uint32_t count;
+    uint64_t total_ticks;
+    uint64_t max_ticks;
+  };
+
+ public:
+  static void WaitForIdle(const char *file, uint32_t line);
+  static void WaitForFlip(const char *file, uint32_t line);
+
+  // Returns a fence at the current end of the push buffer. Waiting on it only blocks until the GPU has fetched the
+  // commands pushed before it, so the CPU may continue while PGRAPH is still executing them. Use WAIT_FOR_GPU_IDLE
+  // instead before reading or modifying memory that earlier commands may still access.
+  static Fence InsertFence();
+  static bool IsFenceComplete(Fence fence);
+  static void WaitForFence(Fence fence, const char *file, uint32_t line);
+
+  static const std::vector<Record> &GetRecords() { return records_; }
+
+  // Prints the waits recorded since the last report and discards them.
+  static void PrintReport(const std::string &test_name);
+  static void ResetReport() { records_.clear(); }
+
+ private:
+  static void AddRecord(const char *file, uint32_t line, WaitType type, uint64_t ticks);
+
+ private:
+  static std::vector<Record> records_;
+};
+
+#endif  // NXDK_PGRAPH_TESTS_GPU_WAIT_H
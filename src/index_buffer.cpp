@@ -0,0 +1,53 @@
+#include "index_buffer.h"
+
+#include <algorithm>
+
+IndexBuffer::IndexBuffer(const std::vector<uint32_t> &indices, Format format) { SetIndices(indices, format); }
+
+IndexBuffer::IndexBuffer(const uint32_t *indices, uint32_t num_indices, Format format) {
+  SetIndices(indices, num_indices, format);
+}
+
+void IndexBuffer::SetIndices(const std::vector<uint32_t> &indices, Format format) {
+  SetIndices(indices.data(), indices.size(), format);
+}
+
+void IndexBuffer::SetIndices(const uint32_t *indices, uint32_t num_indices, Format format) {
+  Clear();
+  if (!num_indices) {
+    return;
+  }
+
+  num_indices_ = num_indices;
+  max_index_ = *std::max_element(indices, indices + num_indices);
+
+  if (format == FORMAT_AUTO) {
+    format = max_index_ > 0xFFFF ? FORMAT_32 : FORMAT_16;
+  }
+  is_16_bit_ = format == FORMAT_16;
+
+  if (!is_16_bit_) {
+    packed_indices_.assign(indices, indices + num_indices);
+    return;
+  }
+
+  packed_indices_.reserve(num_indices / 2);
+  const uint32_t *end = indices + (num_indices & ~1);
+  for (const uint32_t *index = indices; index != end; index += 2) {
+    packed_indices_.push_back((index[0] & 0xFFFF) | (index[1] << 16));
+  }
+
+  if (num_indices & 1) {
+    has_trailing_index_ = true;
+    trailing_index_ = indices[num_indices - 1];
+  }
+}
+
+void IndexBuffer::Clear() {
+  packed_indices_.clear();
+  num_indices_ = 0;
+  max_index_ = 0;
+  is_16_bit_ = true;
+  has_trailing_index_ = false;
+  trailing_index_ = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef NXDK_PGRAPH_TESTS_INDEX_BUFFER_H
+#define NXDK_PGRAPH_TESTS_INDEX_BUFFER_H
+
+#include <cstdint>
+#include <vector>
+
+// Vertex indices stored in the form consumed by NV097_ARRAY_ELEMENT16 and NV097_ARRAY_ELEMENT32, allowing them to be
+// copied into the push buffer without any per-index work at draw time.
+//
+// Indices are packed two per DWORD (first index in the low 16 bits) when every index fits in 16 bits and are stored
+// as full DWORDs otherwise. An odd trailing index in a 16-bit buffer is kept separately as it must be sent via
+// NV097_ARRAY_ELEMENT32.
+class IndexBuffer {
+ public:
+  enum Format {
+    // Chooses FORMAT_16 if the largest index is <= 0xFFFF and FORMAT_32 otherwise.
+    FORMAT_AUTO,
+    // Sends index pairs via NV097_ARRAY_ELEMENT16. Indices are truncated to 16 bits.
+    FORMAT_16,
+    // Sends each index via NV097_ARRAY_ELEMENT32.
+    FORMAT_32,
+  };
+
+ public:
+  IndexBuffer() = default;
+  explicit IndexBuffer(const std::vector<uint32_t> &indices, Format format = FORMAT_AUTO);
+  IndexBuffer(const uint32_t *indices, uint32_t num_indices, Format format = FORMAT_AUTO);
+
+  void SetIndices(const std::vector<uint32_t> &indices, Format format = FORMAT_AUTO);
+  void SetIndices(const uint32_t *indices, uint32_t num_indices, Format format = FORMAT_AUTO);
+  void Clear();
+
+  bool Is16Bit() const { return is_16_bit_; }
+  uint32_t GetNumIndices() const { return num_indices_; }
+  uint32_t GetMaxIndex() const { return max_index_; }
+
+  // Returns the parameters for the NV097_ARRAY_ELEMENT16 or NV097_ARRAY_ELEMENT32 method, excluding any trailing
+  // index.
+  const uint32_t *GetPackedIndices() const { return packed_indices_.data(); }
+  uint32_t GetNumPackedIndices() const { return packed_indices_.size(); }
+
+  // Returns true if the final index of a 16-bit buffer did not fit in a pair.
+  bool HasTrailingIndex() const { return has_trailing_index_; }
+  uint32_t GetTrailingIndex() const { return trailing_index_; }
+
+ private:
+  std::vector<uint32_t> packed_indices_;
+  uint32_t num_indices_{0};
+  uint32_t max_index_{0};
+  bool is_16_bit_{true};
+  bool has_trailing_index_{false};
+  uint32_t trailing_index_{0};
+};
+
+#endif  // NXDK_PGRAPH_TESTS_INDEX_BUFFER_H
@@ -19,6 +19,7 @@
 #include <vector>
 
 #include "debug_output.h"
+#include "pushbuffer_recorder.h"
 #include "test_driver.h"
 #include "test_host.h"
 #include "tests/attribute_carryover_tests.h"
@@ -36,6 +37,7 @@
 #include "tests/material_color_source_tests.h"
 #include "tests/material_color_tests.h"
 #include "tests/overlapping_draw_modes_tests.h"
+#include "tests/procedural_mesh_tests.h"
 #include "tests/set_vertex_data_tests.h"
 #include "tests/texgen_matrix_tests.h"
 #include "tests/texgen_tests.h"
@@ -44,8 +46,10 @@
 #include "tests/texture_format_tests.h"
 #include "tests/texture_framebuffer_blit_tests.h"
 #include "tests/texture_matrix_tests.h"
+#include "tests/texture_mipmap_tests.h"
 #include "tests/texture_render_target_tests.h"
 #include "tests/three_d_primitive_tests.h"
+#include "tests/trace_replay_test_suite.h"
 #include "tests/two_d_line_tests.h"
 #include "tests/vertex_shader_independence_tests.h"
 #include "tests/vertex_shader_rounding_tests.h"
@@ -60,6 +64,9 @@ static constexpr int kFramebufferWidth = 640;
 static constexpr int kFramebufferHeight = 480;
 static constexpr int kTextureWidth = 256;
 static constexpr int kTextureHeight = 256;
+// Shared by every texture stage, palette and render target. Leaves room for a single 1024x1024 32-bit texture with
+// mipmaps or a 128x128x128 32-bit volume in addition to the default reservations of each stage.
+static constexpr uint32_t kTextureMemorySize = 16 * 1024 * 1024;
 
 static void register_suites(TestHost& host, std::vector<std::shared_ptr<TestSuite>>& test_suites,
                             const std::string& output_directory);
@@ -106,7 +113,7 @@ int main() {
 
   pb_show_front_screen();
 
-  TestHost host(kFramebufferWidth, kFramebufferHeight, kTextureWidth, kTextureHeight);
+  TestHost host(kFramebufferWidth, kFramebufferHeight, kTextureWidth, kTextureHeight, 4, kTextureMemorySize);
 
   std::vector<std::shared_ptr<TestSuite>> test_suites;
   register_suites(host, test_suites, test_output_directory);
@@ -119,9 +126,17 @@ int main() {
   process_config(RUNTIME_CONFIG_PATH, test_suites);
 #endif
 
+#ifdef ENABLE_PUSHBUFFER_RECORDER
+  PushBufferRecorder::Open(test_output_directory + "\\pushbuffer.trace");
+#endif
+
   TestDriver driver(host, test_suites, kFramebufferWidth, kFramebufferHeight);
   driver.Run();
 
+#ifdef ENABLE_PUSHBUFFER_RECORDER
+  PushBufferRecorder::Close();
+#endif
+
 #ifdef ENABLE_SHUTDOWN
   HalInitiateShutdown();
 #else
@@ -324,6 +339,10 @@ static void register_suites(TestHost& host, std::vector<std::shared_ptr<TestSuit
     auto suite = std::make_shared<OverlappingDrawModesTests>(host, output_directory);
     test_suites.push_back(std::dynamic_pointer_cast<TestSuite>(suite));
   }
+  {
+    auto suite = std::make_shared<ProceduralMeshTests>(host, output_directory);
+    test_suites.push_back(std::dynamic_pointer_cast<TestSuite>(suite));
+  }
   {
     auto suite = std::make_shared<SetVertexDataTests>(host, output_directory);
     test_suites.push_back(std::dynamic_pointer_cast<TestSuite>(suite));
@@ -352,6 +371,10 @@ static void register_suites(TestHost& host, std::vector<std::shared_ptr<TestSuit
     auto suite = std::make_shared<TextureMatrixTests>(host, output_directory);
     test_suites.push_back(std::dynamic_pointer_cast<TestSuite>(suite));
   }
+  {
+    auto suite = std::make_shared<TextureMipmapTests>(host, output_directory);
+    test_suites.push_back(std::dynamic_pointer_cast<TestSuite>(suite));
+  }
   {
     auto suite = std::make_shared<TextureRenderTargetTests>(host, output_directory);
     test_suites.push_back(std::dynamic_pointer_cast<TestSuite>(suite));
@@ -388,4 +411,11 @@ static void register_suites(TestHost& host, std::vector<std::shared_ptr<TestSuit
     auto suite = std::make_shared<ZeroStrideTests>(host, output_directory);
     test_suites.push_back(std::dynamic_pointer_cast<TestSuite>(suite));
   }
+
+#ifdef REPLAY_TRACE_PATH
+  {
+    auto suite = std::make_shared<TraceReplayTestSuite>(host, output_directory, REPLAY_TRACE_PATH);
+    test_suites.push_back(std::dynamic_pointer_cast<TestSuite>(suite));
+  }
+#endif
 }
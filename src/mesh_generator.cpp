@@ -0,0 +1,287 @@
+#include "mesh_generator.h"
+
+#include <cmath>
+#include <cstring>
+
+#if !defined(MESH_GENERATOR_NO_SIMD) && defined(__SSE__)
+#define MESH_GENERATOR_SSE
+#include <xmmintrin.h>
+#endif
+
+#include "debug_output.h"
+
+namespace {
+
+#ifdef MESH_GENERATOR_SSE
+struct Vec4 {
+  __m128 value;
+
+  static inline Vec4 Set(float x, float y, float z, float w) { return {_mm_setr_ps(x, y, z, w)}; }
+  inline Vec4 operator+(const Vec4 &other) const { return {_mm_add_ps(value, other.value)}; }
+  inline Vec4 operator*(const Vec4 &other) const { return {_mm_mul_ps(value, other.value)}; }
+  inline Vec4 operator*(float scale) const { return {_mm_mul_ps(value, _mm_set1_ps(scale))}; }
+  inline void Store(float *out) const { _mm_storeu_ps(out, value); }
+};
+#else
+struct Vec4 {
+  float value[4];
+
+  static inline Vec4 Set(float x, float y, float z, float w) { return {{x, y, z, w}}; }
+  inline Vec4 operator+(const Vec4 &other) const {
+    return {{value[0] + other.value[0], value[1] + other.value[1], value[2] + other.value[2],
+             value[3] + other.value[3]}};
+  }
+  inline Vec4 operator*(const Vec4 &other) const {
+    return {{value[0] * other.value[0], value[1] * other.value[1], value[2] * other.value[2],
+             value[3] * other.value[3]}};
+  }
+  inline Vec4 operator*(float scale) const {
+    return {{value[0] * scale, value[1] * scale, value[2] * scale, value[3] * scale}};
+  }
+  inline void Store(float *out) const { memcpy(out, value, sizeof(value)); }
+};
+#endif
+
+// Assembles each vertex in cached memory, where only the attributes that vary are updated, and then copies it whole to
+// the write-combined vertex buffer so that the buffer is only ever written sequentially.
+class VertexWriter {
+ public:
+  VertexWriter(VertexBuffer &buffer, const MeshOptions &options)
+      : buffer_(buffer), out_(buffer.Lock()), tangent_stage_(options.tangent_stage) {
+    memset(&vertex_, 0, sizeof(vertex_));
+    vertex_.SetDiffuse(options.diffuse.r, options.diffuse.g, options.diffuse.b, options.diffuse.a);
+    vertex_.SetSpecular(1.0f, 1.0f, 1.0f, 1.0f);
+  }
+  ~VertexWriter() { buffer_.Unlock(); }
+
+  // `position` must have w = 1. The w component of `normal` is ignored.
+  inline void Write(const Vec4 &position, const Vec4 &normal, float u, float v, const Vec4 &tangent) {
+    position.Store(vertex_.pos);
+
+    // The normal is followed by the diffuse color, so it is stored through a temporary.
+    float normal_values[4];
+    normal.Store(normal_values);
+    memcpy(vertex_.normal, normal_values, sizeof(vertex_.normal));
+
+    const Vec4 texcoord = Vec4::Set(u, v, 0.0f, 0.0f);
+    float *texcoords[4] = {vertex_.texcoord0, vertex_.texcoord1, vertex_.texcoord2, vertex_.texcoord3};
+    for (uint32_t stage = 0; stage < 4; ++stage) {
+      (stage == tangent_stage_ ? tangent : texcoord).Store(texcoords[stage]);
+    }
+
+    *out_++ = vertex_;
+  }
+
+ private:
+  VertexBuffer &buffer_;
+  Vertex *out_;
+  uint32_t tangent_stage_;
+  Vertex vertex_;
+};
+
+}  // namespace
+
+// Writes a grid of vertices starting at `origin` with `columns` steps along `u_axis` and `rows` steps along `v_axis`.
+// The normal is the direction of cross(u_axis, v_axis).
+static void WriteGridVertices(VertexWriter &writer, const float *origin, const float *u_axis, const float *v_axis,
+                              uint32_t columns, uint32_t rows) {
+  float normal[3] = {u_axis[1] * v_axis[2] - u_axis[2] * v_axis[1], u_axis[2] * v_axis[0] - u_axis[0] * v_axis[2],
+                     u_axis[0] * v_axis[1] - u_axis[1] * v_axis[0]};
+  const float normal_length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+  const float u_length = sqrtf(u_axis[0] * u_axis[0] + u_axis[1] * u_axis[1] + u_axis[2] * u_axis[2]);
+
+  const Vec4 face_normal = Vec4::Set(normal[0], normal[1], normal[2], 0.0f) * (1.0f / normal_length);
+  // The bitangent always follows v_axis, as cross(cross(u_axis, v_axis), u_axis) points along v_axis.
+  const Vec4 tangent = Vec4::Set(u_axis[0] / u_length, u_axis[1] / u_length, u_axis[2] / u_length, 1.0f);
+  const Vec4 column_step = Vec4::Set(u_axis[0], u_axis[1], u_axis[2], 0.0f) * (1.0f / static_cast<float>(columns));
+  const Vec4 row_step = Vec4::Set(v_axis[0], v_axis[1], v_axis[2], 0.0f) * (1.0f / static_cast<float>(rows));
+
+  Vec4 row_start = Vec4::Set(origin[0], origin[1], origin[2], 1.0f);
+  for (uint32_t row = 0; row <= rows; ++row, row_start = row_start + row_step) {
+    const float v = static_cast<float>(row) / static_cast<float>(rows);
+    Vec4 position = row_start;
+    for (uint32_t column = 0; column <= columns; ++column, position = position + column_step) {
+      writer.Write(position, face_normal, static_cast<float>(column) / static_cast<float>(columns), v, tangent);
+    }
+  }
+}
+
+// Appends the triangles of a grid written by WriteGridVertices whose first vertex is `first`.
+static void AddGridIndices(std::vector<uint32_t> &indices, uint32_t first, uint32_t columns, uint32_t rows) {
+  const uint32_t pitch = columns + 1;
+  for (uint32_t row = 0; row < rows; ++row) {
+    for (uint32_t column = 0; column < columns; ++column) {
+      const uint32_t upper_left = first + row * pitch + column;
+      const uint32_t lower_left = upper_left + pitch;
+      indices.insert(indices.end(),
+                     {upper_left, upper_left + 1, lower_left + 1, upper_left, lower_left + 1, lower_left});
+    }
+  }
+}
+
+Mesh GenerateGrid(float left, float top, float right, float bottom, float z, uint32_t columns, uint32_t rows,
+                  const MeshOptions &options) {
+  ASSERT(columns && rows && "Grid must have at least one row and column.");
+  Mesh mesh;
+  mesh.vertex_buffer = std::make_shared<VertexBuffer>((columns + 1) * (rows + 1));
+  {
+    VertexWriter writer(*mesh.vertex_buffer, options);
+    const float origin[3] = {left, top, z};
+    const float u_axis[3] = {right - left, 0.0f, 0.0f};
+    const float v_axis[3] = {0.0f, bottom - top, 0.0f};
+    WriteGridVertices(writer, origin, u_axis, v_axis, columns, rows);
+  }
+
+  mesh.indices.reserve(columns * rows * 6);
+  AddGridIndices(mesh.indices, 0, columns, rows);
+  return mesh;
+}
+
+Mesh GenerateCube(const float *center, float size, uint32_t tessellation, const MeshOptions &options) {
+  ASSERT(tessellation && "Cube faces must have at least one row and column.");
+
+  // The u and v axes of each face, in units of the edge length, chosen so that cross(u, v) points out of the cube.
+  static constexpr float kFaceAxes[6][2][3] = {
+      {{0.0f, 0.0f, 1.0f}, {0.0f, -1.0f, 0.0f}},   // +X
+      {{0.0f, 0.0f, -1.0f}, {0.0f, -1.0f, 0.0f}},  // -X
+      {{1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, -1.0f}},   // +Y
+      {{1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},    // -Y
+      {{-1.0f, 0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},  // +Z
+      {{1.0f, 0.0f, 0.0f}, {0.0f, -1.0f, 0.0f}},   // -Z
+  };
+
+  const uint32_t face_vertices = (tessellation + 1) * (tessellation + 1);
+  Mesh mesh;
+  mesh.vertex_buffer = std::make_shared<VertexBuffer>(face_vertices * 6);
+  mesh.indices.reserve(tessellation * tessellation * 6 * 6);
+  {
+    VertexWriter writer(*mesh.vertex_buffer, options);
+    const float half_size = size * 0.5f;
+    for (uint32_t face = 0; face < 6; ++face) {
+      const float *u = kFaceAxes[face][0];
+      const float *v = kFaceAxes[face][1];
+      const float normal[3] = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+      float origin[3];
+      float u_axis[3];
+      float v_axis[3];
+      for (uint32_t i = 0; i < 3; ++i) {
+        origin[i] = center[i] + (normal[i] - u[i] - v[i]) * half_size;
+        u_axis[i] = u[i] * size;
+        v_axis[i] = v[i] * size;
+      }
+      WriteGridVertices(writer, origin, u_axis, v_axis, tessellation, tessellation);
+      AddGridIndices(mesh.indices, face * face_vertices, tessellation, tessellation);
+    }
+  }
+
+  return mesh;
+}
+
+Mesh GenerateSphere(const float *center, float radius, uint32_t segments, uint32_t rings, const MeshOptions &options) {
+  ASSERT(segments >= 3 && rings >= 2 && "Sphere must have at least 3 segments and 2 rings.");
+  static constexpr float kPi = 3.14159265358979323846f;
+
+  // Longitude runs around the Y axis with u and latitude from the +Y pole with v. The seam column is duplicated so
+  // that it may have both u = 0 and u = 1.
+  const uint32_t pitch = segments + 1;
+  std::vector<Vec4> longitude(pitch);
+  std::vector<Vec4> tangents(pitch);
+  for (uint32_t segment = 0; segment <= segments; ++segment) {
+    const float angle = 2.0f * kPi * static_cast<float>(segment) / static_cast<float>(segments);
+    const float cos_angle = cosf(angle);
+    const float sin_angle = sinf(angle);
+    longitude[segment] = Vec4::Set(cos_angle, 1.0f, sin_angle, 0.0f);
+    tangents[segment] = Vec4::Set(-sin_angle, 0.0f, cos_angle, 1.0f);
+  }
+
+  Mesh mesh;
+  mesh.vertex_buffer = std::make_shared<VertexBuffer>(pitch * (rings + 1));
+  {
+    VertexWriter writer(*mesh.vertex_buffer, options);
+    const Vec4 origin = Vec4::Set(center[0], center[1], center[2], 1.0f);
+    for (uint32_t ring = 0; ring <= rings; ++ring) {
+      const float v = static_cast<float>(ring) / static_cast<float>(rings);
+      const float angle = kPi * v;
+      const float sin_angle = sinf(angle);
+      const Vec4 latitude = Vec4::Set(sin_angle, cosf(angle), sin_angle, 0.0f);
+      for (uint32_t segment = 0; segment <= segments; ++segment) {
+        const Vec4 normal = latitude * longitude[segment];
+        writer.Write(origin + normal * radius, normal, static_cast<float>(segment) / static_cast<float>(segments), v,
+                     tangents[segment]);
+      }
+    }
+  }
+
+  // The triangles touching the poles would be degenerate and are omitted.
+  mesh.indices.reserve(segments * (rings - 1) * 6);
+  for (uint32_t ring = 0; ring < rings; ++ring) {
+    for (uint32_t segment = 0; segment < segments; ++segment) {
+      const uint32_t upper = ring * pitch + segment;
+      const uint32_t lower = upper + pitch;
+      if (ring) {
+        mesh.indices.insert(mesh.indices.end(), {upper, upper + 1, lower});
+      }
+      if (ring + 1 < rings) {
+        mesh.indices.insert(mesh.indices.end(), {upper + 1, lower + 1, lower});
+      }
+    }
+  }
+
+  return mesh;
+}
+
+Mesh GenerateTorus(const float *center, float major_radius, float minor_radius, uint32_t major_segments,
+                   uint32_t minor_segments, const MeshOptions &options) {
+  ASSERT(major_segments >= 3 && minor_segments >= 3 && "Torus must have at least 3 segments in each direction.");
+  static constexpr float kPi = 3.14159265358979323846f;
+
+  // u runs around the Y axis and v around the tube, starting at its outer edge and passing over the top.
+  const uint32_t minor_pitch = minor_segments + 1;
+  std::vector<Vec4> cross_section(minor_pitch);
+  for (uint32_t segment = 0; segment <= minor_segments; ++segment) {
+    const float angle = 2.0f * kPi * static_cast<float>(segment) / static_cast<float>(minor_segments);
+    const float cos_angle = cosf(angle);
+    cross_section[segment] = Vec4::Set(cos_angle, sinf(angle), cos_angle, 0.0f);
+  }
+
+  Mesh mesh;
+  mesh.vertex_buffer = std::make_shared<VertexBuffer>((major_segments + 1) * minor_pitch);
+  {
+    VertexWriter writer(*mesh.vertex_buffer, options);
+    const Vec4 origin = Vec4::Set(center[0], center[1], center[2], 1.0f);
+    for (uint32_t major = 0; major <= major_segments; ++major) {
+      const float u = static_cast<float>(major) / static_cast<float>(major_segments);
+      const float angle = 2.0f * kPi * u;
+      const float cos_angle = cosf(angle);
+      const float sin_angle = sinf(angle);
+      const Vec4 direction = Vec4::Set(cos_angle, 1.0f, sin_angle, 0.0f);
+      const Vec4 ring_center = origin + Vec4::Set(cos_angle, 0.0f, sin_angle, 0.0f) * major_radius;
+      // Increasing v turns away from cross(normal, tangent), so the bitangent sign is negative.
+      const Vec4 tangent = Vec4::Set(-sin_angle, 0.0f, cos_angle, -1.0f);
+      for (uint32_t minor = 0; minor <= minor_segments; ++minor) {
+        const Vec4 normal = cross_section[minor] * direction;
+        writer.Write(ring_center + normal * minor_radius, normal, u,
+                     static_cast<float>(minor) / static_cast<float>(minor_segments), tangent);
+      }
+    }
+  }
+
+  mesh.indices.reserve(major_segments * minor_segments * 6);
+  for (uint32_t major = 0; major < major_segments; ++major) {
+    for (uint32_t minor = 0; minor < minor_segments; ++minor) {
+      const uint32_t first = major * minor_pitch + minor;
+      const uint32_t next_major = first + minor_pitch;
+      mesh.indices.insert(mesh.indices.end(), {first, first + 1, next_major, next_major, first + 1, next_major + 1});
+    }
+  }
+
+  return mesh;
+}
+
+const char *GetMeshGeneratorImplementation() {
+#ifdef MESH_GENERATOR_SSE
+  return "SSE";
+#else
+  return "scalar";
+#endif
+}
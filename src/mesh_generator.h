@@ -0,0 +1,66 @@
+#ifndef NXDK_PGRAPH_TESTS_MESH_GENERATOR_H
+#define NXDK_PGRAPH_TESTS_MESH_GENERATOR_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "vertex_buffer.h"
+
+// Procedural generation of tessellated test geometry.
+//
+// Each generator allocates a VertexBuffer holding the shared vertices of the shape and returns it with the indices of
+// a PRIMITIVE_TRIANGLES list that draws it (e.g., via an IndexBuffer and TestHost::DrawInlineElements, or
+// ConvertTopology in primitive_topology.h). Vertices are computed in cached memory and written to the vertex buffer in
+// a single sequential pass, using SSE for the vector math when the target supports it. Every vertex has a position
+// with w = 1, a unit normal, the diffuse color and white specular color of the options and (u, v, 0, 0) texture
+// coordinates on every stage, except for the optional tangent stage.
+//
+// Front faces are wound clockwise when viewed from outside of the shape (i.e., against their normal), matching
+// VertexBuffer::DefineTriangle and DefineBiTri.
+
+// Texture stage value used to disable tangent generation.
+static constexpr uint32_t kNoTangentStage = 0xFFFFFFFF;
+
+struct MeshOptions {
+  Color diffuse{1.0f, 1.0f, 1.0f, 1.0f};
+  // Texture stage whose coordinates are replaced by the unit tangent in the direction of increasing u and, in w, the
+  // sign of the bitangent (in the direction of increasing v) relative to cross(normal, tangent).
+  uint32_t tangent_stage{kNoTangentStage};
+};
+
+struct Mesh {
+  std::shared_ptr<VertexBuffer> vertex_buffer;
+  std::vector<uint32_t> indices;
+};
+
+// Returns a `columns` x `rows` grid of quads in the plane at `z`. Texture coordinates run from (0, 0) at (left, top)
+// to (1, 1) at (right, bottom). The normal faces -Z when top > bottom (world space) and +Z when top < bottom (screen
+// space).
+Mesh GenerateGrid(float left, float top, float right, float bottom, float z, uint32_t columns, uint32_t rows,
+                  const MeshOptions &options = {});
+
+// Returns a grid covering a `width` x `height` screen, for use with screen space vertex shaders.
+inline Mesh GenerateFullscreenQuad(float width, float height, float z = 0.0f, uint32_t tessellation = 1,
+                                   const MeshOptions &options = {}) {
+  return GenerateGrid(0.0f, 0.0f, width, height, z, tessellation, tessellation, options);
+}
+
+// Returns an axis aligned cube with edges of length `size`, each face of which is a `tessellation` x `tessellation`
+// grid with its own vertices.
+Mesh GenerateCube(const float *center, float size, uint32_t tessellation, const MeshOptions &options = {});
+
+// Returns a UV sphere with `segments` divisions around the Y axis and `rings` divisions from pole to pole. The texture
+// seam lies on the +X side of the sphere.
+Mesh GenerateSphere(const float *center, float radius, uint32_t segments, uint32_t rings,
+                    const MeshOptions &options = {});
+
+// Returns a torus around the Y axis. `major_segments` divide the circle of radius `major_radius` through the center of
+// the tube and `minor_segments` divide the cross section of the tube.
+Mesh GenerateTorus(const float *center, float major_radius, float minor_radius, uint32_t major_segments,
+                   uint32_t minor_segments, const MeshOptions &options = {});
+
+// Returns the name of the instruction set used for the vector math.
+const char *GetMeshGeneratorImplementation();
+
+#endif  // NXDK_PGRAPH_TESTS_MESH_GENERATOR_H
@@ -27,8 +27,27 @@
 #define NV097_SET_TEXTURE_FORMAT_COLOR_LC_IMAGE_CR8YB8CB8YA8 0x24
 #define NV097_SET_TEXTURE_FORMAT_COLOR_LC_IMAGE_YB8CR8YA8CB8 0x25
 #define NV097_SET_TEXTURE_FORMAT_COLOR_SZ_DEPTH_Y16_FIXED 0x2C
+#define NV097_SET_TEXTURE_FORMAT_COLOR_SZ_DEPTH_Y16_FLOAT 0x2D
 #define NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FLOAT 0x31
 #define NV097_SET_TEXTURE_FORMAT_COLOR_SZ_B8G8R8A8 0x3B
+// Not present in all versions of nv_regs.h.
+#ifndef NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A8
+#define NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A8 0x19
+#endif
+#ifndef NV097_SET_TEXTURE_FORMAT_COLOR_SZ_R6G5B5
+#define NV097_SET_TEXTURE_FORMAT_COLOR_SZ_R6G5B5 0x27
+#endif
+
+// Vertex data array component types.
+#ifndef NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_UB_D3D
+#define NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_UB_D3D 0
+#endif
+#ifndef NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_S1
+#define NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_S1 1
+#endif
+#ifndef NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_CMP
+#define NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_CMP 6
+#endif
 
 #define NV097_SET_CONTROL0_COLOR_SPACE_CONVERT 0xF0000000
 #define NV097_SET_CONTROL0_COLOR_SPACE_CONVERT_CRYCB_TO_RGB 0x1
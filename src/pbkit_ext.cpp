@@ -6,6 +6,7 @@
 
 #include "debug_output.h"
 #include "nxdk_ext.h"
+#include "pushbuffer_recorder.h"
 
 void set_depth_stencil_buffer_region(uint32_t depth_buffer_format, uint32_t depth_value, uint8_t stencil_value,
                                      uint32_t left, uint32_t top, uint32_t width, uint32_t height) {
@@ -104,6 +105,8 @@ void pb_set_dma_address(const struct s_CtxDma *context, const void *address, uin
 }
 
 void pb_bind_subchannel(uint32_t subchannel, const struct s_CtxDma *context) {
+  PushBufferRecorder::MarkBindSubchannel(subchannel, context->Class);
+
   auto p = pb_begin();
   p = pb_push1_to(subchannel, p, NV20_TCL_PRIMITIVE_SET_MAIN_OBJECT, context->ChannelID);
   pb_end(p);
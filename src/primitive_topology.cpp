@@ -0,0 +1,282 @@
+#include "primitive_topology.h"
+
+#include <set>
+#include <utility>
+
+#include "debug_output.h"
+
+static bool IsFacePrimitive(TestHost::DrawPrimitive primitive) {
+  switch (primitive) {
+    case TestHost::PRIMITIVE_TRIANGLES:
+    case TestHost::PRIMITIVE_TRIANGLE_STRIP:
+    case TestHost::PRIMITIVE_TRIANGLE_FAN:
+    case TestHost::PRIMITIVE_QUADS:
+    case TestHost::PRIMITIVE_QUAD_STRIP:
+    case TestHost::PRIMITIVE_POLYGON:
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+static void Triangulate(const std::vector<uint32_t> &indices, TestHost::DrawPrimitive source,
+                        std::vector<uint32_t> &triangles) {
+  const uint32_t count = indices.size();
+  auto add = [&triangles](uint32_t one, uint32_t two, uint32_t three) {
+    triangles.push_back(one);
+    triangles.push_back(two);
+    triangles.push_back(three);
+  };
+
+  switch (source) {
+    case TestHost::PRIMITIVE_TRIANGLES:
+      for (uint32_t i = 0; i + 2 < count; i += 3) {
+        add(indices[i], indices[i + 1], indices[i + 2]);
+      }
+      break;
+
+    case TestHost::PRIMITIVE_TRIANGLE_STRIP:
+      // The first two vertices of every odd triangle are swapped so that the whole strip has the same winding.
+      for (uint32_t i = 0; i + 2 < count; ++i) {
+        if (i & 1) {
+          add(indices[i + 1], indices[i], indices[i + 2]);
+        } else {
+          add(indices[i], indices[i + 1], indices[i + 2]);
+        }
+      }
+      break;
+
+    case TestHost::PRIMITIVE_TRIANGLE_FAN:
+    case TestHost::PRIMITIVE_POLYGON:
+      for (uint32_t i = 1; i + 1 < count; ++i) {
+        add(indices[0], indices[i], indices[i + 1]);
+      }
+      break;
+
+    case TestHost::PRIMITIVE_QUADS:
+      for (uint32_t i = 0; i + 3 < count; i += 4) {
+        add(indices[i], indices[i + 1], indices[i + 2]);
+        add(indices[i], indices[i + 2], indices[i + 3]);
+      }
+      break;
+
+    case TestHost::PRIMITIVE_QUAD_STRIP:
+      // Each quad is formed by two consecutive pairs of vertices and is split as if the vertices were a triangle strip.
+      for (uint32_t i = 0; i + 3 < count; i += 2) {
+        add(indices[i], indices[i + 1], indices[i + 2]);
+        add(indices[i + 2], indices[i + 1], indices[i + 3]);
+      }
+      break;
+
+    default:
+      ASSERT(!"Primitive does not have faces.");
+  }
+}
+
+// Joins a list of triangles into a single strip. Triangles that share an edge with the end of the strip in the
+// required winding continue it directly, others are connected by repeating vertices to form degenerate triangles.
+static void Stripify(const std::vector<uint32_t> &triangles, std::vector<uint32_t> &strip) {
+  for (uint32_t i = 0; i + 2 < triangles.size(); i += 3) {
+    const uint32_t *triangle = &triangles[i];
+    if (strip.empty()) {
+      strip.insert(strip.end(), triangle, triangle + 3);
+      continue;
+    }
+
+    // The next triangle in the strip begins at strip[size - 2]. The hardware swaps the first two vertices of odd
+    // triangles, so the shared edge must appear in the opposite order.
+    const uint32_t size = strip.size();
+    const bool odd = (size - 2) & 1;
+    const uint32_t first = odd ? strip[size - 1] : strip[size - 2];
+    const uint32_t second = odd ? strip[size - 2] : strip[size - 1];
+    bool continued = false;
+    for (uint32_t rotation = 0; rotation < 3; ++rotation) {
+      if (triangle[rotation] == first && triangle[(rotation + 1) % 3] == second) {
+        strip.push_back(triangle[(rotation + 2) % 3]);
+        continued = true;
+        break;
+      }
+    }
+    if (continued) {
+      continue;
+    }
+
+    // Repeat the last vertex and the first vertex of the triangle. The triangle must then begin at an even position.
+    strip.push_back(strip.back());
+    strip.push_back(triangle[0]);
+    strip.push_back(triangle[0]);
+    if ((strip.size() - 1) & 1) {
+      strip.push_back(triangle[0]);
+    }
+    strip.push_back(triangle[1]);
+    strip.push_back(triangle[2]);
+  }
+}
+
+static void AppendEdges(const std::vector<uint32_t> &indices, TestHost::DrawPrimitive source,
+                        std::vector<uint32_t> &lines) {
+  std::set<std::pair<uint32_t, uint32_t>> edges;
+  auto add = [&edges, &lines](uint32_t one, uint32_t two) {
+    if (one == two || !edges.emplace(one < two ? one : two, one < two ? two : one).second) {
+      return;
+    }
+    lines.push_back(one);
+    lines.push_back(two);
+  };
+
+  const uint32_t count = indices.size();
+  switch (source) {
+    case TestHost::PRIMITIVE_LINES:
+      for (uint32_t i = 0; i + 1 < count; i += 2) {
+        add(indices[i], indices[i + 1]);
+      }
+      break;
+
+    case TestHost::PRIMITIVE_LINE_LOOP:
+    case TestHost::PRIMITIVE_LINE_STRIP:
+      for (uint32_t i = 0; i + 1 < count; ++i) {
+        add(indices[i], indices[i + 1]);
+      }
+      if (source == TestHost::PRIMITIVE_LINE_LOOP && count > 2) {
+        add(indices[count - 1], indices[0]);
+      }
+      break;
+
+    case TestHost::PRIMITIVE_TRIANGLES:
+    case TestHost::PRIMITIVE_TRIANGLE_STRIP:
+    case TestHost::PRIMITIVE_TRIANGLE_FAN: {
+      std::vector<uint32_t> triangles;
+      Triangulate(indices, source, triangles);
+      for (uint32_t i = 0; i < triangles.size(); i += 3) {
+        add(triangles[i], triangles[i + 1]);
+        add(triangles[i + 1], triangles[i + 2]);
+        add(triangles[i + 2], triangles[i]);
+      }
+    } break;
+
+    case TestHost::PRIMITIVE_QUADS:
+      for (uint32_t i = 0; i + 3 < count; i += 4) {
+        add(indices[i], indices[i + 1]);
+        add(indices[i + 1], indices[i + 2]);
+        add(indices[i + 2], indices[i + 3]);
+        add(indices[i + 3], indices[i]);
+      }
+      break;
+
+    case TestHost::PRIMITIVE_QUAD_STRIP:
+      for (uint32_t i = 0; i + 3 < count; i += 2) {
+        add(indices[i], indices[i + 1]);
+        add(indices[i + 1], indices[i + 3]);
+        add(indices[i + 3], indices[i + 2]);
+        add(indices[i + 2], indices[i]);
+      }
+      break;
+
+    case TestHost::PRIMITIVE_POLYGON:
+      if (count > 2) {
+        for (uint32_t i = 0; i < count; ++i) {
+          add(indices[i], indices[(i + 1) % count]);
+        }
+      }
+      break;
+
+    default:
+      ASSERT(!"Points do not have edges.");
+  }
+}
+
+std::vector<uint32_t> ConvertTopology(const std::vector<uint32_t> &indices, TestHost::DrawPrimitive source,
+                                      TestHost::DrawPrimitive dest) {
+  if (dest == source || dest == TestHost::PRIMITIVE_POINTS) {
+    return indices;
+  }
+
+  std::vector<uint32_t> ret;
+  switch (dest) {
+    case TestHost::PRIMITIVE_TRIANGLES:
+      ASSERT(IsFacePrimitive(source) && "Source primitive cannot be converted to triangles.");
+      ret.reserve(indices.size() * 3);
+      Triangulate(indices, source, ret);
+      break;
+
+    case TestHost::PRIMITIVE_TRIANGLE_STRIP: {
+      ASSERT(IsFacePrimitive(source) && "Source primitive cannot be converted to a triangle strip.");
+      std::vector<uint32_t> triangles;
+      Triangulate(indices, source, triangles);
+      Stripify(triangles, ret);
+    } break;
+
+    case TestHost::PRIMITIVE_LINES:
+      AppendEdges(indices, source, ret);
+      break;
+
+    case TestHost::PRIMITIVE_QUADS:
+      ASSERT(source == TestHost::PRIMITIVE_QUAD_STRIP && "Only quad strips can be converted to quads.");
+      for (uint32_t i = 0; i + 3 < indices.size(); i += 2) {
+        ret.push_back(indices[i]);
+        ret.push_back(indices[i + 1]);
+        ret.push_back(indices[i + 3]);
+        ret.push_back(indices[i + 2]);
+      }
+      break;
+
+    case TestHost::PRIMITIVE_LINE_STRIP:
+      ASSERT(source == TestHost::PRIMITIVE_LINE_LOOP && "Only line loops can be converted to line strips.");
+      ret = indices;
+      if (indices.size() > 2) {
+        ret.push_back(indices.front());
+      }
+      break;
+
+    case TestHost::PRIMITIVE_TRIANGLE_FAN:
+    case TestHost::PRIMITIVE_POLYGON:
+      ASSERT((source == TestHost::PRIMITIVE_TRIANGLE_FAN || source == TestHost::PRIMITIVE_POLYGON) &&
+             "Only fans and polygons can be converted to each other.");
+      ret = indices;
+      break;
+
+    default:
+      ASSERT(!"Unsupported topology conversion.");
+  }
+
+  return ret;
+}
+
+std::vector<uint32_t> ConvertTopology(uint32_t num_vertices, TestHost::DrawPrimitive source,
+                                      TestHost::DrawPrimitive dest, uint32_t first_vertex) {
+  std::vector<uint32_t> indices(num_vertices);
+  for (uint32_t i = 0; i < num_vertices; ++i) {
+    indices[i] = first_vertex + i;
+  }
+  return ConvertTopology(indices, source, dest);
+}
+
+static bool IsCollinear(const Vertex &one, const Vertex &two, const Vertex &three) {
+  const float a[3] = {two.pos[0] - one.pos[0], two.pos[1] - one.pos[1], two.pos[2] - one.pos[2]};
+  const float b[3] = {three.pos[0] - one.pos[0], three.pos[1] - one.pos[1], three.pos[2] - one.pos[2]};
+  return a[1] * b[2] == a[2] * b[1] && a[2] * b[0] == a[0] * b[2] && a[0] * b[1] == a[1] * b[0];
+}
+
+uint32_t RemoveDegenerateTriangles(std::vector<uint32_t> &indices, const Vertex *vertices) {
+  uint32_t kept = 0;
+  const uint32_t count = indices.size() - indices.size() % 3;
+  for (uint32_t i = 0; i < count; i += 3) {
+    const uint32_t one = indices[i];
+    const uint32_t two = indices[i + 1];
+    const uint32_t three = indices[i + 2];
+    if (one == two || two == three || three == one) {
+      continue;
+    }
+    if (vertices && IsCollinear(vertices[one], vertices[two], vertices[three])) {
+      continue;
+    }
+    indices[kept++] = one;
+    indices[kept++] = two;
+    indices[kept++] = three;
+  }
+
+  const uint32_t removed = (count - kept) / 3;
+  indices.resize(kept);
+  return removed;
+}
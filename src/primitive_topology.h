@@ -0,0 +1,36 @@
+#ifndef NXDK_PGRAPH_TESTS_PRIMITIVE_TOPOLOGY_H
+#define NXDK_PGRAPH_TESTS_PRIMITIVE_TOPOLOGY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "test_host.h"
+
+// Conversion of vertices between primitive topologies by generating indices into a single set of vertices, so that
+// one VertexBuffer may be drawn in several forms (e.g., via TestHost::DrawInlineElements) without duplicating it.
+//
+// The following conversions are supported:
+//   any                                   -> the same primitive or PRIMITIVE_POINTS
+//   triangles, strips, fans, quads,
+//   quad strips and polygons              -> PRIMITIVE_TRIANGLES or PRIMITIVE_TRIANGLE_STRIP
+//   any except points                     -> PRIMITIVE_LINES, giving each edge of the source primitives once
+//   PRIMITIVE_QUAD_STRIP                  -> PRIMITIVE_QUADS
+//   PRIMITIVE_LINE_STRIP, LINE_LOOP       -> PRIMITIVE_LINE_STRIP
+//   PRIMITIVE_TRIANGLE_FAN, POLYGON       -> PRIMITIVE_TRIANGLE_FAN or PRIMITIVE_POLYGON
+//
+// Triangles keep the winding that the hardware gives them in the source primitive. Quads and polygons are split along
+// diagonals from their first vertex and quad strips as if they were triangle strips of the same vertices. These
+// diagonals are not included in line conversions. Vertices that do not complete a primitive are dropped.
+
+// Returns indices that draw the `source` primitives formed by `indices` as `dest` primitives.
+std::vector<uint32_t> ConvertTopology(const std::vector<uint32_t> &indices, TestHost::DrawPrimitive source,
+                                      TestHost::DrawPrimitive dest);
+// As above, for `num_vertices` vertices drawn in order starting at `first_vertex`.
+std::vector<uint32_t> ConvertTopology(uint32_t num_vertices, TestHost::DrawPrimitive source,
+                                      TestHost::DrawPrimitive dest, uint32_t first_vertex = 0);
+
+// Removes triangles from a PRIMITIVE_TRIANGLES index list that repeat a vertex or, if `vertices` is given, whose
+// positions are collinear. Returns the number of triangles removed.
+uint32_t RemoveDegenerateTriangles(std::vector<uint32_t> &indices, const Vertex *vertices = nullptr);
+
+#endif  // NXDK_PGRAPH_TESTS_PRIMITIVE_TOPOLOGY_H
@@ -0,0 +1,208 @@
+#include "pushbuffer_recorder.h"
+
+#include <pbkit/pbkit.h>
+
+#include <vector>
+
+#include "debug_output.h"
+#include "pushbuffer_trace.h"
+
+// Granularity at which tracked memory is checked for modifications.
+static constexpr uint32_t kSnapshotBlockSize = 4096;
+
+struct TrackedMemory {
+  PushBufferTraceMemoryKind kind;
+  const uint8_t *base;
+  uint32_t size;
+  // Checksum of each block as of the last snapshot written to the trace.
+  std::vector<uint32_t> checksums;
+  // Whether `checksums` reflects the content of the trace, false if every block must be written.
+  bool snapshot_valid;
+};
+
+static PushBufferTraceWriter writer;
+static uint32_t *span_start = nullptr;
+static std::vector<TrackedMemory> tracked_memory;
+
+static uint32_t GetTraceAddress(const void *pointer) {
+  return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(pointer)) & kTraceAddressMask;
+}
+
+static void WriteMemoryRegion(TrackedMemory &memory) {
+  PushBufferTraceMemoryRegion payload{memory.kind, GetTraceAddress(memory.base), memory.size};
+  writer.WriteRecord(kTraceRecordMemoryRegion, &payload, sizeof(payload));
+  memory.snapshot_valid = false;
+}
+
+// FNV-1a over DWORDs, trailing bytes are folded in individually.
+static uint32_t ChecksumBlock(const uint8_t *data, uint32_t size) {
+  uint32_t hash = 0x811C9DC5;
+  auto words = reinterpret_cast<const uint32_t *>(data);
+  for (uint32_t i = 0; i < size / 4; ++i) {
+    hash = (hash ^ words[i]) * 0x01000193;
+  }
+  for (uint32_t i = size & ~3; i < size; ++i) {
+    hash = (hash ^ data[i]) * 0x01000193;
+  }
+  return hash;
+}
+
+// Writes any blocks of tracked memory that have changed since the last snapshot, merging adjacent blocks.
+static void SnapshotTrackedMemory() {
+  if (tracked_memory.empty()) {
+    return;
+  }
+
+  // The GPU may still be rendering into tracked memory (e.g., render to texture tests).
+  while (pb_busy()) {
+    /* Wait for completion... */
+  }
+
+  for (auto &memory : tracked_memory) {
+    const uint32_t num_blocks = (memory.size + kSnapshotBlockSize - 1) / kSnapshotBlockSize;
+    memory.checksums.resize(num_blocks);
+
+    uint32_t dirty_start = 0;
+    uint32_t dirty_end = 0;
+    for (uint32_t block = 0; block <= num_blocks; ++block) {
+      bool dirty = false;
+      if (block < num_blocks) {
+        const uint32_t offset = block * kSnapshotBlockSize;
+        const uint32_t size = memory.size - offset < kSnapshotBlockSize ? memory.size - offset : kSnapshotBlockSize;
+        const uint32_t checksum = ChecksumBlock(memory.base + offset, size);
+        dirty = !memory.snapshot_valid || checksum != memory.checksums[block];
+        memory.checksums[block] = checksum;
+      }
+
+      if (dirty) {
+        if (dirty_end != block) {
+          dirty_start = block;
+        }
+        dirty_end = block + 1;
+        continue;
+      }
+
+      if (dirty_end == block && dirty_end > dirty_start) {
+        const uint32_t offset = dirty_start * kSnapshotBlockSize;
+        uint32_t size = dirty_end * kSnapshotBlockSize;
+        size = (size > memory.size ? memory.size : size) - offset;
+        PushBufferTraceMemoryData header{GetTraceAddress(memory.base + offset)};
+        writer.WriteRecord(kTraceRecordMemoryData, &header, sizeof(header), memory.base + offset, size);
+      }
+    }
+
+    memory.snapshot_valid = true;
+  }
+}
+
+// Returns true if the given span contains a NV097_SET_BEGIN_END that starts a primitive.
+static bool SpanBeginsDraw(const uint32_t *start, const uint32_t *end) {
+  while (start < end) {
+    const uint32_t header = *start++;
+
+    // Control flow commands have no parameters.
+    if (TraceCommandIsControlFlow(header)) {
+      continue;
+    }
+
+    const uint32_t count = TraceCommandCount(header);
+    if (count && start < end && TraceCommandSubchannel(header) == SUBCH_3D &&
+        TraceCommandMethod(header) == NV097_SET_BEGIN_END && *start != NV097_SET_BEGIN_END_OP_END) {
+      return true;
+    }
+    start += count;
+  }
+
+  return false;
+}
+
+bool PushBufferRecorder::Open(const std::string &path) {
+  if (!writer.Open(path.c_str())) {
+    PrintMsg("Failed to open push buffer trace '%s'\n", path.c_str());
+    return false;
+  }
+
+  // Memory may have been registered before recording started.
+  for (auto &memory : tracked_memory) {
+    WriteMemoryRegion(memory);
+  }
+  return true;
+}
+
+void PushBufferRecorder::Close() { writer.Close(); }
+
+bool PushBufferRecorder::IsRecording() { return writer.IsOpen(); }
+
+void PushBufferRecorder::MarkPrepareDraw() { writer.WriteRecord(kTraceRecordPrepareDraw); }
+
+void PushBufferRecorder::MarkFinishDraw(const std::string &output_directory, const std::string &name) {
+  if (!IsRecording()) {
+    return;
+  }
+
+  std::string payload = output_directory;
+  payload.push_back(0);
+  payload += name;
+  payload.push_back(0);
+  writer.WriteRecord(kTraceRecordFinishDraw, payload.data(), payload.size());
+
+  // Keep the trace on disk current with the last completed test in case the run does not finish cleanly.
+  writer.Flush();
+}
+
+void PushBufferRecorder::MarkBindSubchannel(uint32_t subchannel, uint32_t object_class) {
+  PushBufferTraceBindSubchannel payload{subchannel, object_class};
+  writer.WriteRecord(kTraceRecordBindSubchannel, &payload, sizeof(payload));
+}
+
+#ifdef ENABLE_PUSHBUFFER_RECORDER
+void PushBufferRecorder::TrackMemory(PushBufferTraceMemoryKind kind, const void *base, uint32_t size) {
+  auto bytes = static_cast<const uint8_t *>(base);
+  for (auto &memory : tracked_memory) {
+    if (memory.base != bytes) {
+      continue;
+    }
+    if (memory.kind == kind && memory.size == size) {
+      return;
+    }
+
+    memory.kind = kind;
+    memory.size = size;
+    WriteMemoryRegion(memory);
+    return;
+  }
+
+  tracked_memory.push_back({kind, bytes, size, {}, false});
+  WriteMemoryRegion(tracked_memory.back());
+}
+
+void PushBufferRecorder::UntrackMemory(const void *base) {
+  for (auto it = tracked_memory.begin(); it != tracked_memory.end(); ++it) {
+    if (it->base == base) {
+      tracked_memory.erase(it);
+      return;
+    }
+  }
+}
+#endif  // ENABLE_PUSHBUFFER_RECORDER
+
+void PushBufferRecorder::RecordCommands(const uint32_t *start, const uint32_t *end) {
+  ASSERT(end >= start && "Invalid push buffer span.");
+  writer.WriteCommands(start, end - start);
+}
+
+// Note: The real pbkit functions are invoked via parenthesized names to prevent expansion of the hook macros.
+uint32_t *PushBufferRecorder::OnBegin() {
+  span_start = (pb_begin)();
+  return span_start;
+}
+
+void PushBufferRecorder::OnEnd(uint32_t *end) {
+  ASSERT(span_start && "pb_end called without a matching pb_begin.");
+  if (IsRecording() && SpanBeginsDraw(span_start, end)) {
+    SnapshotTrackedMemory();
+  }
+  RecordCommands(span_start, end);
+  span_start = nullptr;
+  (pb_end)(end);
+}
@@ -0,0 +1,51 @@
+#ifndef NXDK_PGRAPH_TESTS_PUSHBUFFER_RECORDER_H
+#define NXDK_PGRAPH_TESTS_PUSHBUFFER_RECORDER_H
+
+#include <cstdint>
+#include <string>
+
+#include "pushbuffer_trace.h"
+
+// Captures the NV2A commands pushed by the test harness into a push buffer trace (see pushbuffer_trace.h).
+//
+// Capture is enabled by building with ENABLE_PUSHBUFFER_RECORDER=y, which force-includes pushbuffer_recorder_hooks.h
+// so that every pb_begin()/pb_end() span is routed through OnBegin()/OnEnd(). Commands pushed internally by pbkit
+// (e.g., text rendering and buffer flips) are not captured.
+//
+// Memory read by the GPU must be registered via TrackMemory() for its contents to be captured. Tracked memory is
+// checksummed in fixed size blocks before each span that begins a draw and any blocks that changed since the previous
+// snapshot are written to the trace. Reading back memory is slow, so this is only done while recording, and tracking
+// is a no-op in builds without the recorder.
+class PushBufferRecorder {
+ public:
+  static bool Open(const std::string &path);
+  static void Close();
+  static bool IsRecording();
+
+  // Framing markers delimiting the commands belonging to a single test.
+  static void MarkPrepareDraw();
+  static void MarkFinishDraw(const std::string &output_directory, const std::string &name);
+
+  // Records that a graphics object of the given class has been bound to the given subchannel.
+  static void MarkBindSubchannel(uint32_t subchannel, uint32_t object_class);
+
+#ifdef ENABLE_PUSHBUFFER_RECORDER
+  // Registers (or resizes) a block of memory whose contents should be captured along with the commands that use it.
+  static void TrackMemory(PushBufferTraceMemoryKind kind, const void *base, uint32_t size);
+  // Stops tracking the block of memory at `base`. Must be called before the memory is freed.
+  static void UntrackMemory(const void *base);
+#else
+  // Nothing can be captured without the recorder, so memory tracking compiles away entirely.
+  static void TrackMemory(PushBufferTraceMemoryKind kind, const void *base, uint32_t size) {}
+  static void UntrackMemory(const void *base) {}
+#endif
+
+  // Records a span of commands that has been written to the push buffer.
+  static void RecordCommands(const uint32_t *start, const uint32_t *end);
+
+  // Replacements for pb_begin()/pb_end() that record the span before submitting it.
+  static uint32_t *OnBegin();
+  static void OnEnd(uint32_t *end);
+};
+
+#endif  // NXDK_PGRAPH_TESTS_PUSHBUFFER_RECORDER_H
@@ -0,0 +1,13 @@
+#ifndef NXDK_PGRAPH_TESTS_PUSHBUFFER_RECORDER_HOOKS_H
+#define NXDK_PGRAPH_TESTS_PUSHBUFFER_RECORDER_HOOKS_H
+
+// Force-included into every C++ translation unit when ENABLE_PUSHBUFFER_RECORDER is set. pbkit must be included first
+// so that its declarations of pb_begin/pb_end are not affected by the macros below.
+#include <pbkit/pbkit.h>
+
+#include "pushbuffer_recorder.h"
+
+#define pb_begin() PushBufferRecorder::OnBegin()
+#define pb_end(p) PushBufferRecorder::OnEnd(p)
+
+#endif  // NXDK_PGRAPH_TESTS_PUSHBUFFER_RECORDER_HOOKS_H
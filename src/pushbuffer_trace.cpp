@@ -0,0 +1,191 @@
+#include "pushbuffer_trace.h"
+
+#include <cstddef>
+#include <cstring>
+
+PushBufferTraceWriter::~PushBufferTraceWriter() { Close(); }
+
+bool PushBufferTraceWriter::Open(const char *path) {
+  Close();
+
+  file_ = fopen(path, "wb");
+  if (!file_) {
+    return false;
+  }
+
+  PushBufferTraceFileHeader header{};
+  memcpy(header.magic, kTraceMagic, sizeof(header.magic));
+  header.version = kTraceVersion;
+  header.header_size = sizeof(header);
+  Stage(&header, sizeof(header));
+  return true;
+}
+
+void PushBufferTraceWriter::Close() {
+  if (!file_) {
+    return;
+  }
+
+  Flush();
+  fclose(file_);
+  file_ = nullptr;
+}
+
+void PushBufferTraceWriter::WriteCommands(const uint32_t *commands, uint32_t num_dwords) {
+  if (!file_ || !num_dwords) {
+    return;
+  }
+
+  const uint32_t size = num_dwords * sizeof(*commands);
+
+  // Extend the previous command record if it is still staged rather than paying for another record header.
+  if (open_commands_record_ != kNoOpenRecord && staged_bytes_ + size <= kStagingBufferSize) {
+    auto size_field = staging_buffer_ + open_commands_record_ + offsetof(PushBufferTraceRecordHeader, size);
+    uint32_t record_size;
+    memcpy(&record_size, size_field, sizeof(record_size));
+    record_size += size;
+    memcpy(size_field, &record_size, sizeof(record_size));
+
+    memcpy(staging_buffer_ + staged_bytes_, commands, size);
+    staged_bytes_ += size;
+    return;
+  }
+
+  PushBufferTraceRecordHeader header{kTraceRecordCommands, size};
+  Stage(&header, sizeof(header));
+  if (staged_bytes_ + size <= kStagingBufferSize) {
+    open_commands_record_ = staged_bytes_ - sizeof(header);
+  }
+  Stage(commands, size);
+}
+
+void PushBufferTraceWriter::WriteRecord(PushBufferTraceRecordType type, const void *payload, uint32_t size) {
+  if (!file_) {
+    return;
+  }
+
+  open_commands_record_ = kNoOpenRecord;
+
+  PushBufferTraceRecordHeader header{type, size};
+  Stage(&header, sizeof(header));
+  if (size) {
+    Stage(payload, size);
+  }
+}
+
+void PushBufferTraceWriter::WriteRecord(PushBufferTraceRecordType type, const void *header, uint32_t header_size,
+                                        const void *data, uint32_t size) {
+  if (!file_) {
+    return;
+  }
+
+  open_commands_record_ = kNoOpenRecord;
+
+  PushBufferTraceRecordHeader record_header{type, header_size + size};
+  Stage(&record_header, sizeof(record_header));
+  Stage(header, header_size);
+  if (size) {
+    Stage(data, size);
+  }
+}
+
+void PushBufferTraceWriter::Flush() {
+  if (file_ && staged_bytes_) {
+    fwrite(staging_buffer_, 1, staged_bytes_, file_);
+    fflush(file_);
+  }
+  staged_bytes_ = 0;
+  open_commands_record_ = kNoOpenRecord;
+}
+
+void PushBufferTraceWriter::Stage(const void *data, uint32_t size) {
+  if (staged_bytes_ + size > kStagingBufferSize) {
+    Flush();
+
+    if (size > kStagingBufferSize) {
+      fwrite(data, 1, size, file_);
+      return;
+    }
+  }
+
+  memcpy(staging_buffer_ + staged_bytes_, data, size);
+  staged_bytes_ += size;
+}
+
+PushBufferTraceReader::~PushBufferTraceReader() { Close(); }
+
+bool PushBufferTraceReader::Open(const char *path) {
+  Close();
+
+  file_ = fopen(path, "rb");
+  if (!file_) {
+    return false;
+  }
+
+  PushBufferTraceFileHeader header{};
+  if (fread(&header, sizeof(header), 1, file_) != 1 || memcmp(header.magic, kTraceMagic, sizeof(header.magic)) != 0 ||
+      header.header_size < sizeof(header)) {
+    Close();
+    return false;
+  }
+
+  first_record_ = header.header_size;
+  return Rewind();
+}
+
+void PushBufferTraceReader::Close() {
+  if (file_) {
+    fclose(file_);
+  }
+  file_ = nullptr;
+  first_record_ = 0;
+  remaining_payload_ = 0;
+}
+
+bool PushBufferTraceReader::Rewind() {
+  if (!file_) {
+    return false;
+  }
+
+  remaining_payload_ = 0;
+  return fseek(file_, first_record_, SEEK_SET) == 0;
+}
+
+bool PushBufferTraceReader::NextRecord(PushBufferTraceRecordType &type, uint32_t &size) {
+  if (!file_) {
+    return false;
+  }
+
+  if (remaining_payload_) {
+    if (fseek(file_, static_cast<long>(remaining_payload_), SEEK_CUR)) {
+      return false;
+    }
+    remaining_payload_ = 0;
+  }
+
+  PushBufferTraceRecordHeader header{};
+  if (fread(&header, sizeof(header), 1, file_) != 1) {
+    return false;
+  }
+
+  type = static_cast<PushBufferTraceRecordType>(header.type);
+  size = header.size;
+  remaining_payload_ = header.size;
+  return true;
+}
+
+uint32_t PushBufferTraceReader::ReadPayload(void *buffer, uint32_t max_size) {
+  if (!file_) {
+    return 0;
+  }
+
+  uint32_t to_read = max_size < remaining_payload_ ? max_size : remaining_payload_;
+  auto bytes_read = static_cast<uint32_t>(fread(buffer, 1, to_read, file_));
+  remaining_payload_ -= bytes_read;
+  if (bytes_read != to_read) {
+    // Truncated trace, make sure the next call to NextRecord fails.
+    remaining_payload_ = 0;
+    fseek(file_, 0, SEEK_END);
+  }
+  return bytes_read;
+}
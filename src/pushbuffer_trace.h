@@ -0,0 +1,151 @@
+#ifndef NXDK_PGRAPH_TESTS_PUSHBUFFER_TRACE_H
+#define NXDK_PGRAPH_TESTS_PUSHBUFFER_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+
+// Binary push buffer trace format.
+//
+// A trace begins with a PushBufferTraceFileHeader and is followed by a stream of records. Each record starts with a
+// PushBufferTraceRecordHeader giving its type and payload size, so readers can skip record types they do not
+// understand. All values are little endian.
+//
+//   kTraceRecordCommands     Raw NV2A command words exactly as they were written to the push buffer (a method header
+//                            followed by its parameters, repeated).
+//   kTraceRecordPrepareDraw  Marks the start of a test (TestHost::PrepareDraw). No payload.
+//   kTraceRecordFinishDraw   Marks the end of a test (TestHost::FinishDraw). Payload is the NUL terminated output
+//                            directory followed by the NUL terminated test name.
+//   kTraceRecordBindSubchannel  Records the graphics object class bound to a subchannel (pb_bind_subchannel). Payload
+//                               is a PushBufferTraceBindSubchannel.
+//   kTraceRecordMemoryRegion  Declares a block of memory that is read by the GPU (e.g., texture or vertex data). Payload
+//                             is a PushBufferTraceMemoryRegion. A region replaces any previous region at the same
+//                             address.
+//   kTraceRecordMemoryData  Contents of part of a declared region, written before the commands that consume them.
+//                           Payload is a PushBufferTraceMemoryData followed by the bytes stored at `address`.
+//
+// Memory addresses are recorded in the form that is pushed to the GPU (masked to 0x03FFFFFF).
+
+static constexpr char kTraceMagic[4] = {'N', 'V', 'P', 'B'};
+static constexpr uint16_t kTraceVersion = 1;
+
+enum PushBufferTraceRecordType : uint8_t {
+  kTraceRecordCommands = 0x01,
+  kTraceRecordPrepareDraw = 0x10,
+  kTraceRecordFinishDraw = 0x11,
+  kTraceRecordBindSubchannel = 0x12,
+  kTraceRecordMemoryRegion = 0x20,
+  kTraceRecordMemoryData = 0x21,
+};
+
+enum PushBufferTraceMemoryKind : uint32_t {
+  kTraceMemoryTexture = 0,
+  kTraceMemoryPalette = 1,
+  kTraceMemoryVertex = 2,
+};
+
+static constexpr uint32_t kTraceAddressMask = 0x03FFFFFF;
+
+#pragma pack(push, 1)
+struct PushBufferTraceFileHeader {
+  char magic[4];
+  uint16_t version;
+  uint16_t header_size;
+};
+
+struct PushBufferTraceRecordHeader {
+  uint8_t type;
+  uint32_t size;
+};
+
+struct PushBufferTraceBindSubchannel {
+  uint32_t subchannel;
+  uint32_t object_class;
+};
+
+struct PushBufferTraceMemoryRegion {
+  uint32_t kind;
+  uint32_t address;
+  uint32_t size;
+};
+
+struct PushBufferTraceMemoryData {
+  uint32_t address;
+};
+#pragma pack(pop)
+
+// Accessors for the fields of an NV2A push buffer method header.
+inline uint32_t TraceCommandMethod(uint32_t header) { return header & 0x1FFC; }
+inline uint32_t TraceCommandSubchannel(uint32_t header) { return (header >> 13) & 0x07; }
+inline uint32_t TraceCommandCount(uint32_t header) { return (header >> 18) & 0x7FF; }
+inline bool TraceCommandIsNonIncreasing(uint32_t header) { return (header & 0x40000000) != 0; }
+// Returns true if the given word is a jump, call or return rather than a method header. These have no parameters.
+inline bool TraceCommandIsControlFlow(uint32_t header) {
+  return (header & 0xE0000003) == 0x20000000 || (header & 0x03) == 0x01 || (header & 0x03) == 0x02 ||
+         header == 0x00020000;
+}
+
+// Writes a push buffer trace to disk. Records are staged in a fixed size buffer so memory use is bounded regardless of
+// the length of the trace, and consecutive command records are merged.
+class PushBufferTraceWriter {
+ public:
+  PushBufferTraceWriter() = default;
+  ~PushBufferTraceWriter();
+
+  bool Open(const char *path);
+  void Close();
+  bool IsOpen() const { return file_ != nullptr; }
+
+  void WriteCommands(const uint32_t *commands, uint32_t num_dwords);
+  void WriteRecord(PushBufferTraceRecordType type, const void *payload = nullptr, uint32_t size = 0);
+  // Writes a record whose payload is a fixed size `header` immediately followed by `size` bytes of `data`.
+  void WriteRecord(PushBufferTraceRecordType type, const void *header, uint32_t header_size, const void *data,
+                   uint32_t size);
+
+  // Writes any staged records to the file.
+  void Flush();
+
+ private:
+  void Stage(const void *data, uint32_t size);
+
+ private:
+  static constexpr uint32_t kStagingBufferSize = 32 * 1024;
+
+  FILE *file_{nullptr};
+  uint8_t staging_buffer_[kStagingBufferSize];
+  uint32_t staged_bytes_{0};
+
+  // Offset into staging_buffer_ of the header of a command record that may still be extended, or kNoOpenRecord.
+  static constexpr uint32_t kNoOpenRecord = 0xFFFFFFFF;
+  uint32_t open_commands_record_{kNoOpenRecord};
+};
+
+// Reads a push buffer trace from disk one record at a time. Payloads are only read on request, into caller provided
+// buffers, so traces of any length can be processed with a fixed amount of memory.
+class PushBufferTraceReader {
+ public:
+  PushBufferTraceReader() = default;
+  ~PushBufferTraceReader();
+
+  // Opens the given file, returning false if it cannot be read or is not a push buffer trace.
+  bool Open(const char *path);
+  void Close();
+  bool IsOpen() const { return file_ != nullptr; }
+
+  // Returns to the first record of the trace.
+  bool Rewind();
+
+  // Advances to the next record, discarding any unread payload of the current one. Returns false at the end of the
+  // trace or if the trace is truncated.
+  bool NextRecord(PushBufferTraceRecordType &type, uint32_t &size);
+
+  // Reads up to `max_size` bytes of the unread payload of the current record, returning the number of bytes read.
+  uint32_t ReadPayload(void *buffer, uint32_t max_size);
+  uint32_t GetRemainingPayload() const { return remaining_payload_; }
+
+ private:
+  FILE *file_{nullptr};
+  long first_record_{0};
+  uint32_t remaining_payload_{0};
+};
+
+#endif  // NXDK_PGRAPH_TESTS_PUSHBUFFER_TRACE_H
@@ -0,0 +1,130 @@
+#include "pushbuffer_writer.h"
+
+#include <pbkit/pbkit.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "debug_output.h"
+#include "pbkit_ext.h"
+
+const uint32_t *PushBufferWriter::high_water_base_ = nullptr;
+uint32_t PushBufferWriter::high_water_mark_ = 0;
+
+void PushBufferWriter::Flush() {
+  if (!span_start_) {
+    return;
+  }
+
+  pb_end(p_);
+  UpdateHighWaterMark(p_);
+  span_start_ = nullptr;
+  p_ = nullptr;
+}
+
+uint32_t PushBufferWriter::GetRemaining() const {
+  if (!span_start_) {
+    return kMaxSpanDWORDs;
+  }
+  return kMaxSpanDWORDs - static_cast<uint32_t>(p_ - span_start_);
+}
+
+uint32_t *PushBufferWriter::Reserve(uint32_t num_dwords) {
+  ASSERT(num_dwords <= kMaxSpanDWORDs && "Packet exceeds the maximum push buffer span size.");
+  if (span_start_ && GetRemaining() < num_dwords) {
+    Flush();
+  }
+
+  if (!span_start_) {
+    span_start_ = pb_begin();
+    p_ = span_start_;
+  }
+  return p_;
+}
+
+uint32_t PushBufferWriter::ReservePacketParams(uint32_t granularity) {
+  ASSERT(granularity && granularity <= kMaxPacketParams && "Invalid packet granularity.");
+  Reserve(granularity + 1);
+
+  const uint32_t available = std::min(GetRemaining() - 1, kMaxPacketParams);
+  return available - available % granularity;
+}
+
+uint32_t *PushBufferWriter::BeginPacket(uint32_t method, uint32_t count) {
+  Reserve(count + 1);
+  pb_push_to(SUBCH_3D, p_++, method, count);
+  ++packet_count_;
+
+  uint32_t *params = p_;
+  p_ += count;
+  return params;
+}
+
+void PushBufferWriter::Push1(uint32_t method, uint32_t a) {
+  p_ = pb_push1(Reserve(2), method, a);
+  ++packet_count_;
+}
+
+void PushBufferWriter::Push2(uint32_t method, uint32_t a, uint32_t b) {
+  p_ = pb_push2(Reserve(3), method, a, b);
+  ++packet_count_;
+}
+
+void PushBufferWriter::Push3(uint32_t method, uint32_t a, uint32_t b, uint32_t c) {
+  p_ = pb_push3(Reserve(4), method, a, b, c);
+  ++packet_count_;
+}
+
+void PushBufferWriter::Push4(uint32_t method, uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+  p_ = pb_push4(Reserve(5), method, a, b, c, d);
+  ++packet_count_;
+}
+
+void PushBufferWriter::Push1f(uint32_t method, float a) {
+  p_ = pb_push1f(Reserve(2), method, a);
+  ++packet_count_;
+}
+
+void PushBufferWriter::Push4f(uint32_t method, float a, float b, float c, float d) {
+  p_ = pb_push4f(Reserve(5), method, a, b, c, d);
+  ++packet_count_;
+}
+
+void PushBufferWriter::PushN(uint32_t method, const uint32_t *values, uint32_t count) {
+  memcpy(BeginPacket(method, count), values, count * sizeof(*values));
+}
+
+void PushBufferWriter::PushRepeated(uint32_t method, const uint32_t *values, uint32_t count, uint32_t granularity) {
+  ASSERT(!(count % granularity) && "Parameter count must be a multiple of the granularity.");
+  while (count) {
+    const uint32_t packet_params = std::min(count, ReservePacketParams(granularity));
+    PushN(method, values, packet_params);
+    values += packet_params;
+    count -= packet_params;
+  }
+}
+
+void PushBufferWriter::ResetHighWaterMark() {
+  // An empty span gives the current write position without emitting any commands.
+  auto p = pb_begin();
+  pb_end(p);
+
+  high_water_base_ = p;
+  high_water_mark_ = 0;
+}
+
+uint32_t PushBufferWriter::GetHighWaterMark() {
+  auto p = pb_begin();
+  pb_end(p);
+  UpdateHighWaterMark(p);
+  return high_water_mark_;
+}
+
+void PushBufferWriter::UpdateHighWaterMark(const uint32_t *span_end) {
+  if (!high_water_base_ || span_end < high_water_base_) {
+    high_water_base_ = span_end;
+    return;
+  }
+
+  high_water_mark_ = std::max(high_water_mark_, static_cast<uint32_t>(span_end - high_water_base_));
+}
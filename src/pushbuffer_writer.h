@@ -0,0 +1,83 @@
+#ifndef NXDK_PGRAPH_TESTS_PUSHBUFFER_WRITER_H
+#define NXDK_PGRAPH_TESTS_PUSHBUFFER_WRITER_H
+
+#include <cstdint>
+
+// Writes packets to the pbkit push buffer, ending the current pb_begin()/pb_end() span and beginning a new one
+// whenever the next packet would not fit. Spans are only ever split between packets, so callers may stream an
+// arbitrary amount of data without placing flushes by hand.
+//
+// The span is opened lazily by the first write and closed by Flush() or when the writer is destroyed.
+//
+// The writer also tracks how far into the push buffer commands have been written since the last
+// ResetHighWaterMark() (TestHost does this in PrepareDraw), which gives the push buffer consumption of each test.
+class PushBufferWriter {
+ public:
+  // Maximum number of DWORDs written between a single pb_begin()/pb_end() pair. pbkit only guarantees this much space
+  // in the push buffer per span (and complains in debug builds if it is exceeded).
+  static constexpr uint32_t kMaxSpanDWORDs = 128;
+  // Maximum number of parameters in a single packet.
+  static constexpr uint32_t kMaxPacketParams = kMaxSpanDWORDs - 1;
+
+ public:
+  PushBufferWriter() = default;
+  ~PushBufferWriter() { Flush(); }
+
+  PushBufferWriter(const PushBufferWriter &) = delete;
+  PushBufferWriter &operator=(const PushBufferWriter &) = delete;
+
+  // Ends the current span, if any.
+  void Flush();
+
+  // Returns the number of DWORDs that may still be written to the current span.
+  uint32_t GetRemaining() const;
+
+  // Ensures that `num_dwords` DWORDs may be written to the current span, beginning a new one if necessary. Returns the
+  // position of the next write.
+  uint32_t *Reserve(uint32_t num_dwords);
+
+  // Returns the largest multiple of `granularity` parameters that a packet started now may hold, beginning a new span
+  // if the current one cannot hold at least `granularity`.
+  uint32_t ReservePacketParams(uint32_t granularity = 1);
+
+  // Writes the header of a packet of `count` parameters to `method` and returns the location that the caller must
+  // fill with exactly `count` parameters.
+  uint32_t *BeginPacket(uint32_t method, uint32_t count);
+
+  void Push1(uint32_t method, uint32_t a);
+  void Push2(uint32_t method, uint32_t a, uint32_t b);
+  void Push3(uint32_t method, uint32_t a, uint32_t b, uint32_t c);
+  void Push4(uint32_t method, uint32_t a, uint32_t b, uint32_t c, uint32_t d);
+  void Push1f(uint32_t method, float a);
+  void Push4f(uint32_t method, float a, float b, float c, float d);
+
+  // Writes a single packet of `count` parameters.
+  void PushN(uint32_t method, const uint32_t *values, uint32_t count);
+
+  // Writes `count` parameters to a non-incrementing method (see NV2A_SUPPRESS_COMMAND_INCREMENT), using as many
+  // packets as needed. Packets are only split at multiples of `granularity` parameters so that, e.g., a vertex is
+  // never divided between NV097_INLINE_ARRAY packets.
+  void PushRepeated(uint32_t method, const uint32_t *values, uint32_t count, uint32_t granularity = 1);
+
+  // Returns the number of packets written by this writer.
+  uint32_t GetPacketCount() const { return packet_count_; }
+
+  // Restarts push buffer consumption tracking from the current push buffer position.
+  static void ResetHighWaterMark();
+  // Returns the largest number of DWORDs between the position recorded by ResetHighWaterMark() and the end of any
+  // span written since. If the push buffer wraps, tracking restarts from the wrapped position.
+  static uint32_t GetHighWaterMark();
+
+ private:
+  static void UpdateHighWaterMark(const uint32_t *span_end);
+
+ private:
+  uint32_t *span_start_{nullptr};
+  uint32_t *p_{nullptr};
+  uint32_t packet_count_{0};
+
+  static const uint32_t *high_water_base_;
+  static uint32_t high_water_mark_;
+};
+
+#endif  // NXDK_PGRAPH_TESTS_PUSHBUFFER_WRITER_H
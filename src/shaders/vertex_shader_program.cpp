@@ -2,38 +2,30 @@
 
 #include <pbkit/pbkit.h>
 
+#include <algorithm>
 #include <memory>
 
 #include "pbkit_ext.h"
+#include "pushbuffer_writer.h"
 
 void VertexShaderProgram::LoadShaderProgram(const uint32_t *shader, uint32_t shader_size) const {
-  uint32_t *p;
-  int i;
-
-  p = pb_begin();
+  PushBufferWriter writer;
 
   // Set run address of shader
-  p = pb_push1(p, NV097_SET_TRANSFORM_PROGRAM_START, 0);
+  writer.Push1(NV097_SET_TRANSFORM_PROGRAM_START, 0);
 
-  p = pb_push1(
-      p, NV097_SET_TRANSFORM_EXECUTION_MODE,
+  writer.Push1(
+      NV097_SET_TRANSFORM_EXECUTION_MODE,
       MASK(NV097_SET_TRANSFORM_EXECUTION_MODE_MODE, NV097_SET_TRANSFORM_EXECUTION_MODE_MODE_PROGRAM) |
           MASK(NV097_SET_TRANSFORM_EXECUTION_MODE_RANGE_MODE, NV097_SET_TRANSFORM_EXECUTION_MODE_RANGE_MODE_PRIV));
 
-  p = pb_push1(p, NV097_SET_TRANSFORM_PROGRAM_CXT_WRITE_EN, 0);
-  pb_end(p);
+  writer.Push1(NV097_SET_TRANSFORM_PROGRAM_CXT_WRITE_EN, 0);
 
   // Set cursor and begin copying program
-  p = pb_begin();
-  p = pb_push1(p, NV097_SET_TRANSFORM_PROGRAM_LOAD, 0);
-  pb_end(p);
-
-  for (i = 0; i < shader_size / 16; i++) {
-    p = pb_begin();
-    pb_push(p++, NV097_SET_TRANSFORM_PROGRAM, 4);
-    memcpy(p, &shader[i * 4], 4 * 4);
-    p += 4;
-    pb_end(p);
+  writer.Push1(NV097_SET_TRANSFORM_PROGRAM_LOAD, 0);
+
+  for (uint32_t i = 0; i < shader_size / 16; i++) {
+    writer.PushN(NV097_SET_TRANSFORM_PROGRAM, &shader[i * 4], 4);
   }
 }
 
@@ -60,28 +52,20 @@ void VertexShaderProgram::PrepareDraw() {
 void VertexShaderProgram::UploadConstants() {
   MergeUniforms();
 
-  auto p = pb_begin();
+  PushBufferWriter writer;
 
   /* Set shader constants cursor at C0 */
-  p = pb_push1(p, NV20_TCL_PRIMITIVE_3D_VP_UPLOAD_CONST_ID, 96 + uniform_start_offset_);
+  writer.Push1(NV20_TCL_PRIMITIVE_3D_VP_UPLOAD_CONST_ID, 96 + uniform_start_offset_);
 
-  uint32_t *uniforms = base_transform_constants_.data();
+  const uint32_t *uniforms = base_transform_constants_.data();
   uint32_t values_remaining = base_transform_constants_.size();
-  while (values_remaining > 16) {
-    pb_push(p++, NV20_TCL_PRIMITIVE_3D_VP_UPLOAD_CONST_X, 16);
-    memcpy(p, uniforms, 16 * 4);
-    uniforms += 16;
-    p += 16;
-    values_remaining -= 16;
-  }
-
-  if (values_remaining) {
-    pb_push(p++, NV20_TCL_PRIMITIVE_3D_VP_UPLOAD_CONST_X, values_remaining);
-    memcpy(p, uniforms, values_remaining * 4);
-    p += values_remaining;
+  while (values_remaining) {
+    const uint32_t count = std::min(values_remaining, 16u);
+    writer.PushN(NV20_TCL_PRIMITIVE_3D_VP_UPLOAD_CONST_X, uniforms, count);
+    uniforms += count;
+    values_remaining -= count;
   }
 
-  pb_end(p);
   uniform_upload_required_ = false;
 }
 
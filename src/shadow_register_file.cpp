@@ -0,0 +1,101 @@
+#include "shadow_register_file.h"
+
+#include <pbkit/pbkit.h>
+
+#include <cstring>
+
+#include "debug_output.h"
+#include "pushbuffer_trace.h"
+
+void ShadowRegisterFile::SetEnabled(bool enabled) {
+  enabled_ = enabled;
+  Invalidate();
+}
+
+void ShadowRegisterFile::Invalidate() { memset(valid_, 0, sizeof(valid_)); }
+
+void ShadowRegisterFile::Invalidate(uint32_t method, uint32_t count) {
+  uint32_t index = method >> 2;
+  ASSERT(index + count <= kNumMethods && "Method out of range of the shadow register file.");
+  for (uint32_t i = index; i < index + count; ++i) {
+    valid_[i >> 5] &= ~(1u << (i & 0x1F));
+  }
+}
+
+void ShadowRegisterFile::Track(const uint32_t *commands, uint32_t num_dwords) {
+  if (!enabled_) {
+    return;
+  }
+
+  uint32_t offset = 0;
+  while (offset < num_dwords) {
+    const uint32_t header = commands[offset++];
+    if (TraceCommandIsControlFlow(header)) {
+      continue;
+    }
+
+    const uint32_t count = TraceCommandCount(header);
+    if (TraceCommandSubchannel(header) != SUBCH_3D) {
+      offset += count;
+      continue;
+    }
+
+    uint32_t index = TraceCommandMethod(header) >> 2;
+    if (TraceCommandIsNonIncreasing(header)) {
+      Invalidate(index << 2);
+    } else {
+      for (uint32_t i = 0; i < count && offset + i < num_dwords && index < kNumMethods; ++i, ++index) {
+        values_[index] = commands[offset + i];
+        valid_[index >> 5] |= 1u << (index & 0x1F);
+      }
+    }
+    offset += count;
+  }
+}
+
+bool ShadowRegisterFile::IsShadowed(uint32_t method, uint32_t value) const {
+  uint32_t index = method >> 2;
+  if (!(valid_[index >> 5] & (1u << (index & 0x1F)))) {
+    return false;
+  }
+  return values_[index] == value;
+}
+
+uint32_t *ShadowRegisterFile::Push1(uint32_t *p, uint32_t method, uint32_t value) {
+  return Push(p, method, &value, 1);
+}
+
+uint32_t *ShadowRegisterFile::Push1f(uint32_t *p, uint32_t method, float value) {
+  return Push(p, method, reinterpret_cast<const uint32_t *>(&value), 1);
+}
+
+uint32_t *ShadowRegisterFile::Push4f(uint32_t *p, uint32_t method, float a, float b, float c, float d) {
+  float values[] = {a, b, c, d};
+  return Push(p, method, reinterpret_cast<const uint32_t *>(values), 4);
+}
+
+uint32_t *ShadowRegisterFile::Push(uint32_t *p, uint32_t method, const uint32_t *values, uint32_t count) {
+  ASSERT((method >> 2) + count <= kNumMethods && "Method out of range of the shadow register file.");
+
+  if (enabled_) {
+    bool redundant = true;
+    for (uint32_t i = 0; i < count && redundant; ++i) {
+      redundant = IsShadowed(method + i * 4, values[i]);
+    }
+
+    if (redundant) {
+      dropped_push_count_ += count;
+      return p;
+    }
+
+    uint32_t index = method >> 2;
+    for (uint32_t i = 0; i < count; ++i, ++index) {
+      values_[index] = values[i];
+      valid_[index >> 5] |= 1u << (index & 0x1F);
+    }
+  }
+
+  pb_push_to(SUBCH_3D, p++, method, count);
+  memcpy(p, values, count * sizeof(*values));
+  return p + count;
+}
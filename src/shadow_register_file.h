@@ -0,0 +1,51 @@
+#ifndef NXDK_PGRAPH_TESTS_SHADOW_REGISTER_FILE_H
+#define NXDK_PGRAPH_TESTS_SHADOW_REGISTER_FILE_H
+
+#include <cstdint>
+
+// Tracks the last value pushed to each NV097 method so that pushes which would not change the hardware state can be
+// dropped.
+//
+// Only pushes made through this class are tracked. Any code that sends a tracked method directly via pb_push* must call
+// Invalidate() afterwards, otherwise a later push of the previous value may be incorrectly dropped.
+class ShadowRegisterFile {
+ public:
+  // NV097 methods occupy 0x0000 - 0x1FFC.
+  static constexpr uint32_t kNumMethods = 0x2000 / 4;
+
+  void SetEnabled(bool enabled = true);
+  bool IsEnabled() const { return enabled_; }
+
+  // Discards all shadowed values so that the next push of every method is sent to the hardware.
+  void Invalidate();
+  // Discards the shadowed value of `count` consecutive methods starting at `method`.
+  void Invalidate(uint32_t method, uint32_t count = 1);
+
+  // Updates the shadowed values from commands that were sent without going through this class (e.g., a replayed
+  // DisplayList). Only parameters of incrementing NV097 packets are tracked; other methods written by the commands are
+  // invalidated.
+  void Track(const uint32_t *commands, uint32_t num_dwords);
+
+  // Pushes `value` to `method` unless the shadowed value is known to be identical.
+  uint32_t *Push1(uint32_t *p, uint32_t method, uint32_t value);
+  uint32_t *Push1f(uint32_t *p, uint32_t method, float value);
+  // Pushes `count` consecutive method values, dropping the entire packet only if every value matches.
+  uint32_t *Push(uint32_t *p, uint32_t method, const uint32_t *values, uint32_t count);
+  uint32_t *Push4f(uint32_t *p, uint32_t method, float a, float b, float c, float d);
+
+  // Returns the number of method pushes that were dropped because they were redundant.
+  uint32_t GetDroppedPushCount() const { return dropped_push_count_; }
+  void ResetDroppedPushCount() { dropped_push_count_ = 0; }
+
+ private:
+  bool IsShadowed(uint32_t method, uint32_t value) const;
+
+ private:
+  bool enabled_{false};
+  uint32_t dropped_push_count_{0};
+
+  uint32_t values_[kNumMethods]{};
+  uint32_t valid_[kNumMethods / 32]{};
+};
+
+#endif  // NXDK_PGRAPH_TESTS_SHADOW_REGISTER_FILE_H
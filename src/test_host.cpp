@@ -13,12 +13,17 @@
 #include <xboxkrnl/xboxkrnl.h>
 
 #include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <utility>
 
 #include "debug_output.h"
+#include "gpu_wait.h"
 #include "math3d.h"
 #include "nxdk_ext.h"
 #include "pbkit_ext.h"
+#include "pushbuffer_recorder.h"
+#include "pushbuffer_writer.h"
 #include "shaders/vertex_shader_program.h"
 #include "vertex_buffer.h"
 
@@ -30,40 +35,57 @@ static void ClearVertexAttribute(uint32_t index);
 static void GetCompositeMatrix(MATRIX result, const MATRIX model_view, const MATRIX projection);
 
 TestHost::TestHost(uint32_t framebuffer_width, uint32_t framebuffer_height, uint32_t max_texture_width,
-                   uint32_t max_texture_height, uint32_t max_texture_depth)
+                   uint32_t max_texture_height, uint32_t max_texture_depth, uint32_t texture_memory_size)
     : framebuffer_width_(framebuffer_width),
       framebuffer_height_(framebuffer_height),
       max_texture_width_(max_texture_width),
       max_texture_height_(max_texture_height),
       max_texture_depth_(max_texture_depth) {
-  // allocate texture memory buffer large enough for all types
+  // Every stage starts with enough memory for a texture of the maximum dimensions in any format.
   uint32_t stride = max_texture_width_ * 4;
   uint32_t texture_size = stride * max_texture_height * max_texture_depth;
-
-  static constexpr uint32_t kMaxPaletteSize = 256 * 4;
-  uint32_t palette_size = kMaxPaletteSize * 4;
+  texture_stage_memory_size_ = texture_size;
 
   static constexpr uint32_t kMaxTextures = 4;
+  uint32_t palette_size = kMaxPaletteSize * kMaxTextures;
   uint32_t total_size = texture_size * kMaxTextures + palette_size;
+  if (texture_memory_size > total_size) {
+    total_size = texture_memory_size;
+  }
 
   texture_memory_ = static_cast<uint8_t *>(
       MmAllocateContiguousMemoryEx(total_size, 0, MAXRAM, 0, PAGE_WRITECOMBINE | PAGE_READWRITE));
   ASSERT(texture_memory_ && "Failed to allocate texture memory.");
+  texture_memory_size_ = total_size;
+  texture_arena_.Initialize(total_size);
+
+  for (auto i = 0; i < kMaxTextures; ++i) {
+    uint32_t texture_offset = texture_arena_.Allocate(texture_size, kTextureMemoryAlignment);
+    ASSERT(texture_offset != TextureArena::kInvalidOffset && "Failed to reserve texture memory.");
+    texture_stage_[i].SetTextureOffset(texture_offset);
+  }
+
+  uint32_t palette_memory_offset = texture_arena_.Allocate(palette_size, kPaletteMemoryAlignment);
+  ASSERT(palette_memory_offset != TextureArena::kInvalidOffset && "Failed to reserve palette memory.");
+  texture_palette_memory_ = texture_memory_ + palette_memory_offset;
 
-  texture_palette_memory_ = texture_memory_ + texture_size;
+  PushBufferRecorder::TrackMemory(kTraceMemoryTexture, texture_memory_, total_size);
+  PushBufferRecorder::TrackMemory(kTraceMemoryPalette, texture_palette_memory_, palette_size);
+
+#ifdef ENABLE_SHADOW_REGISTER_FILE
+  shadow_registers_.SetEnabled();
+#endif
 
   matrix_unit(fixed_function_model_view_matrix_);
   matrix_unit(fixed_function_projection_matrix_);
   matrix_unit(fixed_function_composite_matrix_);
   matrix_unit(fixed_function_inverse_composite_matrix_);
 
-  uint32_t texture_offset = 0;
   uint32_t palette_offset = 0;
-  for (auto i = 0; i < 4; ++i, texture_offset += texture_size, palette_offset += kMaxPaletteSize) {
+  for (auto i = 0; i < kMaxTextures; ++i, palette_offset += kMaxPaletteSize) {
     texture_stage_[i].SetStage(i);
     texture_stage_[i].SetTextureDimensions(max_texture_width, max_texture_height);
     texture_stage_[i].SetImageDimensions(max_texture_width, max_texture_height);
-    texture_stage_[i].SetTextureOffset(texture_offset);
     texture_stage_[i].SetPaletteOffset(palette_offset);
   }
 }
@@ -71,6 +93,8 @@ TestHost::TestHost(uint32_t framebuffer_width, uint32_t framebuffer_height, uint
 TestHost::~TestHost() {
   vertex_buffer_.reset();
   if (texture_memory_) {
+    PushBufferRecorder::UntrackMemory(texture_palette_memory_);
+    PushBufferRecorder::UntrackMemory(texture_memory_);
     MmFreeContiguousMemory(texture_memory_);
   }
   // texture_palette_memory_ is an offset into texture_memory_ and is intentionally not freed.
@@ -124,18 +148,18 @@ void TestHost::SetSurfaceFormat(SurfaceColorFormat color_format, SurfaceZetaForm
   }
 
   auto p = pb_begin();
-  p = pb_push1(p, NV097_SET_SURFACE_FORMAT, value);
+  p = shadow_registers_.Push1(p, NV097_SET_SURFACE_FORMAT, value);
   if (!swizzle) {
-    p = pb_push1(p, NV097_SET_SURFACE_CLIP_HORIZONTAL, (width << 16) + clip_x);
-    p = pb_push1(p, NV097_SET_SURFACE_CLIP_VERTICAL, (height << 16) + clip_y);
+    p = shadow_registers_.Push1(p, NV097_SET_SURFACE_CLIP_HORIZONTAL, (width << 16) + clip_x);
+    p = shadow_registers_.Push1(p, NV097_SET_SURFACE_CLIP_VERTICAL, (height << 16) + clip_y);
   }
   pb_end(p);
 }
 
 void TestHost::SetDepthClip(float min, float max) const {
   auto p = pb_begin();
-  p = pb_push1f(p, NV097_SET_CLIP_MIN, min);
-  p = pb_push1f(p, NV097_SET_CLIP_MAX, max);
+  p = shadow_registers_.Push1f(p, NV097_SET_CLIP_MIN, min);
+  p = shadow_registers_.Push1f(p, NV097_SET_CLIP_MAX, max);
   pb_end(p);
 }
 
@@ -143,6 +167,14 @@ void TestHost::PrepareDraw(uint32_t argb, uint32_t depth_value, uint8_t stencil_
   pb_wait_for_vbl();
   pb_reset();
 
+  PushBufferRecorder::MarkPrepareDraw();
+  PushBufferWriter::ResetHighWaterMark();
+
+  // The menu system retargets the back buffer via pbkit, which modifies the surface state behind the shadow's back.
+  shadow_registers_.Invalidate(NV097_SET_SURFACE_FORMAT);
+  shadow_registers_.Invalidate(NV097_SET_SURFACE_CLIP_HORIZONTAL);
+  shadow_registers_.Invalidate(NV097_SET_SURFACE_CLIP_VERTICAL);
+
   SetupTextureStages();
 
   SetSurfaceFormat(SCF_A8R8G8B8, (SurfaceZetaFormat)depth_buffer_format_, framebuffer_width_, framebuffer_height_,
@@ -175,9 +207,9 @@ void TestHost::PrepareDraw(uint32_t argb, uint32_t depth_value, uint8_t stencil_
     vertex_shader_program_->PrepareDraw();
   }
 
-  while (pb_busy()) {
-    /* Wait for completion... */
-  }
+  // The previous test was completed by FinishDraw, so the remaining commands only touch the surface and test setup may
+  // proceed while they are executed.
+  WAIT_FOR_FENCE(GPUWait::InsertFence());
 }
 
 void TestHost::SetVertexBufferAttributes(uint32_t enabled_fields) {
@@ -186,13 +218,35 @@ void TestHost::SetVertexBufferAttributes(uint32_t enabled_fields) {
     auto p = pb_begin();
     p = pb_push1(p, NV097_BREAK_VERTEX_BUFFER_CACHE, 0);
     pb_end(p);
+    vertex_buffer_->InvalidateDerivedVertices();
     vertex_buffer_->SetCacheValid();
   }
 
-  // FIXME: Linearize on a per-stage basis instead of basing entirely on stage 0.
-  // E.g., if texture unit 0 uses linear and 1 uses swizzle, TEX0 should be linearized, TEX1 should be normalized.
-  bool is_linear = texture_stage_[0].enabled_ && texture_stage_[0].IsLinear();
-  Vertex *vptr = is_linear ? vertex_buffer_->linear_vertex_buffer_ : vertex_buffer_->normalized_vertex_buffer_;
+  if (vertex_buffer_->HasCompactLayout()) {
+    ASSERT(!(enabled_fields & VertexBuffer::kCompactLayoutFields & ~vertex_buffer_->GetCompactLayoutFields()) &&
+           "Enabled attribute is not part of the compact layout of the vertex buffer.");
+    const auto &compact = vertex_buffer_->GetCompactVertices();
+    PushBufferRecorder::TrackMemory(kTraceMemoryVertex, compact.data, vertex_buffer_->num_vertices_ * compact.stride);
+
+    for (uint32_t index = 0; index < 16; ++index) {
+      const auto &attribute = compact.attributes[index];
+      if (!(enabled_fields & (1 << index)) || !attribute.size) {
+        ClearVertexAttribute(index);
+        continue;
+      }
+
+      uint32_t stride = compact.stride;
+      if (vertex_attribute_stride_override_[index] != kNoStrideOverride) {
+        stride = vertex_attribute_stride_override_[index];
+      }
+      SetVertexAttribute(index, attribute.format, attribute.size, stride, compact.data + attribute.offset);
+    }
+    SetLinearTexCoordAttributes(enabled_fields);
+    return;
+  }
+
+  Vertex *vptr = vertex_buffer_->normalized_vertex_buffer_;
+  PushBufferRecorder::TrackMemory(kTraceMemoryVertex, vptr, vertex_buffer_->num_vertices_ * sizeof(Vertex));
 
   auto set = [this, enabled_fields](VertexAttribute attribute, uint32_t attribute_index, uint32_t format, uint32_t size,
                                     const void *data) {
@@ -241,6 +295,36 @@ void TestHost::SetVertexBufferAttributes(uint32_t enabled_fields) {
 
   //  set(V15, NV2A_VERTEX_ATTR_15, NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_F, 4, &vptr[0].v15);
   ClearVertexAttribute(NV2A_VERTEX_ATTR_15);
+
+  SetLinearTexCoordAttributes(enabled_fields);
+}
+
+void TestHost::SetLinearTexCoordAttributes(uint32_t enabled_fields) {
+  // Stages sampling a linear texture take unnormalized coordinates from the vertex buffer's side arrays, all other
+  // stages keep the normalized coordinates set up by SetVertexBufferAttributes.
+  for (uint32_t stage = 0; stage < 4; ++stage) {
+    if (!(enabled_fields & (TEXCOORD0 << stage)) || !texture_stage_[stage].enabled_ ||
+        !texture_stage_[stage].IsLinear()) {
+      continue;
+    }
+
+    const float *texcoords = vertex_buffer_->GetLinearTexCoords(stage);
+    if (!texcoords) {
+      continue;
+    }
+
+    // The side array is bound with the count it was packed with, which must match the count declared for the stage.
+    const uint32_t count = vertex_buffer_->GetLinearTexCoordCount(stage);
+    ASSERT(count == vertex_buffer_->GetTexCoordCount(stage) && "Linear texture coordinates were not re-derived.");
+    const uint32_t index = NV2A_VERTEX_ATTR_TEXTURE0 + stage;
+    PushBufferRecorder::TrackMemory(kTraceMemoryVertex, texcoords, vertex_buffer_->num_vertices_ * count * 4);
+
+    uint32_t stride = count * 4;
+    if (vertex_attribute_stride_override_[index] != kNoStrideOverride) {
+      stride = vertex_attribute_stride_override_[index];
+    }
+    SetVertexAttribute(index, NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_F, count, stride, texcoords);
+  }
 }
 
 void TestHost::DrawArrays(uint32_t enabled_vertex_fields, DrawPrimitive primitive) {
@@ -249,39 +333,79 @@ void TestHost::DrawArrays(uint32_t enabled_vertex_fields, DrawPrimitive primitiv
   }
 
   ASSERT(vertex_buffer_ && "Vertex buffer must be set before calling DrawArrays.");
-  static constexpr int kVerticesPerPush = 120;
+  // The NV097_DRAW_ARRAYS count field holds (count - 1) in 8 bits.
+  static constexpr uint32_t kMaxVerticesPerRange = (NV097_DRAW_ARRAYS_COUNT >> 24) + 1;
 
   SetVertexBufferAttributes(enabled_vertex_fields);
-  int num_vertices = static_cast<int>(vertex_buffer_->num_vertices_);
+  const uint32_t num_vertices = vertex_buffer_->num_vertices_;
 
-  int start = 0;
-  while (start < num_vertices) {
-    int count = std::min(num_vertices - start, kVerticesPerPush);
-
-    auto p = pb_begin();
-    p = pb_push1(p, NV097_SET_BEGIN_END, primitive);
+  // Vertices of list primitives are assembled identically regardless of how the ranges are split, so every range can
+  // be sent within a single SET_BEGIN_END. Other primitives are restarted for each range.
+  const bool is_list = primitive == PRIMITIVE_POINTS || primitive == PRIMITIVE_LINES ||
+                       primitive == PRIMITIVE_TRIANGLES || primitive == PRIMITIVE_QUADS;
 
-    p = pb_push1(p, NV2A_SUPPRESS_COMMAND_INCREMENT(NV097_DRAW_ARRAYS),
-                 MASK(NV097_DRAW_ARRAYS_COUNT, count - 1) | MASK(NV097_DRAW_ARRAYS_START_INDEX, start));
+  PushBufferWriter writer;
+  writer.Push1(NV097_SET_BEGIN_END, primitive);
 
-    p = pb_push1(p, NV097_SET_BEGIN_END, NV097_SET_BEGIN_END_OP_END);
+  uint32_t start = 0;
+  while (start < num_vertices) {
+    uint32_t num_ranges = 1;
+    if (is_list) {
+      num_ranges = (num_vertices - start + kMaxVerticesPerRange - 1) / kMaxVerticesPerRange;
+      num_ranges = std::min(num_ranges, writer.ReservePacketParams());
+    }
 
-    pb_end(p);
+    auto p = writer.BeginPacket(NV2A_SUPPRESS_COMMAND_INCREMENT(NV097_DRAW_ARRAYS), num_ranges);
+    for (uint32_t i = 0; i < num_ranges; ++i) {
+      uint32_t count = std::min(num_vertices - start, kMaxVerticesPerRange);
+      *p++ = MASK(NV097_DRAW_ARRAYS_COUNT, count - 1) | MASK(NV097_DRAW_ARRAYS_START_INDEX, start);
+      start += count;
+    }
 
-    start += count;
+    if (!is_list && start < num_vertices) {
+      writer.Push1(NV097_SET_BEGIN_END, NV097_SET_BEGIN_END_OP_END);
+      writer.Push1(NV097_SET_BEGIN_END, primitive);
+    }
   }
+
+  writer.Push1(NV097_SET_BEGIN_END, NV097_SET_BEGIN_END_OP_END);
+  last_draw_packet_count_ = writer.GetPacketCount();
 }
 
 void TestHost::Begin(DrawPrimitive primitive) const {
-  auto p = pb_begin();
-  p = pb_push1(p, NV097_SET_BEGIN_END, primitive);
-  pb_end(p);
+  ASSERT(!immediate_mode_span_ && "Begin called without a matching End.");
+  immediate_mode_span_start_ = pb_begin();
+  immediate_mode_span_ = pb_push1(immediate_mode_span_start_, NV097_SET_BEGIN_END, primitive);
 }
 
 void TestHost::End() const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push1(p, NV097_SET_BEGIN_END, NV097_SET_BEGIN_END_OP_END);
   pb_end(p);
+  immediate_mode_span_start_ = nullptr;
+  immediate_mode_span_ = nullptr;
+}
+
+uint32_t *TestHost::BeginImmediateModeMethod() const {
+  if (immediate_mode_span_) {
+    return immediate_mode_span_;
+  }
+  return pb_begin();
+}
+
+void TestHost::EndImmediateModeMethod(uint32_t *p, bool vertex_complete) const {
+  if (!immediate_mode_span_) {
+    pb_end(p);
+    return;
+  }
+
+  // Attributes are latched by the next vertex, so the span may only be split once a vertex has been emitted.
+  if (vertex_complete && static_cast<uint32_t>(p - immediate_mode_span_start_) > kMaxImmediateModeSpanDWORDs) {
+    pb_end(p);
+    p = pb_begin();
+    immediate_mode_span_start_ = p;
+  }
+  immediate_mode_span_ = p;
 }
 
 void TestHost::DrawInlineBuffer(uint32_t enabled_vertex_fields, DrawPrimitive primitive) {
@@ -348,355 +472,335 @@ void TestHost::DrawInlineArray(uint32_t enabled_vertex_fields, DrawPrimitive pri
   }
 
   ASSERT(vertex_buffer_ && "Vertex buffer must be set before calling DrawInlineArray.");
-  static constexpr int kElementsPerPush = 64;
 
   SetVertexBufferAttributes(enabled_vertex_fields);
 
-  auto p = pb_begin();
-  p = pb_push1(p, NV097_SET_BEGIN_END, primitive);
+  // Note: Ordering is important and must follow the NV2A_VERTEX_ATTR_POSITION, ... ordering.
+  struct InlineAttribute {
+    uint32_t offset;
+    uint32_t num_dwords;
+  };
+  InlineAttribute attributes[16];
+  uint32_t num_attributes = 0;
+  auto add = [&attributes, &num_attributes](uint32_t offset, uint32_t num_dwords) {
+    attributes[num_attributes++] = {offset, num_dwords};
+  };
 
-  int num_pushed = 0;
-  auto vertex = vertex_buffer_->Lock();
-  for (auto i = 0; i < vertex_buffer_->GetNumVertices(); ++i, ++vertex) {
-    // Note: Ordering is important and must follow the NV2A_VERTEX_ATTR_POSITION, ... ordering.
-    if (enabled_vertex_fields & POSITION) {
-      auto vals = (uint32_t *)vertex->pos;
-      if (vertex_buffer_->position_count_ == 3) {
-        p = pb_push3(p, NV2A_SUPPRESS_COMMAND_INCREMENT(NV097_INLINE_ARRAY), vals[0], vals[1], vals[2]);
-        num_pushed += 3;
-      } else {
-        p = pb_push4(p, NV2A_SUPPRESS_COMMAND_INCREMENT(NV097_INLINE_ARRAY), vals[0], vals[1], vals[2], vals[3]);
-        num_pushed += 4;
-      }
-    }
-    if (enabled_vertex_fields & WEIGHT) {
-      ASSERT(!"WEIGHT not supported");
-    }
-    if (enabled_vertex_fields & NORMAL) {
-      auto vals = (uint32_t *)vertex->normal;
-      p = pb_push3(p, NV2A_SUPPRESS_COMMAND_INCREMENT(NV097_INLINE_ARRAY), vals[0], vals[1], vals[2]);
-      num_pushed += 3;
-    }
-    if (enabled_vertex_fields & DIFFUSE) {
-      // TODO: Enable sending as a DWORD by changing the type and size sent via SetVertexBufferAttributes.
-      auto vals = (uint32_t *)vertex->diffuse;
-      p = pb_push4(p, NV2A_SUPPRESS_COMMAND_INCREMENT(NV097_INLINE_ARRAY), vals[0], vals[1], vals[2], vals[3]);
-      num_pushed += 4;
-    }
-    if (enabled_vertex_fields & SPECULAR) {
-      // TODO: Enable sending as a DWORD by changing the type and size sent via SetVertexBufferAttributes.
-      auto vals = (uint32_t *)vertex->specular;
-      p = pb_push4(p, NV2A_SUPPRESS_COMMAND_INCREMENT(NV097_INLINE_ARRAY), vals[0], vals[1], vals[2], vals[3]);
-      num_pushed += 4;
-    }
-    if (enabled_vertex_fields & FOG_COORD) {
-      ASSERT(!"FOG_COORD not supported");
-    }
-    if (enabled_vertex_fields & POINT_SIZE) {
-      ASSERT(!"POINT_SIZE not supported");
-    }
-    if (enabled_vertex_fields & BACK_DIFFUSE) {
-      ASSERT(!"BACK_DIFFUSE not supported");
-    }
-    if (enabled_vertex_fields & BACK_SPECULAR) {
-      ASSERT(!"BACK_SPECULAR not supported");
-    }
-    if (enabled_vertex_fields & TEXCOORD0) {
-      auto vals = (uint32_t *)vertex->texcoord0;
-      p = pb_push2(p, NV2A_SUPPRESS_COMMAND_INCREMENT(NV097_INLINE_ARRAY), vals[0], vals[1]);
-      num_pushed += 2;
-    }
-    if (enabled_vertex_fields & TEXCOORD1) {
-      auto vals = (uint32_t *)vertex->texcoord1;
-      p = pb_push2(p, NV2A_SUPPRESS_COMMAND_INCREMENT(NV097_INLINE_ARRAY), vals[0], vals[1]);
-      num_pushed += 2;
-    }
-    if (enabled_vertex_fields & TEXCOORD2) {
-      auto vals = (uint32_t *)vertex->texcoord2;
-      p = pb_push2(p, NV2A_SUPPRESS_COMMAND_INCREMENT(NV097_INLINE_ARRAY), vals[0], vals[1]);
-      num_pushed += 2;
-    }
-    if (enabled_vertex_fields & TEXCOORD3) {
-      auto vals = (uint32_t *)vertex->texcoord3;
-      p = pb_push2(p, NV2A_SUPPRESS_COMMAND_INCREMENT(NV097_INLINE_ARRAY), vals[0], vals[1]);
-      num_pushed += 2;
-    }
+  if (enabled_vertex_fields & POSITION) {
+    add(offsetof(Vertex, pos), vertex_buffer_->position_count_ == 3 ? 3 : 4);
+  }
+  if (enabled_vertex_fields & WEIGHT) {
+    ASSERT(!"WEIGHT not supported");
+  }
+  if (enabled_vertex_fields & NORMAL) {
+    add(offsetof(Vertex, normal), 3);
+  }
+  if (enabled_vertex_fields & DIFFUSE) {
+    // TODO: Enable sending as a DWORD by changing the type and size sent via SetVertexBufferAttributes.
+    add(offsetof(Vertex, diffuse), 4);
+  }
+  if (enabled_vertex_fields & SPECULAR) {
+    // TODO: Enable sending as a DWORD by changing the type and size sent via SetVertexBufferAttributes.
+    add(offsetof(Vertex, specular), 4);
+  }
+  if (enabled_vertex_fields & FOG_COORD) {
+    ASSERT(!"FOG_COORD not supported");
+  }
+  if (enabled_vertex_fields & POINT_SIZE) {
+    ASSERT(!"POINT_SIZE not supported");
+  }
+  if (enabled_vertex_fields & BACK_DIFFUSE) {
+    ASSERT(!"BACK_DIFFUSE not supported");
+  }
+  if (enabled_vertex_fields & BACK_SPECULAR) {
+    ASSERT(!"BACK_SPECULAR not supported");
+  }
+  if (enabled_vertex_fields & TEXCOORD0) {
+    add(offsetof(Vertex, texcoord0), 2);
+  }
+  if (enabled_vertex_fields & TEXCOORD1) {
+    add(offsetof(Vertex, texcoord1), 2);
+  }
+  if (enabled_vertex_fields & TEXCOORD2) {
+    add(offsetof(Vertex, texcoord2), 2);
+  }
+  if (enabled_vertex_fields & TEXCOORD3) {
+    add(offsetof(Vertex, texcoord3), 2);
+  }
 
-    if (num_pushed > kElementsPerPush) {
-      pb_end(p);
-      p = pb_begin();
-      num_pushed = 0;
+  // Vertices in a compact layout are sent in the encodings declared by SetVertexBufferAttributes.
+  auto vertex = reinterpret_cast<const uint8_t *>(vertex_buffer_->Lock());
+  uint32_t vertex_stride = sizeof(Vertex);
+  if (vertex_buffer_->HasCompactLayout()) {
+    const auto &compact = vertex_buffer_->GetCompactVertices();
+    vertex = compact.data;
+    vertex_stride = compact.stride;
+    num_attributes = 0;
+    for (uint32_t index = 0; index < 16; ++index) {
+      const auto &attribute = compact.attributes[index];
+      if ((enabled_vertex_fields & (1 << index)) && attribute.size) {
+        add(attribute.offset, attribute.bytes / sizeof(uint32_t));
+      }
     }
   }
-  vertex_buffer_->Unlock();
-  vertex_buffer_->SetCacheValid();
-
-  p = pb_push1(p, NV097_SET_BEGIN_END, NV097_SET_BEGIN_END_OP_END);
-  pb_end(p);
-}
 
-void TestHost::DrawInlineElements16(const std::vector<uint32_t> &indices, uint32_t enabled_vertex_fields,
-                                    DrawPrimitive primitive) {
-  if (vertex_shader_program_) {
-    vertex_shader_program_->PrepareDraw();
+  uint32_t dwords_per_vertex = 0;
+  for (uint32_t i = 0; i < num_attributes; ++i) {
+    dwords_per_vertex += attributes[i].num_dwords;
   }
 
-  ASSERT(vertex_buffer_ && "Vertex buffer must be set before calling DrawInlineElements.");
-  static constexpr int kIndicesPerPush = 64;
+  PushBufferWriter writer;
+  writer.Push1(NV097_SET_BEGIN_END, primitive);
 
-  SetVertexBufferAttributes(enabled_vertex_fields);
+  uint32_t vertices_remaining = vertex_buffer_->GetNumVertices();
+  while (vertices_remaining && dwords_per_vertex) {
+    const uint32_t max_vertices = writer.ReservePacketParams(dwords_per_vertex) / dwords_per_vertex;
+    const uint32_t count = std::min(vertices_remaining, max_vertices);
+    auto p = writer.BeginPacket(NV2A_SUPPRESS_COMMAND_INCREMENT(NV097_INLINE_ARRAY), count * dwords_per_vertex);
 
-  auto p = pb_begin();
-  p = pb_push1(p, NV097_SET_BEGIN_END, primitive);
-
-  ASSERT(indices.size() < 0x7FFFFFFF);
-  int indices_remaining = static_cast<int>(indices.size());
-  int num_pushed = 0;
-  const uint32_t *next_index = indices.data();
-  while (indices_remaining >= 2) {
-    if (num_pushed++ > kIndicesPerPush) {
-      pb_end(p);
-      p = pb_begin();
-      num_pushed = 0;
+    for (uint32_t i = 0; i < count; ++i, vertex += vertex_stride) {
+      auto data = vertex;
+      for (uint32_t attribute = 0; attribute < num_attributes; ++attribute) {
+        memcpy(p, data + attributes[attribute].offset, attributes[attribute].num_dwords * sizeof(uint32_t));
+        p += attributes[attribute].num_dwords;
+      }
     }
-
-    uint32_t index_pair = *next_index++ & 0xFFFF;
-    index_pair += *next_index++ << 16;
-
-    p = pb_push1(p, NV097_ARRAY_ELEMENT16, index_pair);
-
-    indices_remaining -= 2;
+    vertices_remaining -= count;
   }
+  vertex_buffer_->Unlock();
+  vertex_buffer_->SetCacheValid();
 
-  if (indices_remaining) {
-    p = pb_push1(p, NV097_ARRAY_ELEMENT32, *next_index);
-  }
+  writer.Push1(NV097_SET_BEGIN_END, NV097_SET_BEGIN_END_OP_END);
+  last_draw_packet_count_ = writer.GetPacketCount();
+}
 
-  p = pb_push1(p, NV097_SET_BEGIN_END, NV097_SET_BEGIN_END_OP_END);
-  pb_end(p);
+void TestHost::DrawInlineElements16(const std::vector<uint32_t> &indices, uint32_t enabled_vertex_fields,
+                                    DrawPrimitive primitive) {
+  DrawInlineElements(IndexBuffer(indices, IndexBuffer::FORMAT_16), enabled_vertex_fields, primitive);
 }
 
 void TestHost::DrawInlineElements32(const std::vector<uint32_t> &indices, uint32_t enabled_vertex_fields,
                                     DrawPrimitive primitive) {
+  DrawInlineElements(IndexBuffer(indices, IndexBuffer::FORMAT_32), enabled_vertex_fields, primitive);
+}
+
+void TestHost::DrawInlineElements(const IndexBuffer &indices, uint32_t enabled_vertex_fields,
+                                  DrawPrimitive primitive) {
   if (vertex_shader_program_) {
     vertex_shader_program_->PrepareDraw();
   }
 
-  ASSERT(vertex_buffer_ && "Vertex buffer must be set before calling DrawInlineElementsForce32.");
-  static constexpr int kIndicesPerPush = 64;
+  ASSERT(vertex_buffer_ && "Vertex buffer must be set before calling DrawInlineElements.");
 
   SetVertexBufferAttributes(enabled_vertex_fields);
 
-  auto p = pb_begin();
-  p = pb_push1(p, NV097_SET_BEGIN_END, primitive);
-
-  int num_pushed = 0;
-  for (auto index : indices) {
-    if (num_pushed++ > kIndicesPerPush) {
-      pb_end(p);
-      p = pb_begin();
-      num_pushed = 0;
-    }
+  const uint32_t method =
+      NV2A_SUPPRESS_COMMAND_INCREMENT(indices.Is16Bit() ? NV097_ARRAY_ELEMENT16 : NV097_ARRAY_ELEMENT32);
+
+  PushBufferWriter writer;
+  writer.Push1(NV097_SET_BEGIN_END, primitive);
+  writer.PushRepeated(method, indices.GetPackedIndices(), indices.GetNumPackedIndices());
 
-    p = pb_push1(p, NV097_ARRAY_ELEMENT32, index);
+  if (indices.HasTrailingIndex()) {
+    writer.Push1(NV097_ARRAY_ELEMENT32, indices.GetTrailingIndex());
   }
 
-  p = pb_push1(p, NV097_SET_BEGIN_END, NV097_SET_BEGIN_END_OP_END);
-  pb_end(p);
+  writer.Push1(NV097_SET_BEGIN_END, NV097_SET_BEGIN_END_OP_END);
+  last_draw_packet_count_ = writer.GetPacketCount();
 }
 
 void TestHost::SetVertex(float x, float y, float z) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push3f(p, NV097_SET_VERTEX3F, x, y, z);
-  pb_end(p);
+  EndImmediateModeMethod(p, true);
 }
 
 void TestHost::SetVertex(float x, float y, float z, float w) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push4f(p, NV097_SET_VERTEX4F, x, y, z, w);
-  pb_end(p);
+  EndImmediateModeMethod(p, true);
 }
 
 void TestHost::SetWeight(float w1, float w2, float w3, float w4) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push4f(p, NV097_SET_WEIGHT4F, w1, w2, w3, w4);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetWeight(float w) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push1f(p, NV097_SET_WEIGHT1F, w);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetNormal(float x, float y, float z) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push3(p, NV097_SET_NORMAL3F, *(uint32_t *)&x, *(uint32_t *)&y, *(uint32_t *)&z);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetNormal3S(int x, int y, int z) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   uint32_t xy = (x & 0xFFFF) | y << 16;
   uint32_t z0 = z & 0xFFFF;
   p = pb_push2(p, NV097_SET_NORMAL3S, xy, z0);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetDiffuse(float r, float g, float b, float a) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push4f(p, NV097_SET_DIFFUSE_COLOR4F, r, g, b, a);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetDiffuse(float r, float g, float b) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push3f(p, NV097_SET_DIFFUSE_COLOR3F, r, g, b);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetDiffuse(uint32_t color) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push1(p, NV097_SET_DIFFUSE_COLOR4I, color);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetSpecular(float r, float g, float b, float a) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push4f(p, NV097_SET_SPECULAR_COLOR4F, r, g, b, a);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetSpecular(float r, float g, float b) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push3f(p, NV097_SET_SPECULAR_COLOR3F, r, g, b);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetSpecular(uint32_t color) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push1(p, NV097_SET_SPECULAR_COLOR4I, color);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetFogCoord(float fc) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push1f(p, NV097_SET_FOG_COORD, fc);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetPointSize(float ps) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push1f(p, NV097_SET_POINT_SIZE, ps);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetTexCoord0(float u, float v) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push2(p, NV097_SET_TEXCOORD0_2F, *(uint32_t *)&u, *(uint32_t *)&v);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetTexCoord0S(int u, int v) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   uint32_t uv = (u & 0xFFFF) | (v << 16);
   p = pb_push1(p, NV097_SET_TEXCOORD0_2S, uv);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetTexCoord0(float s, float t, float p, float q) const {
-  auto pb = pb_begin();
+  auto pb = BeginImmediateModeMethod();
   pb = pb_push4f(pb, NV097_SET_TEXCOORD0_4F, s, t, p, q);
-  pb_end(pb);
+  EndImmediateModeMethod(pb);
 }
 
 void TestHost::SetTexCoord0S(int s, int t, int p, int q) const {
-  auto pb = pb_begin();
+  auto pb = BeginImmediateModeMethod();
   uint32_t st = (s & 0xFFFF) | (t << 16);
   uint32_t pq = (p & 0xFFFF) | (q << 16);
   pb = pb_push2(pb, NV097_SET_TEXCOORD0_4S, st, pq);
-  pb_end(pb);
+  EndImmediateModeMethod(pb);
 }
 
 void TestHost::SetTexCoord1(float u, float v) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push2(p, NV097_SET_TEXCOORD1_2F, *(uint32_t *)&u, *(uint32_t *)&v);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetTexCoord1S(int u, int v) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   uint32_t uv = (u & 0xFFFF) | (v << 16);
   p = pb_push1(p, NV097_SET_TEXCOORD1_2S, uv);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetTexCoord1(float s, float t, float p, float q) const {
-  auto pb = pb_begin();
+  auto pb = BeginImmediateModeMethod();
   pb = pb_push4f(pb, NV097_SET_TEXCOORD1_4F, s, t, p, q);
-  pb_end(pb);
+  EndImmediateModeMethod(pb);
 }
 
 void TestHost::SetTexCoord1S(int s, int t, int p, int q) const {
-  auto pb = pb_begin();
+  auto pb = BeginImmediateModeMethod();
   uint32_t st = (s & 0xFFFF) | (t << 16);
   uint32_t pq = (p & 0xFFFF) | (q << 16);
   pb = pb_push2(pb, NV097_SET_TEXCOORD1_4S, st, pq);
-  pb_end(pb);
+  EndImmediateModeMethod(pb);
 }
 
 void TestHost::SetTexCoord2(float u, float v) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push2f(p, NV097_SET_TEXCOORD2_2F, u, v);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetTexCoord2S(int u, int v) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   uint32_t uv = (u & 0xFFFF) | (v << 16);
   p = pb_push1(p, NV097_SET_TEXCOORD2_2S, uv);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetTexCoord2(float s, float t, float p, float q) const {
-  auto pb = pb_begin();
+  auto pb = BeginImmediateModeMethod();
   pb = pb_push4f(pb, NV097_SET_TEXCOORD2_4F, s, t, p, q);
-  pb_end(pb);
+  EndImmediateModeMethod(pb);
 }
 
 void TestHost::SetTexCoord2S(int s, int t, int p, int q) const {
-  auto pb = pb_begin();
+  auto pb = BeginImmediateModeMethod();
   uint32_t st = (s & 0xFFFF) | (t << 16);
   uint32_t pq = (p & 0xFFFF) | (q << 16);
   pb = pb_push2(pb, NV097_SET_TEXCOORD2_4S, st, pq);
-  pb_end(pb);
+  EndImmediateModeMethod(pb);
 }
 
 void TestHost::SetTexCoord3(float u, float v) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   p = pb_push2(p, NV097_SET_TEXCOORD3_2F, *(uint32_t *)&u, *(uint32_t *)&v);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetTexCoord3S(int u, int v) const {
-  auto p = pb_begin();
+  auto p = BeginImmediateModeMethod();
   uint32_t uv = (u & 0xFFFF) | (v << 16);
   p = pb_push1(p, NV097_SET_TEXCOORD3_2S, uv);
-  pb_end(p);
+  EndImmediateModeMethod(p);
 }
 
 void TestHost::SetTexCoord3(float s, float t, float p, float q) const {
-  auto pb = pb_begin();
+  auto pb = BeginImmediateModeMethod();
   pb = pb_push4f(pb, NV097_SET_TEXCOORD3_4F, s, t, p, q);
-  pb_end(pb);
+  EndImmediateModeMethod(pb);
 }
 
 void TestHost::SetTexCoord3S(int s, int t, int p, int q) const {
-  auto pb = pb_begin();
+  auto pb = BeginImmediateModeMethod();
   uint32_t st = (s & 0xFFFF) | (t << 16);
   uint32_t pq = (p & 0xFFFF) | (q << 16);
   pb = pb_push2(pb, NV097_SET_TEXCOORD3_4S, st, pq);
-  pb_end(pb);
+  EndImmediateModeMethod(pb);
 }
 
 void TestHost::EnsureFolderExists(const std::string &folder_path) {
@@ -852,7 +956,7 @@ void TestHost::SetupTextureStages() const {
   auto texture_dma_offset = reinterpret_cast<uint32_t>(texture_memory_);
   auto palette_dma_offset = reinterpret_cast<uint32_t>(texture_palette_memory_);
   for (auto &stage : texture_stage_) {
-    stage.Commit(texture_dma_offset, palette_dma_offset);
+    stage.Commit(texture_dma_offset, palette_dma_offset, shadow_registers_);
   }
 }
 
@@ -892,41 +996,237 @@ void TestHost::SetDepthBufferFloatMode(bool enabled) {
 }
 
 int TestHost::SetTexture(SDL_Surface *surface, uint32_t stage) {
-  return texture_stage_[stage].SetTexture(surface, texture_memory_);
+  const TextureStage &texture_stage = texture_stage_[stage];
+  const TextureFormatInfo &format = texture_stage.GetFormat();
+  const TextureUploadCache::SourceRows source{
+      static_cast<const uint8_t *>(surface->pixels), static_cast<uint32_t>(surface->w * surface->format->BytesPerPixel),
+      static_cast<uint32_t>(surface->h), static_cast<uint32_t>(surface->pitch)};
+  const TextureUploadCache::Key key{
+      TextureUploadCache::UPLOAD_SURFACE,
+      format.xbox_format,
+      surface->format->format,
+      static_cast<uint32_t>(surface->w),
+      static_cast<uint32_t>(surface->h),
+      1,
+      static_cast<uint32_t>(surface->pitch),
+      surface->format->BytesPerPixel,
+      format.xbox_swizzled,
+      texture_stage.GetMipmapLevels(),
+      texture_stage.GetMipmapFilter()};
+  if (texture_upload_cache_.Lookup(stage, key, &source)) {
+    return 0;
+  }
+
+  int ret = ReserveTextureMemory(stage, texture_stage.GetTextureSize(surface->w, surface->h));
+  if (ret) {
+    return ret;
+  }
+
+  ret = texture_stage_[stage].SetTexture(surface, texture_memory_);
+  if (!ret) {
+    texture_upload_cache_.Store(stage, key, &source);
+  }
+  return ret;
 }
 
 int TestHost::SetVolumetricTexture(const SDL_Surface **surface, uint32_t depth, uint32_t stage) {
-  return texture_stage_[stage].SetVolumetricTexture(surface, depth, texture_memory_);
+  const TextureStage &texture_stage = texture_stage_[stage];
+  const TextureFormatInfo &format = texture_stage.GetFormat();
+  const SDL_Surface *first_layer = surface[0];
+  std::vector<TextureUploadCache::SourceRows> sources(depth);
+  for (uint32_t layer = 0; layer < depth; ++layer) {
+    const SDL_Surface *layer_surface = surface[layer];
+    sources[layer] = {static_cast<const uint8_t *>(layer_surface->pixels),
+                      static_cast<uint32_t>(layer_surface->w * layer_surface->format->BytesPerPixel),
+                      static_cast<uint32_t>(layer_surface->h), static_cast<uint32_t>(layer_surface->pitch)};
+  }
+  const TextureUploadCache::Key key{TextureUploadCache::UPLOAD_VOLUMETRIC,
+                                    format.xbox_format,
+                                    first_layer->format->format,
+                                    static_cast<uint32_t>(first_layer->w),
+                                    static_cast<uint32_t>(first_layer->h),
+                                    depth,
+                                    static_cast<uint32_t>(first_layer->pitch),
+                                    first_layer->format->BytesPerPixel,
+                                    format.xbox_swizzled,
+                                    texture_stage.GetMipmapLevels(),
+                                    texture_stage.GetMipmapFilter()};
+  if (texture_upload_cache_.Lookup(stage, key, sources.data(), depth)) {
+    return 0;
+  }
+
+  int ret = ReserveTextureMemory(stage, texture_stage.GetTextureSize(first_layer->w, first_layer->h, depth));
+  if (ret) {
+    return ret;
+  }
+
+  ret = texture_stage_[stage].SetVolumetricTexture(surface, depth, texture_memory_);
+  if (!ret) {
+    texture_upload_cache_.Store(stage, key, sources.data(), depth);
+  }
+  return ret;
+}
+
+int TestHost::SetVolumetricTexture(uint32_t width, uint32_t height, uint32_t depth,
+                                   const TextureStage::VolumeSliceGenerator &generate, uint32_t stage,
+                                   uint32_t slice_format) {
+  const TextureStage &texture_stage = texture_stage_[stage];
+  int ret = ReserveTextureMemory(stage, texture_stage.GetTextureSize(width, height, depth));
+  if (ret) {
+    return ret;
+  }
+
+  // The content is not known until it has been generated, so whatever the stage held before is simply discarded.
+  texture_upload_cache_.Invalidate(stage);
+  return texture_stage.SetVolumetricTexture(width, height, depth, generate, slice_format, texture_memory_);
+}
+
+int TestHost::SetCubemapTexture(const SDL_Surface **faces, uint32_t stage) {
+  const TextureStage &texture_stage = texture_stage_[stage];
+  const TextureFormatInfo &format = texture_stage.GetFormat();
+  const SDL_Surface *first_face = faces[0];
+  TextureUploadCache::SourceRows sources[TextureStage::CUBEMAP_NUM_FACES];
+  for (uint32_t face = 0; face < TextureStage::CUBEMAP_NUM_FACES; ++face) {
+    const SDL_Surface *face_surface = faces[face];
+    sources[face] = {static_cast<const uint8_t *>(face_surface->pixels),
+                     static_cast<uint32_t>(face_surface->w * face_surface->format->BytesPerPixel),
+                     static_cast<uint32_t>(face_surface->h), static_cast<uint32_t>(face_surface->pitch)};
+  }
+  const TextureUploadCache::Key key{TextureUploadCache::UPLOAD_CUBEMAP,
+                                    format.xbox_format,
+                                    first_face->format->format,
+                                    static_cast<uint32_t>(first_face->w),
+                                    static_cast<uint32_t>(first_face->h),
+                                    1,
+                                    static_cast<uint32_t>(first_face->pitch),
+                                    first_face->format->BytesPerPixel,
+                                    format.xbox_swizzled,
+                                    texture_stage.GetMipmapLevels(),
+                                    texture_stage.GetMipmapFilter()};
+  if (texture_upload_cache_.Lookup(stage, key, sources, TextureStage::CUBEMAP_NUM_FACES)) {
+    return 0;
+  }
+
+  const uint32_t face_size = texture_stage.GetCubemapFaceSize(first_face->w, first_face->h);
+  int ret = ReserveTextureMemory(stage, face_size * TextureStage::CUBEMAP_NUM_FACES);
+  if (ret) {
+    return ret;
+  }
+
+  ret = texture_stage.SetCubemapTexture(faces, texture_memory_);
+  if (!ret) {
+    texture_upload_cache_.Store(stage, key, sources, TextureStage::CUBEMAP_NUM_FACES);
+  }
+  return ret;
 }
 
 int TestHost::SetRawTexture(const uint8_t *source, uint32_t width, uint32_t height, uint32_t depth, uint32_t pitch,
                             uint32_t bytes_per_pixel, bool swizzle, uint32_t stage) {
-  const uint32_t max_stride = max_texture_width_ * 4;
-  const uint32_t max_texture_size = max_stride * max_texture_height_ * max_texture_depth_;
-
   const uint32_t layer_size = pitch * height;
   const uint32_t surface_size = layer_size * depth;
-  ASSERT(surface_size < max_texture_size && "Texture too large.");
 
-  return texture_stage_[stage].SetRawTexture(source, width, height, depth, pitch, bytes_per_pixel, swizzle,
-                                             texture_memory_);
+  // Raw uploads are copied without conversion, so the result does not depend on the stage's format.
+  const TextureUploadCache::SourceRows source_rows{source, surface_size, 1, surface_size};
+  const TextureUploadCache::Key key{TextureUploadCache::UPLOAD_RAW,
+                                    0,
+                                    0,
+                                    width,
+                                    height,
+                                    depth,
+                                    pitch,
+                                    bytes_per_pixel,
+                                    swizzle,
+                                    1,
+                                    0};
+  if (texture_upload_cache_.Lookup(stage, key, &source_rows)) {
+    return 0;
+  }
+
+  int ret = ReserveTextureMemory(stage, surface_size);
+  ASSERT(!ret && "Texture too large.");
+
+  ret = texture_stage_[stage].SetRawTexture(source, width, height, depth, pitch, bytes_per_pixel, swizzle,
+                                            texture_memory_);
+  if (!ret) {
+    texture_upload_cache_.Store(stage, key, &source_rows);
+  }
+  return ret;
 }
 
 int TestHost::SetPalette(const uint32_t *palette, PaletteSize size, uint32_t stage) {
   return texture_stage_[stage].SetPalette(palette, size, texture_palette_memory_);
 }
 
+int TestHost::ReserveTextureMemory(uint32_t stage, uint32_t size) {
+  const uint32_t offset = texture_stage_[stage].GetTextureOffset();
+  const uint32_t reserved_size = texture_arena_.GetAllocationSize(offset);
+  if (size <= reserved_size) {
+    return 0;
+  }
+
+  texture_upload_cache_.Invalidate(stage);
+  texture_arena_.Free(offset);
+  uint32_t new_offset = texture_arena_.Allocate(size, kTextureMemoryAlignment);
+  if (new_offset == TextureArena::kInvalidOffset) {
+    PrintMsg("Failed to reserve %u bytes of texture memory for stage %u (%u free, largest block %u).\n", size, stage,
+             texture_arena_.GetFreeSize(), texture_arena_.GetLargestFreeBlock());
+    // The previous reservation was just released, so there is always room to restore it.
+    new_offset = texture_arena_.Allocate(reserved_size, kTextureMemoryAlignment);
+    texture_stage_[stage].SetTextureOffset(new_offset);
+    return 1;
+  }
+
+  texture_stage_[stage].SetTextureOffset(new_offset);
+  return 0;
+}
+
+void TestHost::ResetTextureStageMemory() {
+  bool resized[TextureUploadCache::kNumStages]{};
+  for (uint32_t stage = 0; stage < TextureUploadCache::kNumStages; ++stage) {
+    const uint32_t offset = texture_stage_[stage].GetTextureOffset();
+    if (texture_arena_.GetAllocationSize(offset) != texture_stage_memory_size_) {
+      texture_arena_.Free(offset);
+      resized[stage] = true;
+    }
+  }
+
+  for (uint32_t stage = 0; stage < TextureUploadCache::kNumStages; ++stage) {
+    if (!resized[stage]) {
+      continue;
+    }
+    texture_upload_cache_.Invalidate(stage);
+    uint32_t offset = texture_arena_.Allocate(texture_stage_memory_size_, kTextureMemoryAlignment);
+    ASSERT(offset != TextureArena::kInvalidOffset && "Failed to restore texture memory reservation.");
+    texture_stage_[stage].SetTextureOffset(offset);
+  }
+}
+
+uint8_t *TestHost::AllocateTextureMemory(uint32_t size, uint32_t alignment) {
+  uint32_t offset = texture_arena_.Allocate(size, alignment);
+  if (offset == TextureArena::kInvalidOffset) {
+    return nullptr;
+  }
+  return texture_memory_ + offset;
+}
+
+void TestHost::FreeTextureMemory(uint8_t *memory) {
+  if (memory) {
+    texture_arena_.Free(memory - texture_memory_);
+  }
+}
+
 void TestHost::FinishDraw(bool allow_saving, const std::string &output_directory, const std::string &name,
                           const std::string &z_buffer_name) {
+  PushBufferRecorder::MarkFinishDraw(output_directory, name);
+  push_buffer_high_water_mark_ = PushBufferWriter::GetHighWaterMark();
+
   bool perform_save = allow_saving && save_results_;
   if (!perform_save) {
     pb_printat(0, 55, (char *)"ns");
     pb_draw_text_screen();
   }
 
-  while (pb_busy()) {
-    /* Wait for completion... */
-  }
+  WAIT_FOR_GPU_IDLE();
 
   if (perform_save) {
     // TODO: See why waiting for tiles to be non-busy results in the screen not updating anymore.
@@ -941,9 +1241,42 @@ void TestHost::FinishDraw(bool allow_saving, const std::string &output_directory
   }
 
   /* Swap buffers (if we can) */
-  while (pb_finished()) {
-    /* Not ready to swap yet */
+  WAIT_FOR_FLIP();
+
+  GPUWait::PrintReport(name);
+}
+
+void TestHost::BeginDisplayList() {
+  ASSERT(!display_list_start_ && "BeginDisplayList called while already recording.");
+
+  // The list must contain every state push regardless of what was sent before recording started.
+  shadow_registers_.Invalidate();
+
+  display_list_start_ = pb_begin();
+  pb_end(display_list_start_);
+}
+
+bool TestHost::EndDisplayList(DisplayList &list) {
+  ASSERT(display_list_start_ && "EndDisplayList called without BeginDisplayList.");
+
+  auto end = pb_begin();
+  pb_end(end);
+
+  auto start = display_list_start_;
+  display_list_start_ = nullptr;
+
+  if (end < start) {
+    PrintMsg("Push buffer wrapped while recording display list.\n");
+    list.Clear();
+    return false;
   }
+
+  return list.Assign(start, end);
+}
+
+void TestHost::CallDisplayList(const DisplayList &list) const {
+  list.Replay();
+  shadow_registers_.Track(list.GetCommands(), list.GetSize());
 }
 
 void TestHost::SetVertexShaderProgram(std::shared_ptr<VertexShaderProgram> program) {
@@ -1150,6 +1483,39 @@ void TestHost::SetFixedFunctionProjectionMatrix(const MATRIX projection_matrix)
   fixed_function_matrix_mode_ = MATRIX_MODE_USER;
 }
 
+void TestHost::SetDefaultMaterial(uint32_t color_material, const Color &scene_ambient) {
+  auto p = pb_begin();
+  p = pb_push1(p, NV097_SET_SPECULAR_PARAMS, 0xBF34DCE5);       // -0.706496
+  p = pb_push1(p, NV097_SET_SPECULAR_PARAMS + 4, 0xC020743F);   // -2.5071
+  p = pb_push1(p, NV097_SET_SPECULAR_PARAMS + 8, 0x40333D06);   // 2.8006
+  p = pb_push1(p, NV097_SET_SPECULAR_PARAMS + 12, 0xBF003612);  // -0.500825
+  p = pb_push1(p, NV097_SET_SPECULAR_PARAMS + 16, 0xBFF852A5);  // -1.94002
+  p = pb_push1(p, NV097_SET_SPECULAR_PARAMS + 20, 0x401C1BCE);  // 2.4392
+
+  p = pb_push1(p, NV097_SET_COLOR_MATERIAL, color_material);
+  p = pb_push3f(p, NV097_SET_SCENE_AMBIENT_COLOR, scene_ambient.r, scene_ambient.g, scene_ambient.b);
+  p = pb_push3(p, NV097_SET_MATERIAL_EMISSION, 0x0, 0x0, 0x0);
+  p = pb_push1f(p, NV097_SET_MATERIAL_ALPHA, 1.0f);
+  pb_end(p);
+}
+
+void TestHost::SetInfiniteLight(uint32_t light_index, float direction_x, float direction_y, float direction_z,
+                                const Color &diffuse) {
+  // Each light's methods are offset from the previous light's by this many bytes.
+  static constexpr uint32_t kLightMethodStride = 128;
+  ASSERT(light_index < 8 && "Only 8 lights are supported.");
+  const uint32_t offset = light_index * kLightMethodStride;
+
+  auto p = pb_begin();
+  p = pb_push3(p, NV097_SET_LIGHT_AMBIENT_COLOR + offset, 0, 0, 0);
+  p = pb_push3f(p, NV097_SET_LIGHT_DIFFUSE_COLOR + offset, diffuse.r, diffuse.g, diffuse.b);
+  p = pb_push3(p, NV097_SET_LIGHT_SPECULAR_COLOR + offset, 0, 0, 0);
+  p = pb_push1(p, NV097_SET_LIGHT_LOCAL_RANGE + offset, 0x7149F2CA);  // 1e30
+  p = pb_push3(p, NV097_SET_LIGHT_INFINITE_HALF_VECTOR + offset, 0, 0, 0);
+  p = pb_push3f(p, NV097_SET_LIGHT_INFINITE_DIRECTION + offset, direction_x, direction_y, direction_z);
+  pb_end(p);
+}
+
 void TestHost::SetTextureStageEnabled(uint32_t stage, bool enabled) {
   ASSERT(stage < 4 && "Only 4 texture stages are supported.");
   texture_stage_[stage].SetEnabled(enabled);
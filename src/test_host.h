@@ -7,11 +7,16 @@
 #include <cstdint>
 #include <memory>
 
+#include "display_list.h"
+#include "index_buffer.h"
 #include "math3d.h"
 #include "nxdk_ext.h"
+#include "shadow_register_file.h"
 #include "string"
+#include "texture_arena.h"
 #include "texture_format.h"
 #include "texture_stage.h"
+#include "texture_upload_cache.h"
 #include "vertex_buffer.h"
 
 class VertexShaderProgram;
@@ -226,8 +231,12 @@ class TestHost {
   };
 
  public:
+  // Each texture stage initially reserves enough texture memory for a 32-bit texture of max_texture_width x
+  // max_texture_height x max_texture_depth. Larger textures are given more memory on demand, up to a total of
+  // `texture_memory_size` bytes shared by every stage, palette and render target. 0 allocates just enough for the
+  // initial reservations.
   TestHost(uint32_t framebuffer_width, uint32_t framebuffer_height, uint32_t max_texture_width,
-           uint32_t max_texture_height, uint32_t max_texture_depth = 4);
+           uint32_t max_texture_height, uint32_t max_texture_depth = 4, uint32_t texture_memory_size = 0);
   ~TestHost();
 
   TextureStage &GetTextureStage(uint32_t stage) { return texture_stage_[stage]; }
@@ -235,6 +244,15 @@ class TestHost {
   void SetDefaultTextureParams(uint32_t stage = 0);
   int SetTexture(SDL_Surface *surface, uint32_t stage = 0);
   int SetVolumetricTexture(const SDL_Surface **surface, uint32_t depth, uint32_t stage = 0);
+  // Uploads a `width` x `height` x `depth` volumetric texture one slice at a time. Each slice is produced by `generate`
+  // into a surface of `slice_format` that is reused for every slice, so only a single slice is held in memory at once.
+  // Generated textures bypass the upload cache.
+  int SetVolumetricTexture(uint32_t width, uint32_t height, uint32_t depth,
+                           const TextureStage::VolumeSliceGenerator &generate, uint32_t stage = 0,
+                           uint32_t slice_format = SDL_PIXELFORMAT_RGBA8888);
+  // Uploads TextureStage::CUBEMAP_NUM_FACES square surfaces, in TextureStage::CubemapFace order, as the faces of a
+  // cubemap. The stage must also be configured via TextureStage::SetCubemapEnable.
+  int SetCubemapTexture(const SDL_Surface **faces, uint32_t stage = 0);
   int SetRawTexture(const uint8_t *source, uint32_t width, uint32_t height, uint32_t depth, uint32_t pitch,
                     uint32_t bytes_per_pixel, bool swizzle, uint32_t stage = 0);
 
@@ -252,7 +270,34 @@ class TestHost {
   uint32_t GetMaxTextureHeight() const { return max_texture_height_; }
   uint32_t GetMaxTextureDepth() const { return max_texture_depth_; }
 
-  uint8_t *GetTextureMemory() const { return texture_memory_; }
+  // Callers may write to the returned memory directly (e.g., by rendering into it), so the texture upload cache is
+  // invalidated for every stage whose texture memory may be affected.
+  uint8_t *GetTextureMemory() {
+    texture_upload_cache_.InvalidateAll();
+    return texture_memory_;
+  }
+  uint32_t GetTextureMemorySize() const { return texture_memory_size_; }
+  // Returns the texture memory of the given stage, which holds at least the most recently reserved size.
+  uint8_t *GetTextureStageMemory(uint32_t stage) {
+    texture_upload_cache_.Invalidate(stage);
+    return texture_memory_ + texture_stage_[stage].GetTextureOffset();
+  }
+  uint8_t *GetPaletteMemory() const { return texture_palette_memory_; }
+
+  // Ensures that the given stage has at least `size` bytes of texture memory, moving it elsewhere in the texture memory
+  // arena if necessary. The previous contents are not preserved when the memory is moved. Returns 0 on success.
+  int ReserveTextureMemory(uint32_t stage, uint32_t size);
+  // Returns every stage to its initial reservation so that memory taken by large textures is available to later suites.
+  void ResetTextureStageMemory();
+
+  // Allocates memory for render targets and other buffers that must be visible to the GPU from the texture memory
+  // arena. Returns nullptr if there is not enough contiguous free space.
+  uint8_t *AllocateTextureMemory(uint32_t size, uint32_t alignment = kTextureMemoryAlignment);
+  void FreeTextureMemory(uint8_t *memory);
+
+  TextureArena &GetTextureArena() { return texture_arena_; }
+
+  TextureUploadCache &GetTextureUploadCache() { return texture_upload_cache_; }
 
   inline uint32_t GetFramebufferWidth() const { return framebuffer_width_; }
   inline uint32_t GetFramebufferHeight() const { return framebuffer_height_; }
@@ -284,7 +329,12 @@ class TestHost {
   void DrawInlineArray(uint32_t enabled_vertex_fields = kDefaultVertexFields,
                        DrawPrimitive primitive = PRIMITIVE_TRIANGLES);
 
-  // Sends vertices via an index array. Index values must be < 0xFFFF and are sent two per command.
+  // Sends vertices via a pre-packed index buffer, using NV097_ARRAY_ELEMENT16 for 16-bit buffers and
+  // NV097_ARRAY_ELEMENT32 otherwise. Indices are sent in long non-incrementing runs of the element method.
+  void DrawInlineElements(const IndexBuffer &indices, uint32_t enabled_vertex_fields = kDefaultVertexFields,
+                          DrawPrimitive primitive = PRIMITIVE_TRIANGLES);
+
+  // Sends vertices via an index array. Index values must be < 0xFFFF and are sent two per DWORD.
   void DrawInlineElements16(const std::vector<uint32_t> &indices, uint32_t enabled_vertex_fields = kDefaultVertexFields,
                             DrawPrimitive primitive = PRIMITIVE_TRIANGLES);
 
@@ -295,6 +345,13 @@ class TestHost {
   void FinishDraw(bool allow_saving, const std::string &output_directory, const std::string &name,
                   const std::string &z_buffer_name = "");
 
+  // Returns the number of push buffer packets (including the SET_BEGIN_END pair) emitted by the most recent call to
+  // DrawArrays, DrawInlineArray, or one of the DrawInlineElements variants.
+  uint32_t GetLastDrawPacketCount() const { return last_draw_packet_count_; }
+
+  // Returns the number of push buffer DWORDs consumed between the most recent PrepareDraw and FinishDraw calls.
+  uint32_t GetPushBufferHighWaterMark() const { return push_buffer_high_water_mark_; }
+
   // Set the surface format
   // width and height are treated differently depending on whether swizzle is enabled or not.
   // swizzle = true
@@ -342,8 +399,20 @@ class TestHost {
   inline const float *GetFixedFunctionModelViewMatrix() const { return fixed_function_model_view_matrix_; }
   inline const float *GetFixedFunctionProjectionMatrix() const { return fixed_function_projection_matrix_; }
 
+  // Sets up a fixed function material with no emission and full alpha, using the specular params of a default XDK
+  // material. `color_material` is an NV097_SET_COLOR_MATERIAL value selecting which colors come from the vertex.
+  static void SetDefaultMaterial(uint32_t color_material, const Color &scene_ambient);
+  // Sets up `light_index` as an infinite light shining along the given direction with the given diffuse color and no
+  // ambient or specular contribution. The light must still be enabled via NV097_SET_LIGHT_ENABLE_MASK.
+  static void SetInfiniteLight(uint32_t light_index, float direction_x, float direction_y, float direction_z,
+                               const Color &diffuse);
+
   // Start the process of rendering an inline-defined primitive (specified via SetXXXX methods below).
   // Note that End() must be called to trigger rendering, and that SetVertex() triggers the creation of a vertex.
+  //
+  // Attributes set between Begin() and End() are accumulated into a single push buffer span which is submitted by
+  // End() (or at a vertex boundary once the span exceeds kMaxImmediateModeSpanDWORDs). Callers must not start their own
+  // pb_begin()/pb_end() span until End() has been called.
   void Begin(DrawPrimitive primitive) const;
   void End() const;
 
@@ -498,6 +567,22 @@ class TestHost {
   // in scenes with multiple draws per clear)
   void SetupTextureStages() const;
 
+  // Returns the shadow copy of NV097 state used to drop redundant pushes from PrepareDraw, SetupTextureStages and the
+  // surface setters. The shadow is disabled unless built with ENABLE_SHADOW_REGISTER_FILE.
+  ShadowRegisterFile &GetShadowRegisters() const { return shadow_registers_; }
+  // Forces every shadowed method to be resent on its next push. Must be called by tests that push shadowed methods
+  // directly.
+  void InvalidateShadowRegisters() const { shadow_registers_.Invalidate(); }
+
+  // Captures every command pushed between BeginDisplayList and EndDisplayList (including those pushed by TestHost
+  // helpers) into `list`. The commands are executed as they are recorded. Recording must not span PrepareDraw or
+  // FinishDraw. Returns false if the commands could not be captured (e.g., because the push buffer wrapped), in which
+  // case `list` is cleared and the recording should be retried later.
+  void BeginDisplayList();
+  bool EndDisplayList(DisplayList &list);
+  // Replays the given list, which is much cheaper than recreating the commands it contains.
+  void CallDisplayList(const DisplayList &list) const;
+
   static void SaveTexture(const std::string &output_directory, const std::string &name, const uint8_t *texture,
                           uint32_t width, uint32_t height, uint32_t pitch, uint32_t bits_per_pixel,
                           SDL_PixelFormatEnum format);
@@ -518,7 +603,24 @@ class TestHost {
                                      const std::string &ext = ".png");
   static void SaveBackBuffer(const std::string &output_directory, const std::string &name);
 
+  // Points the texture coordinates of each enabled stage that samples a linear texture at the unnormalized coordinates
+  // of the current vertex buffer.
+  void SetLinearTexCoordAttributes(uint32_t enabled_fields);
+
+  // Returns the push buffer pointer that the next immediate mode method should be written to.
+  uint32_t *BeginImmediateModeMethod() const;
+  // Commits immediate mode methods written up to `p`. If no Begin() is active the methods are submitted immediately,
+  // otherwise they are held until End() or until a completed vertex pushes the span over its size limit.
+  void EndImmediateModeMethod(uint32_t *p, bool vertex_complete = false) const;
+
  private:
+  // Maximum number of DWORDs accumulated between Begin() and End() before the span is flushed at a vertex boundary.
+  static constexpr uint32_t kMaxImmediateModeSpanDWORDs = 64;
+  // Size in bytes of the palette of a single texture stage.
+  static constexpr uint32_t kMaxPaletteSize = 256 * 4;
+  static constexpr uint32_t kTextureMemoryAlignment = 128;
+  static constexpr uint32_t kPaletteMemoryAlignment = 64;
+
   uint32_t framebuffer_width_;
   uint32_t framebuffer_height_;
 
@@ -535,7 +637,12 @@ class TestHost {
 
   std::shared_ptr<VertexBuffer> vertex_buffer_{};
   uint8_t *texture_memory_{nullptr};
+  uint32_t texture_memory_size_{0};
+  // Size of the initial reservation of each texture stage.
+  uint32_t texture_stage_memory_size_{0};
+  TextureArena texture_arena_;
   uint8_t *texture_palette_memory_{nullptr};
+  TextureUploadCache texture_upload_cache_;
 
   enum FixedFunctionMatrixSetting {
     MATRIX_MODE_DEFAULT_NXDK,
@@ -550,6 +657,18 @@ class TestHost {
 
   bool save_results_{true};
 
+  mutable ShadowRegisterFile shadow_registers_;
+
+  uint32_t last_draw_packet_count_{0};
+  uint32_t push_buffer_high_water_mark_{0};
+
+  // Push buffer position at which the display list currently being recorded started.
+  uint32_t *display_list_start_{nullptr};
+
+  // Push buffer span opened by Begin() and extended by the immediate mode setters until End().
+  mutable uint32_t *immediate_mode_span_start_{nullptr};
+  mutable uint32_t *immediate_mode_span_{nullptr};
+
   uint32_t vertex_attribute_stride_override_[16]{
       kNoStrideOverride, kNoStrideOverride, kNoStrideOverride, kNoStrideOverride, kNoStrideOverride, kNoStrideOverride,
       kNoStrideOverride, kNoStrideOverride, kNoStrideOverride, kNoStrideOverride, kNoStrideOverride, kNoStrideOverride,
@@ -599,9 +599,7 @@ void AttributeExplicitSetterTests::Draw(float x, float y, const std::function<vo
   shader->PrepareDraw();
 
   const float z = 3.0f;
-  auto p = pb_begin();
-  p = pb_push1(p, NV097_SET_BEGIN_END, TestHost::PRIMITIVE_TRIANGLES);
-  pb_end(p);
+  host_.Begin(TestHost::PRIMITIVE_TRIANGLES);
 
   attribute_setter(0);
   host_.SetVertex(x, y, z);
@@ -612,9 +610,7 @@ void AttributeExplicitSetterTests::Draw(float x, float y, const std::function<vo
   attribute_setter(2);
   host_.SetVertex(x + (test_triangle_width * 0.5f), y + test_triangle_height, z);
 
-  p = pb_begin();
-  p = pb_push1(p, NV097_SET_BEGIN_END, NV097_SET_BEGIN_END_OP_END);
-  pb_end(p);
+  host_.End();
 }
 
 static TestHost::VertexAttribute TestAttributeToVertexAttribute(AttributeExplicitSetterTests::Attribute attribute) {
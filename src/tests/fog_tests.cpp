@@ -55,6 +55,7 @@ void FogTests::Initialize() {
 
 void FogTests::Deinitialize() {
   vertex_buffer_.reset();
+  fog_state_.Clear();
   TestSuite::Deinitialize();
 }
 
@@ -98,59 +99,6 @@ void FogTests::Test(FogTests::FogMode fog_mode, FogTests::FogGenMode gen_mode, u
   static constexpr uint32_t kBackgroundColor = 0xFF303030;
   host_.PrepareDraw(kBackgroundColor);
 
-  auto p = pb_begin();
-  p = pb_push1(p, NV097_SET_COMBINER_CONTROL, 1);
-
-  pb_push_to(SUBCH_3D, p++, NV097_SET_COMBINER_COLOR_ICW, 8);
-  *(p++) = 0x4200000;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-
-  pb_push_to(SUBCH_3D, p++, NV097_SET_COMBINER_COLOR_OCW, 8);
-  *(p++) = 0xC00;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-
-  pb_push_to(SUBCH_3D, p++, NV097_SET_COMBINER_ALPHA_ICW, 8);
-  *(p++) = 0x14200000;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-
-  pb_push_to(SUBCH_3D, p++, NV097_SET_COMBINER_ALPHA_OCW, 8);
-  *(p++) = 0xC00;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-  *(p++) = 0x0;
-
-  p = pb_push1(p, NV097_SET_FOG_ENABLE, true);
-  p = pb_push1(p, NV097_SET_COMBINER_SPECULAR_FOG_CW0, 0x130C0300);
-  p = pb_push1(p, NV097_SET_COMBINER_SPECULAR_FOG_CW1, 0x1c80);
-
-  // Note: Fog color is ABGR and not ARGB
-  p = pb_push1(p, NV097_SET_FOG_COLOR, 0x7F2030 + (fog_alpha << 24));
-
-  p = pb_push1(p, NV097_SET_FOG_GEN_MODE, gen_mode);
-  p = pb_push1(p, NV097_SET_FOG_MODE, fog_mode);
-
   // Linear parameters.
   // TODO: Parameterize.
   // Right now these are just the near and far planes.
@@ -186,10 +134,85 @@ void FogTests::Test(FogTests::FogMode fog_mode, FogTests::FogGenMode gen_mode, u
       break;
   }
 
-  // TODO: Figure out what the third parameter is. In all examples I've seen it's always been 0.
-  p = pb_push3f(p, NV097_SET_FOG_PARAMS, bias_param, multiplier_param, 0.0f);
-
-  pb_end(p);
+  // Note: Fog color is ABGR and not ARGB
+  const uint32_t fog_color = 0x7F2030 + (fog_alpha << 24);
+
+  // The combiner and fog setup only differs in a few parameters between tests, so it is recorded once and patched.
+  if (fog_state_.IsRecorded()) {
+    fog_state_.Patch(fog_color_patch_, fog_color);
+    fog_state_.Patch(fog_gen_mode_patch_, gen_mode);
+    fog_state_.Patch(fog_mode_patch_, fog_mode);
+    fog_state_.Patchf(fog_bias_patch_, bias_param);
+    fog_state_.Patchf(fog_multiplier_patch_, multiplier_param);
+    host_.CallDisplayList(fog_state_);
+  } else {
+    host_.BeginDisplayList();
+
+    auto p = pb_begin();
+    p = pb_push1(p, NV097_SET_COMBINER_CONTROL, 1);
+
+    pb_push_to(SUBCH_3D, p++, NV097_SET_COMBINER_COLOR_ICW, 8);
+    *(p++) = 0x4200000;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+
+    pb_push_to(SUBCH_3D, p++, NV097_SET_COMBINER_COLOR_OCW, 8);
+    *(p++) = 0xC00;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+
+    pb_push_to(SUBCH_3D, p++, NV097_SET_COMBINER_ALPHA_ICW, 8);
+    *(p++) = 0x14200000;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+
+    pb_push_to(SUBCH_3D, p++, NV097_SET_COMBINER_ALPHA_OCW, 8);
+    *(p++) = 0xC00;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+    *(p++) = 0x0;
+
+    p = pb_push1(p, NV097_SET_FOG_ENABLE, true);
+    p = pb_push1(p, NV097_SET_COMBINER_SPECULAR_FOG_CW0, 0x130C0300);
+    p = pb_push1(p, NV097_SET_COMBINER_SPECULAR_FOG_CW1, 0x1c80);
+
+    p = pb_push1(p, NV097_SET_FOG_COLOR, fog_color);
+
+    p = pb_push1(p, NV097_SET_FOG_GEN_MODE, gen_mode);
+    p = pb_push1(p, NV097_SET_FOG_MODE, fog_mode);
+
+    // TODO: Figure out what the third parameter is. In all examples I've seen it's always been 0.
+    p = pb_push3f(p, NV097_SET_FOG_PARAMS, bias_param, multiplier_param, 0.0f);
+
+    pb_end(p);
+
+    if (host_.EndDisplayList(fog_state_)) {
+      fog_color_patch_ = fog_state_.FindPatchPoint(NV097_SET_FOG_COLOR);
+      fog_gen_mode_patch_ = fog_state_.FindPatchPoint(NV097_SET_FOG_GEN_MODE);
+      fog_mode_patch_ = fog_state_.FindPatchPoint(NV097_SET_FOG_MODE);
+      fog_bias_patch_ = fog_state_.FindPatchPoint(NV097_SET_FOG_PARAMS);
+      fog_multiplier_patch_ = fog_state_.FindPatchPoint(NV097_SET_FOG_PARAMS + 4);
+    }
+  }
 
   host_.DrawArrays(host_.POSITION | host_.DIFFUSE);
 
@@ -44,6 +44,14 @@ class FogTests : public TestSuite {
 
  protected:
   std::shared_ptr<VertexBuffer> vertex_buffer_;
+
+  // Combiner and fog state shared by all tests.
+  DisplayList fog_state_;
+  DisplayList::PatchPoint fog_color_patch_{DisplayList::kInvalidPatchPoint};
+  DisplayList::PatchPoint fog_gen_mode_patch_{DisplayList::kInvalidPatchPoint};
+  DisplayList::PatchPoint fog_mode_patch_{DisplayList::kInvalidPatchPoint};
+  DisplayList::PatchPoint fog_bias_patch_{DisplayList::kInvalidPatchPoint};
+  DisplayList::PatchPoint fog_multiplier_patch_{DisplayList::kInvalidPatchPoint};
 };
 
 class FogCustomShaderTests : public FogTests {
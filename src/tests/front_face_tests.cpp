@@ -4,6 +4,7 @@
 
 #include "../test_host.h"
 #include "debug_output.h"
+#include "gpu_wait.h"
 #include "shaders/precalculated_vertex_shader.h"
 #include "vertex_buffer.h"
 
@@ -110,8 +111,7 @@ void FrontFaceTests::Test(uint32_t front_face, uint32_t cull_face) {
     pb_end(p);
   }
 
-  while (pb_busy()) {
-  }
+  WAIT_FOR_FENCE(GPUWait::InsertFence());
 
   auto p = pb_begin();
   p = pb_push1(p, NV097_SET_FRONT_FACE, front_face);
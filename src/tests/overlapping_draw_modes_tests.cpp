@@ -19,6 +19,9 @@ OverlappingDrawModesTests::OverlappingDrawModesTests(TestHost &host, std::string
   tests_[kArrElDrawArrArrElTest] = [this]() { TestArrayElementDrawArrayArrayElement(); };
   tests_[kDrawArrDrawArrTest] = [this]() { TestDrawArrayDrawArray(); };
   tests_[kXemuSquashOptimizationTest] = [this]() { TestXemuSquashOptimization(); };
+
+  // These tests verify behavior when draw state is re-sent between overlapping draws.
+  invalidate_shadow_registers_per_test_ = true;
 }
 
 void OverlappingDrawModesTests::Initialize() {
@@ -0,0 +1,132 @@
+#include "procedural_mesh_tests.h"
+
+#include <pbkit/pbkit.h>
+
+#include "../test_host.h"
+#include "debug_output.h"
+#include "index_buffer.h"
+#include "mesh_generator.h"
+#include "pbkit_ext.h"
+#include "vertex_buffer.h"
+#include "vertex_memory_pool.h"
+
+struct TessellationParams {
+  ProceduralMeshTests::Shape shape;
+  // Low tessellation to check the shape, high tessellation to stress transform and lighting. The high tessellation
+  // levels are the largest that keep the generated Vertex array within VertexMemoryPool::kMaxClassSize.
+  uint32_t tessellation[2];
+};
+
+static constexpr TessellationParams kTests[] = {
+    {ProceduralMeshTests::SHAPE_GRID, {4, 156}},
+    {ProceduralMeshTests::SHAPE_CUBE, {2, 63}},
+    {ProceduralMeshTests::SHAPE_SPHERE, {12, 110}},
+    {ProceduralMeshTests::SHAPE_TORUS, {12, 110}},
+};
+
+// The highly tessellated meshes are drawn repeatedly so that about 100k vertices are processed per frame.
+static constexpr uint32_t kHighTessellationDraws = 4;
+
+static constexpr uint32_t kVertexElements = TestHost::POSITION | TestHost::NORMAL | TestHost::DIFFUSE;
+
+ProceduralMeshTests::ProceduralMeshTests(TestHost& host, std::string output_dir)
+    : TestSuite(host, std::move(output_dir), "Procedural mesh") {
+  for (auto& params : kTests) {
+    for (uint32_t i = 0; i < 2; ++i) {
+      uint32_t tessellation = params.tessellation[i];
+      uint32_t draws = i ? kHighTessellationDraws : 1;
+      std::string name = MakeTestName(params.shape, tessellation);
+      Shape shape = params.shape;
+      tests_[name] = [this, shape, tessellation, draws]() { this->Test(shape, tessellation, draws); };
+    }
+  }
+}
+
+void ProceduralMeshTests::Initialize() {
+  TestSuite::Initialize();
+
+  host_.SetVertexShaderProgram(nullptr);
+  host_.SetXDKDefaultViewportAndFixedFunctionMatrices();
+
+  auto p = pb_begin();
+  p = pb_push1(p, NV097_SET_LIGHTING_ENABLE, true);
+  p = pb_push1(p, NV097_SET_SPECULAR_ENABLE, false);
+  p = pb_push1(p, NV097_SET_LIGHT_CONTROL, 0x10001);
+  p = pb_push1(p, NV097_SET_LIGHT_ENABLE_MASK, NV097_SET_LIGHT_ENABLE_MASK_LIGHT0_INFINITE);
+
+  // The torus and the highly tessellated shapes overlap themselves.
+  p = pb_push1(p, NV097_SET_DEPTH_TEST_ENABLE, true);
+  pb_end(p);
+
+  host_.SetDefaultMaterial(NV097_SET_COLOR_MATERIAL_DIFFUSE_FROM_VERTEX_DIFFUSE, Color{0.15f, 0.15f, 0.15f});
+  // Light the faces pointing up, left and towards the camera so that the curvature of each shape is visible.
+  host_.SetInfiniteLight(0, -0.3f, 0.5f, -0.81f, Color{1.0f, 1.0f, 1.0f});
+}
+
+Mesh ProceduralMeshTests::GenerateShape(Shape shape, uint32_t tessellation) {
+  static constexpr float kCenter[] = {0.0f, 0.0f, 1.0f};
+  MeshOptions options;
+
+  switch (shape) {
+    case SHAPE_GRID:
+      options.diffuse = Color{0.3f, 0.9f, 0.4f, 1.0f};
+      return GenerateGrid(-2.0f, 1.5f, 2.0f, -1.5f, kCenter[2], tessellation, tessellation, options);
+
+    case SHAPE_CUBE:
+      options.diffuse = Color{0.9f, 0.5f, 0.2f, 1.0f};
+      return GenerateCube(kCenter, 1.5f, tessellation, options);
+
+    case SHAPE_SPHERE:
+      options.diffuse = Color{0.3f, 0.5f, 1.0f, 1.0f};
+      return GenerateSphere(kCenter, 1.25f, tessellation * 2, tessellation, options);
+
+    case SHAPE_TORUS:
+      options.diffuse = Color{1.0f, 0.8f, 0.3f, 1.0f};
+      return GenerateTorus(kCenter, 1.0f, 0.4f, tessellation * 2, tessellation, options);
+  }
+
+  ASSERT(!"Unknown shape.");
+  return {};
+}
+
+void ProceduralMeshTests::Test(Shape shape, uint32_t tessellation, uint32_t draws) {
+  static constexpr uint32_t kBackgroundColor = 0xFF303030;
+  host_.PrepareDraw(kBackgroundColor);
+
+  Mesh mesh = GenerateShape(shape, tessellation);
+  ASSERT(sizeof(Vertex) * mesh.vertex_buffer->GetNumVertices() <= VertexMemoryPool::kMaxClassSize &&
+         "Mesh does not fit in the largest vertex pool size class.");
+  // Fetch 20 bytes per vertex instead of the full Vertex.
+  mesh.vertex_buffer->SetCompactLayout(kVertexElements);
+  IndexBuffer indices(mesh.indices);
+
+  host_.SetVertexBuffer(mesh.vertex_buffer);
+  for (uint32_t i = 0; i < draws; ++i) {
+    host_.DrawInlineElements(indices, kVertexElements);
+  }
+
+  std::string name = MakeTestName(shape, tessellation);
+  pb_print("%s\n", name.c_str());
+  pb_print("Vertices: %u x %u\n", mesh.vertex_buffer->GetNumVertices(), draws);
+  pb_print("Triangles: %u\n", static_cast<uint32_t>(mesh.indices.size() / 3));
+  pb_print("Generator: %s\n", GetMeshGeneratorImplementation());
+  pb_draw_text_screen();
+
+  host_.FinishDraw(allow_saving_, output_dir_, name);
+
+  // Release the vertices before the next test generates its own.
+  host_.SetVertexBuffer(nullptr);
+}
+
+std::string ProceduralMeshTests::MakeTestName(Shape shape, uint32_t tessellation) {
+  static constexpr const char* kShapeNames[] = {
+      "Grid",
+      "Cube",
+      "Sphere",
+      "Torus",
+  };
+
+  char buf[32] = {0};
+  snprintf(buf, 31, "%s-%u", kShapeNames[shape], tessellation);
+  return buf;
+}
@@ -0,0 +1,34 @@
+#ifndef NXDK_PGRAPH_TESTS_PROCEDURAL_MESH_TESTS_H
+#define NXDK_PGRAPH_TESTS_PROCEDURAL_MESH_TESTS_H
+
+#include <string>
+
+#include "test_suite.h"
+
+class TestHost;
+struct Mesh;
+
+// Draws lit geometry built by mesh_generator.h at various tessellation levels. The highly tessellated variants push
+// about 100k vertices through the fixed function transform and lighting pipeline.
+class ProceduralMeshTests : public TestSuite {
+ public:
+  enum Shape {
+    SHAPE_GRID,
+    SHAPE_CUBE,
+    SHAPE_SPHERE,
+    SHAPE_TORUS,
+  };
+
+ public:
+  ProceduralMeshTests(TestHost& host, std::string output_dir);
+
+  void Initialize() override;
+
+ private:
+  void Test(Shape shape, uint32_t tessellation, uint32_t draws);
+
+  static Mesh GenerateShape(Shape shape, uint32_t tessellation);
+  static std::string MakeTestName(Shape shape, uint32_t tessellation);
+};
+
+#endif  // NXDK_PGRAPH_TESTS_PROCEDURAL_MESH_TESTS_H
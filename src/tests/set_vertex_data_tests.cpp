@@ -65,42 +65,6 @@ void SetVertexDataTests::CreateGeometry() {
   }
 }
 
-static void SetLightAndMaterial() {
-  auto p = pb_begin();
-
-  p = pb_push1(p, NV097_SET_SPECULAR_PARAMS, 0xbf34dce5);
-  p = pb_push1(p, 0x09e4, 0xc020743f);
-  p = pb_push1(p, 0x09e8, 0x40333d06);
-  p = pb_push1(p, 0x09ec, 0xbf003612);
-  p = pb_push1(p, 0x09f0, 0xbff852a5);
-  p = pb_push1(p, 0x09f4, 0x401c1bce);
-
-  p = pb_push1(p, NV097_SET_COLOR_MATERIAL, NV097_SET_COLOR_MATERIAL_ALL_FROM_MATERIAL);
-  p = pb_push3(p, NV097_SET_SCENE_AMBIENT_COLOR, 0x0, 0x0, 0x0);
-  p = pb_push3(p, NV097_SET_MATERIAL_EMISSION, 0x0, 0x0, 0x0);
-  p = pb_push1f(p, NV097_SET_MATERIAL_ALPHA, 1.0f);
-
-  {
-    p = pb_push3(p, NV097_SET_LIGHT_AMBIENT_COLOR, 0, 0, 0);
-    p = pb_push3f(p, NV097_SET_LIGHT_DIFFUSE_COLOR, 0.0f, 0.25f, 0.8f);
-    p = pb_push3(p, NV097_SET_LIGHT_SPECULAR_COLOR, 0, 0, 0);
-    p = pb_push1(p, NV097_SET_LIGHT_LOCAL_RANGE, 0x7149f2ca);  // 1e30
-    p = pb_push3(p, NV097_SET_LIGHT_INFINITE_HALF_VECTOR, 0, 0, 0);
-    p = pb_push3f(p, NV097_SET_LIGHT_INFINITE_DIRECTION, 1.0f, 0.0f, 0.0f);
-  }
-
-  {
-    p = pb_push3(p, NV097_SET_LIGHT_AMBIENT_COLOR + 128, 0, 0, 0);
-    p = pb_push3f(p, NV097_SET_LIGHT_DIFFUSE_COLOR + 128, 0.8f, 0.25f, 0.33f);
-    p = pb_push3(p, NV097_SET_LIGHT_SPECULAR_COLOR + 128, 0, 0, 0);
-    p = pb_push1(p, NV097_SET_LIGHT_LOCAL_RANGE + 128, 0x7149f2ca);  // 1e30
-    p = pb_push3(p, NV097_SET_LIGHT_INFINITE_HALF_VECTOR + 128, 0, 0, 0);
-    p = pb_push3f(p, NV097_SET_LIGHT_INFINITE_DIRECTION + 128, -1.0f, 0.0f, 0.0f);
-  }
-
-  pb_end(p);
-}
-
 void SetVertexDataTests::Test(SetFunction func, const Color& diffuse, bool saturate_signed) {
   static constexpr uint32_t kBackgroundColor = 0xFF303030;
   host_.PrepareDraw(kBackgroundColor);
@@ -156,7 +120,9 @@ void SetVertexDataTests::Test(SetFunction func, const Color& diffuse, bool satur
 
   pb_end(p);
 
-  SetLightAndMaterial();
+  host_.SetDefaultMaterial(NV097_SET_COLOR_MATERIAL_ALL_FROM_MATERIAL, Color{0.0f, 0.0f, 0.0f});
+  host_.SetInfiniteLight(0, 1.0f, 0.0f, 0.0f, Color{0.0f, 0.25f, 0.8f});
+  host_.SetInfiniteLight(1, -1.0f, 0.0f, 0.0f, Color{0.8f, 0.25f, 0.33f});
 
   host_.SetVertexBuffer(diffuse_buffer_);
   host_.DrawInlineBuffer(host_.POSITION);
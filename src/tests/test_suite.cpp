@@ -1,10 +1,12 @@
 #include "test_suite.h"
 
 #include "debug_output.h"
+#include "gpu_wait.h"
 #include "pbkit_ext.h"
 #include "shaders/pixel_shader_program.h"
 #include "test_host.h"
 #include "texture_format.h"
+#include "vertex_memory_pool.h"
 
 TestSuite::TestSuite(TestHost& host, std::string output_dir, std::string suite_name)
     : host_(host), output_dir_(std::move(output_dir)), suite_name_(std::move(suite_name)) {
@@ -35,14 +37,40 @@ void TestSuite::Run(const std::string& test_name) {
     ASSERT(!"Invalid test name");
   }
 
+  if (invalidate_shadow_registers_per_test_) {
+    host_.InvalidateShadowRegisters();
+  }
+
   it->second();
 }
 
 void TestSuite::RunAll() {
+  auto& shadow = host_.GetShadowRegisters();
+  shadow.ResetDroppedPushCount();
+  auto& upload_cache = host_.GetTextureUploadCache();
+  upload_cache.ResetCounters();
+  auto& texture_arena = host_.GetTextureArena();
+  texture_arena.ResetPeakUsedSize();
+  VertexMemoryPool::ResetCounters();
+
   auto names = TestNames();
   for (const auto& test_name : names) {
     Run(test_name);
   }
+
+  if (shadow.IsEnabled()) {
+    PrintMsg("%s: Dropped %u redundant state pushes.\n", suite_name_.c_str(), shadow.GetDroppedPushCount());
+  }
+  if (upload_cache.GetHitCount() || upload_cache.GetMissCount()) {
+    PrintMsg("%s: Texture upload cache: %u hits, %u misses.\n", suite_name_.c_str(), upload_cache.GetHitCount(),
+             upload_cache.GetMissCount());
+  }
+  PrintMsg("%s: Texture memory: peak %u of %u bytes, %u%% of free memory fragmented.\n", suite_name_.c_str(),
+           texture_arena.GetPeakUsedSize(), texture_arena.GetSize(), texture_arena.GetFragmentationPercent());
+  const auto& vertex_memory = VertexMemoryPool::GetStats();
+  PrintMsg("%s: Vertex memory: %u allocations, %u reused, %u from the kernel, peak %u bytes reserved.\n",
+           suite_name_.c_str(), vertex_memory.allocations, vertex_memory.reused_allocations,
+           vertex_memory.system_allocations, vertex_memory.peak_reserved_size);
 }
 
 void TestSuite::SetDefaultTextureFormat() const {
@@ -58,6 +86,12 @@ void TestSuite::SetDefaultTextureFormat() const {
 }
 
 void TestSuite::Initialize() {
+  // State pushed directly by the previous suite is unknown, so the shadow must be rebuilt from scratch. The defaults
+  // below are always sent, so they are pushed directly and their methods stay unshadowed until the next tracked push.
+  host_.InvalidateShadowRegisters();
+
+  host_.ResetTextureStageMemory();
+
   auto p = pb_begin();
   p = pb_push1(p, NV097_SET_LIGHTING_ENABLE, false);
   p = pb_push1(p, NV097_SET_SPECULAR_ENABLE, false);
@@ -103,9 +137,7 @@ void TestSuite::Initialize() {
 
   host_.SetShaderStageProgram(TestHost::STAGE_NONE, TestHost::STAGE_NONE, TestHost::STAGE_NONE, TestHost::STAGE_NONE);
 
-  while (pb_busy()) {
-    /* Wait for completion... */
-  }
+  WAIT_FOR_FENCE(GPUWait::InsertFence());
 
   p = pb_begin();
 
@@ -123,6 +155,7 @@ void TestSuite::Initialize() {
     stage.SetFilter();
     stage.SetAlphaKillEnable(false);
     stage.SetLODClamp(0, 4095);
+    stage.SetMipmapLevels(1);
 
     stage.SetTextureMatrixEnable(false);
     stage.SetTextureMatrix(identity_matrix);
@@ -36,6 +36,9 @@ class TestSuite {
   // Flag to forcibly disallow saving of output (e.g., when in multiframe test mode for debugging).
   bool allow_saving_{true};
 
+  // Flag indicating that every test requires all state to be resent rather than relying on the shadow register file.
+  bool invalidate_shadow_registers_per_test_{false};
+
   // Map of `test_name` to `void test()`
   std::map<std::string, std::function<void()>> tests_{};
 };
@@ -13,9 +13,16 @@
 #include "vertex_buffer.h"
 
 static int GenerateSurface(SDL_Surface **surface, int width, int height);
+static int GenerateCubemapFaceSurface(SDL_Surface **surface, int size, uint32_t color);
 
 static constexpr int kTextureWidth = 256;
 static constexpr int kTextureHeight = 128;
+static constexpr int kCubemapSize = 64;
+
+// Colors of the +X, -X, +Y, -Y, +Z and -Z faces of the cubemap.
+static constexpr uint32_t kCubemapFaceColors[TextureStage::CUBEMAP_NUM_FACES] = {
+    0xFF0000, 0x00FFFF, 0x00FF00, 0xFF00FF, 0x0000FF, 0xFFFF00,
+};
 
 static TextureStage::TexGen kTestModes[] = {
     TextureStage::TG_DISABLE,
@@ -26,10 +33,20 @@ static TextureStage::TexGen kTestModes[] = {
     TextureStage::TG_REFLECTION_MAP,
 };
 
+// Modes that generate 3D coordinates and are also tested with a cubemap.
+static TextureStage::TexGen kCubemapTestModes[] = {
+    TextureStage::TG_NORMAL_MAP,
+    TextureStage::TG_REFLECTION_MAP,
+};
+
 TexgenTests::TexgenTests(TestHost &host, std::string output_dir) : TestSuite(host, std::move(output_dir), "Texgen") {
   for (auto mode : kTestModes) {
-    std::string name = MakeTestName(mode);
-    tests_[name] = [this, mode]() { Test(mode); };
+    std::string name = MakeTestName(mode, false);
+    tests_[name] = [this, mode]() { Test(mode, false); };
+  }
+  for (auto mode : kCubemapTestModes) {
+    std::string name = MakeTestName(mode, true);
+    tests_[name] = [this, mode]() { Test(mode, true); };
   }
 }
 
@@ -39,19 +56,10 @@ void TexgenTests::Initialize() {
 
   host_.SetXDKDefaultViewportAndFixedFunctionMatrices();
   host_.SetTextureStageEnabled(0, true);
-  host_.SetShaderStageProgram(TestHost::STAGE_2D_PROJECTIVE);
 
   host_.SetTextureFormat(GetTextureFormatInfo(NV097_SET_TEXTURE_FORMAT_COLOR_SZ_R8G8B8A8));
   auto &texture_stage = host_.GetTextureStage(0);
   texture_stage.SetBorderColor(0xFF7F007F);
-  texture_stage.SetTextureDimensions(kTextureWidth, kTextureHeight);
-
-  SDL_Surface *gradient_surface;
-  int update_texture_result = GenerateSurface(&gradient_surface, kTextureWidth, kTextureHeight);
-  ASSERT(!update_texture_result && "Failed to generate SDL surface");
-  update_texture_result = host_.SetTexture(gradient_surface, 0);
-  SDL_FreeSurface(gradient_surface);
-  ASSERT(!update_texture_result && "Failed to set texture");
 
   host_.SetCombinerControl(1, true, true);
   host_.SetFinalCombiner0Just(TestHost::SRC_TEX0);
@@ -69,8 +77,46 @@ void TexgenTests::CreateGeometry() {
   buffer->DefineBiTri(0, left, top, right, bottom);
 }
 
-void TexgenTests::Test(TextureStage::TexGen mode) {
-  std::string test_name = MakeTestName(mode);
+void TexgenTests::SetGradientTexture() {
+  auto &texture_stage = host_.GetTextureStage(0);
+  texture_stage.SetCubemapEnable(false);
+  texture_stage.SetTextureDimensions(kTextureWidth, kTextureHeight);
+  host_.SetShaderStageProgram(TestHost::STAGE_2D_PROJECTIVE);
+
+  SDL_Surface *gradient_surface;
+  int update_texture_result = GenerateSurface(&gradient_surface, kTextureWidth, kTextureHeight);
+  ASSERT(!update_texture_result && "Failed to generate SDL surface");
+  update_texture_result = host_.SetTexture(gradient_surface, 0);
+  SDL_FreeSurface(gradient_surface);
+  ASSERT(!update_texture_result && "Failed to set texture");
+}
+
+void TexgenTests::SetCubemapTexture() {
+  auto &texture_stage = host_.GetTextureStage(0);
+  texture_stage.SetCubemapEnable();
+  texture_stage.SetTextureDimensions(kCubemapSize, kCubemapSize);
+  host_.SetShaderStageProgram(TestHost::STAGE_CUBE_MAP);
+
+  SDL_Surface *faces[TextureStage::CUBEMAP_NUM_FACES];
+  for (uint32_t face = 0; face < TextureStage::CUBEMAP_NUM_FACES; ++face) {
+    int update_texture_result = GenerateCubemapFaceSurface(&faces[face], kCubemapSize, kCubemapFaceColors[face]);
+    ASSERT(!update_texture_result && "Failed to generate SDL surface");
+  }
+  int update_texture_result = host_.SetCubemapTexture((const SDL_Surface **)faces, 0);
+  for (auto face : faces) {
+    SDL_FreeSurface(face);
+  }
+  ASSERT(!update_texture_result && "Failed to set texture");
+}
+
+void TexgenTests::Test(TextureStage::TexGen mode, bool cubemap) {
+  std::string test_name = MakeTestName(mode, cubemap);
+
+  if (cubemap) {
+    SetCubemapTexture();
+  } else {
+    SetGradientTexture();
+  }
 
   host_.PrepareDraw(0xFE202020);
 
@@ -88,7 +134,11 @@ void TexgenTests::Test(TextureStage::TexGen mode) {
   host_.FinishDraw(allow_saving_, output_dir_, test_name);
 }
 
-std::string TexgenTests::MakeTestName(TextureStage::TexGen mode) {
+std::string TexgenTests::MakeTestName(TextureStage::TexGen mode, bool cubemap) {
+  if (cubemap) {
+    return MakeTestName(mode, false) + "Cube";
+  }
+
   switch (mode) {
     case TextureStage::TG_DISABLE:
       return "Disabled";
@@ -135,3 +185,38 @@ static int GenerateSurface(SDL_Surface **surface, int width, int height) {
 
   return 0;
 }
+
+// Fills a square surface with a checkerboard of `color` and a darker shade of it, with a white border along the top
+// and left edges to show the orientation of the face.
+static int GenerateCubemapFaceSurface(SDL_Surface **surface, int size, uint32_t color) {
+  *surface = SDL_CreateRGBSurfaceWithFormat(0, size, size, 32, SDL_PIXELFORMAT_RGBA8888);
+  if (!(*surface)) {
+    return 1;
+  }
+
+  if (SDL_LockSurface(*surface)) {
+    SDL_FreeSurface(*surface);
+    *surface = nullptr;
+    return 2;
+  }
+
+  const uint8_t red = (color >> 16) & 0xFF;
+  const uint8_t green = (color >> 8) & 0xFF;
+  const uint8_t blue = color & 0xFF;
+  auto pixels = static_cast<uint32_t *>((*surface)->pixels);
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x, ++pixels) {
+      if (x < 2 || y < 2) {
+        *pixels = SDL_MapRGBA((*surface)->format, 0xFF, 0xFF, 0xFF, 0xFF);
+      } else if (((x >> 3) ^ (y >> 3)) & 1) {
+        *pixels = SDL_MapRGBA((*surface)->format, red / 2, green / 2, blue / 2, 0xFF);
+      } else {
+        *pixels = SDL_MapRGBA((*surface)->format, red, green, blue, 0xFF);
+      }
+    }
+  }
+
+  SDL_UnlockSurface(*surface);
+
+  return 0;
+}
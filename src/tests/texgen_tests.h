@@ -19,9 +19,12 @@ class TexgenTests : public TestSuite {
  private:
   void CreateGeometry();
 
-  void Test(TextureStage::TexGen gen_mode);
+  void Test(TextureStage::TexGen gen_mode, bool cubemap);
 
-  static std::string MakeTestName(TextureStage::TexGen mode);
+  void SetGradientTexture();
+  void SetCubemapTexture();
+
+  static std::string MakeTestName(TextureStage::TexGen mode, bool cubemap);
 };
 
 #endif  // NXDK_PGRAPH_TESTS_TEXGEN_TESTS_H
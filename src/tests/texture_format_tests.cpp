@@ -7,6 +7,7 @@
 #include <utility>
 
 #include "debug_output.h"
+#include "nxdk_ext.h"
 #include "shaders/perspective_vertex_shader.h"
 #include "shaders/pixel_shader_program.h"
 #include "test_host.h"
@@ -18,6 +19,8 @@ static int GeneratePalettizedGradientSurface(uint8_t **gradient_surface, int wid
                                              TestHost::PaletteSize size);
 static uint32_t *GeneratePalette(TestHost::PaletteSize size);
 
+static constexpr const char kLinearTexCoordCountTestName[] = "TexFmt_LinearTexCoordCount";
+
 static constexpr TestHost::PaletteSize kPaletteSizes[] = {
     TestHost::PALETTE_256,
     TestHost::PALETTE_128,
@@ -31,6 +34,8 @@ static bool RequiresSpecialTest(const TextureFormatInfo &format) {
     case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FIXED:
     case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FLOAT:
     case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_X8_Y24_FIXED:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_DEPTH_Y16_FIXED:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_DEPTH_Y16_FLOAT:
       return true;
 
     default:
@@ -53,6 +58,8 @@ TextureFormatTests::TextureFormatTests(TestHost &host, std::string output_dir)
     std::string name = MakePalettizedTestName(size);
     tests_[name] = [this, size]() { TestPalettized(size); };
   }
+
+  tests_[kLinearTexCoordCountTestName] = [this]() { TestLinearTexCoordCount(); };
 }
 
 void TextureFormatTests::Initialize() {
@@ -138,6 +145,39 @@ void TextureFormatTests::TestPalettized(TestHost::PaletteSize size) {
   host_.FinishDraw(allow_saving_, output_dir_, test_name);
 }
 
+// Draws the linear texture twice, changing the texture coordinate count of the vertex buffer between the draws. The
+// second draw must rebind the linearized coordinates with the new stride, so the result matches the plain linear
+// A8R8G8B8 test.
+void TextureFormatTests::TestLinearTexCoordCount() {
+  auto &texture_format = GetTextureFormatInfo(NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_A8R8G8B8);
+  host_.SetTextureFormat(texture_format);
+
+  SDL_Surface *gradient_surface;
+  int update_texture_result =
+      GenerateGradientSurface(&gradient_surface, (int)host_.GetMaxTextureWidth(), (int)host_.GetMaxTextureHeight());
+  ASSERT(!update_texture_result && "Failed to generate SDL surface");
+
+  update_texture_result = host_.SetTexture(gradient_surface);
+  SDL_FreeSurface(gradient_surface);
+  ASSERT(!update_texture_result && "Failed to set texture");
+
+  auto buffer = host_.GetVertexBuffer();
+
+  host_.PrepareDraw(0xFE202020);
+  buffer->SetTexCoord0Count(2);
+  host_.DrawArrays();
+
+  buffer->SetTexCoord0Count(4);
+  host_.DrawArrays();
+  buffer->SetTexCoord0Count(2);
+
+  pb_print("N: %s\n", texture_format.name);
+  pb_print("Texcoord count 2 then 4\n");
+  pb_draw_text_screen();
+
+  host_.FinishDraw(allow_saving_, output_dir_, kLinearTexCoordCountTestName);
+}
+
 std::string TextureFormatTests::MakeTestName(const TextureFormatInfo &texture_format) {
   std::string test_name = "TexFmt_";
   test_name += texture_format.name;
@@ -19,6 +19,7 @@ class TextureFormatTests : public TestSuite {
 
   void Test(const TextureFormatInfo &texture_format);
   void TestPalettized(TestHost::PaletteSize size);
+  void TestLinearTexCoordCount();
 
   static std::string MakeTestName(const TextureFormatInfo &texture_format);
   static std::string MakePalettizedTestName(TestHost::PaletteSize size);
@@ -44,7 +44,9 @@ static constexpr char kRenderTextureTarget[] = "FBToOldRenderTarget";
 TextureFramebufferBlitTests::TextureFramebufferBlitTests(TestHost& host, std::string output_dir)
     : TestSuite(host, std::move(output_dir), "Texture Framebuffer Blit") {
   tests_[kTextureTarget] = [this]() {
-    auto offset = reinterpret_cast<uint32_t>(host_.GetTextureMemory());
+    int err = host_.ReserveTextureMemory(0, host_.GetFramebufferWidth() * 4 * host_.GetFramebufferHeight());
+    ASSERT(!err && "Failed to reserve texture memory for the framebuffer.");
+    auto offset = reinterpret_cast<uint32_t>(host_.GetTextureStageMemory(0));
     Test(offset, kTextureTarget);
   };
   tests_[kZetaTarget] = [this]() {
@@ -225,8 +227,7 @@ void TextureFramebufferBlitTests::CreateGeometry() {
 void TextureFramebufferBlitTests::TestRenderTarget(const char* test_name) {
   const auto pitch = host_.GetFramebufferWidth() * 4;
   const uint32_t texture_size = pitch * host_.GetFramebufferHeight();
-  auto target =
-      (uint8_t*)MmAllocateContiguousMemoryEx(texture_size, 0, MAXRAM, 0x1000, PAGE_WRITECOMBINE | PAGE_READWRITE);
+  auto target = host_.AllocateTextureMemory(texture_size, 0x1000);
   ASSERT(target && "Failed to allocate target surface.");
 
   auto p = pb_begin();
@@ -255,7 +256,7 @@ void TextureFramebufferBlitTests::TestRenderTarget(const char* test_name) {
 
   Test(reinterpret_cast<uint32_t>(target), test_name);
 
-  MmFreeContiguousMemory(target);
+  host_.FreeTextureMemory(target);
 }
 
 void TextureFramebufferBlitTests::Test(uint32_t texture_destination, const char* test_name) {
@@ -312,6 +313,7 @@ void TextureFramebufferBlitTests::Test(uint32_t texture_destination, const char*
   p = pb_begin();
   p = pb_push1(p, NV097_SET_TEXTURE_OFFSET, texture_destination);
   pb_end(p);
+  host_.GetShadowRegisters().Invalidate(NV097_SET_TEXTURE_OFFSET);
 
   host_.SetFinalCombiner0Just(TestHost::SRC_TEX0);
   host_.SetFinalCombiner1Just(TestHost::SRC_TEX0, true);
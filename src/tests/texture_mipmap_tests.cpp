@@ -0,0 +1,189 @@
+#include "texture_mipmap_tests.h"
+
+#include <SDL.h>
+#include <pbkit/pbkit.h>
+
+#include <memory>
+#include <utility>
+
+#include "debug_output.h"
+#include "test_host.h"
+#include "texture_format.h"
+#include "vertex_buffer.h"
+
+static int GenerateSurface(SDL_Surface **surface, int width, int height);
+
+static constexpr uint32_t kTextureSize = 64;
+// 64x64 down to 1x1.
+static constexpr uint32_t kMipmapLevels = 7;
+// Number of times the texture is repeated across the plane in each direction.
+static constexpr float kTextureRepeat = 8.0f;
+
+struct MinFilterTest {
+  TextureStage::MinFilter filter;
+  const char *name;
+};
+
+static constexpr MinFilterTest kMinFilters[] = {
+    {TextureStage::MIN_BOX_LOD0, "BoxLOD0"},
+    {TextureStage::MIN_BOX_NEARESTLOD, "BoxNearestLOD"},
+    {TextureStage::MIN_TENT_NEARESTLOD, "TentNearestLOD"},
+    {TextureStage::MIN_BOX_TENT_LOD, "BoxTentLOD"},
+    {TextureStage::MIN_TENT_TENT_LOD, "TentTentLOD"},
+};
+
+static constexpr float kLODBiases[] = {-1.0f, 0.0f, 1.0f, 2.0f};
+
+struct MipmapFilterTest {
+  MipmapFilter filter;
+  const char *name;
+};
+
+static constexpr MipmapFilterTest kMipmapFilters[] = {
+    {MIPMAP_FILTER_BOX, "Box"},
+    {MIPMAP_FILTER_TENT, "Tent"},
+    {MIPMAP_FILTER_GAMMA_CORRECT, "Gamma"},
+};
+
+// Converts a bias in levels to the signed 5.8 fixed point NV097_SET_TEXTURE_FILTER_MIPMAP_LOD_BIAS field.
+static uint32_t ToLODBias(float bias) { return static_cast<uint32_t>(static_cast<int32_t>(bias * 256.0f)) & 0x1FFF; }
+
+TextureMipmapTests::TextureMipmapTests(TestHost &host, std::string output_dir)
+    : TestSuite(host, std::move(output_dir), "Texture mipmap") {
+  for (auto &min_filter : kMinFilters) {
+    for (auto bias : kLODBiases) {
+      char name[64] = {0};
+      snprintf(name, 63, "%s_Bias%d", min_filter.name, static_cast<int>(bias));
+      std::string test_name = name;
+      TextureStage::MinFilter filter = min_filter.filter;
+      tests_[test_name] = [this, test_name, filter, bias]() { Test(test_name, filter, bias, MIPMAP_FILTER_BOX); };
+    }
+  }
+
+  for (auto &mipmap_filter : kMipmapFilters) {
+    std::string test_name = std::string("Generate") + mipmap_filter.name;
+    MipmapFilter filter = mipmap_filter.filter;
+    tests_[test_name] = [this, test_name, filter]() {
+      Test(test_name, TextureStage::MIN_TENT_TENT_LOD, 0.0f, filter);
+    };
+  }
+}
+
+void TextureMipmapTests::Initialize() {
+  TestSuite::Initialize();
+  CreateGeometry();
+
+  host_.SetVertexShaderProgram(nullptr);
+  host_.SetXDKDefaultViewportAndFixedFunctionMatrices();
+
+  host_.SetTextureStageEnabled(0, true);
+  host_.SetShaderStageProgram(TestHost::STAGE_2D_PROJECTIVE);
+
+  host_.SetInputColorCombiner(0, TestHost::SRC_TEX0, false, TestHost::MAP_UNSIGNED_IDENTITY, TestHost::SRC_ZERO, false,
+                              TestHost::MAP_UNSIGNED_INVERT);
+  host_.SetInputAlphaCombiner(0, TestHost::SRC_TEX0, true, TestHost::MAP_UNSIGNED_IDENTITY, TestHost::SRC_ZERO, false,
+                              TestHost::MAP_UNSIGNED_INVERT);
+
+  host_.SetOutputColorCombiner(0, TestHost::DST_R0);
+  host_.SetOutputAlphaCombiner(0, TestHost::DST_R0);
+
+  host_.SetFinalCombiner0(TestHost::SRC_ZERO, false, false, TestHost::SRC_ZERO, false, false, TestHost::SRC_ZERO, false,
+                          false, TestHost::SRC_R0);
+  host_.SetFinalCombiner1(TestHost::SRC_ZERO, false, false, TestHost::SRC_ZERO, false, false, TestHost::SRC_R0, true);
+}
+
+void TextureMipmapTests::Deinitialize() {
+  plane_.reset();
+  TestSuite::Deinitialize();
+}
+
+void TextureMipmapTests::CreateGeometry() {
+  // The top of the plane is much further from the camera than the bottom, so the texture is minified progressively
+  // more towards the top and every level of the chain is sampled.
+  static constexpr float kLeft = -3.0f;
+  static constexpr float kRight = 3.0f;
+  static constexpr float kTop = 2.0f;
+  static constexpr float kBottom = -2.5f;
+  static constexpr float kNearZ = -3.0f;
+  static constexpr float kFarZ = 60.0f;
+
+  plane_ = host_.AllocateVertexBuffer(6);
+  plane_->DefineBiTri(0, kLeft, kTop, kRight, kBottom, kFarZ, kNearZ, kNearZ, kFarZ);
+
+  auto vertex = plane_->Lock();
+  for (uint32_t i = 0; i < plane_->GetNumVertices(); ++i, ++vertex) {
+    vertex->texcoord0[0] *= kTextureRepeat;
+    vertex->texcoord0[1] *= kTextureRepeat;
+  }
+  plane_->Unlock();
+}
+
+void TextureMipmapTests::Test(const std::string &name, TextureStage::MinFilter min_filter, float lod_bias,
+                              MipmapFilter mipmap_filter) {
+  host_.SetTextureFormat(GetTextureFormatInfo(NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A8R8G8B8));
+
+  auto &stage = host_.GetTextureStage(0);
+  stage.SetMipmapLevels(kMipmapLevels, mipmap_filter);
+
+  SDL_Surface *surface;
+  int update_texture_result = GenerateSurface(&surface, kTextureSize, kTextureSize);
+  ASSERT(!update_texture_result && "Failed to generate SDL surface");
+
+  update_texture_result = host_.SetTexture(surface);
+  SDL_FreeSurface(surface);
+  ASSERT(!update_texture_result && "Failed to set texture");
+
+  host_.PrepareDraw(0xFE202020);
+
+  stage.SetEnabled();
+  stage.SetTextureDimensions(kTextureSize, kTextureSize);
+  stage.SetFilter(ToLODBias(lod_bias), TextureStage::K_QUINCUNX, min_filter, TextureStage::MAG_TENT_LOD0);
+  stage.SetUWrap(TextureStage::WRAP_REPEAT, false);
+  stage.SetVWrap(TextureStage::WRAP_REPEAT, false);
+  host_.SetupTextureStages();
+
+  host_.SetVertexBuffer(plane_);
+  host_.DrawArrays();
+
+  pb_print("%s\n", name.c_str());
+  pb_print("LOD bias: %g\n", lod_bias);
+  pb_draw_text_screen();
+
+  host_.FinishDraw(allow_saving_, output_dir_, name);
+}
+
+// Fills the surface with a one texel red and green checkerboard, modulated by bright and dark 8x8 blocks. The
+// checkerboard is averaged away in the first generated level and the blocks shrink to single texels by the fourth, so
+// the selected level can be told apart on screen.
+static int GenerateSurface(SDL_Surface **surface, int width, int height) {
+  *surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA8888);
+  if (!(*surface)) {
+    return 1;
+  }
+
+  if (SDL_LockSurface(*surface)) {
+    SDL_FreeSurface(*surface);
+    *surface = nullptr;
+    return 2;
+  }
+
+  const uint32_t kColors[] = {
+      SDL_MapRGBA((*surface)->format, 0xFF, 0x20, 0x20, 0xFF),
+      SDL_MapRGBA((*surface)->format, 0x20, 0xFF, 0x20, 0xFF),
+      SDL_MapRGBA((*surface)->format, 0x60, 0x08, 0x08, 0xFF),
+      SDL_MapRGBA((*surface)->format, 0x08, 0x60, 0x08, 0xFF),
+  };
+
+  auto pixels = static_cast<uint32_t *>((*surface)->pixels);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const int checker = (x + y) & 1;
+      const int dark = ((x / 8) + (y / 8)) & 1;
+      *pixels++ = kColors[dark * 2 + checker];
+    }
+  }
+
+  SDL_UnlockSurface(*surface);
+
+  return 0;
+}
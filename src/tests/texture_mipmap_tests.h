@@ -0,0 +1,31 @@
+#ifndef NXDK_PGRAPH_TESTS_TEXTURE_MIPMAP_TESTS_H
+#define NXDK_PGRAPH_TESTS_TEXTURE_MIPMAP_TESTS_H
+
+#include <memory>
+#include <string>
+
+#include "test_host.h"
+#include "test_suite.h"
+#include "texture_mipmap.h"
+
+class VertexBuffer;
+
+// Draws a receding plane textured with a generated mipmap chain to exercise LOD selection with each minification
+// filter and a range of LOD biases, and compares the filters used to generate the chain.
+class TextureMipmapTests : public TestSuite {
+ public:
+  TextureMipmapTests(TestHost &host, std::string output_dir);
+
+  void Initialize() override;
+  void Deinitialize() override;
+
+ private:
+  void CreateGeometry();
+
+  void Test(const std::string &name, TextureStage::MinFilter min_filter, float lod_bias, MipmapFilter mipmap_filter);
+
+ private:
+  std::shared_ptr<VertexBuffer> plane_;
+};
+
+#endif  // NXDK_PGRAPH_TESTS_TEXTURE_MIPMAP_TESTS_H
@@ -7,6 +7,7 @@
 #include <utility>
 
 #include "debug_output.h"
+#include "nxdk_ext.h"
 #include "pbkit_ext.h"
 #include "shaders/precalculated_vertex_shader.h"
 #include "test_host.h"
@@ -40,6 +41,8 @@ static bool RequiresSpecialTest(const TextureFormatInfo &format) {
     case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FIXED:
     case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FLOAT:
     case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_X8_Y24_FIXED:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_DEPTH_Y16_FIXED:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_DEPTH_Y16_FLOAT:
       return true;
 
     default:
@@ -73,8 +76,7 @@ void TextureRenderTargetTests::Initialize() {
   pb_bind_channel(&texture_target_ctx_);
 
   const uint32_t texture_size = kTexturePitch * kTextureHeight;
-  render_target_ =
-      (uint8_t *)MmAllocateContiguousMemoryEx(texture_size, 0, MAXRAM, 0x1000, PAGE_WRITECOMBINE | PAGE_READWRITE);
+  render_target_ = host_.AllocateTextureMemory(texture_size, 0x1000);
   ASSERT(render_target_ && "Failed to allocate target surface.");
   pb_set_dma_address(&texture_target_ctx_, render_target_, texture_size - 1);
 
@@ -88,9 +90,8 @@ void TextureRenderTargetTests::Initialize() {
 
 void TextureRenderTargetTests::Deinitialize() {
   TestSuite::Deinitialize();
-  if (render_target_) {
-    MmFreeContiguousMemory(render_target_);
-  }
+  host_.FreeTextureMemory(render_target_);
+  render_target_ = nullptr;
 }
 
 void TextureRenderTargetTests::CreateGeometry() {
@@ -3,12 +3,14 @@
 #include <pbkit/pbkit.h>
 
 #include <utility>
+#include <vector>
 
 #include "debug_output.h"
+#include "nxdk_ext.h"
 #include "pbkit_ext.h"
 #include "shaders/precalculated_vertex_shader.h"
-#include "swizzle.h"
 #include "test_host.h"
+#include "texture_conversion.h"
 
 // Uncomment to save the depth texture as an additional artifact.
 //#define DEBUG_DUMP_DEPTH_TEXTURE
@@ -96,6 +98,19 @@ static std::string MakeRawValueTestName(const TextureFormatInfo &format, uint32_
   return std::move(ret);
 }
 
+static std::string MakeRawFloatValueTestName(const TextureFormatInfo &format, uint32_t comp_func, float min_val,
+                                             float max_val, float ref) {
+  std::string ret = "R";
+  ret += ShortDepthName(format, NV097_SET_SURFACE_FORMAT_ZETA_Z16, true);
+
+  char buf[32] = {0};
+  sprintf(buf, "_%0.02f-%0.02f_%0.02f_", min_val, max_val, ref);
+  ret += buf;
+
+  ret += CompareFunctionName(comp_func);
+  return std::move(ret);
+}
+
 static std::string MakePerspectiveTestName(const TextureFormatInfo &format, uint32_t depth_format, bool float_depth,
                                            float min_val, float max_val, float ref, uint32_t comp_func) {
   std::string ret = "P";
@@ -120,6 +135,14 @@ TextureShadowComparatorTests::TextureShadowComparatorTests(TestHost &host, std::
     };
   };
 
+  auto add_float_test = [this](uint32_t texture_format, uint32_t comp_func, float min_val, float max_val, float ref) {
+    const TextureFormatInfo &texture_format_info = GetTextureFormatInfo(texture_format);
+    std::string name = MakeRawFloatValueTestName(texture_format_info, comp_func, min_val, max_val, ref);
+    tests_[name] = [this, texture_format, comp_func, name, min_val, max_val, ref]() {
+      TestRawFloatValues(texture_format, comp_func, min_val, max_val, ref, name);
+    };
+  };
+
   auto add_perspective_test = [this](uint32_t texture_format, uint32_t surface_format, bool float_depth,
                                      uint32_t comp_func, float min_val, float max_val, float ref_val) {
     const TextureFormatInfo &texture_format_info = GetTextureFormatInfo(texture_format);
@@ -145,6 +168,9 @@ TextureShadowComparatorTests::TextureShadowComparatorTests(TestHost &host, std::
     add_test(NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_X8_Y24_FIXED, NV097_SET_SURFACE_FORMAT_ZETA_Z24S8, comp_func,
              256, 512, 384);
 
+    add_float_test(NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FLOAT, comp_func, 0.0f, 200.0f, 100.0f);
+    add_float_test(NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FLOAT, comp_func, 0.0f, kF16Max, 256.0f);
+
     add_perspective_test(NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FIXED, NV097_SET_SURFACE_FORMAT_ZETA_Z16,
                          false, comp_func, 0.0f, 200.0f, 100.0f);
     add_perspective_test(NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FIXED, NV097_SET_SURFACE_FORMAT_ZETA_Z16,
@@ -172,6 +198,10 @@ void TextureShadowComparatorTests::Initialize() {
   raw_value_shader_ = std::make_shared<PrecalculatedVertexShader>(true);
   host_.SetXDKDefaultViewportAndFixedFunctionMatrices();
 
+  // The zeta buffer is rendered directly into the texture memory of stage 0.
+  int err = host_.ReserveTextureMemory(0, host_.GetFramebufferWidth() * host_.GetFramebufferHeight() * 4);
+  ASSERT(!err && "Failed to reserve texture memory for the zeta buffer.");
+
   auto p = pb_begin();
   p = pb_push1(p, NV097_SET_STENCIL_TEST_ENABLE, false);
   p = pb_push1(p, NV097_SET_STENCIL_MASK, false);
@@ -198,6 +228,14 @@ static BoxLayoutInfo GetExplicitBoxLayout(uint32_t buffer_width, uint32_t buffer
   return info;
 }
 
+template <typename T>
+static T ShiftLeft(T value, uint32_t bits) {
+  return value << bits;
+}
+
+// Float depth values are never shifted.
+static float ShiftLeft(float value, uint32_t bits) { return value; }
+
 template <typename T>
 static void PrepareRawValueTestTexture(uint8_t *memory, uint32_t width, uint32_t height, T min_val, T max_val,
                                        T default_val, uint32_t left_shift = 0) {
@@ -221,7 +259,7 @@ static void PrepareRawValueTestTexture(uint8_t *memory, uint32_t width, uint32_t
   float val_inc = static_cast<float>(max_val) / static_cast<float>(kTotal);
   auto row_data = new T[width];
   for (auto i = 0; i < width; ++i) {
-    row_data[i] = default_val << left_shift;
+    row_data[i] = ShiftLeft(default_val, left_shift);
   }
 
   for (auto y = y_indent >> 1; y < kVertical; ++y) {
@@ -251,7 +289,7 @@ static void PrepareRawValueTestTexture(uint8_t *memory, uint32_t width, uint32_t
 
   auto set_box = [&layout, left_shift](T *row, uint32_t left, T value) {
     T *pixel = row + left;
-    value <<= left_shift;
+    value = ShiftLeft(value, left_shift);
     for (auto x = 0; x < layout.box_width; ++x) {
       *pixel++ = value;
     }
@@ -290,12 +328,12 @@ void TextureShadowComparatorTests::TestRawValues(uint32_t depth_format, uint32_t
 
   switch (depth_format) {
     case NV097_SET_SURFACE_FORMAT_ZETA_Z16:
-      PrepareRawValueTestTexture<uint16_t>(host_.GetTextureMemory(), host_.GetFramebufferWidth(),
+      PrepareRawValueTestTexture<uint16_t>(host_.GetTextureStageMemory(0), host_.GetFramebufferWidth(),
                                            host_.GetFramebufferHeight(), min_val, max_val, ref);
       break;
 
     case NV097_SET_SURFACE_FORMAT_ZETA_Z24S8:
-      PrepareRawValueTestTexture<uint32_t>(host_.GetTextureMemory(), host_.GetFramebufferWidth(),
+      PrepareRawValueTestTexture<uint32_t>(host_.GetTextureStageMemory(0), host_.GetFramebufferWidth(),
                                            host_.GetFramebufferHeight(), min_val, max_val, ref, 8);
       break;
   }
@@ -305,11 +343,56 @@ void TextureShadowComparatorTests::TestRawValues(uint32_t depth_format, uint32_t
     std::string z_buffer_name = name + "_DT";
     const uint32_t bpp = depth_format == NV097_SET_SURFACE_FORMAT_ZETA_Z16 ? 16 : 32;
     const uint32_t texture_pitch = host_.GetFramebufferWidth() * (bpp >> 3);
-    host_.SaveRawTexture(output_dir_, z_buffer_name, host_.GetTextureMemory(), host_.GetFramebufferWidth(),
+    host_.SaveRawTexture(output_dir_, z_buffer_name, host_.GetTextureStageMemory(0), host_.GetFramebufferWidth(),
                          host_.GetFramebufferHeight(), texture_pitch, bpp);
   }
 #endif
 
+  DrawRawValueComparison(texture_format, shadow_comp_function, static_cast<float>(ref));
+
+  pb_print("%s\n", name.c_str());
+  pb_print("Rng 0x%X-0x%x\n", min_val, max_val);
+  pb_print("Ref, edges, center: 0x%X\n", ref);
+  pb_draw_text_screen();
+
+  host_.FinishDraw(allow_saving_, output_dir_, name);
+}
+
+void TextureShadowComparatorTests::TestRawFloatValues(uint32_t texture_format, uint32_t shadow_comp_function,
+                                                      float min_val, float max_val, float ref,
+                                                      const std::string &name) {
+  host_.SetVertexShaderProgram(raw_value_shader_);
+
+  host_.PrepareDraw(0xFE112233);
+
+  // The values are generated in single precision and then encoded in the 16-bit float depth format.
+  const uint32_t texel_count = host_.GetFramebufferWidth() * host_.GetFramebufferHeight();
+  std::vector<float> values(texel_count);
+  PrepareRawValueTestTexture<float>(reinterpret_cast<uint8_t *>(values.data()), host_.GetFramebufferWidth(),
+                                    host_.GetFramebufferHeight(), min_val, max_val, ref);
+  ConvertFloatsToZ16(values.data(), texel_count, host_.GetTextureStageMemory(0));
+
+#ifdef DEBUG_DUMP_DEPTH_TEXTURE
+  if (allow_saving_) {
+    std::string z_buffer_name = name + "_DT";
+    const uint32_t texture_pitch = host_.GetFramebufferWidth() * 2;
+    host_.SaveRawTexture(output_dir_, z_buffer_name, host_.GetTextureStageMemory(0), host_.GetFramebufferWidth(),
+                         host_.GetFramebufferHeight(), texture_pitch, 16);
+  }
+#endif
+
+  DrawRawValueComparison(texture_format, shadow_comp_function, ref);
+
+  pb_print("%s\n", name.c_str());
+  pb_print("Rng %.02f-%.02f\n", min_val, max_val);
+  pb_print("Ref, edges, center: %.02f\n", ref);
+  pb_draw_text_screen();
+
+  host_.FinishDraw(allow_saving_, output_dir_, name);
+}
+
+void TextureShadowComparatorTests::DrawRawValueComparison(uint32_t texture_format, uint32_t shadow_comp_function,
+                                                          float ref) {
   // Render a quad using the zeta buffer as a shadow map applied to the diffuse color.
 
   // The texture map is used as a color source and will either be 0xFFFFFFFF or 0x00000000 for any given texel.
@@ -335,7 +418,7 @@ void TextureShadowComparatorTests::TestRawValues(uint32_t depth_format, uint32_t
     const float kTop = 100.0f;
     const float kBottom = host_.GetFramebufferHeightF() - kTop;
 
-    const auto tex_depth = static_cast<float>(ref);
+    const float tex_depth = ref;
     const float z = 1.5f;
     host_.Begin(TestHost::PRIMITIVE_QUADS);
     host_.SetDiffuse(0xFF2277FF);
@@ -387,13 +470,6 @@ void TextureShadowComparatorTests::TestRawValues(uint32_t depth_format, uint32_t
       host_.End();
     }
   }
-
-  pb_print("%s\n", name.c_str());
-  pb_print("Rng 0x%X-0x%x\n", min_val, max_val);
-  pb_print("Ref, edges, center: 0x%X\n", ref);
-  pb_draw_text_screen();
-
-  host_.FinishDraw(allow_saving_, output_dir_, name);
 }
 
 void TextureShadowComparatorTests::TestPerspective(uint32_t depth_format, bool float_depth, uint32_t texture_format,
@@ -409,9 +485,10 @@ void TextureShadowComparatorTests::TestPerspective(uint32_t depth_format, bool f
   p = pb_push1(p, NV097_SET_DEPTH_MASK, true);
   p = pb_push1(p, NV097_SET_DEPTH_FUNC, NV097_SET_DEPTH_FUNC_V_ALWAYS);
 
-  // Point the depth buffer at the base of texture memory.
+  // Point the depth buffer at the texture memory of stage 0.
   p = pb_push1(p, NV097_SET_CONTEXT_DMA_ZETA, texture_target_ctx_.ChannelID);
-  p = pb_push1(p, NV097_SET_SURFACE_ZETA_OFFSET, reinterpret_cast<uint32_t>(host_.GetTextureMemory()) & 0x03FFFFFF);
+  p = pb_push1(p, NV097_SET_SURFACE_ZETA_OFFSET,
+               reinterpret_cast<uint32_t>(host_.GetTextureStageMemory(0)) & 0x03FFFFFF);
   pb_end(p);
 
   host_.PrepareDraw(0xFE332211);
@@ -515,7 +592,7 @@ void TextureShadowComparatorTests::TestPerspective(uint32_t depth_format, bool f
     std::string z_buffer_name = name + "_DT";
     const uint32_t bpp = depth_format == NV097_SET_SURFACE_FORMAT_ZETA_Z16 ? 16 : 32;
 
-    host_.SaveRawTexture(output_dir_, z_buffer_name, host_.GetTextureMemory(), host_.GetFramebufferWidth(),
+    host_.SaveRawTexture(output_dir_, z_buffer_name, host_.GetTextureStageMemory(0), host_.GetFramebufferWidth(),
                          host_.GetFramebufferHeight(), texture_pitch, bpp);
   }
 #endif
@@ -552,6 +629,7 @@ void TextureShadowComparatorTests::TestPerspective(uint32_t depth_format, bool f
   p = pb_begin();
   p = pb_push1(p, NV097_SET_TEXTURE_CONTROL1, texture_pitch << 16);
   pb_end(p);
+  host_.GetShadowRegisters().Invalidate(NV097_SET_TEXTURE_CONTROL1);
 
   float tex_depth = ref;
   {
@@ -20,8 +20,13 @@ class TextureShadowComparatorTests : public TestSuite {
 
  private:
   void TestRawValues(uint32_t depth_format, uint32_t texture_format, uint32_t shadow_comp_function, uint32_t min_val, uint32_t max_val, uint32_t ref, const std::string &name);
+  void TestRawFloatValues(uint32_t texture_format, uint32_t shadow_comp_function, float min_val, float max_val, float ref, const std::string &name);
   void TestPerspective(uint32_t depth_format, bool float_depth, uint32_t texture_format, uint32_t shadow_comp_function, float min_val, float max_val, float ref, const std::string &name);
 
+  // Draws a quad textured by the depth values in the memory of stage 0, compared against `ref`, followed by markers
+  // over the boxes of known values.
+  void DrawRawValueComparison(uint32_t texture_format, uint32_t shadow_comp_function, float ref);
+
  private:
   struct s_CtxDma texture_target_ctx_ {};
   std::shared_ptr<PrecalculatedVertexShader> raw_value_shader_;
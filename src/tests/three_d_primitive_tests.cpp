@@ -3,6 +3,7 @@
 #include <pbkit/pbkit.h>
 
 #include "pbkit_ext.h"
+#include "primitive_topology.h"
 #include "test_host.h"
 #include "vertex_buffer.h"
 
@@ -12,6 +13,10 @@ static constexpr ThreeDPrimitiveTests::DrawMode kDrawModes[] = {
     ThreeDPrimitiveTests::DRAW_INLINE_BUFFERS,
     ThreeDPrimitiveTests::DRAW_INLINE_ARRAYS,
     ThreeDPrimitiveTests::DRAW_INLINE_ELEMENTS,
+    ThreeDPrimitiveTests::DRAW_ARRAYS_COMPACT,
+    ThreeDPrimitiveTests::DRAW_INLINE_ARRAYS_COMPACT,
+    ThreeDPrimitiveTests::DRAW_INLINE_ELEMENTS_CONVERTED,
+    ThreeDPrimitiveTests::DRAW_INLINE_ELEMENTS_WIREFRAME,
 };
 
 static constexpr TestHost::DrawPrimitive kPrimitives[] = {
@@ -35,6 +40,22 @@ static constexpr float kBottom = -1.75f;
 static constexpr float kZFront = 1.0f;
 static constexpr float kZBack = 5.0f;
 
+// Returns the list primitive that draws the same points, lines or faces as `primitive`.
+static TestHost::DrawPrimitive GetListPrimitive(TestHost::DrawPrimitive primitive) {
+  switch (primitive) {
+    case TestHost::PRIMITIVE_POINTS:
+      return TestHost::PRIMITIVE_POINTS;
+
+    case TestHost::PRIMITIVE_LINES:
+    case TestHost::PRIMITIVE_LINE_LOOP:
+    case TestHost::PRIMITIVE_LINE_STRIP:
+      return TestHost::PRIMITIVE_LINES;
+
+    default:
+      return TestHost::PRIMITIVE_TRIANGLES;
+  }
+}
+
 ThreeDPrimitiveTests::ThreeDPrimitiveTests(TestHost& host, std::string output_dir)
     : TestSuite(host, std::move(output_dir), "3D primitive") {
   for (const auto primitive : kPrimitives) {
@@ -367,6 +388,29 @@ void ThreeDPrimitiveTests::Test(TestHost::DrawPrimitive primitive, DrawMode draw
     case DRAW_INLINE_ARRAYS:
       host_.DrawInlineArray(vertex_elements, primitive);
       break;
+
+    case DRAW_ARRAYS_COMPACT:
+      host_.GetVertexBuffer()->SetCompactLayout(vertex_elements);
+      host_.DrawArrays(vertex_elements, primitive);
+      break;
+
+    case DRAW_INLINE_ARRAYS_COMPACT:
+      host_.GetVertexBuffer()->SetCompactLayout(vertex_elements);
+      host_.DrawInlineArray(vertex_elements, primitive);
+      break;
+
+    case DRAW_INLINE_ELEMENTS_CONVERTED: {
+      const auto list_primitive = GetListPrimitive(primitive);
+      const IndexBuffer indices(ConvertTopology(index_buffer_, primitive, list_primitive));
+      host_.DrawInlineElements(indices, vertex_elements, list_primitive);
+    } break;
+
+    case DRAW_INLINE_ELEMENTS_WIREFRAME: {
+      const auto line_primitive =
+          primitive == TestHost::PRIMITIVE_POINTS ? TestHost::PRIMITIVE_POINTS : TestHost::PRIMITIVE_LINES;
+      const IndexBuffer indices(ConvertTopology(index_buffer_, primitive, line_primitive));
+      host_.DrawInlineElements(indices, vertex_elements, line_primitive);
+    } break;
   }
 
   std::string name = MakeTestName(primitive, draw_mode);
@@ -394,6 +438,22 @@ std::string ThreeDPrimitiveTests::MakeTestName(TestHost::DrawPrimitive primitive
     case DRAW_INLINE_ELEMENTS:
       ret += "-inlineelements";
       break;
+
+    case DRAW_ARRAYS_COMPACT:
+      ret += "-compact";
+      break;
+
+    case DRAW_INLINE_ARRAYS_COMPACT:
+      ret += "-inlinearrays-compact";
+      break;
+
+    case DRAW_INLINE_ELEMENTS_CONVERTED:
+      ret += "-converted";
+      break;
+
+    case DRAW_INLINE_ELEMENTS_WIREFRAME:
+      ret += "-wireframe";
+      break;
   }
 
   return std::move(ret);
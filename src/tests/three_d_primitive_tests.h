@@ -19,6 +19,13 @@ class ThreeDPrimitiveTests : public TestSuite {
     DRAW_INLINE_BUFFERS,
     DRAW_INLINE_ARRAYS,
     DRAW_INLINE_ELEMENTS,
+    // Draw from a compact vertex layout containing only the enabled attributes.
+    DRAW_ARRAYS_COMPACT,
+    DRAW_INLINE_ARRAYS_COMPACT,
+    // Draw the same vertices as the equivalent list primitive via generated indices.
+    DRAW_INLINE_ELEMENTS_CONVERTED,
+    // Draw each edge of the primitive once as a line via generated indices.
+    DRAW_INLINE_ELEMENTS_WIREFRAME,
   };
 
  public:
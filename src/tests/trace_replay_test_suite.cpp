@@ -0,0 +1,360 @@
+#include "trace_replay_test_suite.h"
+
+#include <pbkit/pbkit.h>
+
+#include <cstring>
+
+#include "debug_output.h"
+#include "gpu_wait.h"
+#include "pbkit_ext.h"
+#include "test_host.h"
+#include "vertex_buffer.h"
+
+static constexpr uint32_t kNumTextureStages = 4;
+static constexpr uint32_t kTextureStageMethodStride = 0x40;
+static constexpr uint32_t kNumVertexAttributes = 16;
+
+// Mask of the bits of NV097_SET_TEXTURE_PALETTE that hold the palette address.
+static constexpr uint32_t kPaletteAddressMask = 0x03FFFFC0;
+
+static bool IsStageMethod(uint32_t method, uint32_t stage_0_method) {
+  return method >= stage_0_method && method < stage_0_method + kNumTextureStages * kTextureStageMethodStride &&
+         !((method - stage_0_method) % kTextureStageMethodStride);
+}
+
+TraceReplayTestSuite::TraceReplayTestSuite(TestHost &host, std::string output_dir, std::string trace_path)
+    : TestSuite(host, std::move(output_dir), "Trace replay"), trace_path_(std::move(trace_path)) {
+  PushBufferTraceReader reader;
+  if (!reader.Open(trace_path_.c_str())) {
+    PrintMsg("Failed to open push buffer trace '%s'\n", trace_path_.c_str());
+    return;
+  }
+
+  // Each FinishDraw marker in the trace is a test. Test names are prefixed with their position in the trace so that
+  // RunAll replays them in order and each test can continue from where the previous one stopped.
+  uint32_t test_index = 0;
+  PushBufferTraceRecordType type;
+  uint32_t size;
+  while (reader.NextRecord(type, size)) {
+    if (type != kTraceRecordFinishDraw) {
+      continue;
+    }
+
+    // Payload is "<output_directory>\0<name>\0".
+    std::string payload(size, 0);
+    payload.resize(reader.ReadPayload(&payload[0], size));
+    auto directory_end = payload.find('\0');
+    std::string directory = payload.substr(0, directory_end);
+    std::string name = directory_end == std::string::npos ? "" : payload.c_str() + directory_end + 1;
+
+    auto suite_start = directory.find_last_of('\\');
+    std::string suite = suite_start == std::string::npos ? directory : directory.substr(suite_start + 1);
+
+    char prefix[16];
+    snprintf(prefix, 15, "%04u_", test_index);
+    std::string test_name = prefix + suite + "_" + name;
+    tests_[test_name] = [this, test_index, test_name]() { this->Test(test_index, test_name); };
+    ++test_index;
+  }
+}
+
+void TraceReplayTestSuite::Initialize() {
+  // The trace contains all of the state set up by the suites that were recorded, so the standard initialization is
+  // intentionally skipped.
+  host_.GetShadowRegisters().Invalidate();
+
+  if (!reader_.Open(trace_path_.c_str())) {
+    PrintMsg("Failed to open push buffer trace '%s'\n", trace_path_.c_str());
+  }
+  Restart();
+}
+
+void TraceReplayTestSuite::Deinitialize() {
+  EndSpan();
+  WaitForIdle();
+  regions_.clear();
+  reader_.Close();
+
+  // The replayed commands bypassed the shadow register file.
+  host_.GetShadowRegisters().Invalidate();
+}
+
+void TraceReplayTestSuite::Restart() {
+  EndSpan();
+  WaitForIdle();
+
+  reader_.Rewind();
+  next_test_index_ = 0;
+  regions_.clear();
+
+  memset(subchannel_classes_, 0, sizeof(subchannel_classes_));
+  subchannel_classes_[SUBCH_3D] = GR_CLASS_97;
+
+  remaining_params_ = 0;
+}
+
+void TraceReplayTestSuite::Test(uint32_t test_index, const std::string &name) {
+  if (!reader_.IsOpen()) {
+    PrintMsg("Push buffer trace '%s' is not open\n", trace_path_.c_str());
+    return;
+  }
+
+  if (test_index < next_test_index_) {
+    Restart();
+  }
+
+  // Tests preceding the requested one are executed to reproduce the GPU state but are not presented.
+  PushBufferTraceRecordType type;
+  uint32_t size;
+  while (reader_.NextRecord(type, size)) {
+    if (type != kTraceRecordCommands && remaining_params_) {
+      PrintMsg("Discarding %u parameters of truncated packet 0x%X\n", remaining_params_, packet_method_);
+      remaining_params_ = 0;
+      CloseSubPacket();
+    }
+
+    switch (type) {
+      case kTraceRecordCommands:
+        ReplayCommands();
+        break;
+
+      case kTraceRecordPrepareDraw:
+        EndSpan();
+        if (next_test_index_ == test_index) {
+          pb_wait_for_vbl();
+        } else {
+          WaitForIdle();
+        }
+        pb_reset();
+        break;
+
+      case kTraceRecordFinishDraw:
+        EndSpan();
+        if (next_test_index_++ == test_index) {
+          host_.FinishDraw(allow_saving_, output_dir_, name);
+          return;
+        }
+        WaitForIdle();
+        break;
+
+      case kTraceRecordBindSubchannel: {
+        PushBufferTraceBindSubchannel binding{};
+        if (reader_.ReadPayload(&binding, sizeof(binding)) == sizeof(binding) &&
+            binding.subchannel < kNumSubchannels) {
+          subchannel_classes_[binding.subchannel] = binding.object_class;
+        }
+      } break;
+
+      case kTraceRecordMemoryRegion:
+        DeclareRegion();
+        break;
+
+      case kTraceRecordMemoryData:
+        RestoreMemory();
+        break;
+
+      default:
+        // Unknown records are skipped so that newer traces can be replayed.
+        break;
+    }
+  }
+
+  EndSpan();
+  PrintMsg("Push buffer trace ended before test %u (%s)\n", test_index, name.c_str());
+}
+
+void TraceReplayTestSuite::ReplayCommands() {
+  while (reader_.GetRemainingPayload()) {
+    uint32_t num_dwords = reader_.ReadPayload(chunk_, sizeof(chunk_)) / 4;
+    if (!num_dwords) {
+      return;
+    }
+
+    for (uint32_t i = 0; i < num_dwords; ++i) {
+      ReplayCommand(chunk_[i]);
+    }
+  }
+}
+
+void TraceReplayTestSuite::ReplayCommand(uint32_t value) {
+  if (remaining_params_) {
+    if (!sub_packet_header_ || span_end_ - span_start_ >= kMaxReplaySpanDWORDs) {
+      EnsureSpan(2);
+      sub_packet_header_ = span_end_++;
+      sub_packet_method_ = packet_method_;
+      sub_packet_params_ = 0;
+    }
+
+    *span_end_++ = Relocate(packet_subchannel_, packet_method_, value);
+    ++sub_packet_params_;
+    if (!packet_non_increasing_) {
+      packet_method_ += 4;
+    }
+    if (!--remaining_params_) {
+      CloseSubPacket();
+    }
+    return;
+  }
+
+  // Jumps and calls refer to the push buffer of the original run. pbkit manages control flow itself, so they are
+  // dropped.
+  if (TraceCommandIsControlFlow(value)) {
+    return;
+  }
+
+  packet_subchannel_ = TraceCommandSubchannel(value);
+  packet_method_ = TraceCommandMethod(value);
+  packet_non_increasing_ = TraceCommandIsNonIncreasing(value);
+  remaining_params_ = TraceCommandCount(value);
+
+  if (!remaining_params_) {
+    EnsureSpan(1);
+    *span_end_++ = value;
+  }
+}
+
+void TraceReplayTestSuite::DeclareRegion() {
+  PushBufferTraceMemoryRegion region{};
+  if (reader_.ReadPayload(&region, sizeof(region)) != sizeof(region)) {
+    return;
+  }
+
+  for (auto it = regions_.begin(); it != regions_.end(); ++it) {
+    if (it->recorded_address == region.address) {
+      // The GPU may still be reading from the memory being replaced.
+      EndSpan();
+      WaitForIdle();
+      regions_.erase(it);
+      break;
+    }
+  }
+
+  ReplayRegion replay{static_cast<PushBufferTraceMemoryKind>(region.kind), region.address, region.size, nullptr, {}};
+  uint8_t *texture_memory_end = host_.GetTextureMemory() + host_.GetTextureMemorySize();
+  switch (region.kind) {
+    case kTraceMemoryTexture:
+      replay.memory = host_.GetTextureMemory();
+      break;
+
+    case kTraceMemoryPalette:
+      replay.memory = host_.GetPaletteMemory();
+      break;
+
+    case kTraceMemoryVertex: {
+      uint32_t num_vertices = (region.size + sizeof(Vertex) - 1) / sizeof(Vertex);
+      replay.vertex_buffer = std::make_shared<VertexBuffer>(num_vertices);
+      replay.memory = reinterpret_cast<uint8_t *>(replay.vertex_buffer->Lock());
+      texture_memory_end = nullptr;
+    } break;
+
+    default:
+      PrintMsg("Ignoring memory region of unknown kind %u\n", region.kind);
+      return;
+  }
+
+  if (texture_memory_end && replay.memory + region.size > texture_memory_end) {
+    PrintMsg("Memory region of %u bytes at 0x%X does not fit in texture memory\n", region.size, region.address);
+    return;
+  }
+
+  regions_.push_back(replay);
+}
+
+void TraceReplayTestSuite::RestoreMemory() {
+  PushBufferTraceMemoryData header{};
+  if (reader_.ReadPayload(&header, sizeof(header)) != sizeof(header)) {
+    return;
+  }
+
+  const uint32_t size = reader_.GetRemainingPayload();
+  uint8_t *destination = nullptr;
+  for (auto &region : regions_) {
+    if (header.address >= region.recorded_address && header.address - region.recorded_address <= region.size &&
+        size <= region.size - (header.address - region.recorded_address)) {
+      destination = region.memory + (header.address - region.recorded_address);
+      break;
+    }
+  }
+
+  if (!destination) {
+    PrintMsg("Ignoring %u bytes of data for untracked address 0x%X\n", size, header.address);
+    return;
+  }
+
+  // Previously replayed commands may still be reading the memory.
+  EndSpan();
+  WaitForIdle();
+  reader_.ReadPayload(destination, size);
+}
+
+uint32_t TraceReplayTestSuite::Relocate(uint32_t subchannel, uint32_t method, uint32_t value) const {
+  uint32_t mask = 0;
+  const uint32_t object_class = subchannel_classes_[subchannel];
+  if (object_class == GR_CLASS_97) {
+    if (IsStageMethod(method, NV097_SET_TEXTURE_OFFSET)) {
+      mask = kTraceAddressMask;
+    } else if (IsStageMethod(method, NV097_SET_TEXTURE_PALETTE)) {
+      mask = kPaletteAddressMask;
+    } else if (method >= NV097_SET_VERTEX_DATA_ARRAY_OFFSET &&
+               method < NV097_SET_VERTEX_DATA_ARRAY_OFFSET + kNumVertexAttributes * 4) {
+      mask = kTraceAddressMask;
+    } else if (method == NV097_SET_SURFACE_COLOR_OFFSET || method == NV097_SET_SURFACE_ZETA_OFFSET) {
+      mask = kTraceAddressMask;
+    }
+  } else if (object_class == GR_CLASS_62) {
+    if (method == NV062_SET_OFFSET_SOURCE || method == NV062_SET_OFFSET_DESTIN) {
+      mask = kTraceAddressMask;
+    }
+  }
+
+  if (!mask) {
+    return value;
+  }
+
+  const uint32_t address = value & mask;
+  for (auto &region : regions_) {
+    if (address >= region.recorded_address && address - region.recorded_address < region.size) {
+      uint32_t relocated = (reinterpret_cast<uint32_t>(region.memory) & kTraceAddressMask) + address -
+                           region.recorded_address;
+      return (value & ~mask) | (relocated & mask);
+    }
+  }
+
+  return value;
+}
+
+void TraceReplayTestSuite::EnsureSpan(uint32_t num_dwords) {
+  if (span_start_ && span_end_ - span_start_ + num_dwords > kMaxReplaySpanDWORDs) {
+    EndSpan();
+  }
+
+  if (!span_start_) {
+    span_start_ = pb_begin();
+    span_end_ = span_start_;
+  }
+}
+
+void TraceReplayTestSuite::CloseSubPacket() {
+  if (!sub_packet_header_) {
+    return;
+  }
+
+  uint32_t header = (sub_packet_params_ << 18) | (packet_subchannel_ << 13) | sub_packet_method_;
+  if (packet_non_increasing_) {
+    header = NV2A_SUPPRESS_COMMAND_INCREMENT(header);
+  }
+  *sub_packet_header_ = header;
+  sub_packet_header_ = nullptr;
+}
+
+void TraceReplayTestSuite::EndSpan() {
+  CloseSubPacket();
+
+  if (span_start_) {
+    pb_end(span_end_);
+  }
+  span_start_ = nullptr;
+  span_end_ = nullptr;
+}
+
+void TraceReplayTestSuite::WaitForIdle() { WAIT_FOR_GPU_IDLE(); }
@@ -0,0 +1,88 @@
+#ifndef NXDK_PGRAPH_TESTS_TRACE_REPLAY_TEST_SUITE_H
+#define NXDK_PGRAPH_TESTS_TRACE_REPLAY_TEST_SUITE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pushbuffer_trace.h"
+#include "pushbuffer_writer.h"
+#include "test_suite.h"
+
+class TestHost;
+class VertexBuffer;
+
+// Re-executes a push buffer trace captured by PushBufferRecorder (see pushbuffer_trace.h).
+//
+// Every test recorded in the trace becomes a test in this suite. Running a test streams the trace back into the push
+// buffer from the start, restoring captured texture, palette and vertex data and relocating the addresses that refer
+// to them, and captures the output of the recorded test via the usual FinishDraw path. The tests that precede it are
+// executed without being presented so that the GPU state matches the original run.
+//
+// The trace is read in bounded chunks, so its size is limited only by the storage it is read from.
+class TraceReplayTestSuite : public TestSuite {
+ public:
+  TraceReplayTestSuite(TestHost &host, std::string output_dir, std::string trace_path);
+
+  void Initialize() override;
+  void Deinitialize() override;
+
+ private:
+  // A block of memory captured in the trace and the memory that it is restored into.
+  struct ReplayRegion {
+    PushBufferTraceMemoryKind kind;
+    uint32_t recorded_address;
+    uint32_t size;
+    uint8_t *memory;
+    std::shared_ptr<VertexBuffer> vertex_buffer;
+  };
+
+  void Test(uint32_t test_index, const std::string &name);
+
+  // Returns to the beginning of the trace and discards all replay state.
+  void Restart();
+
+  void ReplayCommands();
+  void ReplayCommand(uint32_t value);
+  void DeclareRegion();
+  void RestoreMemory();
+
+  uint32_t Relocate(uint32_t subchannel, uint32_t method, uint32_t value) const;
+
+  // Push buffer span management. Long packets are split so that spans never exceed kMaxReplaySpanDWORDs.
+  void EnsureSpan(uint32_t num_dwords);
+  void CloseSubPacket();
+  void EndSpan();
+  static void WaitForIdle();
+
+ private:
+  static constexpr uint32_t kNumSubchannels = 8;
+  static constexpr uint32_t kMaxReplaySpanDWORDs = PushBufferWriter::kMaxSpanDWORDs;
+  static constexpr uint32_t kChunkDWORDs = 8 * 1024;
+
+  std::string trace_path_;
+  PushBufferTraceReader reader_;
+
+  // Index of the recorded test whose commands begin at the current position of reader_.
+  uint32_t next_test_index_{0};
+
+  std::vector<ReplayRegion> regions_;
+  uint32_t subchannel_classes_[kNumSubchannels]{};
+
+  // State of the packet currently being replayed, which may continue into the next chunk.
+  uint32_t remaining_params_{0};
+  uint32_t packet_subchannel_{0};
+  uint32_t packet_method_{0};
+  bool packet_non_increasing_{false};
+
+  uint32_t *span_start_{nullptr};
+  uint32_t *span_end_{nullptr};
+  // Header of the portion of the current packet that has been written to the current span.
+  uint32_t *sub_packet_header_{nullptr};
+  uint32_t sub_packet_method_{0};
+  uint32_t sub_packet_params_{0};
+
+  uint32_t chunk_[kChunkDWORDs];
+};
+
+#endif  // NXDK_PGRAPH_TESTS_TRACE_REPLAY_TEST_SUITE_H
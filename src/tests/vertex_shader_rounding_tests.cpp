@@ -48,8 +48,7 @@ void VertexShaderRoundingTests::Initialize() {
   pb_bind_channel(&texture_target_ctx_);
 
   const uint32_t texture_size = kTexturePitch * kTextureHeight;
-  render_target_ =
-      (uint8_t *)MmAllocateContiguousMemoryEx(texture_size, 0, MAXRAM, 0x1000, PAGE_WRITECOMBINE | PAGE_READWRITE);
+  render_target_ = host_.AllocateTextureMemory(texture_size, 0x1000);
   ASSERT(render_target_ && "Failed to allocate target surface.");
   auto *pixel = reinterpret_cast<uint32_t *>(render_target_);
   for (uint32_t i = 0; i < kTextureWidth * kTextureHeight; ++i) {
@@ -67,9 +66,8 @@ void VertexShaderRoundingTests::Initialize() {
 
 void VertexShaderRoundingTests::Deinitialize() {
   TestSuite::Deinitialize();
-  if (render_target_) {
-    MmFreeContiguousMemory(render_target_);
-  }
+  host_.FreeTextureMemory(render_target_);
+  render_target_ = nullptr;
 }
 
 void VertexShaderRoundingTests::CreateGeometry() {
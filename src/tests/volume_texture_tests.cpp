@@ -7,6 +7,7 @@
 #include <utility>
 
 #include "debug_output.h"
+#include "nxdk_ext.h"
 #include "shaders/perspective_vertex_shader.h"
 #include "test_host.h"
 #include "texture_format.h"
@@ -22,6 +23,10 @@ static const uint32_t kTextureWidth = 256;
 static const uint32_t kTextureHeight = 256;
 static const uint32_t kTextureDepth = 4;
 
+// Dimensions of the volume generated one slice at a time by TestStreamed.
+static const uint32_t kStreamedTextureSize = 128;
+static const char kStreamedTestName[] = "Streamed 128x128x128";
+
 static const uint32_t kNumQuads = 7;
 
 static bool RequiresSpecialTest(const TextureFormatInfo &format) {
@@ -30,6 +35,8 @@ static bool RequiresSpecialTest(const TextureFormatInfo &format) {
     case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FIXED:
     case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FLOAT:
     case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_X8_Y24_FIXED:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_DEPTH_Y16_FIXED:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_DEPTH_Y16_FLOAT:
       return true;
 
     default:
@@ -53,6 +60,8 @@ VolumeTextureTests::VolumeTextureTests(TestHost &host, std::string output_dir)
 
   auto palettized = GetTextureFormatInfo(NV097_SET_TEXTURE_FORMAT_COLOR_SZ_I8_A8R8G8B8);
   tests_[palettized.name] = [this]() { TestPalettized(); };
+
+  tests_[kStreamedTestName] = [this]() { TestStreamed(); };
 }
 
 void VolumeTextureTests::Initialize() {
@@ -219,6 +228,42 @@ void VolumeTextureTests::TestPalettized() {
   host_.FinishDraw(allow_saving_, output_dir_, texture_format.name);
 }
 
+void VolumeTextureTests::TestStreamed() {
+  auto &texture_format = GetTextureFormatInfo(NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A8R8G8B8);
+  host_.SetTextureFormat(texture_format);
+
+  const uint32_t size = kStreamedTextureSize;
+  auto &stage = host_.GetTextureStage(0);
+  stage.SetTextureDimensions(size, size, size);
+  stage.SetImageDimensions(size, size, size);
+
+  // Each channel ramps along one axis, with alternating 16 texel cubes darkened to make the slices distinguishable.
+  auto generate_slice = [size](uint32_t slice, SDL_Surface *surface) {
+    const uint32_t blue = slice * 255 / (size - 1);
+    for (uint32_t y = 0; y < size; ++y) {
+      auto pixels = reinterpret_cast<uint32_t *>(static_cast<uint8_t *>(surface->pixels) + y * surface->pitch);
+      const uint32_t green = y * 255 / (size - 1);
+      for (uint32_t x = 0; x < size; ++x) {
+        const uint32_t red = x * 255 / (size - 1);
+        const uint32_t shift = ((x >> 4) ^ (y >> 4) ^ (slice >> 4)) & 1;
+        pixels[x] = SDL_MapRGBA(surface->format, red >> shift, green >> shift, blue >> shift, 0xFF);
+      }
+    }
+  };
+
+  int err = host_.SetVolumetricTexture(size, size, size, generate_slice);
+  ASSERT(!err && "Failed to set texture");
+
+  host_.PrepareDraw(kBackgroundColor);
+  host_.DrawArrays(TestHost::POSITION | TestHost::DIFFUSE | TestHost::TEXCOORD0);
+
+  pb_print("N: %s\n", kStreamedTestName);
+  pb_print("F: 0x%x\n", texture_format.xbox_format);
+  pb_draw_text_screen();
+
+  host_.FinishDraw(allow_saving_, output_dir_, kStreamedTestName);
+}
+
 static int GenerateSurface(SDL_Surface **gradient_surface, int width, int height, int layer) {
   *gradient_surface = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_RGBA8888);
   if (!(*gradient_surface)) {
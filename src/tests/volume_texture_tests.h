@@ -20,6 +20,7 @@ class VolumeTextureTests : public TestSuite {
 
   void Test(const TextureFormatInfo &texture_format);
   void TestPalettized();
+  void TestStreamed();
 };
 
 #endif  // NXDK_PGRAPH_TESTS_VOLUME_TEXTURE_TESTS_H
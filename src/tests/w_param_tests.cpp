@@ -2,8 +2,11 @@
 
 #include <pbkit/pbkit.h>
 
+#include <cstring>
+
 #include "../test_host.h"
 #include "debug_output.h"
+#include "primitive_topology.h"
 #include "shaders/precalculated_vertex_shader.h"
 #include "vertex_buffer.h"
 
@@ -26,6 +29,7 @@ void WParamTests::Initialize() {
 void WParamTests::Deinitialize() {
   triangle_strip_.reset();
   triangles_.reset();
+  triangle_indices_.Clear();
   TestSuite::Deinitialize();
 }
 
@@ -108,8 +112,15 @@ void WParamTests::CreateGeometryWGaps() {
 
   triangle_strip_->Unlock();
 
-  triangles_ = triangle_strip_->ConvertFromTriangleStripToTriangles();
+  // The triangles are drawn from an offset copy of the strip's vertices, indexed as a triangle list.
+  const uint32_t num_vertices = triangle_strip_->GetNumVertices();
+  triangles_ = host_.AllocateVertexBuffer(num_vertices);
+  memcpy(triangles_->Lock(), triangle_strip_->Lock(), num_vertices * sizeof(Vertex));
+  triangles_->Unlock();
+  triangle_strip_->Unlock();
   triangles_->Translate(-6.0f, 6.0f + (bottom - top) * 0.5f, 0.0f, 0.0f);
+  triangle_indices_.SetIndices(
+      ConvertTopology(num_vertices, TestHost::PRIMITIVE_TRIANGLE_STRIP, TestHost::PRIMITIVE_TRIANGLES));
 }
 
 void WParamTests::TestWGaps() {
@@ -135,7 +146,7 @@ void WParamTests::TestWGaps() {
   pb_end(p);
 
   host_.SetVertexBuffer(triangles_);
-  host_.DrawArrays(TestHost::POSITION | TestHost::DIFFUSE);
+  host_.DrawInlineElements(triangle_indices_, TestHost::POSITION | TestHost::DIFFUSE);
 
   p = pb_begin();
   p = pb_push1(p, NV097_SET_FRONT_POLYGON_MODE, NV097_SET_FRONT_POLYGON_MODE_V_LINE);
@@ -145,7 +156,7 @@ void WParamTests::TestWGaps() {
   p = pb_push1(p, NV097_SET_DIFFUSE_COLOR4I, 0xFFFFFFFF);
   pb_end(p);
 
-  host_.DrawArrays(TestHost::POSITION);
+  host_.DrawInlineElements(triangle_indices_, TestHost::POSITION);
 
   p = pb_begin();
   p = pb_push1(p, NV097_SET_FRONT_POLYGON_MODE, NV097_SET_FRONT_POLYGON_MODE_V_FILL);
@@ -1,6 +1,7 @@
 #ifndef NXDK_PGRAPH_TESTS_INF_TESTS_H
 #define NXDK_PGRAPH_TESTS_INF_TESTS_H
 
+#include "index_buffer.h"
 #include "test_suite.h"
 
 class TestHost;
@@ -26,6 +27,7 @@ class WParamTests : public TestSuite {
  private:
   std::shared_ptr<VertexBuffer> triangle_strip_;
   std::shared_ptr<VertexBuffer> triangles_;
+  IndexBuffer triangle_indices_;
 };
 
 #endif  // NXDK_PGRAPH_TESTS_INF_TESTS_H
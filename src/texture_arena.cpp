@@ -0,0 +1,110 @@
+#include "texture_arena.h"
+
+void TextureArena::Initialize(uint32_t size) {
+  blocks_.clear();
+  blocks_.push_back({0, size, true});
+  size_ = size;
+  used_size_ = 0;
+  peak_used_size_ = 0;
+}
+
+uint32_t TextureArena::Allocate(uint32_t size, uint32_t alignment) {
+  if (!size) {
+    return kInvalidOffset;
+  }
+
+  auto best = blocks_.end();
+  uint32_t best_padding = 0;
+  for (auto it = blocks_.begin(); it != blocks_.end(); ++it) {
+    if (!it->free) {
+      continue;
+    }
+
+    const uint32_t aligned = (it->offset + alignment - 1) & ~(alignment - 1);
+    const uint32_t padding = aligned - it->offset;
+    if (padding >= it->size || it->size - padding < size) {
+      continue;
+    }
+
+    if (best == blocks_.end() || it->size < best->size) {
+      best = it;
+      best_padding = padding;
+    }
+  }
+
+  if (best == blocks_.end()) {
+    return kInvalidOffset;
+  }
+
+  // Split off the alignment padding and any remainder as free blocks on either side of the allocation.
+  const uint32_t remainder = best->size - best_padding - size;
+  if (best_padding) {
+    best = blocks_.insert(best, {best->offset, best_padding, true}) + 1;
+    best->offset += best_padding;
+  }
+  best->size = size;
+  best->free = false;
+  const uint32_t offset = best->offset;
+  if (remainder) {
+    blocks_.insert(best + 1, {offset + size, remainder, true});
+  }
+
+  used_size_ += size;
+  if (used_size_ > peak_used_size_) {
+    peak_used_size_ = used_size_;
+  }
+  return offset;
+}
+
+void TextureArena::Free(uint32_t offset) {
+  for (auto it = blocks_.begin(); it != blocks_.end(); ++it) {
+    if (it->offset != offset || it->free) {
+      continue;
+    }
+
+    used_size_ -= it->size;
+    it->free = true;
+
+    auto next = it + 1;
+    if (next != blocks_.end() && next->free) {
+      it->size += next->size;
+      it = blocks_.erase(next) - 1;
+    }
+    if (it != blocks_.begin()) {
+      auto previous = it - 1;
+      if (previous->free) {
+        previous->size += it->size;
+        blocks_.erase(it);
+      }
+    }
+    return;
+  }
+}
+
+uint32_t TextureArena::GetAllocationSize(uint32_t offset) const {
+  for (auto &block : blocks_) {
+    if (block.offset == offset && !block.free) {
+      return block.size;
+    }
+  }
+  return 0;
+}
+
+uint32_t TextureArena::GetLargestFreeBlock() const {
+  uint32_t largest = 0;
+  for (auto &block : blocks_) {
+    if (block.free && block.size > largest) {
+      largest = block.size;
+    }
+  }
+  return largest;
+}
+
+uint32_t TextureArena::GetFragmentationPercent() const {
+  const uint32_t free_size = GetFreeSize();
+  if (!free_size) {
+    return 0;
+  }
+  const uint64_t fragmented = free_size - GetLargestFreeBlock();
+  return static_cast<uint32_t>(fragmented * 100 / free_size);
+}
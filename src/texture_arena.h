@@ -0,0 +1,53 @@
+#ifndef NXDK_PGRAPH_TESTS_TEXTURE_ARENA_H
+#define NXDK_PGRAPH_TESTS_TEXTURE_ARENA_H
+
+#include <cstdint>
+#include <vector>
+
+// Manages variable sized allocations within a single contiguous block of texture memory.
+//
+// Allocations are identified by their offset from the start of the block. Free space is tracked as a list of blocks
+// ordered by offset; allocations are placed in the smallest free block that can hold them after alignment and adjacent
+// free blocks are merged when an allocation is released.
+class TextureArena {
+ public:
+  static constexpr uint32_t kInvalidOffset = 0xFFFFFFFF;
+
+  // Discards all allocations and resets the arena to manage `size` bytes.
+  void Initialize(uint32_t size);
+
+  // Returns the offset of a new allocation of `size` bytes aligned to `alignment`, which must be a power of two, or
+  // kInvalidOffset if no free block is large enough.
+  uint32_t Allocate(uint32_t size, uint32_t alignment);
+  void Free(uint32_t offset);
+
+  // Returns the size of the allocation at `offset`, or 0 if there is none.
+  uint32_t GetAllocationSize(uint32_t offset) const;
+
+  uint32_t GetSize() const { return size_; }
+  uint32_t GetUsedSize() const { return used_size_; }
+  uint32_t GetPeakUsedSize() const { return peak_used_size_; }
+  void ResetPeakUsedSize() { peak_used_size_ = used_size_; }
+
+  uint32_t GetFreeSize() const { return size_ - used_size_; }
+  uint32_t GetLargestFreeBlock() const;
+  // Returns the percentage of free memory that lies outside of the largest free block and is therefore unusable by an
+  // allocation of the size of all free memory.
+  uint32_t GetFragmentationPercent() const;
+
+ private:
+  struct Block {
+    uint32_t offset;
+    uint32_t size;
+    bool free;
+  };
+
+  // Covers the whole arena, ordered by offset.
+  std::vector<Block> blocks_;
+
+  uint32_t size_{0};
+  uint32_t used_size_{0};
+  uint32_t peak_used_size_{0};
+};
+
+#endif  // NXDK_PGRAPH_TESTS_TEXTURE_ARENA_H
@@ -0,0 +1,541 @@
+#include "texture_compression.h"
+
+#include <cstring>
+
+#ifndef NXDK
+#include <atomic>
+#include <thread>
+#include <vector>
+#endif
+
+static constexpr uint32_t kBlockTexels = 16;
+
+// DXT1 texels with alpha below this value are encoded as transparent.
+static constexpr uint32_t kDXT1AlphaThreshold = 128;
+
+// Number of least squares refinement passes applied to each candidate pair of endpoints in DXT_QUALITY_HIGH.
+static constexpr uint32_t kRefinementPasses = 2;
+
+// Blocks per thread below which images are compressed on the calling thread.
+static constexpr uint32_t kMinBlocksPerThread = 64;
+
+struct Color {
+  int32_t red;
+  int32_t green;
+  int32_t blue;
+};
+
+// An encoded color block and its total squared error.
+struct ColorBlock {
+  uint16_t color0;
+  uint16_t color1;
+  uint32_t indices;
+  uint32_t error;
+};
+
+// An encoded DXT5 alpha block and its total squared error.
+struct AlphaBlock {
+  uint8_t alpha0;
+  uint8_t alpha1;
+  uint64_t indices;
+  uint32_t error;
+};
+
+static inline Color TexelColor(uint32_t texel) {
+  return {static_cast<int32_t>(texel & 0xFF), static_cast<int32_t>((texel >> 8) & 0xFF),
+          static_cast<int32_t>((texel >> 16) & 0xFF)};
+}
+
+static inline uint32_t TexelAlpha(uint32_t texel) { return texel >> 24; }
+
+static inline int32_t Clamp(int32_t value, int32_t min, int32_t max) {
+  return value < min ? min : (value > max ? max : value);
+}
+
+static inline uint16_t PackRGB565(const Color &color) {
+  return ((color.red * 31 + 127) / 255) << 11 | ((color.green * 63 + 127) / 255) << 5 | (color.blue * 31 + 127) / 255;
+}
+
+static inline Color UnpackRGB565(uint16_t color) {
+  const int32_t red = (color >> 11) & 0x1F;
+  const int32_t green = (color >> 5) & 0x3F;
+  const int32_t blue = color & 0x1F;
+  return {(red << 3) | (red >> 2), (green << 2) | (green >> 4), (blue << 3) | (blue >> 2)};
+}
+
+static inline int32_t SquaredDistance(const Color &a, const Color &b) {
+  const int32_t red = a.red - b.red;
+  const int32_t green = a.green - b.green;
+  const int32_t blue = a.blue - b.blue;
+  return red * red + green * green + blue * blue;
+}
+
+// Builds the palette that the hardware decodes from a pair of endpoints. The fourth entry of a three color palette is
+// transparent black.
+static void BuildColorPalette(uint16_t color0, uint16_t color1, bool four_color, Color *palette) {
+  const Color c0 = UnpackRGB565(color0);
+  const Color c1 = UnpackRGB565(color1);
+  palette[0] = c0;
+  palette[1] = c1;
+  if (four_color) {
+    palette[2] = {(2 * c0.red + c1.red) / 3, (2 * c0.green + c1.green) / 3, (2 * c0.blue + c1.blue) / 3};
+    palette[3] = {(c0.red + 2 * c1.red) / 3, (c0.green + 2 * c1.green) / 3, (c0.blue + 2 * c1.blue) / 3};
+  } else {
+    palette[2] = {(c0.red + c1.red) / 2, (c0.green + c1.green) / 2, (c0.blue + c1.blue) / 2};
+    palette[3] = {0, 0, 0};
+  }
+}
+
+// Orders the endpoints for the required mode and selects the nearest palette entry for every texel. `transparent` is
+// a mask of the texels that must use the transparent entry of the three color mode, which is only valid for DXT1.
+static ColorBlock EncodeColorBlock(const uint32_t *texels, uint16_t endpoint_a, uint16_t endpoint_b, DXTFormat format,
+                                   uint32_t transparent) {
+  ColorBlock block{};
+  const bool three_color = transparent != 0;
+  const uint16_t low = endpoint_a < endpoint_b ? endpoint_a : endpoint_b;
+  const uint16_t high = endpoint_a < endpoint_b ? endpoint_b : endpoint_a;
+  block.color0 = three_color ? low : high;
+  block.color1 = three_color ? high : low;
+
+  // DXT1 blocks with equal endpoints are decoded in the three color mode.
+  const bool four_color = format != DXT_FORMAT_DXT1 || block.color0 > block.color1;
+  Color palette[4];
+  BuildColorPalette(block.color0, block.color1, four_color, palette);
+  const uint32_t num_colors = four_color ? 4 : 3;
+
+  for (uint32_t i = 0; i < kBlockTexels; ++i) {
+    if (transparent & (1 << i)) {
+      block.indices |= 3u << (i * 2);
+      continue;
+    }
+
+    const Color color = TexelColor(texels[i]);
+    uint32_t best_index = 0;
+    int32_t best_error = SquaredDistance(color, palette[0]);
+    for (uint32_t index = 1; index < num_colors; ++index) {
+      const int32_t error = SquaredDistance(color, palette[index]);
+      if (error < best_error) {
+        best_error = error;
+        best_index = index;
+      }
+    }
+    block.indices |= best_index << (i * 2);
+    block.error += best_error;
+  }
+
+  return block;
+}
+
+// Finds the endpoints that minimize the squared error of the index assignment in `block` and re-encodes the block with
+// them.
+static ColorBlock RefineColorBlock(const uint32_t *texels, const ColorBlock &block, DXTFormat format,
+                                   uint32_t transparent) {
+  const bool four_color = format != DXT_FORMAT_DXT1 || block.color0 > block.color1;
+  // Weight of color0 for each palette index.
+  static constexpr float kFourColorWeights[] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+  static constexpr float kThreeColorWeights[] = {1.0f, 0.0f, 0.5f, 0.0f};
+  const float *weights = four_color ? kFourColorWeights : kThreeColorWeights;
+
+  float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+  float ax[3] = {0.0f, 0.0f, 0.0f};
+  float bx[3] = {0.0f, 0.0f, 0.0f};
+  for (uint32_t i = 0; i < kBlockTexels; ++i) {
+    if (transparent & (1 << i)) {
+      continue;
+    }
+    const float alpha = weights[(block.indices >> (i * 2)) & 3];
+    const float beta = 1.0f - alpha;
+    const Color color = TexelColor(texels[i]);
+    const float channels[3] = {static_cast<float>(color.red), static_cast<float>(color.green),
+                               static_cast<float>(color.blue)};
+    aa += alpha * alpha;
+    bb += beta * beta;
+    ab += alpha * beta;
+    for (uint32_t c = 0; c < 3; ++c) {
+      ax[c] += alpha * channels[c];
+      bx[c] += beta * channels[c];
+    }
+  }
+
+  const float determinant = aa * bb - ab * ab;
+  if (determinant < 1e-4f && determinant > -1e-4f) {
+    return block;
+  }
+
+  int32_t a[3];
+  int32_t b[3];
+  for (uint32_t c = 0; c < 3; ++c) {
+    a[c] = Clamp(static_cast<int32_t>((ax[c] * bb - bx[c] * ab) / determinant + 0.5f), 0, 255);
+    b[c] = Clamp(static_cast<int32_t>((bx[c] * aa - ax[c] * ab) / determinant + 0.5f), 0, 255);
+  }
+
+  const uint16_t color0 = PackRGB565({a[0], a[1], a[2]});
+  const uint16_t color1 = PackRGB565({b[0], b[1], b[2]});
+  ColorBlock refined = EncodeColorBlock(texels, color0, color1, format, transparent);
+  return refined.error < block.error ? refined : block;
+}
+
+// Returns the endpoints of the bounding box of the opaque texels, inset by 1/16 of its size to account for the
+// interpolated palette entries.
+static void FindBoundingBoxEndpoints(const uint32_t *texels, uint32_t transparent, uint16_t &endpoint_a,
+                                     uint16_t &endpoint_b) {
+  Color min{255, 255, 255};
+  Color max{0, 0, 0};
+  for (uint32_t i = 0; i < kBlockTexels; ++i) {
+    if (transparent & (1 << i)) {
+      continue;
+    }
+    const Color color = TexelColor(texels[i]);
+    min = {color.red < min.red ? color.red : min.red, color.green < min.green ? color.green : min.green,
+           color.blue < min.blue ? color.blue : min.blue};
+    max = {color.red > max.red ? color.red : max.red, color.green > max.green ? color.green : max.green,
+           color.blue > max.blue ? color.blue : max.blue};
+  }
+
+  if (min.red > max.red) {
+    endpoint_a = endpoint_b = 0;
+    return;
+  }
+
+  const Color inset{(max.red - min.red) >> 4, (max.green - min.green) >> 4, (max.blue - min.blue) >> 4};
+  endpoint_a = PackRGB565({max.red - inset.red, max.green - inset.green, max.blue - inset.blue});
+  endpoint_b = PackRGB565({min.red + inset.red, min.green + inset.green, min.blue + inset.blue});
+}
+
+// Returns the opaque texels at either end of the principal axis of the opaque colors. Returns false if the colors do
+// not vary.
+static bool FindPrincipalAxisEndpoints(const uint32_t *texels, uint32_t transparent, uint16_t &endpoint_a,
+                                       uint16_t &endpoint_b) {
+  float mean[3] = {0.0f, 0.0f, 0.0f};
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < kBlockTexels; ++i) {
+    if (transparent & (1 << i)) {
+      continue;
+    }
+    const Color color = TexelColor(texels[i]);
+    mean[0] += static_cast<float>(color.red);
+    mean[1] += static_cast<float>(color.green);
+    mean[2] += static_cast<float>(color.blue);
+    ++count;
+  }
+  if (!count) {
+    return false;
+  }
+  for (auto &channel : mean) {
+    channel /= static_cast<float>(count);
+  }
+
+  // Upper triangle of the covariance matrix: rr, rg, rb, gg, gb, bb.
+  float covariance[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+  for (uint32_t i = 0; i < kBlockTexels; ++i) {
+    if (transparent & (1 << i)) {
+      continue;
+    }
+    const Color color = TexelColor(texels[i]);
+    const float red = static_cast<float>(color.red) - mean[0];
+    const float green = static_cast<float>(color.green) - mean[1];
+    const float blue = static_cast<float>(color.blue) - mean[2];
+    covariance[0] += red * red;
+    covariance[1] += red * green;
+    covariance[2] += red * blue;
+    covariance[3] += green * green;
+    covariance[4] += green * blue;
+    covariance[5] += blue * blue;
+  }
+
+  // Power iteration for the dominant eigenvector.
+  float axis[3] = {1.0f, 1.0f, 1.0f};
+  for (uint32_t iteration = 0; iteration < 8; ++iteration) {
+    const float red = covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2];
+    const float green = covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2];
+    const float blue = covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2];
+
+    float magnitude = red < 0.0f ? -red : red;
+    magnitude = green > magnitude ? green : (-green > magnitude ? -green : magnitude);
+    magnitude = blue > magnitude ? blue : (-blue > magnitude ? -blue : magnitude);
+    if (magnitude < 1e-6f) {
+      return false;
+    }
+    axis[0] = red / magnitude;
+    axis[1] = green / magnitude;
+    axis[2] = blue / magnitude;
+  }
+
+  float min_projection = 0.0f;
+  float max_projection = 0.0f;
+  uint32_t min_texel = 0;
+  uint32_t max_texel = 0;
+  bool first = true;
+  for (uint32_t i = 0; i < kBlockTexels; ++i) {
+    if (transparent & (1 << i)) {
+      continue;
+    }
+    const Color color = TexelColor(texels[i]);
+    const float projection = static_cast<float>(color.red) * axis[0] + static_cast<float>(color.green) * axis[1] +
+                             static_cast<float>(color.blue) * axis[2];
+    if (first || projection < min_projection) {
+      min_projection = projection;
+      min_texel = i;
+    }
+    if (first || projection > max_projection) {
+      max_projection = projection;
+      max_texel = i;
+    }
+    first = false;
+  }
+
+  endpoint_a = PackRGB565(TexelColor(texels[max_texel]));
+  endpoint_b = PackRGB565(TexelColor(texels[min_texel]));
+  return true;
+}
+
+static void StoreColorBlock(const ColorBlock &block, uint8_t *dest) {
+  dest[0] = block.color0 & 0xFF;
+  dest[1] = block.color0 >> 8;
+  dest[2] = block.color1 & 0xFF;
+  dest[3] = block.color1 >> 8;
+  dest[4] = block.indices & 0xFF;
+  dest[5] = (block.indices >> 8) & 0xFF;
+  dest[6] = (block.indices >> 16) & 0xFF;
+  dest[7] = block.indices >> 24;
+}
+
+static void CompressColorBlock(const uint32_t *texels, DXTFormat format, DXTQuality quality, uint8_t *dest) {
+  uint32_t transparent = 0;
+  if (format == DXT_FORMAT_DXT1) {
+    for (uint32_t i = 0; i < kBlockTexels; ++i) {
+      if (TexelAlpha(texels[i]) < kDXT1AlphaThreshold) {
+        transparent |= 1 << i;
+      }
+    }
+  }
+
+  uint16_t endpoint_a;
+  uint16_t endpoint_b;
+  FindBoundingBoxEndpoints(texels, transparent, endpoint_a, endpoint_b);
+  ColorBlock best = EncodeColorBlock(texels, endpoint_a, endpoint_b, format, transparent);
+
+  if (quality == DXT_QUALITY_HIGH && best.error) {
+    ColorBlock candidates[2] = {best, best};
+    if (FindPrincipalAxisEndpoints(texels, transparent, endpoint_a, endpoint_b)) {
+      candidates[1] = EncodeColorBlock(texels, endpoint_a, endpoint_b, format, transparent);
+    }
+
+    for (auto candidate : candidates) {
+      for (uint32_t pass = 0; pass < kRefinementPasses && candidate.error; ++pass) {
+        candidate = RefineColorBlock(texels, candidate, format, transparent);
+      }
+      if (candidate.error < best.error) {
+        best = candidate;
+      }
+    }
+  }
+
+  StoreColorBlock(best, dest);
+}
+
+static void BuildAlphaPalette(uint8_t alpha0, uint8_t alpha1, uint8_t *palette) {
+  palette[0] = alpha0;
+  palette[1] = alpha1;
+  if (alpha0 > alpha1) {
+    for (uint32_t i = 1; i < 7; ++i) {
+      palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+    }
+  } else {
+    for (uint32_t i = 1; i < 5; ++i) {
+      palette[i + 1] = ((5 - i) * alpha0 + i * alpha1) / 5;
+    }
+    palette[6] = 0;
+    palette[7] = 255;
+  }
+}
+
+// Encodes DXT5 alpha with the given endpoints, which select the eight value mode if alpha0 > alpha1 and the six value
+// mode (with additional entries for 0 and 255) otherwise.
+static AlphaBlock EncodeAlphaBlock(const uint32_t *texels, uint8_t alpha0, uint8_t alpha1) {
+  AlphaBlock block{alpha0, alpha1, 0, 0};
+  uint8_t palette[8];
+  BuildAlphaPalette(alpha0, alpha1, palette);
+
+  for (uint32_t i = 0; i < kBlockTexels; ++i) {
+    const int32_t alpha = static_cast<int32_t>(TexelAlpha(texels[i]));
+    uint64_t best_index = 0;
+    int32_t best_error = 0x7FFFFFFF;
+    for (uint32_t index = 0; index < 8; ++index) {
+      const int32_t difference = alpha - palette[index];
+      const int32_t error = difference * difference;
+      if (error < best_error) {
+        best_error = error;
+        best_index = index;
+      }
+    }
+    block.indices |= best_index << (i * 3);
+    block.error += best_error;
+  }
+
+  return block;
+}
+
+static void CompressInterpolatedAlpha(const uint32_t *texels, DXTQuality quality, uint8_t *dest) {
+  uint32_t min = 255;
+  uint32_t max = 0;
+  // Range of the values other than 0 and 255, which the six value mode represents exactly.
+  uint32_t inner_min = 255;
+  uint32_t inner_max = 0;
+  for (uint32_t i = 0; i < kBlockTexels; ++i) {
+    const uint32_t alpha = TexelAlpha(texels[i]);
+    min = alpha < min ? alpha : min;
+    max = alpha > max ? alpha : max;
+    if (alpha && alpha != 255) {
+      inner_min = alpha < inner_min ? alpha : inner_min;
+      inner_max = alpha > inner_max ? alpha : inner_max;
+    }
+  }
+
+  AlphaBlock best = EncodeAlphaBlock(texels, max, min);
+  if (quality == DXT_QUALITY_HIGH && best.error) {
+    if (inner_min > inner_max) {
+      inner_min = inner_max = 0;
+    }
+    AlphaBlock six_value = EncodeAlphaBlock(texels, inner_min, inner_max);
+    if (six_value.error < best.error) {
+      best = six_value;
+    }
+  }
+
+  dest[0] = best.alpha0;
+  dest[1] = best.alpha1;
+  for (uint32_t i = 0; i < 6; ++i) {
+    dest[2 + i] = (best.indices >> (i * 8)) & 0xFF;
+  }
+}
+
+static void CompressExplicitAlpha(const uint32_t *texels, uint8_t *dest) {
+  for (uint32_t i = 0; i < kBlockTexels; i += 2) {
+    const uint32_t low = (TexelAlpha(texels[i]) * 15 + 127) / 255;
+    const uint32_t high = (TexelAlpha(texels[i + 1]) * 15 + 127) / 255;
+    dest[i / 2] = low | (high << 4);
+  }
+}
+
+void CompressDXTBlock(const uint32_t *texels, DXTFormat format, DXTQuality quality, uint8_t *dest) {
+  switch (format) {
+    case DXT_FORMAT_DXT1:
+      CompressColorBlock(texels, format, quality, dest);
+      break;
+
+    case DXT_FORMAT_DXT3:
+      CompressExplicitAlpha(texels, dest);
+      CompressColorBlock(texels, format, quality, dest + 8);
+      break;
+
+    case DXT_FORMAT_DXT5:
+      CompressInterpolatedAlpha(texels, quality, dest);
+      CompressColorBlock(texels, format, quality, dest + 8);
+      break;
+  }
+}
+
+void DecompressDXTBlock(const uint8_t *block, DXTFormat format, uint32_t *texels) {
+  uint8_t alphas[kBlockTexels];
+  memset(alphas, 0xFF, sizeof(alphas));
+
+  if (format == DXT_FORMAT_DXT3) {
+    for (uint32_t i = 0; i < kBlockTexels; ++i) {
+      alphas[i] = ((block[i / 2] >> ((i & 1) * 4)) & 0x0F) * 17;
+    }
+    block += 8;
+  } else if (format == DXT_FORMAT_DXT5) {
+    uint8_t palette[8];
+    BuildAlphaPalette(block[0], block[1], palette);
+    uint64_t indices = 0;
+    for (uint32_t i = 0; i < 6; ++i) {
+      indices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+    }
+    for (uint32_t i = 0; i < kBlockTexels; ++i) {
+      alphas[i] = palette[(indices >> (i * 3)) & 7];
+    }
+    block += 8;
+  }
+
+  const uint16_t color0 = block[0] | (block[1] << 8);
+  const uint16_t color1 = block[2] | (block[3] << 8);
+  const uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+  const bool four_color = format != DXT_FORMAT_DXT1 || color0 > color1;
+  Color palette[4];
+  BuildColorPalette(color0, color1, four_color, palette);
+
+  for (uint32_t i = 0; i < kBlockTexels; ++i) {
+    const uint32_t index = (indices >> (i * 2)) & 3;
+    const Color &color = palette[index];
+    const uint8_t alpha = (!four_color && index == 3) ? 0 : alphas[i];
+    texels[i] = PackTexel(color.red, color.green, color.blue, alpha);
+  }
+}
+
+// Compresses the rows of blocks in [first_row, end_row).
+static void CompressBlockRows(const uint8_t *texels, uint32_t width, uint32_t height, uint32_t pitch,
+                              const TexelChannelLayout &layout, DXTFormat format, DXTQuality quality, uint8_t *dest,
+                              uint32_t first_row, uint32_t end_row) {
+  const uint32_t blocks_wide = (width + 3) / 4;
+  const uint32_t block_size = GetDXTBlockSize(format);
+  uint32_t block[kBlockTexels];
+
+  for (uint32_t block_y = first_row; block_y < end_row; ++block_y) {
+    uint8_t *out = dest + block_y * blocks_wide * block_size;
+    for (uint32_t block_x = 0; block_x < blocks_wide; ++block_x, out += block_size) {
+      for (uint32_t y = 0; y < 4; ++y) {
+        const uint32_t source_y = block_y * 4 + y < height ? block_y * 4 + y : height - 1;
+        const uint8_t *row = texels + source_y * pitch;
+        for (uint32_t x = 0; x < 4; ++x) {
+          const uint32_t source_x = block_x * 4 + x < width ? block_x * 4 + x : width - 1;
+          uint32_t texel;
+          memcpy(&texel, row + source_x * 4, sizeof(texel));
+          block[y * 4 + x] = PackTexel((texel >> layout.red_shift) & 0xFF, (texel >> layout.green_shift) & 0xFF,
+                                       (texel >> layout.blue_shift) & 0xFF,
+                                       layout.has_alpha ? (texel >> layout.alpha_shift) & 0xFF : 0xFF);
+        }
+      }
+      CompressDXTBlock(block, format, quality, out);
+    }
+  }
+}
+
+void CompressDXTImage(const uint8_t *texels, uint32_t width, uint32_t height, uint32_t pitch,
+                      const TexelChannelLayout &layout, DXTFormat format, DXTQuality quality, uint8_t *dest,
+                      uint32_t max_threads) {
+  const uint32_t blocks_high = (height + 3) / 4;
+
+#ifdef NXDK
+  (void)max_threads;
+#else
+  const uint32_t blocks_wide = (width + 3) / 4;
+  uint32_t num_threads = max_threads ? max_threads : std::thread::hardware_concurrency();
+  const uint32_t max_useful_threads = (blocks_wide * blocks_high) / kMinBlocksPerThread;
+  num_threads = num_threads < max_useful_threads ? num_threads : max_useful_threads;
+  num_threads = num_threads < blocks_high ? num_threads : blocks_high;
+
+  if (num_threads > 1) {
+    // Rows are handed out one at a time so that threads that finish early take on more of the work.
+    std::atomic<uint32_t> next_row{0};
+    auto worker = [&]() {
+      for (uint32_t row = next_row++; row < blocks_high; row = next_row++) {
+        CompressBlockRows(texels, width, height, pitch, layout, format, quality, dest, row, row + 1);
+      }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (uint32_t i = 1; i < num_threads; ++i) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    return;
+  }
+#endif
+
+  CompressBlockRows(texels, width, height, pitch, layout, format, quality, dest, 0, blocks_high);
+}
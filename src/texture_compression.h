@@ -0,0 +1,47 @@
+#ifndef NXDK_PGRAPH_TESTS_TEXTURE_COMPRESSION_H
+#define NXDK_PGRAPH_TESTS_TEXTURE_COMPRESSION_H
+
+#include <cstdint>
+
+#include "texture_conversion.h"
+
+// S3TC (DXT1, DXT3 and DXT5) block compression of 32-bit textures.
+//
+// DXT_QUALITY_FAST picks the color endpoints from the inset bounding box of the block. DXT_QUALITY_HIGH fits the
+// endpoints to the principal axis of the block's colors, refines them by least squares and keeps whichever candidate
+// has the lowest error, and tries both interpolation modes for DXT5 alpha.
+//
+// DXT1 blocks that contain texels with alpha below 128 use the three color mode, in which those texels are
+// transparent. DXT3 and DXT5 color blocks always use the four color mode.
+//
+// Images are split into rows of blocks that are compressed in parallel on every core of the host when built outside of
+// the nxdk. tools/dxt_bench reports the error and throughput of each mode.
+
+enum DXTFormat {
+  DXT_FORMAT_DXT1,
+  DXT_FORMAT_DXT3,
+  DXT_FORMAT_DXT5,
+};
+
+enum DXTQuality {
+  DXT_QUALITY_FAST,
+  DXT_QUALITY_HIGH,
+};
+
+// Returns the size in bytes of a compressed 4x4 block.
+inline uint32_t GetDXTBlockSize(DXTFormat format) { return format == DXT_FORMAT_DXT1 ? 8 : 16; }
+
+// Compresses the 16 texels of a 4x4 block, given in row order in the PackTexel layout.
+void CompressDXTBlock(const uint32_t *texels, DXTFormat format, DXTQuality quality, uint8_t *dest);
+
+// Decodes a compressed block into 16 texels in the PackTexel layout.
+void DecompressDXTBlock(const uint8_t *block, DXTFormat format, uint32_t *texels);
+
+// Compresses an image of 32-bit texels with the given row pitch in bytes. Blocks are written in row order. Partial
+// blocks at the right and bottom edges repeat the last column and row of the image. `max_threads` limits the number of
+// threads used on the host, 0 uses every core.
+void CompressDXTImage(const uint8_t *texels, uint32_t width, uint32_t height, uint32_t pitch,
+                      const TexelChannelLayout &layout, DXTFormat format, DXTQuality quality, uint8_t *dest,
+                      uint32_t max_threads = 0);
+
+#endif  // NXDK_PGRAPH_TESTS_TEXTURE_COMPRESSION_H
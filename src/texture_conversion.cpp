@@ -0,0 +1,453 @@
+#include "texture_conversion.h"
+
+#include <cstring>
+
+#if !defined(TEXTURE_CONVERSION_NO_SIMD) && defined(__SSE2__)
+#define TEXTURE_CONVERSION_SSE2
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#define TEXTURE_CONVERSION_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+// Weights of the red, green and blue channels and the bias added to their sum. The original conversions subtract some
+// of the products; since x - y is evaluated as x + (-y) and negation is exact, the signs are folded into the weights.
+struct ChannelWeights {
+  float red;
+  float green;
+  float blue;
+  float bias;
+};
+
+static constexpr ChannelWeights kLumaWeights{0.299f, 0.587f, 0.114f, 0.0f};
+static constexpr ChannelWeights kYWeights{0.257f, 0.504f, 0.098f, 16.0f};
+static constexpr ChannelWeights kUWeights{-0.148f, -0.291f, 0.439f, 128.0f};
+static constexpr ChannelWeights kVWeights{0.439f, -0.368f, -0.071f, 128.0f};
+
+// The products of a set of weights with every channel value, which are exactly the values that the original
+// conversions computed with floating point multiplies.
+struct WeightTable {
+  explicit WeightTable(const ChannelWeights &weights) : bias(weights.bias) {
+    for (uint32_t i = 0; i < 256; ++i) {
+      red[i] = weights.red * static_cast<float>(i);
+      green[i] = weights.green * static_cast<float>(i);
+      blue[i] = weights.blue * static_cast<float>(i);
+    }
+  }
+
+  inline uint32_t Apply(uint32_t r, uint32_t g, uint32_t b) const {
+    return static_cast<int32_t>(((red[r] + green[g]) + blue[b]) + bias);
+  }
+
+  float red[256];
+  float green[256];
+  float blue[256];
+  float bias;
+};
+
+static const WeightTable kLumaTable(kLumaWeights);
+static const WeightTable kYTable(kYWeights);
+static const WeightTable kUTable(kUWeights);
+static const WeightTable kVTable(kVWeights);
+
+struct Texel {
+  uint32_t red;
+  uint32_t green;
+  uint32_t blue;
+  uint32_t alpha;
+};
+
+static inline Texel Unpack(uint32_t texel, const TexelChannelLayout &layout) {
+  return {(texel >> layout.red_shift) & 0xFF, (texel >> layout.green_shift) & 0xFF, (texel >> layout.blue_shift) & 0xFF,
+          layout.has_alpha ? (texel >> layout.alpha_shift) & 0xFF : 0xFF};
+}
+
+static inline uint32_t Luminance(const Texel &texel) { return kLumaTable.Apply(texel.red, texel.green, texel.blue); }
+
+// Scale from 8-bit luminance to the range of the 16-bit floating point depth format.
+static constexpr float kLuminanceToZ16Float = kZ16FloatMax / 255.0f;
+
+// Encodes the bit pattern of a single precision float as a 16-bit floating point depth value. Identical to
+// float_to_z16 in pbkit_ext.cpp: the sign and the low 11 bits of the mantissa are dropped and the exponent is rebased,
+// keeping the low 16 bits of the result. Both zeros map to 0.
+static inline uint32_t FloatBitsToZ16(uint32_t bits) {
+  if (!(bits & 0x7FFFFFFF)) {
+    return 0;
+  }
+  return ((bits >> 11) - 0x3F8000) & 0xFFFF;
+}
+
+// Packs the YUV 4:2:2 representation of a pair of texels into a little endian word with the given byte positions.
+static inline uint32_t PackYUVPair(const Texel &first, const Texel &second, uint32_t y0_shift, uint32_t u_shift,
+                                   uint32_t y1_shift, uint32_t v_shift) {
+  return (kYTable.Apply(first.red, first.green, first.blue) << y0_shift) |
+         (kUTable.Apply(second.red, second.green, second.blue) << u_shift) |
+         (kYTable.Apply(second.red, second.green, second.blue) << y1_shift) |
+         (kVTable.Apply(second.red, second.green, second.blue) << v_shift);
+}
+
+#ifdef TEXTURE_CONVERSION_SSE2
+
+// Operations on 128-bit vectors of four texels.
+struct SSE2Vector {
+  using Int = __m128i;
+  using Float = __m128;
+  static constexpr uint32_t kLanes = 4;
+
+  static inline Int Load(const uint32_t *texels) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(texels)); }
+  static inline Int Set1(uint32_t value) { return _mm_set1_epi32(static_cast<int>(value)); }
+  static inline Int Or(Int a, Int b) { return _mm_or_si128(a, b); }
+  static inline Int And(Int a, Int b) { return _mm_and_si128(a, b); }
+  static inline Int Sub(Int a, Int b) { return _mm_sub_epi32(a, b); }
+  // Clears the lanes of `value` in which `condition` is zero.
+  static inline Int SelectNonZero(Int condition, Int value) {
+    return _mm_andnot_si128(_mm_cmpeq_epi32(condition, _mm_setzero_si128()), value);
+  }
+  static inline Int Channel(Int texels, __m128i shift) {
+    return _mm_and_si128(_mm_srl_epi32(texels, shift), _mm_set1_epi32(0xFF));
+  }
+  template <int kBits>
+  static inline Int ShiftLeft(Int value) {
+    return _mm_slli_epi32(value, kBits);
+  }
+  template <int kBits>
+  static inline Int ShiftRight(Int value) {
+    return _mm_srli_epi32(value, kBits);
+  }
+  static inline Int ShiftLeftBy(Int value, __m128i bits) { return _mm_sll_epi32(value, bits); }
+  static inline Int ShiftRightBy(Int value, __m128i bits) { return _mm_srl_epi32(value, bits); }
+  // Moves the odd lanes into the even lanes.
+  static inline Int OddToEven(Int value) { return _mm_srli_epi64(value, 32); }
+
+  static inline Int WeightedSum(Int red, Int green, Int blue, const ChannelWeights &weights) {
+    Float sum = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(weights.red), _mm_cvtepi32_ps(red)),
+                           _mm_mul_ps(_mm_set1_ps(weights.green), _mm_cvtepi32_ps(green)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights.blue), _mm_cvtepi32_ps(blue)));
+    return _mm_cvttps_epi32(_mm_add_ps(sum, _mm_set1_ps(weights.bias)));
+  }
+  // Returns the bit patterns of `value` * `scale` in single precision.
+  static inline Int ScaleToFloatBits(Int value, float scale) {
+    return _mm_castps_si128(_mm_mul_ps(_mm_cvtepi32_ps(value), _mm_set1_ps(scale)));
+  }
+
+  template <typename Store>
+  static inline void StoreHalves(Int value, uint8_t *dest, uint32_t half_size, Store &&store) {
+    store(value, dest);
+  }
+};
+
+#ifdef TEXTURE_CONVERSION_AVX2
+// Operations on 256-bit vectors of eight texels.
+struct AVX2Vector {
+  using Int = __m256i;
+  using Float = __m256;
+  static constexpr uint32_t kLanes = 8;
+
+  static inline Int Load(const uint32_t *texels) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(texels));
+  }
+  static inline Int Set1(uint32_t value) { return _mm256_set1_epi32(static_cast<int>(value)); }
+  static inline Int Or(Int a, Int b) { return _mm256_or_si256(a, b); }
+  static inline Int And(Int a, Int b) { return _mm256_and_si256(a, b); }
+  static inline Int Sub(Int a, Int b) { return _mm256_sub_epi32(a, b); }
+  static inline Int SelectNonZero(Int condition, Int value) {
+    return _mm256_andnot_si256(_mm256_cmpeq_epi32(condition, _mm256_setzero_si256()), value);
+  }
+  static inline Int Channel(Int texels, __m128i shift) {
+    return _mm256_and_si256(_mm256_srl_epi32(texels, shift), _mm256_set1_epi32(0xFF));
+  }
+  template <int kBits>
+  static inline Int ShiftLeft(Int value) {
+    return _mm256_slli_epi32(value, kBits);
+  }
+  template <int kBits>
+  static inline Int ShiftRight(Int value) {
+    return _mm256_srli_epi32(value, kBits);
+  }
+  static inline Int ShiftLeftBy(Int value, __m128i bits) { return _mm256_sll_epi32(value, bits); }
+  static inline Int ShiftRightBy(Int value, __m128i bits) { return _mm256_srl_epi32(value, bits); }
+  static inline Int OddToEven(Int value) { return _mm256_srli_epi64(value, 32); }
+
+  static inline Int WeightedSum(Int red, Int green, Int blue, const ChannelWeights &weights) {
+    Float sum = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(weights.red), _mm256_cvtepi32_ps(red)),
+                              _mm256_mul_ps(_mm256_set1_ps(weights.green), _mm256_cvtepi32_ps(green)));
+    sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights.blue), _mm256_cvtepi32_ps(blue)));
+    return _mm256_cvttps_epi32(_mm256_add_ps(sum, _mm256_set1_ps(weights.bias)));
+  }
+  static inline Int ScaleToFloatBits(Int value, float scale) {
+    return _mm256_castps_si256(_mm256_mul_ps(_mm256_cvtepi32_ps(value), _mm256_set1_ps(scale)));
+  }
+
+  template <typename Store>
+  static inline void StoreHalves(Int value, uint8_t *dest, uint32_t half_size, Store &&store) {
+    store(_mm256_castsi256_si128(value), dest);
+    store(_mm256_extracti128_si256(value, 1), dest + half_size);
+  }
+};
+using Vector = AVX2Vector;
+#else
+using Vector = SSE2Vector;
+#endif
+
+// Extracts channels from vectors of texels with a given layout.
+struct VectorChannels {
+  explicit VectorChannels(const TexelChannelLayout &layout)
+      : red(_mm_cvtsi32_si128(static_cast<int>(layout.red_shift))),
+        green(_mm_cvtsi32_si128(static_cast<int>(layout.green_shift))),
+        blue(_mm_cvtsi32_si128(static_cast<int>(layout.blue_shift))),
+        alpha(_mm_cvtsi32_si128(static_cast<int>(layout.alpha_shift))),
+        has_alpha(layout.has_alpha) {}
+
+  inline Vector::Int Red(Vector::Int texels) const { return Vector::Channel(texels, red); }
+  inline Vector::Int Green(Vector::Int texels) const { return Vector::Channel(texels, green); }
+  inline Vector::Int Blue(Vector::Int texels) const { return Vector::Channel(texels, blue); }
+  inline Vector::Int Alpha(Vector::Int texels) const {
+    return has_alpha ? Vector::Channel(texels, alpha) : Vector::Set1(0xFF);
+  }
+  inline Vector::Int Luminance(Vector::Int texels) const {
+    return Vector::WeightedSum(Red(texels), Green(texels), Blue(texels), kLumaWeights);
+  }
+
+  __m128i red;
+  __m128i green;
+  __m128i blue;
+  __m128i alpha;
+  bool has_alpha;
+};
+
+// Stores the low byte of each of four 32-bit lanes.
+static inline void StoreBytes(__m128i value, uint8_t *dest) {
+  const __m128i words = _mm_packs_epi32(value, value);
+  const int bytes = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+  memcpy(dest, &bytes, sizeof(bytes));
+}
+
+// Stores the low 16 bits of each of four 32-bit lanes. The values are biased into the signed range so that the
+// saturating pack preserves them.
+static inline void StoreWords(__m128i value, uint8_t *dest) {
+  const __m128i bias = _mm_set1_epi32(0x8000);
+  const __m128i words = _mm_packs_epi32(_mm_sub_epi32(value, bias), _mm_setzero_si128());
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(dest), _mm_xor_si128(words, _mm_set1_epi16(-0x8000)));
+}
+
+// Stores all four 32-bit lanes.
+static inline void StoreDWORDs(__m128i value, uint8_t *dest) {
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), value);
+}
+
+// Stores the even 32-bit lanes.
+static inline void StoreEvenDWORDs(__m128i value, uint8_t *dest) {
+  _mm_storel_epi64(reinterpret_cast<__m128i *>(dest), _mm_shuffle_epi32(value, _MM_SHUFFLE(3, 1, 2, 0)));
+}
+
+// Vector form of FloatBitsToZ16.
+static inline Vector::Int FloatBitsToZ16(Vector::Int bits) {
+  const auto magnitude = Vector::And(bits, Vector::Set1(0x7FFFFFFF));
+  const auto z16 = Vector::And(Vector::Sub(Vector::ShiftRight<11>(bits), Vector::Set1(0x3F8000)), Vector::Set1(0xFFFF));
+  return Vector::SelectNonZero(magnitude, z16);
+}
+
+// Converts whole vectors of texels via `convert` and stores the results via `store`, which writes four texels at a
+// time. Returns the number of texels that were converted.
+template <typename Convert, typename Store>
+static uint32_t ConvertVectors(const uint32_t *texels, uint32_t count, uint32_t dest_bytes_per_texel, uint8_t *dest,
+                               Convert &&convert, Store &&store) {
+  const uint32_t half_size = 4 * dest_bytes_per_texel;
+  uint32_t i = 0;
+  for (; i + Vector::kLanes <= count; i += Vector::kLanes, dest += Vector::kLanes * dest_bytes_per_texel) {
+    Vector::StoreHalves(convert(Vector::Load(texels + i)), dest, half_size, store);
+  }
+  return i;
+}
+
+template <int kY0Shift, int kUShift, int kY1Shift, int kVShift>
+static uint32_t ConvertYUVVectors(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout,
+                                  uint8_t *dest) {
+  const VectorChannels channels(layout);
+  auto convert = [&channels](Vector::Int texels) {
+    const auto red = channels.Red(texels);
+    const auto green = channels.Green(texels);
+    const auto blue = channels.Blue(texels);
+    const auto y = Vector::WeightedSum(red, green, blue, kYWeights);
+    // Only the odd lanes of the chroma are used.
+    const auto u = Vector::OddToEven(Vector::WeightedSum(red, green, blue, kUWeights));
+    const auto v = Vector::OddToEven(Vector::WeightedSum(red, green, blue, kVWeights));
+    auto pair = Vector::ShiftLeft<kY0Shift>(y);
+    pair = Vector::Or(pair, Vector::ShiftLeft<kUShift>(u));
+    pair = Vector::Or(pair, Vector::ShiftLeft<kY1Shift>(Vector::OddToEven(y)));
+    return Vector::Or(pair, Vector::ShiftLeft<kVShift>(v));
+  };
+  return ConvertVectors(texels, count, 2, dest, convert, StoreEvenDWORDs);
+}
+
+#endif  // TEXTURE_CONVERSION_SSE2
+
+void ConvertTexelsToPacked(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout,
+                           const PackedTexelFormat &format, uint8_t *dest) {
+  uint32_t i = 0;
+#ifdef TEXTURE_CONVERSION_SSE2
+  const VectorChannels channels(layout);
+  auto count_vector = [](uint32_t bits) { return _mm_cvtsi32_si128(static_cast<int>(bits)); };
+  const __m128i losses[4] = {count_vector(format.red_loss), count_vector(format.green_loss),
+                             count_vector(format.blue_loss), count_vector(format.alpha_loss)};
+  const __m128i shifts[4] = {count_vector(format.red_shift), count_vector(format.green_shift),
+                             count_vector(format.blue_shift), count_vector(format.alpha_shift)};
+  auto convert = [&](Vector::Int texels) {
+    auto pack = [&](Vector::Int channel, uint32_t index) {
+      return Vector::ShiftLeftBy(Vector::ShiftRightBy(channel, losses[index]), shifts[index]);
+    };
+    auto packed = Vector::Or(pack(channels.Red(texels), 0), pack(channels.Green(texels), 1));
+    packed = Vector::Or(packed, pack(channels.Blue(texels), 2));
+    return Vector::Or(packed, pack(channels.Alpha(texels), 3));
+  };
+  if (format.bytes_per_texel == 4) {
+    i = ConvertVectors(texels, count, 4, dest, convert, StoreDWORDs);
+  } else if (format.bytes_per_texel == 2) {
+    i = ConvertVectors(texels, count, 2, dest, convert, StoreWords);
+  } else {
+    i = ConvertVectors(texels, count, 1, dest, convert, StoreBytes);
+  }
+#endif
+  for (; i < count; ++i) {
+    const Texel texel = Unpack(texels[i], layout);
+    const uint32_t packed = ((texel.red >> format.red_loss) << format.red_shift) |
+                            ((texel.green >> format.green_loss) << format.green_shift) |
+                            ((texel.blue >> format.blue_loss) << format.blue_shift) |
+                            ((texel.alpha >> format.alpha_loss) << format.alpha_shift);
+    memcpy(dest + i * format.bytes_per_texel, &packed, format.bytes_per_texel);
+  }
+}
+
+void ConvertTexelsToY8(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+  uint32_t i = 0;
+#ifdef TEXTURE_CONVERSION_SSE2
+  const VectorChannels channels(layout);
+  i = ConvertVectors(
+      texels, count, 1, dest, [&channels](Vector::Int texels) { return channels.Luminance(texels); }, StoreBytes);
+#endif
+  for (; i < count; ++i) {
+    dest[i] = Luminance(Unpack(texels[i], layout));
+  }
+}
+
+void ConvertTexelsToA8Y8(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+  uint32_t i = 0;
+#ifdef TEXTURE_CONVERSION_SSE2
+  const VectorChannels channels(layout);
+  auto convert = [&channels](Vector::Int texels) {
+    return Vector::Or(channels.Luminance(texels), Vector::ShiftLeft<8>(channels.Alpha(texels)));
+  };
+  i = ConvertVectors(texels, count, 2, dest, convert, StoreWords);
+#endif
+  for (; i < count; ++i) {
+    const Texel texel = Unpack(texels[i], layout);
+    dest[i * 2] = Luminance(texel);
+    dest[i * 2 + 1] = texel.alpha;
+  }
+}
+
+void ConvertTexelsToY16(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+  // The original conversion scaled the luminance by 65535 / 255 in floating point, which is exactly y * 257
+  // (y | y << 8) for every 8-bit y.
+  uint32_t i = 0;
+#ifdef TEXTURE_CONVERSION_SSE2
+  const VectorChannels channels(layout);
+  auto convert = [&channels](Vector::Int texels) {
+    const auto y = channels.Luminance(texels);
+    return Vector::Or(y, Vector::ShiftLeft<8>(y));
+  };
+  i = ConvertVectors(texels, count, 2, dest, convert, StoreWords);
+#endif
+  for (; i < count; ++i) {
+    const uint32_t y = Luminance(Unpack(texels[i], layout));
+    dest[i * 2] = y;
+    dest[i * 2 + 1] = y;
+  }
+}
+
+void ConvertTexelsToY16Float(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout,
+                             uint8_t *dest) {
+  uint32_t i = 0;
+#ifdef TEXTURE_CONVERSION_SSE2
+  const VectorChannels channels(layout);
+  auto convert = [&channels](Vector::Int texels) {
+    return FloatBitsToZ16(Vector::ScaleToFloatBits(channels.Luminance(texels), kLuminanceToZ16Float));
+  };
+  i = ConvertVectors(texels, count, 2, dest, convert, StoreWords);
+#endif
+  for (; i < count; ++i) {
+    const float depth = static_cast<float>(Luminance(Unpack(texels[i], layout))) * kLuminanceToZ16Float;
+    uint32_t bits;
+    memcpy(&bits, &depth, sizeof(bits));
+    const uint32_t z16 = FloatBitsToZ16(bits);
+    dest[i * 2] = z16;
+    dest[i * 2 + 1] = z16 >> 8;
+  }
+}
+
+void ConvertFloatsToZ16(const float *values, uint32_t count, uint8_t *dest) {
+  uint32_t i = 0;
+#ifdef TEXTURE_CONVERSION_SSE2
+  static_assert(sizeof(float) == sizeof(uint32_t), "Floats are loaded as 32-bit lanes");
+  i = ConvertVectors(
+      reinterpret_cast<const uint32_t *>(values), count, 2, dest,
+      [](Vector::Int bits) { return FloatBitsToZ16(bits); }, StoreWords);
+#endif
+  for (; i < count; ++i) {
+    uint32_t value;
+    memcpy(&value, values + i, sizeof(value));
+    const uint32_t z16 = FloatBitsToZ16(value);
+    dest[i * 2] = z16;
+    dest[i * 2 + 1] = z16 >> 8;
+  }
+}
+
+void ConvertTexelsToChannelPair(const uint32_t *texels, uint32_t count, uint32_t low_shift, uint32_t high_shift,
+                                uint8_t *dest) {
+  uint32_t i = 0;
+#ifdef TEXTURE_CONVERSION_SSE2
+  const __m128i low = _mm_cvtsi32_si128(static_cast<int>(low_shift));
+  const __m128i high = _mm_cvtsi32_si128(static_cast<int>(high_shift));
+  auto convert = [low, high](Vector::Int texels) {
+    return Vector::Or(Vector::Channel(texels, low), Vector::ShiftLeft<8>(Vector::Channel(texels, high)));
+  };
+  i = ConvertVectors(texels, count, 2, dest, convert, StoreWords);
+#endif
+  for (; i < count; ++i) {
+    dest[i * 2] = (texels[i] >> low_shift) & 0xFF;
+    dest[i * 2 + 1] = (texels[i] >> high_shift) & 0xFF;
+  }
+}
+
+void ConvertTexelsToYUY2(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+  uint32_t i = 0;
+#ifdef TEXTURE_CONVERSION_SSE2
+  i = ConvertYUVVectors<0, 8, 16, 24>(texels, count, layout, dest);
+#endif
+  for (; i + 1 < count; i += 2) {
+    const uint32_t pair = PackYUVPair(Unpack(texels[i], layout), Unpack(texels[i + 1], layout), 0, 8, 16, 24);
+    memcpy(dest + i * 2, &pair, sizeof(pair));
+  }
+}
+
+void ConvertTexelsToUYVY(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+  uint32_t i = 0;
+#ifdef TEXTURE_CONVERSION_SSE2
+  i = ConvertYUVVectors<8, 0, 24, 16>(texels, count, layout, dest);
+#endif
+  for (; i + 1 < count; i += 2) {
+    const uint32_t pair = PackYUVPair(Unpack(texels[i], layout), Unpack(texels[i + 1], layout), 8, 0, 24, 16);
+    memcpy(dest + i * 2, &pair, sizeof(pair));
+  }
+}
+
+const char *GetTexelConversionImplementation() {
+#if defined(TEXTURE_CONVERSION_AVX2)
+  return "AVX2";
+#elif defined(TEXTURE_CONVERSION_SSE2)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,81 @@
+#ifndef NXDK_PGRAPH_TESTS_TEXTURE_CONVERSION_H
+#define NXDK_PGRAPH_TESTS_TEXTURE_CONVERSION_H
+
+#include <cstdint>
+
+// Kernels that convert runs of 32-bit source texels with 8-bit channels into the packed RGB, luminance, YUV 4:2:2,
+// two channel and 16-bit depth layouts of the nv2a texture formats.
+//
+// The output is bit-exact with the original per-texel conversions: every weighted sum is evaluated in single precision
+// with the same operation order and then truncated. SSE2 and AVX2 implementations are selected at compile time when
+// the target supports them; the scalar implementation replaces the per-channel multiplies with tables of the same
+// products. tools/texel_conversion_bench checks every implementation against the reference conversions.
+
+// Bit offsets of the channels of a 32-bit source texel. Alpha is treated as 0xFF if `has_alpha` is false.
+struct TexelChannelLayout {
+  uint32_t red_shift;
+  uint32_t green_shift;
+  uint32_t blue_shift;
+  uint32_t alpha_shift;
+  bool has_alpha;
+};
+
+// Layout of the texels produced by PackTexel.
+static constexpr TexelChannelLayout kPackedTexelLayout{0, 8, 16, 24, true};
+
+inline uint32_t PackTexel(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha) {
+  return red | (green << 8) | (blue << 16) | (static_cast<uint32_t>(alpha) << 24);
+}
+
+// Largest value of the 16-bit floating point depth format (DEPTH_Y16_FLOAT), which has a 4-bit exponent and a 12-bit
+// mantissa. Equal to kF16Max in pbkit_ext.h.
+static constexpr float kZ16FloatMax = 511.9375f;
+
+// Bit layout of an 8, 16 or 32-bit packed destination texel, given by the loss and shift of each channel as in an
+// SDL_PixelFormat. Channels with a loss of 8 are dropped.
+struct PackedTexelFormat {
+  uint32_t red_loss;
+  uint32_t red_shift;
+  uint32_t green_loss;
+  uint32_t green_shift;
+  uint32_t blue_loss;
+  uint32_t blue_shift;
+  uint32_t alpha_loss;
+  uint32_t alpha_shift;
+  uint32_t bytes_per_texel;
+};
+
+// Truncates the channels of each texel into a packed texel, little endian (R5G6B5, R6G5B5, A1R5G5B5, A4R4G4B4,
+// A8R8G8B8, A8 and the other RGB formats). Equivalent to SDL_MapRGBA.
+void ConvertTexelsToPacked(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout,
+                           const PackedTexelFormat &format, uint8_t *dest);
+
+// Writes the luminance of each texel as a single byte (Y8, AY8).
+void ConvertTexelsToY8(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest);
+
+// Writes the luminance followed by the alpha of each texel (A8Y8).
+void ConvertTexelsToA8Y8(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest);
+
+// Writes the luminance of each texel expanded to 16 bits, little endian (Y16, DEPTH_Y16_FIXED).
+void ConvertTexelsToY16(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest);
+
+// Writes the luminance of each texel scaled to [0, kZ16FloatMax] as a 16-bit floating point depth value, little endian
+// (DEPTH_Y16_FLOAT).
+void ConvertTexelsToY16Float(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest);
+
+// Encodes each value as a 16-bit floating point depth value, little endian, exactly as float_to_z16 in pbkit_ext.h.
+void ConvertFloatsToZ16(const float *values, uint32_t count, uint8_t *dest);
+
+// Writes the 8-bit channel at `low_shift` followed by the one at `high_shift` (G8B8, R8B8).
+void ConvertTexelsToChannelPair(const uint32_t *texels, uint32_t count, uint32_t low_shift, uint32_t high_shift,
+                                uint8_t *dest);
+
+// Writes each pair of texels as Y0 U Y1 V (YUY2) or U Y0 V Y1 (UYVY). The chroma of a pair is taken from its second
+// texel. `count` must be even.
+void ConvertTexelsToYUY2(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest);
+void ConvertTexelsToUYVY(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest);
+
+// Returns the name of the instruction set used by the kernels.
+const char *GetTexelConversionImplementation();
+
+#endif  // NXDK_PGRAPH_TESTS_TEXTURE_CONVERSION_H
@@ -19,6 +19,7 @@ constexpr TextureFormatInfo kTextureFormats[] = {
     {SDL_PIXELFORMAT_ARGB1555, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A1R5G5B5, 16, true, false, false, "A1R5G5B5"},
     {SDL_PIXELFORMAT_ARGB1555, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_X1R5G5B5, 16, true, false, false, "X1R5G5B5"},
     {SDL_PIXELFORMAT_ARGB4444, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A4R4G4B4, 16, true, false, false, "A4R4G4B4"},
+    {SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_R6G5B5, 16, true, false, true, "R6G5B5"},
 
     // linear unsigned
     {SDL_PIXELFORMAT_ABGR8888, NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_A8B8G8R8, 32, false, true, false, "A8B8G8R8"},
@@ -41,6 +42,12 @@ constexpr TextureFormatInfo kTextureFormats[] = {
      "D_Y16_FLOAT"},
     {SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_Y16, 16, false, true, true, "Y16"},
 
+    // swizzled depth (D16 and F16)
+    {SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_DEPTH_Y16_FIXED, 16, true, false, true,
+     "D_Y16_FIXED"},
+    {SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_DEPTH_Y16_FLOAT, 16, true, false, true,
+     "D_Y16_FLOAT"},
+
     // yuv color space
     // Each 4 bytes represent the color for 2 neighboring pixels:
     // [ U0 | Y0 | V0 | Y1 ]
@@ -55,7 +62,7 @@ constexpr TextureFormatInfo kTextureFormats[] = {
     {SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_AY8, 8, false, true, true, "AY8"},
     {SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_Y8, 8, true, false, true, "Y8"},
     {SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_AY8, 8, true, false, true, "AY8"},
-    //{ SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A8, true, true, "SZ_A8" },
+    {SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A8, 8, true, false, true, "A8"},
     {SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A8Y8, 16, true, false, true, "A8Y8"},
 
     {SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_G8B8, 16, true, false, true, "G8B8"},
@@ -63,13 +70,8 @@ constexpr TextureFormatInfo kTextureFormats[] = {
 
     // misc formats
     {SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT1_A1R5G5B5, 4, false, false, true, "DXT1"},
-    //{ SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT23_A8R8G8B8, false, true, "DXT3" },
-    //{ SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT45_A8R8G8B8, false, true, "DXT5" },
-    // TODO: implement in xemu
-    //{ SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_D16, false, true, "D16" },
-    // TODO: implement in xemu
-    //{ SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_LIN_F16, false, true, "LIN_F16" },
-    //{ SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_R6G5B5, true, true, "R6G5B5" }
+    {SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT23_A8R8G8B8, 8, false, false, true, "DXT3"},
+    {SDL_PIXELFORMAT_RGBA8888, NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT45_A8R8G8B8, 8, false, false, true, "DXT5"},
 
     {SDL_PIXELFORMAT_INDEX8, NV097_SET_TEXTURE_FORMAT_COLOR_SZ_I8_A8R8G8B8, 8, true, false, false, "SZ_Index8"},
 };
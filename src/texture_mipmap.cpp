@@ -0,0 +1,256 @@
+#include "texture_mipmap.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#if !defined(TEXTURE_CONVERSION_NO_SIMD) && defined(__SSE2__)
+#define TEXTURE_MIPMAP_SSE2
+#include <emmintrin.h>
+#endif
+
+static inline const uint32_t *GetRow(const uint8_t *source, uint32_t pitch, uint32_t y) {
+  return reinterpret_cast<const uint32_t *>(source + y * pitch);
+}
+
+static inline uint32_t ClampRow(int32_t y, uint32_t height) {
+  if (y < 0) {
+    return 0;
+  }
+  return static_cast<uint32_t>(y) < height ? y : height - 1;
+}
+
+// Averages four texels, rounding to nearest. The even and odd channels are each summed in the two 16-bit halves of a
+// register.
+static inline uint32_t Average4(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+  static constexpr uint32_t kMask = 0x00FF00FF;
+  static constexpr uint32_t kRound = 0x00020002;
+  const uint32_t even = (a & kMask) + (b & kMask) + (c & kMask) + (d & kMask) + kRound;
+  const uint32_t odd = ((a >> 8) & kMask) + ((b >> 8) & kMask) + ((c >> 8) & kMask) + ((d >> 8) & kMask) + kRound;
+  return ((even >> 2) & kMask) | (((odd >> 2) & kMask) << 8);
+}
+
+#ifdef TEXTURE_MIPMAP_SSE2
+// Returns the 16-bit channel sums of the 2x2 blocks formed by the four texels in each of `top` and `bottom`.
+static inline __m128i SumBlocks(__m128i top, __m128i bottom) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i left = _mm_add_epi16(_mm_unpacklo_epi8(top, zero), _mm_unpacklo_epi8(bottom, zero));
+  const __m128i right = _mm_add_epi16(_mm_unpackhi_epi8(top, zero), _mm_unpackhi_epi8(bottom, zero));
+  return _mm_add_epi16(_mm_unpacklo_epi64(left, right), _mm_unpackhi_epi64(left, right));
+}
+
+static inline __m128i Load(const void *source) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(source)); }
+#endif
+
+// Averages the 2x2 blocks of `top` and `bottom` into `dest_width` texels. `right_step` is the offset of the second
+// texel of each block, 0 if the source is a single column.
+static void BoxRow(const uint32_t *top, const uint32_t *bottom, uint32_t dest_width, uint32_t right_step,
+                   uint32_t *dest) {
+  uint32_t x = 0;
+#ifdef TEXTURE_MIPMAP_SSE2
+  if (right_step) {
+    const __m128i round = _mm_set1_epi16(2);
+    for (; x + 4 <= dest_width; x += 4) {
+      const __m128i first = SumBlocks(Load(top + x * 2), Load(bottom + x * 2));
+      const __m128i second = SumBlocks(Load(top + x * 2 + 4), Load(bottom + x * 2 + 4));
+      const __m128i result = _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(first, round), 2),
+                                              _mm_srli_epi16(_mm_add_epi16(second, round), 2));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + x), result);
+    }
+  }
+#endif
+  for (; x < dest_width; ++x) {
+    const uint32_t left = x * 2;
+    dest[x] = Average4(top[left], top[left + right_step], bottom[left], bottom[left + right_step]);
+  }
+}
+
+static void GenerateBox(const uint8_t *source, uint32_t width, uint32_t height, uint32_t pitch, uint32_t *dest) {
+  const uint32_t dest_width = GetMipmapDimension(width, 1);
+  const uint32_t dest_height = GetMipmapDimension(height, 1);
+  const uint32_t right_step = width > 1 ? 1 : 0;
+  for (uint32_t y = 0; y < dest_height; ++y, dest += dest_width) {
+    BoxRow(GetRow(source, pitch, ClampRow(y * 2, height)), GetRow(source, pitch, ClampRow(y * 2 + 1, height)),
+           dest_width, right_step, dest);
+  }
+}
+
+// Applies the vertical [1 3 3 1] taps to four rows, writing four 16-bit channel sums per texel to `sums`.
+static void TentColumns(const uint32_t *const rows[4], uint32_t width, uint16_t *sums) {
+  uint32_t x = 0;
+#ifdef TEXTURE_MIPMAP_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  auto weigh = [&](__m128i r0, __m128i r1, __m128i r2, __m128i r3) {
+    const __m128i inner = _mm_add_epi16(r1, r2);
+    return _mm_add_epi16(_mm_add_epi16(r0, r3), _mm_add_epi16(inner, _mm_add_epi16(inner, inner)));
+  };
+  for (; x + 4 <= width; x += 4) {
+    const __m128i r0 = Load(rows[0] + x);
+    const __m128i r1 = Load(rows[1] + x);
+    const __m128i r2 = Load(rows[2] + x);
+    const __m128i r3 = Load(rows[3] + x);
+    const __m128i low = weigh(_mm_unpacklo_epi8(r0, zero), _mm_unpacklo_epi8(r1, zero), _mm_unpacklo_epi8(r2, zero),
+                              _mm_unpacklo_epi8(r3, zero));
+    const __m128i high = weigh(_mm_unpackhi_epi8(r0, zero), _mm_unpackhi_epi8(r1, zero), _mm_unpackhi_epi8(r2, zero),
+                               _mm_unpackhi_epi8(r3, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sums + x * 4), low);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(sums + x * 4 + 8), high);
+  }
+#endif
+  for (; x < width; ++x) {
+    for (uint32_t channel = 0; channel < 4; ++channel) {
+      const uint32_t shift = channel * 8;
+      const uint32_t inner = ((rows[1][x] >> shift) & 0xFF) + ((rows[2][x] >> shift) & 0xFF);
+      sums[x * 4 + channel] = ((rows[0][x] >> shift) & 0xFF) + inner * 3 + ((rows[3][x] >> shift) & 0xFF);
+    }
+  }
+}
+
+// Applies the horizontal [1 3 3 1] taps to the column sums, which are padded by one texel on the left.
+static void TentRow(const uint16_t *sums, uint32_t dest_width, uint32_t *dest) {
+  uint32_t x = 0;
+#ifdef TEXTURE_MIPMAP_SSE2
+  const __m128i round = _mm_set1_epi16(32);
+  for (; x + 2 <= dest_width; x += 2) {
+    const __m128i a = Load(sums + x * 8);
+    const __m128i b = Load(sums + x * 8 + 8);
+    const __m128i c = Load(sums + x * 8 + 16);
+    const __m128i outer = _mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(b, c));
+    const __m128i inner = _mm_add_epi16(_mm_unpackhi_epi64(a, b), _mm_unpacklo_epi64(b, c));
+    __m128i sum = _mm_add_epi16(outer, _mm_add_epi16(inner, _mm_add_epi16(inner, inner)));
+    sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 6);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(dest + x), _mm_packus_epi16(sum, sum));
+  }
+#endif
+  for (; x < dest_width; ++x) {
+    const uint16_t *texels = sums + x * 8;
+    uint32_t texel = 0;
+    for (uint32_t channel = 0; channel < 4; ++channel) {
+      const uint32_t sum =
+          texels[channel] + (texels[4 + channel] + texels[8 + channel]) * 3 + texels[12 + channel] + 32;
+      texel |= (sum >> 6) << (channel * 8);
+    }
+    dest[x] = texel;
+  }
+}
+
+static void GenerateTent(const uint8_t *source, uint32_t width, uint32_t height, uint32_t pitch, uint32_t *dest) {
+  const uint32_t dest_width = GetMipmapDimension(width, 1);
+  const uint32_t dest_height = GetMipmapDimension(height, 1);
+
+  // One texel of padding on the left and two on the right repeat the edges, which covers single column sources.
+  std::vector<uint16_t> padded_sums((width + 3) * 4);
+  uint16_t *sums = padded_sums.data() + 4;
+  for (uint32_t y = 0; y < dest_height; ++y, dest += dest_width) {
+    const int32_t top = static_cast<int32_t>(y * 2) - 1;
+    const uint32_t *rows[4];
+    for (int32_t i = 0; i < 4; ++i) {
+      rows[i] = GetRow(source, pitch, ClampRow(top + i, height));
+    }
+    TentColumns(rows, width, sums);
+
+    for (uint32_t channel = 0; channel < 4; ++channel) {
+      padded_sums[channel] = sums[channel];
+      sums[width * 4 + channel] = sums[(width - 1) * 4 + channel];
+      sums[(width + 1) * 4 + channel] = sums[(width - 1) * 4 + channel];
+    }
+    TentRow(padded_sums.data(), dest_width, dest);
+  }
+}
+
+namespace {
+
+// Converts 8-bit sRGB values to 16-bit linear values and back. Linear values are looked up by their top 12 bits.
+struct GammaTables {
+  GammaTables() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      const float value = static_cast<float>(i) / 255.0f;
+      const float linear = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+      to_linear[i] = static_cast<uint16_t>(linear * 65535.0f + 0.5f);
+    }
+
+    // Adjacent sRGB values are always more than 16 linear steps apart, so every value survives a round trip.
+    uint32_t code = 0;
+    for (uint32_t i = 0; i < 4096; ++i) {
+      const int32_t center = static_cast<int32_t>(i * 16 + 8);
+      while (code < 255 && abs(to_linear[code + 1] - center) <= abs(to_linear[code] - center)) {
+        ++code;
+      }
+      to_srgb[i] = code;
+    }
+  }
+
+  uint16_t to_linear[256];
+  uint8_t to_srgb[4096];
+};
+
+}  // namespace
+
+static void GenerateGammaCorrect(const uint8_t *source, uint32_t width, uint32_t height, uint32_t pitch,
+                                 const TexelChannelLayout &layout, uint32_t *dest) {
+  static const GammaTables kTables;
+  const uint32_t dest_width = GetMipmapDimension(width, 1);
+  const uint32_t dest_height = GetMipmapDimension(height, 1);
+  const uint32_t right_step = width > 1 ? 1 : 0;
+
+  // Alpha is averaged as stored, along with any unused channel.
+  const uint32_t alpha_mask = layout.has_alpha ? 0xFFu << layout.alpha_shift : 0;
+
+  for (uint32_t y = 0; y < dest_height; ++y, dest += dest_width) {
+    const uint32_t *top = GetRow(source, pitch, ClampRow(y * 2, height));
+    const uint32_t *bottom = GetRow(source, pitch, ClampRow(y * 2 + 1, height));
+    for (uint32_t x = 0; x < dest_width; ++x) {
+      const uint32_t left = x * 2;
+      const uint32_t a = top[left];
+      const uint32_t b = top[left + right_step];
+      const uint32_t c = bottom[left];
+      const uint32_t d = bottom[left + right_step];
+      uint32_t texel = Average4(a, b, c, d) & alpha_mask;
+      for (uint32_t shift = 0; shift < 32; shift += 8) {
+        if ((alpha_mask >> shift) & 0xFF) {
+          continue;
+        }
+        const uint32_t sum = kTables.to_linear[(a >> shift) & 0xFF] + kTables.to_linear[(b >> shift) & 0xFF] +
+                             kTables.to_linear[(c >> shift) & 0xFF] + kTables.to_linear[(d >> shift) & 0xFF];
+        texel |= static_cast<uint32_t>(kTables.to_srgb[(sum + 2) >> 6]) << shift;
+      }
+      dest[x] = texel;
+    }
+  }
+}
+
+uint32_t GetMaxMipmapLevels(uint32_t width, uint32_t height, uint32_t depth) {
+  uint32_t levels = 1;
+  while (width > 1 || height > 1 || depth > 1) {
+    width >>= 1;
+    height >>= 1;
+    depth >>= 1;
+    ++levels;
+  }
+  return levels;
+}
+
+void GenerateMipmap(const uint8_t *source, uint32_t width, uint32_t height, uint32_t pitch,
+                    const TexelChannelLayout &layout, MipmapFilter filter, uint32_t *dest) {
+  switch (filter) {
+    case MIPMAP_FILTER_BOX:
+      GenerateBox(source, width, height, pitch, dest);
+      break;
+
+    case MIPMAP_FILTER_TENT:
+      GenerateTent(source, width, height, pitch, dest);
+      break;
+
+    case MIPMAP_FILTER_GAMMA_CORRECT:
+      GenerateGammaCorrect(source, width, height, pitch, layout, dest);
+      break;
+  }
+}
+
+const char *GetMipmapImplementation() {
+#ifdef TEXTURE_MIPMAP_SSE2
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
@@ -0,0 +1,43 @@
+#ifndef NXDK_PGRAPH_TESTS_TEXTURE_MIPMAP_H
+#define NXDK_PGRAPH_TESTS_TEXTURE_MIPMAP_H
+
+#include <cstdint>
+
+#include "texture_conversion.h"
+
+// Generation of mipmap levels from images of 32-bit texels with 8-bit channels.
+//
+// Each level is computed from the previous one in a single pass over its rows. MIPMAP_FILTER_BOX averages each 2x2
+// block, MIPMAP_FILTER_TENT applies a separable [1 3 3 1] / 8 kernel (bilinear downsampling) with the edges clamped,
+// and MIPMAP_FILTER_GAMMA_CORRECT averages each 2x2 block of color in linear space by decoding and re-encoding it as
+// sRGB. Alpha is always averaged as stored.
+//
+// The box and tent filters use SSE2 when the target supports it and otherwise process two channels at a time in each
+// 32-bit register. tools/mipmap_bench checks each implementation against a reference and compares the cost of a full
+// chain to the cost of uploading the base level.
+
+enum MipmapFilter {
+  MIPMAP_FILTER_BOX,
+  MIPMAP_FILTER_TENT,
+  MIPMAP_FILTER_GAMMA_CORRECT,
+};
+
+// Returns the size of a dimension of the given mipmap level.
+inline uint32_t GetMipmapDimension(uint32_t base, uint32_t level) {
+  const uint32_t dimension = base >> level;
+  return dimension ? dimension : 1;
+}
+
+// Returns the number of levels in a complete chain down to 1x1x1.
+uint32_t GetMaxMipmapLevels(uint32_t width, uint32_t height, uint32_t depth = 1);
+
+// Computes the level following a `width` x `height` image whose rows are `pitch` bytes apart. The result has the same
+// channel layout and is written to `dest` without padding between rows. Only MIPMAP_FILTER_GAMMA_CORRECT depends on
+// `layout`.
+void GenerateMipmap(const uint8_t *source, uint32_t width, uint32_t height, uint32_t pitch,
+                    const TexelChannelLayout &layout, MipmapFilter filter, uint32_t *dest);
+
+// Returns the name of the instruction set used by the box and tent filters.
+const char *GetMipmapImplementation();
+
+#endif  // NXDK_PGRAPH_TESTS_TEXTURE_MIPMAP_H
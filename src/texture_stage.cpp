@@ -1,10 +1,19 @@
 #include "texture_stage.h"
 
+#include <cstring>
+#include <vector>
+
 #include "debug_output.h"
 #include "math3d.h"
 #include "nxdk_ext.h"
 #include "pbkit_ext.h"
-#include "swizzle.h"
+#include "texture_compression.h"
+#include "texture_conversion.h"
+#include "texture_mipmap.h"
+#include "texture_swizzle.h"
+
+// Each face of a cubemap, including its mipmap levels, starts at a multiple of this alignment.
+static constexpr uint32_t kCubemapFaceAlignment = 128;
 
 // bitscan forward
 static int bsf(int val){__asm bsf eax, val}
@@ -18,11 +27,11 @@ bool TextureStage::RequiresColorspaceConversion() const {
          format_.xbox_format == NV097_SET_TEXTURE_FORMAT_COLOR_LC_IMAGE_YB8CR8YA8CB8;
 }
 
-void TextureStage::Commit(uint32_t memory_dma_offset, uint32_t palette_dma_offset) const {
+void TextureStage::Commit(uint32_t memory_dma_offset, uint32_t palette_dma_offset, ShadowRegisterFile &shadow) const {
   if (!enabled_) {
     auto p = pb_begin();
     // NV097_SET_TEXTURE_CONTROL0
-    p = pb_push1(p, NV20_TCL_PRIMITIVE_3D_TX_ENABLE(stage_), false);
+    p = shadow.Push1(p, NV20_TCL_PRIMITIVE_3D_TX_ENABLE(stage_), false);
     pb_end(p);
     return;
   }
@@ -36,14 +45,14 @@ void TextureStage::Commit(uint32_t memory_dma_offset, uint32_t palette_dma_offse
   uint32_t offset = reinterpret_cast<uint32_t>(memory_dma_offset) + texture_memory_offset_;
   uint32_t texture_addr = offset & 0x03ffffff;
   // NV097_SET_TEXTURE_OFFSET
-  p = pb_push1(p, NV20_TCL_PRIMITIVE_3D_TX_OFFSET(stage_), texture_addr);
+  p = shadow.Push1(p, NV20_TCL_PRIMITIVE_3D_TX_OFFSET(stage_), texture_addr);
 
   // NV097_SET_TEXTURE_CONTROL0
-  p = pb_push1(p, NV20_TCL_PRIMITIVE_3D_TX_ENABLE(stage_),
-               NV097_SET_TEXTURE_CONTROL0_ENABLE |
-                   MASK(NV097_SET_TEXTURE_CONTROL0_ALPHA_KILL_ENABLE, alpha_kill_enable_) |
-                   MASK(NV097_SET_TEXTURE_CONTROL0_MIN_LOD_CLAMP, lod_min_) |
-                   MASK(NV097_SET_TEXTURE_CONTROL0_MAX_LOD_CLAMP, lod_max_));
+  p = shadow.Push1(p, NV20_TCL_PRIMITIVE_3D_TX_ENABLE(stage_),
+                   NV097_SET_TEXTURE_CONTROL0_ENABLE |
+                       MASK(NV097_SET_TEXTURE_CONTROL0_ALPHA_KILL_ENABLE, alpha_kill_enable_) |
+                       MASK(NV097_SET_TEXTURE_CONTROL0_MIN_LOD_CLAMP, lod_min_) |
+                       MASK(NV097_SET_TEXTURE_CONTROL0_MAX_LOD_CLAMP, lod_max_));
 
   uint32_t dimensionality = GetDimensionality();
 
@@ -68,15 +77,15 @@ void TextureStage::Commit(uint32_t memory_dma_offset, uint32_t palette_dma_offse
                     MASK(NV097_SET_TEXTURE_FORMAT_BASE_SIZE_P, size_p);
 
   // NV097_SET_TEXTURE_FORMAT
-  p = pb_push1(p, NV20_TCL_PRIMITIVE_3D_TX_FORMAT(stage_), format);
+  p = shadow.Push1(p, NV20_TCL_PRIMITIVE_3D_TX_FORMAT(stage_), format);
 
   uint32_t pitch_param = (format_.xbox_bpp * width_ / 8) << 16;
   // NV097_SET_TEXTURE_CONTROL1
-  p = pb_push1(p, NV20_TCL_PRIMITIVE_3D_TX_NPOT_PITCH(stage_), pitch_param);
+  p = shadow.Push1(p, NV20_TCL_PRIMITIVE_3D_TX_NPOT_PITCH(stage_), pitch_param);
 
   uint32_t size_param = (width_ << 16) | (height_ & 0xFFFF);
   // NV097_SET_TEXTURE_IMAGE_RECT
-  p = pb_push1(p, NV20_TCL_PRIMITIVE_3D_TX_NPOT_SIZE(stage_), size_param);
+  p = shadow.Push1(p, NV20_TCL_PRIMITIVE_3D_TX_NPOT_SIZE(stage_), size_param);
 
   // NV097_SET_TEXTURE_ADDRESS
   uint32_t texture_address = MASK(NV097_SET_TEXTURE_ADDRESS_U, wrap_modes_[0]) |
@@ -86,10 +95,10 @@ void TextureStage::Commit(uint32_t memory_dma_offset, uint32_t palette_dma_offse
                              MASK(NV097_SET_TEXTURE_ADDRESS_P, wrap_modes_[2]) |
                              MASK(NV097_SET_TEXTURE_ADDRESS_CYLINDERWRAP_P, cylinder_wrap_[2]) |
                              MASK(NV097_SET_TEXTURE_ADDRESS_CYLINDERWRAP_Q, cylinder_wrap_[3]);
-  p = pb_push1(p, NV20_TCL_PRIMITIVE_3D_TX_WRAP(stage_), texture_address);
+  p = shadow.Push1(p, NV20_TCL_PRIMITIVE_3D_TX_WRAP(stage_), texture_address);
 
   // NV097_SET_TEXTURE_FILTER
-  p = pb_push1(p, NV20_TCL_PRIMITIVE_3D_TX_FILTER(stage_), texture_filter_);
+  p = shadow.Push1(p, NV20_TCL_PRIMITIVE_3D_TX_FILTER(stage_), texture_filter_);
 
   uint32_t palette_config = 0;
   if (format_.xbox_format == NV097_SET_TEXTURE_FORMAT_COLOR_SZ_I8_A8R8G8B8) {
@@ -101,23 +110,23 @@ void TextureStage::Commit(uint32_t memory_dma_offset, uint32_t palette_dma_offse
   }
 
   // NV097_SET_TEXTURE_PALETTE
-  p = pb_push1(p, NV20_TCL_PRIMITIVE_3D_TX_PALETTE_OFFSET(stage_), palette_config);
+  p = shadow.Push1(p, NV20_TCL_PRIMITIVE_3D_TX_PALETTE_OFFSET(stage_), palette_config);
 
-  p = pb_push1(p, NV097_SET_TEXTURE_BORDER_COLOR, border_color_);
+  p = shadow.Push1(p, NV097_SET_TEXTURE_BORDER_COLOR, border_color_);
 
-  p = pb_push4f(p, NV097_SET_TEXTURE_SET_BUMP_ENV_MAT, bump_env_material[0], bump_env_material[1], bump_env_material[2],
-                bump_env_material[3]);
-  p = pb_push1f(p, NV097_SET_TEXTURE_SET_BUMP_ENV_SCALE, bump_env_scale);
-  p = pb_push1f(p, NV097_SET_TEXTURE_SET_BUMP_ENV_OFFSET, bump_env_offset);
-  p = pb_push1(p, NV097_SET_TEXTURE_MATRIX_ENABLE + (4 * stage_), texture_matrix_enable_);
+  p = shadow.Push4f(p, NV097_SET_TEXTURE_SET_BUMP_ENV_MAT, bump_env_material[0], bump_env_material[1],
+                    bump_env_material[2], bump_env_material[3]);
+  p = shadow.Push1f(p, NV097_SET_TEXTURE_SET_BUMP_ENV_SCALE, bump_env_scale);
+  p = shadow.Push1f(p, NV097_SET_TEXTURE_SET_BUMP_ENV_OFFSET, bump_env_offset);
+  p = shadow.Push1(p, NV097_SET_TEXTURE_MATRIX_ENABLE + (4 * stage_), texture_matrix_enable_);
   if (texture_matrix_enable_) {
     p = pb_push_4x4_matrix(p, NV097_SET_TEXTURE_MATRIX + 64 * stage_, texture_matrix_);
   }
 
-  p = pb_push1(p, NV097_SET_TEXGEN_S, texgen_s_);
-  p = pb_push1(p, NV097_SET_TEXGEN_T, texgen_t_);
-  p = pb_push1(p, NV097_SET_TEXGEN_R, texgen_r_);
-  p = pb_push1(p, NV097_SET_TEXGEN_Q, texgen_q_);
+  p = shadow.Push1(p, NV097_SET_TEXGEN_S, texgen_s_);
+  p = shadow.Push1(p, NV097_SET_TEXGEN_T, texgen_t_);
+  p = shadow.Push1(p, NV097_SET_TEXGEN_R, texgen_r_);
+  p = shadow.Push1(p, NV097_SET_TEXGEN_Q, texgen_q_);
 
   pb_end(p);
 }
@@ -133,293 +142,558 @@ void TextureStage::SetFilter(uint32_t lod_bias, TextureStage::ConvolutionKernel
       MASK(NV097_SET_TEXTURE_FILTER_BSIGNED, signed_blue);
 }
 
-int TextureStage::SetTexture(const SDL_Surface *surface, uint8_t *memory_base) const {
-  auto pixels = static_cast<uint32_t *>(surface->pixels);
-
-  // if conversion required, do so, otherwise use SDL to convert
-  if (format_.require_conversion) {
-    uint8_t *dest = memory_base + texture_memory_offset_;
-
-    // Buffer for formats that need to be swizzled after conversion.
-    uint32_t swizzle_w = surface->w;
-    uint32_t swizzle_h = surface->h;
-    uint32_t swizzle_depth = 1;
-    uint32_t swizzle_pitch = surface->pitch;
-    uint32_t swizzle_bpp = surface->format->BytesPerPixel;
-    uint8_t *converted = nullptr;
-
-    // TODO: potential reference material -
-    // https://github.com/scalablecory/colors/blob/master/color.c
-    switch (format_.xbox_format) {
-      case NV097_SET_TEXTURE_FORMAT_COLOR_LC_IMAGE_CR8YB8CB8YA8:  // YUY2 aka
-                                                                  // YUYV
-      {
-        uint32_t *source = pixels;
-        for (int y = 0; y < surface->h; ++y) {
-          for (int x = 0; x < surface->w; x += 2, source += 2) {
-            uint8_t R0, G0, B0, R1, G1, B1;
-            SDL_GetRGB(source[0], surface->format, &R0, &G0, &B0);
-            SDL_GetRGB(source[1], surface->format, &R1, &G1, &B1);
-            dest[0] = (0.257f * R0) + (0.504f * G0) + (0.098f * B0) + 16;    // Y0
-            dest[1] = -(0.148f * R1) - (0.291f * G1) + (0.439f * B1) + 128;  // U
-            dest[2] = (0.257f * R1) + (0.504f * G1) + (0.098f * B1) + 16;    // Y1
-            dest[3] = (0.439f * R1) - (0.368f * G1) - (0.071f * B1) + 128;   // V
-            dest += 4;
-          }
-        }
-      } break;
-
-      case NV097_SET_TEXTURE_FORMAT_COLOR_LC_IMAGE_YB8CR8YA8CB8:  // UYVY
-      {
-        uint32_t *source = pixels;
-        for (int y = 0; y < surface->h; ++y) {
-          for (int x = 0; x < surface->w; x += 2, source += 2) {
-            uint8_t R0, G0, B0, R1, G1, B1;
-            SDL_GetRGB(source[0], surface->format, &R0, &G0, &B0);
-            SDL_GetRGB(source[1], surface->format, &R1, &G1, &B1);
-            dest[0] = -(0.148f * R1) - (0.291f * G1) + (0.439f * B1) + 128;  // U
-            dest[1] = (0.257f * R0) + (0.504f * G0) + (0.098f * B0) + 16;    // Y0
-            dest[2] = (0.439f * R1) - (0.368f * G1) - (0.071f * B1) + 128;   // V
-            dest[3] = (0.257f * R1) + (0.504f * G1) + (0.098f * B1) + 16;    // Y1
-            dest += 4;
-          }
-        }
-      } break;
-
-      case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_AY8:
-      case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_Y8: {
-        uint32_t *source = pixels;
-        for (int y = 0; y < surface->h; ++y) {
-          for (int x = 0; x < surface->w; ++x, ++source) {
-            uint8_t red, green, blue;
-            SDL_GetRGB(source[0], surface->format, &red, &green, &blue);
-            *dest++ = static_cast<uint8_t>(0.299f * red + 0.587f * green + 0.114f * blue);
-          }
-        }
-      } break;
-
-      case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_AY8:
-      case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_Y8: {
-        uint32_t *source = pixels;
-        swizzle_bpp = 1;
-        swizzle_pitch = swizzle_w * swizzle_bpp;
-        converted = new uint8_t[swizzle_pitch * swizzle_h * swizzle_depth];
-        dest = converted;
-
-        for (int y = 0; y < surface->h; ++y) {
-          for (int x = 0; x < surface->w; ++x, ++source) {
-            uint8_t red, green, blue;
-            SDL_GetRGB(source[0], surface->format, &red, &green, &blue);
-            *dest++ = static_cast<uint8_t>(0.299f * red + 0.587f * green + 0.114f * blue);
-          }
-        }
-      } break;
-
-      case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A8Y8: {
-        uint32_t *source = pixels;
-        swizzle_bpp = 2;
-        swizzle_pitch = swizzle_w * swizzle_bpp;
-        converted = new uint8_t[swizzle_pitch * swizzle_h * swizzle_depth];
-        dest = converted;
-
-        for (int y = 0; y < surface->h; ++y) {
-          for (int x = 0; x < surface->w; ++x, ++source) {
-            uint8_t red, green, blue, alpha;
-            SDL_GetRGBA(*source, surface->format, &red, &green, &blue, &alpha);
-            *dest++ = static_cast<uint8_t>(0.299f * red + 0.587f * green + 0.114f * blue);
-            *dest++ = alpha;
-          }
-        }
-      } break;
-
-      case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_Y16:
-      case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FIXED: {
-        // Treat the source as a 32-bit depth value and remap to 16 bit.
-        uint32_t *source = pixels;
-        for (int y = 0; y < surface->h; ++y) {
-          for (int x = 0; x < surface->w; ++x, ++source) {
-            uint8_t red, green, blue;
-            SDL_GetRGB(source[0], surface->format, &red, &green, &blue);
-            uint32_t y_value = static_cast<uint8_t>(0.299f * red + 0.587f * green + 0.114f * blue);
-            y_value = static_cast<uint32_t>(static_cast<float>(y_value) / 255.0f * 65535.0f);
-            *dest++ = y_value & 0xFF;
-            *dest++ = (y_value >> 8) & 0xFF;
-          }
-        }
-      } break;
-
-      case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FLOAT: {
-        // TODO: Implement conversion to float.
-        ASSERT(!"Y16 float format not supported.");
-      } break;
-
-      case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_G8B8: {
-        uint32_t *source = pixels;
-        for (int y = 0; y < surface->h; ++y) {
-          for (int x = 0; x < surface->w; ++x, ++source) {
-            uint8_t red, green, blue, alpha;
-            SDL_GetRGBA(*source, surface->format, &red, &green, &blue, &alpha);
-            *dest++ = blue;
-            *dest++ = green;
-          }
-        }
-      } break;
-
-      case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_R8B8: {
-        uint32_t *source = pixels;
-        for (int y = 0; y < surface->h; ++y) {
-          for (int x = 0; x < surface->w; ++x, ++source) {
-            uint8_t red, green, blue, alpha;
-            SDL_GetRGBA(*source, surface->format, &red, &green, &blue, &alpha);
-            *dest++ = blue;
-            *dest++ = red;
-          }
-        }
-      } break;
-
-      case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_G8B8: {
-        uint32_t *source = pixels;
-        swizzle_bpp = 2;
-        swizzle_pitch = swizzle_w * swizzle_bpp;
-        converted = new uint8_t[swizzle_pitch * swizzle_h * swizzle_depth];
-        dest = converted;
-
-        for (int y = 0; y < surface->h; ++y) {
-          for (int x = 0; x < surface->w; ++x, ++source) {
-            uint8_t red, green, blue, alpha;
-            SDL_GetRGBA(*source, surface->format, &red, &green, &blue, &alpha);
-            *dest++ = blue;
-            *dest++ = green;
-          }
-        }
-      } break;
-
-      case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_R8B8: {
-        uint32_t *source = pixels;
-        swizzle_bpp = 2;
-        swizzle_pitch = swizzle_w * swizzle_bpp;
-        converted = new uint8_t[swizzle_pitch * swizzle_h * swizzle_depth];
-        dest = converted;
-
-        for (int y = 0; y < surface->h; ++y) {
-          for (int x = 0; x < surface->w; ++x, ++source) {
-            uint8_t red, green, blue, alpha;
-            SDL_GetRGBA(*source, surface->format, &red, &green, &blue, &alpha);
-            *dest++ = blue;
-            *dest++ = red;
-          }
-        }
-      } break;
-
-      case NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT1_A1R5G5B5: {
-        uint32_t *source = pixels;
-        for (int y = 0; y < surface->h; y += 4) {
-          for (int x = 0; x < surface->w; x += 4, source += 4) {
-            // TODO: use proper encoding of the colors by quering all the colors and calculating color distances
-            // Reference: https://www.khronos.org/opengl/wiki/S3_Texture_Compression
-            uint8_t red, green, blue, alpha;
-            SDL_GetRGBA(*source, surface->format, &red, &green, &blue, &alpha);
-
-            // color0
-            dest[0] = 0x0;
-            dest[1] = 0x0;
-            // color1
-            dest[2] = ((green & 0x1C) << 3) + (blue >> 3);
-            dest[3] = (red & 0xF8) + (green >> 5);
-            uint8_t code = alpha >= 125 ? 0x55 : 0xFF;
-            dest[4] = code;  // code 0
-            dest[5] = code;  // code 1
-            dest[6] = code;  // code 2
-            dest[7] = code;  // code 3
-            dest += 8;
-          }
-          source += 3 * surface->w;
+void TextureStage::SetMinFilter(TextureStage::MinFilter min) {
+  texture_filter_ = (texture_filter_ & ~NV097_SET_TEXTURE_FILTER_MIN) | MASK(NV097_SET_TEXTURE_FILTER_MIN, min);
+}
+
+void TextureStage::SetMagFilter(TextureStage::MagFilter mag) {
+  texture_filter_ = (texture_filter_ & ~NV097_SET_TEXTURE_FILTER_MAG) | MASK(NV097_SET_TEXTURE_FILTER_MAG, mag);
+}
+
+void TextureStage::SetLODBias(uint32_t lod_bias) {
+  texture_filter_ = (texture_filter_ & ~NV097_SET_TEXTURE_FILTER_MIPMAP_LOD_BIAS) |
+                    MASK(NV097_SET_TEXTURE_FILTER_MIPMAP_LOD_BIAS, lod_bias);
+}
+
+// Returns the number of bytes occupied by a single mipmap level. Compressed levels are padded to whole 4x4 blocks.
+static uint32_t GetLevelSize(const TextureFormatInfo &format, uint32_t width, uint32_t height, uint32_t depth) {
+  if (format.xbox_format == NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT1_A1R5G5B5 ||
+      format.xbox_format == NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT23_A8R8G8B8 ||
+      format.xbox_format == NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT45_A8R8G8B8) {
+    width = (width + 3) & ~3;
+    height = (height + 3) & ~3;
+  }
+  return width * height * depth * format.xbox_bpp / 8;
+}
+
+uint32_t TextureStage::GetTextureSize(uint32_t width, uint32_t height, uint32_t depth) const {
+  uint32_t size = 0;
+  for (uint32_t level = 0; level < mipmap_levels_; ++level) {
+    size += GetLevelSize(format_, GetMipmapDimension(width, level), GetMipmapDimension(height, level),
+                         GetMipmapDimension(depth, level));
+  }
+  return size;
+}
+
+uint32_t TextureStage::GetCubemapFaceSize(uint32_t width, uint32_t height) const {
+  return (GetTextureSize(width, height) + kCubemapFaceAlignment - 1) & ~(kCubemapFaceAlignment - 1);
+}
+
+namespace {
+
+// Reads texels from one or more identically formatted SDL surfaces (the layers of a volumetric texture).
+struct TexelSource {
+  const SDL_PixelFormat *format;
+  const uint8_t *const *layers;
+  uint32_t width;
+  uint32_t height;
+  uint32_t depth;
+  uint32_t pitch;
+  uint32_t bytes_per_pixel;
+
+  inline uint32_t GetPixel(const uint8_t *texel) const {
+    if (bytes_per_pixel == 4) {
+      uint32_t pixel;
+      memcpy(&pixel, texel, sizeof(pixel));
+      return pixel;
+    }
+
+    uint32_t pixel = 0;
+    memcpy(&pixel, texel, bytes_per_pixel);
+    return pixel;
+  }
+
+  inline void GetRGBA(const uint8_t *texel, uint8_t &red, uint8_t &green, uint8_t &blue, uint8_t &alpha) const {
+    SDL_GetRGBA(GetPixel(texel), format, &red, &green, &blue, &alpha);
+  }
+
+  // Describes the source texels if they are 32-bit with 8-bit channels, which the conversion kernels can read without
+  // unpacking them.
+  inline bool GetDirectLayout(TexelChannelLayout &layout) const {
+    if (bytes_per_pixel != 4 || format->Rloss || format->Gloss || format->Bloss || (format->Amask && format->Aloss)) {
+      return false;
+    }
+    layout = {format->Rshift, format->Gshift, format->Bshift, format->Ashift, format->Amask != 0};
+    return true;
+  }
+};
+
+inline uint32_t MapRGBA(const SDL_PixelFormat *format, uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha) {
+  return ((red >> format->Rloss) << format->Rshift) | ((green >> format->Gloss) << format->Gshift) |
+         ((blue >> format->Bloss) << format->Bshift) | (((alpha >> format->Aloss) << format->Ashift) & format->Amask);
+}
+
+}  // namespace
+
+// Invokes `visit` with every texel of `source`, in swizzled order if `swizzle` is set.
+template <typename Visitor>
+static void ForEachTexel(const TexelSource &source, bool swizzle, Visitor &&visit) {
+  if (!swizzle) {
+    for (uint32_t z = 0; z < source.depth; ++z) {
+      for (uint32_t y = 0; y < source.height; ++y) {
+        const uint8_t *texel = source.layers[z] + y * source.pitch;
+        for (uint32_t x = 0; x < source.width; ++x, texel += source.bytes_per_pixel) {
+          visit(texel);
         }
-      } break;
+      }
+    }
+    return;
+  }
 
-      default:
-        return 3;
+  // The layers are addressed as though they were stored at power of two intervals, so the layer index of a texel can
+  // be extracted from its offset with a shift.
+  uint32_t layer_shift = 0;
+  while ((1u << layer_shift) < source.pitch * source.height) {
+    ++layer_shift;
+  }
+  const uint32_t layer_mask = (1u << layer_shift) - 1;
+
+  std::vector<uint32_t> low_offsets;
+  std::vector<uint32_t> high_offsets;
+  BuildSwizzleOffsetTables(source.width, source.height, source.depth, source.pitch, 1u << layer_shift,
+                           source.bytes_per_pixel, low_offsets, high_offsets);
+
+  for (auto high_offset : high_offsets) {
+    for (auto low_offset : low_offsets) {
+      const uint32_t offset = high_offset + low_offset;
+      visit(source.layers[offset >> layer_shift] + (offset & layer_mask));
     }
+  }
+}
+
+// Converts every texel of `source` via `convert` and writes the results directly to `dest`, in swizzled order if
+// `swizzle` is set. `convert` is invoked with the source texel and the destination for `dest_bytes_per_texel` bytes.
+template <typename Converter>
+static void WriteTexels(const TexelSource &source, bool swizzle, uint32_t dest_bytes_per_texel, uint8_t *dest,
+                        Converter &&convert) {
+  ForEachTexel(source, swizzle, [&](const uint8_t *texel) {
+    convert(texel, dest);
+    dest += dest_bytes_per_texel;
+  });
+}
 
-    if (format_.xbox_swizzled) {
-      ASSERT(converted && "Swizzle source buffer not populated");
-      SetRawTexture((const uint8_t *)converted, swizzle_w, swizzle_h, swizzle_depth, swizzle_pitch, swizzle_bpp,
-                    format_.xbox_swizzled, memory_base);
-      delete[] converted;
+// Converts runs of texels via one of the kernels in texture_conversion.h, which is invoked with a run of 32-bit texels,
+// their layout and the destination. Rows of linear textures whose texels the kernels can read directly are passed
+// straight from the source. Otherwise texels are gathered (and unpacked, if necessary) into a small buffer first.
+template <typename Kernel>
+static void WriteTexelRuns(const TexelSource &source, bool swizzle, uint32_t dest_bytes_per_texel, uint8_t *dest,
+                           Kernel &&kernel) {
+  TexelChannelLayout layout{};
+  const bool direct = source.GetDirectLayout(layout);
+
+  if (direct && !swizzle) {
+    for (uint32_t z = 0; z < source.depth; ++z) {
+      for (uint32_t y = 0; y < source.height; ++y) {
+        auto row = reinterpret_cast<const uint32_t *>(source.layers[z] + y * source.pitch);
+        kernel(row, source.width, layout, dest);
+        dest += source.width * dest_bytes_per_texel;
+      }
     }
+    return;
+  }
 
-    return 0;
+  if (!direct) {
+    layout = kPackedTexelLayout;
   }
 
-  // standard SDL conversion to destination format
-  SDL_Surface *new_surf = SDL_ConvertSurfaceFormat(const_cast<SDL_Surface *>(surface), format_.sdl_format, 0);
-  if (!new_surf) {
-    return 4;
+  // Must be even so that YUV pairs are never split between runs.
+  static constexpr uint32_t kRunTexels = 64;
+  uint32_t run[kRunTexels];
+  uint32_t run_length = 0;
+  ForEachTexel(source, swizzle, [&](const uint8_t *texel) {
+    if (direct) {
+      memcpy(run + run_length, texel, sizeof(*run));
+    } else {
+      uint8_t red, green, blue, alpha;
+      source.GetRGBA(texel, red, green, blue, alpha);
+      run[run_length] = PackTexel(red, green, blue, alpha);
+    }
+
+    if (++run_length == kRunTexels) {
+      kernel(run, run_length, layout, dest);
+      dest += run_length * dest_bytes_per_texel;
+      run_length = 0;
+    }
+  });
+
+  if (run_length) {
+    kernel(run, run_length, layout, dest);
   }
+}
 
-  SetRawTexture((const uint8_t *)new_surf->pixels, new_surf->w, new_surf->h, 1, new_surf->pitch,
-                new_surf->format->BytesPerPixel, format_.xbox_swizzled, memory_base);
+// Compresses each layer of `source` into consecutive images of DXT blocks.
+static void CompressTexture(const TexelSource &source, DXTFormat format, uint8_t *dest) {
+  const uint32_t block_size = GetDXTBlockSize(format);
+  const uint32_t blocks_wide = (source.width + 3) / 4;
+  const uint32_t blocks_high = (source.height + 3) / 4;
+
+  TexelChannelLayout layout{};
+  const bool direct = source.GetDirectLayout(layout);
+  for (uint32_t z = 0; z < source.depth; ++z) {
+    if (direct) {
+      CompressDXTImage(source.layers[z], source.width, source.height, source.pitch, layout, format, DXT_QUALITY_HIGH,
+                       dest);
+      dest += blocks_wide * blocks_high * block_size;
+      continue;
+    }
 
-  SDL_FreeSurface(new_surf);
-  return 0;
+    // Other source formats are unpacked one block at a time.
+    uint32_t block[16];
+    for (uint32_t block_y = 0; block_y < blocks_high; ++block_y) {
+      for (uint32_t block_x = 0; block_x < blocks_wide; ++block_x, dest += block_size) {
+        for (uint32_t i = 0; i < 16; ++i) {
+          const uint32_t x = block_x * 4 + (i & 3) < source.width ? block_x * 4 + (i & 3) : source.width - 1;
+          const uint32_t y = block_y * 4 + (i >> 2) < source.height ? block_y * 4 + (i >> 2) : source.height - 1;
+          uint8_t red, green, blue, alpha;
+          source.GetRGBA(source.layers[z] + y * source.pitch + x * source.bytes_per_pixel, red, green, blue, alpha);
+          block[i] = PackTexel(red, green, blue, alpha);
+        }
+        CompressDXTBlock(block, format, DXT_QUALITY_HIGH, dest);
+      }
+    }
+  }
 }
 
-int TextureStage::SetVolumetricTexture(const SDL_Surface **layers, uint32_t depth, uint8_t *memory_base) const {
-  ASSERT((!format_.xbox_linear) && "Volumetric textures using linear formats are not supported by XBOX.")
+// Converts `source` into the given format, writing the result directly into texture memory.
+static int ConvertTexture(const TextureFormatInfo &format, const TexelSource &source, uint8_t *dest) {
+  const bool swizzle = format.xbox_swizzled;
+  if (swizzle) {
+    auto is_power_of_two = [](uint32_t value) { return value && !(value & (value - 1)); };
+    ASSERT(is_power_of_two(source.width) && is_power_of_two(source.height) && is_power_of_two(source.depth) &&
+           "Swizzled textures must have power of two dimensions.");
+  }
 
-  auto **new_surfaces = new SDL_Surface *[depth];
+  if (!format.require_conversion) {
+    if (source.format->format == format.sdl_format) {
+      const uint32_t bytes_per_pixel = source.bytes_per_pixel;
+      switch (bytes_per_pixel) {
+        case 4:
+          WriteTexels(source, swizzle, 4, dest, [](const uint8_t *texel, uint8_t *out) { memcpy(out, texel, 4); });
+          break;
+        case 2:
+          WriteTexels(source, swizzle, 2, dest, [](const uint8_t *texel, uint8_t *out) { memcpy(out, texel, 2); });
+          break;
+        default:
+          WriteTexels(source, swizzle, bytes_per_pixel, dest, [bytes_per_pixel](const uint8_t *texel, uint8_t *out) {
+            memcpy(out, texel, bytes_per_pixel);
+          });
+          break;
+      }
+      return 0;
+    }
 
-  for (auto i = 0; i < depth; ++i) {
-    auto *surface = const_cast<SDL_Surface *>(layers[i]);
-    new_surfaces[i] = SDL_ConvertSurfaceFormat(surface, format_.sdl_format, 0);
+    if (SDL_ISPIXELFORMAT_INDEXED(format.sdl_format) || SDL_ISPIXELFORMAT_INDEXED(source.format->format)) {
+      return 4;
+    }
 
-    if (!new_surfaces[i]) {
-      ASSERT(!"Failed to convert surface format.");
-      // This will leak memory, but the ASSERT will halt execution anyway.
+    SDL_PixelFormat *target = SDL_AllocFormat(format.sdl_format);
+    if (!target) {
       return 4;
     }
+
+    // Equivalent to SDL_ConvertSurfaceFormat, but without the intermediate surface.
+    const uint32_t bytes_per_pixel = target->BytesPerPixel;
+    if (bytes_per_pixel == 2 || bytes_per_pixel == 4) {
+      const PackedTexelFormat packed{target->Rloss, target->Rshift, target->Gloss, target->Gshift,
+                                     target->Bloss, target->Bshift, target->Amask ? target->Aloss : 8u,
+                                     target->Ashift, bytes_per_pixel};
+      SDL_FreeFormat(target);
+      WriteTexelRuns(source, swizzle, bytes_per_pixel, dest,
+                     [&packed](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *out) {
+                       ConvertTexelsToPacked(texels, count, layout, packed, out);
+                     });
+      return 0;
+    }
+
+    auto convert = [&source, target, bytes_per_pixel](const uint8_t *texel, uint8_t *out) {
+      uint8_t red, green, blue, alpha;
+      source.GetRGBA(texel, red, green, blue, alpha);
+      const uint32_t pixel = MapRGBA(target, red, green, blue, alpha);
+      memcpy(out, &pixel, bytes_per_pixel);
+    };
+    WriteTexels(source, swizzle, bytes_per_pixel, dest, convert);
+    SDL_FreeFormat(target);
+    return 0;
   }
 
-  const int32_t width = new_surfaces[0]->w;
-  int32_t height = new_surfaces[0]->h;
-  int32_t pitch = new_surfaces[0]->pitch;
-  int32_t bytes_per_pixel = new_surfaces[0]->format->BytesPerPixel;
+  // TODO: potential reference material -
+  // https://github.com/scalablecory/colors/blob/master/color.c
+  switch (format.xbox_format) {
+    case NV097_SET_TEXTURE_FORMAT_COLOR_LC_IMAGE_CR8YB8CB8YA8:  // YUY2 aka YUYV
+    case NV097_SET_TEXTURE_FORMAT_COLOR_LC_IMAGE_YB8CR8YA8CB8:  // UYVY
+      // These formats are always linear.
+      if (format.xbox_format == NV097_SET_TEXTURE_FORMAT_COLOR_LC_IMAGE_CR8YB8CB8YA8) {
+        WriteTexelRuns(source, false, 2, dest, ConvertTexelsToYUY2);
+      } else {
+        WriteTexelRuns(source, false, 2, dest, ConvertTexelsToUYVY);
+      }
+      break;
 
-  uint32_t converted_surface_size = pitch * height;
-  auto *flattened = new uint8_t[converted_surface_size * depth];
-  uint8_t *dest = flattened;
-  for (auto i = 0; i < depth; ++i) {
-    SDL_Surface *s = new_surfaces[i];
-    ASSERT(s->w == width && "Volumetric surface layers must have identical dimensions");
-    ASSERT(s->h == height && "Volumetric surface layers must have identical dimensions");
-    ASSERT(s->pitch == pitch && "Volumetric surface layers must have identical dimensions");
-    ASSERT(s->format->BytesPerPixel == bytes_per_pixel && "Volumetric surface layers must have identical dimensions");
+    case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_AY8:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_Y8:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_AY8:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_Y8:
+      WriteTexelRuns(source, swizzle, 1, dest, ConvertTexelsToY8);
+      break;
+
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A8Y8:
+      WriteTexelRuns(source, swizzle, 2, dest, ConvertTexelsToA8Y8);
+      break;
+
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_A8:
+      WriteTexelRuns(source, swizzle, 1, dest,
+                     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *out) {
+                       static constexpr PackedTexelFormat kA8{8, 0, 8, 0, 8, 0, 0, 0, 1};
+                       ConvertTexelsToPacked(texels, count, layout, kA8, out);
+                     });
+      break;
+
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_R6G5B5:
+      WriteTexelRuns(source, swizzle, 2, dest,
+                     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *out) {
+                       static constexpr PackedTexelFormat kR6G5B5{2, 10, 3, 5, 3, 0, 8, 0, 2};
+                       ConvertTexelsToPacked(texels, count, layout, kR6G5B5, out);
+                     });
+      break;
+
+    case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_Y16:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FIXED:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_DEPTH_Y16_FIXED:
+      // Treat the source as a 32-bit depth value and remap to 16 bit.
+      WriteTexelRuns(source, swizzle, 2, dest, ConvertTexelsToY16);
+      break;
+
+    case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_DEPTH_Y16_FLOAT:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_DEPTH_Y16_FLOAT:
+      // Remap the luminance to the range of the 16-bit float depth format.
+      WriteTexelRuns(source, swizzle, 2, dest, ConvertTexelsToY16Float);
+      break;
+
+    case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_G8B8:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_G8B8:
+      WriteTexelRuns(source, swizzle, 2, dest,
+                     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *out) {
+                       ConvertTexelsToChannelPair(texels, count, layout.blue_shift, layout.green_shift, out);
+                     });
+      break;
 
-    memcpy(dest, s->pixels, converted_surface_size);
-    dest += converted_surface_size;
+    case NV097_SET_TEXTURE_FORMAT_COLOR_LU_IMAGE_R8B8:
+    case NV097_SET_TEXTURE_FORMAT_COLOR_SZ_R8B8:
+      WriteTexelRuns(source, swizzle, 2, dest,
+                     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *out) {
+                       ConvertTexelsToChannelPair(texels, count, layout.blue_shift, layout.red_shift, out);
+                     });
+      break;
+
+    case NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT1_A1R5G5B5:
+      CompressTexture(source, DXT_FORMAT_DXT1, dest);
+      break;
+
+    case NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT23_A8R8G8B8:
+      CompressTexture(source, DXT_FORMAT_DXT3, dest);
+      break;
+
+    case NV097_SET_TEXTURE_FORMAT_COLOR_L_DXT45_A8R8G8B8:
+      CompressTexture(source, DXT_FORMAT_DXT5, dest);
+      break;
+
+    default:
+      return 3;
+  }
+
+  return 0;
+}
+
+// Converts `source` followed by the `levels` - 1 mipmap levels generated from it with `filter`. Each level immediately
+// follows the previous one in texture memory, swizzled if the format is.
+static int ConvertMipmapChain(const TextureFormatInfo &format, const TexelSource &source, uint32_t levels,
+                              MipmapFilter filter, uint8_t *dest) {
+  int ret = ConvertTexture(format, source, dest);
+  if (ret || levels <= 1) {
+    return ret;
+  }
+
+  ASSERT(!format.xbox_linear && "Linear textures cannot have mipmaps.");
+  ASSERT(source.depth == 1 && "Mipmap generation is not supported for volumetric textures.");
+  ASSERT(levels <= GetMaxMipmapLevels(source.width, source.height) && "Too many mipmap levels.");
+
+  // The filters read 32-bit texels with 8-bit channels, so other source formats are unpacked first. Each level is then
+  // generated from the previous one and converted like the base level.
+  TexelChannelLayout layout{};
+  const SDL_PixelFormat *level_format = source.format;
+  SDL_PixelFormat *unpacked_format = nullptr;
+  std::vector<uint32_t> unpacked;
+  const uint8_t *previous = source.layers[0];
+  uint32_t previous_pitch = source.pitch;
+  if (!source.GetDirectLayout(layout)) {
+    unpacked_format = SDL_AllocFormat(SDL_PIXELFORMAT_ABGR8888);
+    if (!unpacked_format) {
+      return 4;
+    }
+    layout = kPackedTexelLayout;
+    level_format = unpacked_format;
+
+    unpacked.resize(source.width * source.height);
+    uint32_t *out = unpacked.data();
+    ForEachTexel(source, false, [&source, &out](const uint8_t *texel) {
+      uint8_t red, green, blue, alpha;
+      source.GetRGBA(texel, red, green, blue, alpha);
+      *out++ = PackTexel(red, green, blue, alpha);
+    });
+    previous = reinterpret_cast<const uint8_t *>(unpacked.data());
+    previous_pitch = source.width * 4;
   }
 
+  uint32_t chain_texels = 0;
+  for (uint32_t level = 1; level < levels; ++level) {
+    chain_texels += GetMipmapDimension(source.width, level) * GetMipmapDimension(source.height, level);
+  }
+  std::vector<uint32_t> chain(chain_texels);
+
+  uint32_t width = source.width;
+  uint32_t height = source.height;
+  uint32_t *level_texels = chain.data();
+  for (uint32_t level = 1; level < levels && !ret; ++level) {
+    dest += GetLevelSize(format, width, height, 1);
+    GenerateMipmap(previous, width, height, previous_pitch, layout, filter, level_texels);
+
+    width = GetMipmapDimension(width, 1);
+    height = GetMipmapDimension(height, 1);
+    previous = reinterpret_cast<const uint8_t *>(level_texels);
+    previous_pitch = width * 4;
+    TexelSource level_source{level_format, &previous, width, height, 1, previous_pitch, 4};
+    ret = ConvertTexture(format, level_source, dest);
+    level_texels += width * height;
+  }
+
+  if (unpacked_format) {
+    SDL_FreeFormat(unpacked_format);
+  }
+  return ret;
+}
+
+int TextureStage::SetTexture(const SDL_Surface *surface, uint8_t *memory_base) const {
+  const auto pixels = static_cast<const uint8_t *>(surface->pixels);
+  TexelSource source{surface->format,
+                     &pixels,
+                     static_cast<uint32_t>(surface->w),
+                     static_cast<uint32_t>(surface->h),
+                     1,
+                     static_cast<uint32_t>(surface->pitch),
+                     surface->format->BytesPerPixel};
+
+  return ConvertMipmapChain(format_, source, mipmap_levels_, mipmap_filter_, memory_base + texture_memory_offset_);
+}
+
+int TextureStage::SetVolumetricTexture(const SDL_Surface **layers, uint32_t depth, uint8_t *memory_base) const {
+  ASSERT((!format_.xbox_linear) && "Volumetric textures using linear formats are not supported by XBOX.")
+
+  const SDL_Surface *first = layers[0];
+  std::vector<const uint8_t *> pixels(depth);
   for (auto i = 0; i < depth; ++i) {
-    SDL_FreeSurface(new_surfaces[i]);
+    const SDL_Surface *s = layers[i];
+    ASSERT(s->w == first->w && "Volumetric surface layers must have identical dimensions");
+    ASSERT(s->h == first->h && "Volumetric surface layers must have identical dimensions");
+    ASSERT(s->pitch == first->pitch && "Volumetric surface layers must have identical dimensions");
+    ASSERT(s->format->format == first->format->format && "Volumetric surface layers must have identical formats");
+    pixels[i] = static_cast<const uint8_t *>(s->pixels);
   }
-  delete[] new_surfaces;
 
-  int ret = SetRawTexture(flattened, width, height, depth, pitch, bytes_per_pixel, format_.xbox_swizzled, memory_base);
+  TexelSource source{first->format,
+                     pixels.data(),
+                     static_cast<uint32_t>(first->w),
+                     static_cast<uint32_t>(first->h),
+                     depth,
+                     static_cast<uint32_t>(first->pitch),
+                     first->format->BytesPerPixel};
 
-  delete[] flattened;
+  return ConvertMipmapChain(format_, source, mipmap_levels_, mipmap_filter_, memory_base + texture_memory_offset_);
+}
+
+int TextureStage::SetVolumetricTexture(uint32_t width, uint32_t height, uint32_t depth,
+                                       const VolumeSliceGenerator &generate, uint32_t slice_format,
+                                       uint8_t *memory_base) const {
+  ASSERT((!format_.xbox_linear) && "Volumetric textures using linear formats are not supported by XBOX.")
+  ASSERT(mipmap_levels_ == 1 && "Mipmap generation is not supported for volumetric textures.");
+
+  SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, static_cast<int>(width), static_cast<int>(height),
+                                                        SDL_BITSPERPIXEL(slice_format), slice_format);
+  if (!surface) {
+    return 1;
+  }
 
+  // The texels of a swizzled slice are interleaved with those of its neighbors, so each slice is converted into a
+  // linear scratch image and then scattered into place. Compressed slices are stored one after another.
+  const uint32_t slice_size = GetLevelSize(format_, width, height, 1);
+  TextureFormatInfo slice_texture_format = format_;
+  slice_texture_format.xbox_swizzled = false;
+  std::vector<uint8_t> scratch(format_.xbox_swizzled ? slice_size : 0);
+  const uint32_t bytes_per_texel = format_.xbox_bpp / 8;
+  uint8_t *dest = memory_base + texture_memory_offset_;
+
+  int ret = 0;
+  for (uint32_t slice = 0; slice < depth && !ret; ++slice) {
+    generate(slice, surface);
+
+    const auto pixels = static_cast<const uint8_t *>(surface->pixels);
+    TexelSource source{surface->format, &pixels, width, height, 1, static_cast<uint32_t>(surface->pitch),
+                       surface->format->BytesPerPixel};
+    if (!format_.xbox_swizzled) {
+      ret = ConvertTexture(format_, source, dest + slice * slice_size);
+      continue;
+    }
+
+    ret = ConvertTexture(slice_texture_format, source, scratch.data());
+    if (!ret) {
+      SwizzleSlice(scratch.data(), width, height, depth, slice, dest, width * bytes_per_texel, bytes_per_texel);
+    }
+  }
+
+  SDL_FreeSurface(surface);
   return ret;
 }
 
+int TextureStage::SetCubemapTexture(const SDL_Surface **faces, uint8_t *memory_base) const {
+  ASSERT((!format_.xbox_linear) && "Cubemap textures using linear formats are not supported by XBOX.")
+
+  const SDL_Surface *first = faces[0];
+  ASSERT(first->w == first->h && "Cubemap faces must be square");
+  for (uint32_t i = 1; i < CUBEMAP_NUM_FACES; ++i) {
+    const SDL_Surface *s = faces[i];
+    ASSERT(s->w == first->w && "Cubemap faces must have identical dimensions");
+    ASSERT(s->h == first->h && "Cubemap faces must have identical dimensions");
+    ASSERT(s->format->format == first->format->format && "Cubemap faces must have identical formats");
+  }
+
+  const uint32_t face_size = GetCubemapFaceSize(first->w, first->h);
+  uint8_t *dest = memory_base + texture_memory_offset_;
+  for (uint32_t face = 0; face < CUBEMAP_NUM_FACES; ++face) {
+    const SDL_Surface *surface = faces[face];
+    const auto pixels = static_cast<const uint8_t *>(surface->pixels);
+    TexelSource source{surface->format,
+                       &pixels,
+                       static_cast<uint32_t>(surface->w),
+                       static_cast<uint32_t>(surface->h),
+                       1,
+                       static_cast<uint32_t>(surface->pitch),
+                       surface->format->BytesPerPixel};
+    int ret = ConvertMipmapChain(format_, source, mipmap_levels_, mipmap_filter_, dest + face * face_size);
+    if (ret) {
+      return ret;
+    }
+  }
+  return 0;
+}
+
 int TextureStage::SetRawTexture(const uint8_t *source, uint32_t width, uint32_t height, uint32_t depth, uint32_t pitch,
                                 uint32_t bytes_per_pixel, bool swizzle, uint8_t *memory_base) const {
   uint8_t *dest = memory_base + texture_memory_offset_;
 
   if (swizzle) {
     if (depth > 1) {
-      swizzle_box(source, width, height, depth, dest, pitch, pitch * height, bytes_per_pixel);
+      SwizzleBox(source, width, height, depth, dest, pitch, pitch * height, bytes_per_pixel);
     } else {
-      swizzle_rect(source, width, height, dest, pitch, bytes_per_pixel);
+      SwizzleRect(source, width, height, dest, pitch, bytes_per_pixel);
     }
   } else {
     memcpy(dest, source, pitch * height * depth);
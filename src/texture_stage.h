@@ -4,7 +4,11 @@
 #include <pbkit/pbkit.h>
 #include <printf/printf.h>
 
+#include <functional>
+
+#include "shadow_register_file.h"
 #include "texture_format.h"
+#include "texture_mipmap.h"
 
 // Sets up an nv2a texture stage.
 class TextureStage {
@@ -41,6 +45,20 @@ class TextureStage {
     TG_REFLECTION_MAP = NV097_SET_TEXGEN_S_REFLECTION_MAP,
   };
 
+  // Fills `surface` with slice `slice` of a volumetric texture.
+  typedef std::function<void(uint32_t slice, SDL_Surface *surface)> VolumeSliceGenerator;
+
+  // The order in which the faces of a cubemap are laid out in texture memory.
+  enum CubemapFace {
+    CUBEMAP_POSITIVE_X,
+    CUBEMAP_NEGATIVE_X,
+    CUBEMAP_POSITIVE_Y,
+    CUBEMAP_NEGATIVE_Y,
+    CUBEMAP_POSITIVE_Z,
+    CUBEMAP_NEGATIVE_Z,
+    CUBEMAP_NUM_FACES,
+  };
+
  public:
   TextureStage();
 
@@ -60,6 +78,7 @@ class TextureStage {
 
   void SetEnabled(bool enabled = true) { enabled_ = enabled; }
   void SetFormat(const TextureFormatInfo &format) { format_ = format; }
+  const TextureFormatInfo &GetFormat() const { return format_; }
   void SetBorderColor(uint32_t color) { border_color_ = color; }
 
   void SetCubemapEnable(bool val = true) { cubemap_enable_ = val; }
@@ -107,6 +126,23 @@ class TextureStage {
   void SetFilter(uint32_t lod_bias = 0, ConvolutionKernel kernel = K_QUINCUNX, MinFilter min = MIN_BOX_LOD0,
                  MagFilter mag = MAG_BOX_LOD0, bool signed_alpha = false, bool signed_red = false,
                  bool signed_green = false, bool signed_blue = false);
+  // Replace a single field of the filter set by SetFilter.
+  void SetMinFilter(MinFilter min);
+  void SetMagFilter(MagFilter mag);
+  void SetLODBias(uint32_t lod_bias);
+
+  // Sets the number of mipmap levels, including the base level. Levels after the first are generated with `filter`
+  // when a surface is uploaded to this stage.
+  void SetMipmapLevels(uint32_t levels, MipmapFilter filter = MIPMAP_FILTER_BOX) {
+    mipmap_levels_ = levels;
+    mipmap_filter_ = filter;
+  }
+  uint32_t GetMipmapLevels() const { return mipmap_levels_; }
+  MipmapFilter GetMipmapFilter() const { return mipmap_filter_; }
+
+  // Returns the number of bytes of texture memory used by an image of the given dimensions in the current format,
+  // including all of its mipmap levels.
+  uint32_t GetTextureSize(uint32_t width, uint32_t height, uint32_t depth = 1) const;
 
   bool IsSwizzled() const { return format_.xbox_swizzled; }
   bool IsLinear() const { return format_.xbox_linear; }
@@ -132,13 +168,21 @@ class TextureStage {
 
   void SetStage(uint32_t stage) { stage_ = stage; }
 
+  // Returns the distance between the faces of a cubemap whose faces are `width` x `height`, including their mipmap
+  // levels and the padding between faces.
+  uint32_t GetCubemapFaceSize(uint32_t width, uint32_t height) const;
+
   void SetTextureOffset(uint32_t offset) { texture_memory_offset_ = offset; }
+  uint32_t GetTextureOffset() const { return texture_memory_offset_; }
   void SetPaletteOffset(uint32_t offset) { palette_memory_offset_ = offset; }
 
-  void Commit(uint32_t memory_dma_offset, uint32_t palette_dma_offset) const;
+  void Commit(uint32_t memory_dma_offset, uint32_t palette_dma_offset, ShadowRegisterFile &shadow) const;
 
   int SetTexture(const SDL_Surface *surface, uint8_t *memory_base) const;
   int SetVolumetricTexture(const SDL_Surface **layers, uint32_t depth, uint8_t *memory_base) const;
+  int SetVolumetricTexture(uint32_t width, uint32_t height, uint32_t depth, const VolumeSliceGenerator &generate,
+                           uint32_t slice_format, uint8_t *memory_base) const;
+  int SetCubemapTexture(const SDL_Surface **faces, uint8_t *memory_base) const;
   int SetRawTexture(const uint8_t *source, uint32_t width, uint32_t height, uint32_t depth, uint32_t pitch,
                     uint32_t bytes_per_pixel, bool swizzle, uint8_t *memory_base) const;
 
@@ -162,6 +206,7 @@ class TextureStage {
   uint32_t size_p_{0};
 
   uint32_t mipmap_levels_{1};
+  MipmapFilter mipmap_filter_{MIPMAP_FILTER_BOX};
 
   uint32_t palette_length_{10};
   uint32_t palette_memory_offset_{0};
@@ -0,0 +1,234 @@
+#include "texture_swizzle.h"
+
+#include <cstring>
+#include <vector>
+
+// Linear byte offset contributed by each bit of a swizzled index.
+struct SwizzleLayout {
+  uint32_t num_bits{0};
+  uint32_t bit_offsets[32]{};
+  // Swizzled bit masks for each axis.
+  uint32_t mask_x{0};
+  uint32_t mask_y{0};
+  uint32_t mask_z{0};
+};
+
+static bool IsPowerOfTwo(uint32_t value) { return value && !(value & (value - 1)); }
+
+// Assigns the bits of the swizzled index to the axes in the same way as generate_swizzle_masks in swizzle.c: x, y,
+// and z bits are interleaved starting with x until an axis runs out of bits, after which the remaining axes are packed
+// together.
+static SwizzleLayout BuildLayout(uint32_t width, uint32_t height, uint32_t depth, uint32_t row_pitch,
+                                 uint32_t slice_pitch, uint32_t bytes_per_pixel) {
+  SwizzleLayout layout;
+  uint32_t x_offset = bytes_per_pixel;
+  uint32_t y_offset = row_pitch;
+  uint32_t z_offset = slice_pitch;
+
+  for (uint32_t bit = 1; bit < width || bit < height || bit < depth; bit <<= 1) {
+    if (bit < width) {
+      layout.mask_x |= 1 << layout.num_bits;
+      layout.bit_offsets[layout.num_bits++] = x_offset;
+      x_offset <<= 1;
+    }
+    if (bit < height) {
+      layout.mask_y |= 1 << layout.num_bits;
+      layout.bit_offsets[layout.num_bits++] = y_offset;
+      y_offset <<= 1;
+    }
+    if (bit < depth) {
+      layout.mask_z |= 1 << layout.num_bits;
+      layout.bit_offsets[layout.num_bits++] = z_offset;
+      z_offset <<= 1;
+    }
+  }
+
+  return layout;
+}
+
+// Fills `table` with the linear offset of every value of the `num_bits` bits of the swizzled index starting at
+// `first_bit`.
+static void BuildOffsetTable(const SwizzleLayout &layout, uint32_t first_bit, uint32_t num_bits,
+                             std::vector<uint32_t> &table) {
+  table.resize(1 << num_bits);
+  table[0] = 0;
+  for (uint32_t i = 1; i < table.size(); ++i) {
+    const uint32_t lowest_bit = __builtin_ctz(i);
+    table[i] = table[i & (i - 1)] + layout.bit_offsets[first_bit + lowest_bit];
+  }
+}
+
+// Spreads the bits of `value` into the set bits of `pattern`, e.g., value 0b101 and pattern 0b1011 gives 0b1001.
+static uint32_t FillPattern(uint32_t pattern, uint32_t value) {
+  uint32_t result = 0;
+  for (uint32_t bit = 1; value && bit; bit <<= 1) {
+    if (pattern & bit) {
+      if (value & 1) {
+        result |= bit;
+      }
+      value >>= 1;
+    }
+  }
+  return result;
+}
+
+template <typename T>
+static void SwizzleSequential(const uint8_t *linear, T *swizzled, const std::vector<uint32_t> &low_table,
+                              const std::vector<uint32_t> &high_table) {
+  const uint32_t *low_begin = low_table.data();
+  const uint32_t *low_end = low_begin + low_table.size();
+  for (auto high_offset : high_table) {
+    const uint8_t *base = linear + high_offset;
+    for (auto low = low_begin; low != low_end; ++low) {
+      memcpy(swizzled++, base + *low, sizeof(T));
+    }
+  }
+}
+
+template <typename T>
+static void UnswizzleSequential(const T *swizzled, uint8_t *linear, const std::vector<uint32_t> &low_table,
+                                const std::vector<uint32_t> &high_table) {
+  const uint32_t *low_begin = low_table.data();
+  const uint32_t *low_end = low_begin + low_table.size();
+  for (auto high_offset : high_table) {
+    uint8_t *base = linear + high_offset;
+    for (auto low = low_begin; low != low_end; ++low) {
+      memcpy(base + *low, swizzled++, sizeof(T));
+    }
+  }
+}
+
+static void SwizzleSequentialGeneric(const uint8_t *linear, uint8_t *swizzled, const std::vector<uint32_t> &low_table,
+                                     const std::vector<uint32_t> &high_table, uint32_t bytes_per_pixel) {
+  for (auto high_offset : high_table) {
+    const uint8_t *base = linear + high_offset;
+    for (auto low_offset : low_table) {
+      memcpy(swizzled, base + low_offset, bytes_per_pixel);
+      swizzled += bytes_per_pixel;
+    }
+  }
+}
+
+static void UnswizzleSequentialGeneric(const uint8_t *swizzled, uint8_t *linear, const std::vector<uint32_t> &low_table,
+                                       const std::vector<uint32_t> &high_table, uint32_t bytes_per_pixel) {
+  for (auto high_offset : high_table) {
+    uint8_t *base = linear + high_offset;
+    for (auto low_offset : low_table) {
+      memcpy(base + low_offset, swizzled, bytes_per_pixel);
+      swizzled += bytes_per_pixel;
+    }
+  }
+}
+
+// Converts images with arbitrary dimensions, where not every swizzled index corresponds to a texel. Only the slices
+// from `first_slice` up to `end_slice` are converted; `linear` points to the first of them.
+static void ConvertLinearOrder(uint8_t *linear, uint8_t *swizzled, uint32_t width, uint32_t height, uint32_t depth,
+                               uint32_t row_pitch, uint32_t slice_pitch, uint32_t bytes_per_pixel, bool to_swizzled,
+                               uint32_t first_slice, uint32_t end_slice) {
+  const SwizzleLayout layout = BuildLayout(width, height, depth, row_pitch, slice_pitch, bytes_per_pixel);
+
+  std::vector<uint32_t> columns(width);
+  for (uint32_t x = 0; x < width; ++x) {
+    columns[x] = FillPattern(layout.mask_x, x) * bytes_per_pixel;
+  }
+
+  linear -= first_slice * slice_pitch;
+  for (uint32_t z = first_slice; z < end_slice; ++z) {
+    const uint32_t slice = FillPattern(layout.mask_z, z);
+    for (uint32_t y = 0; y < height; ++y) {
+      uint8_t *swizzled_row = swizzled + (slice | FillPattern(layout.mask_y, y)) * bytes_per_pixel;
+      uint8_t *linear_texel = linear + z * slice_pitch + y * row_pitch;
+      for (uint32_t x = 0; x < width; ++x, linear_texel += bytes_per_pixel) {
+        if (to_swizzled) {
+          memcpy(swizzled_row + columns[x], linear_texel, bytes_per_pixel);
+        } else {
+          memcpy(linear_texel, swizzled_row + columns[x], bytes_per_pixel);
+        }
+      }
+    }
+  }
+}
+
+void SwizzleBox(const uint8_t *source, uint32_t width, uint32_t height, uint32_t depth, uint8_t *dest,
+                uint32_t row_pitch, uint32_t slice_pitch, uint32_t bytes_per_pixel) {
+  if (!width || !height || !depth) {
+    return;
+  }
+
+  if (!IsPowerOfTwo(width) || !IsPowerOfTwo(height) || !IsPowerOfTwo(depth)) {
+    ConvertLinearOrder(const_cast<uint8_t *>(source), dest, width, height, depth, row_pitch, slice_pitch,
+                       bytes_per_pixel, true, 0, depth);
+    return;
+  }
+
+  std::vector<uint32_t> low_table;
+  std::vector<uint32_t> high_table;
+  BuildSwizzleOffsetTables(width, height, depth, row_pitch, slice_pitch, bytes_per_pixel, low_table, high_table);
+
+  switch (bytes_per_pixel) {
+    case 1:
+      SwizzleSequential(source, dest, low_table, high_table);
+      break;
+    case 2:
+      SwizzleSequential(source, reinterpret_cast<uint16_t *>(dest), low_table, high_table);
+      break;
+    case 4:
+      SwizzleSequential(source, reinterpret_cast<uint32_t *>(dest), low_table, high_table);
+      break;
+    default:
+      SwizzleSequentialGeneric(source, dest, low_table, high_table, bytes_per_pixel);
+      break;
+  }
+}
+
+void UnswizzleBox(const uint8_t *source, uint32_t width, uint32_t height, uint32_t depth, uint8_t *dest,
+                  uint32_t row_pitch, uint32_t slice_pitch, uint32_t bytes_per_pixel) {
+  if (!width || !height || !depth) {
+    return;
+  }
+
+  if (!IsPowerOfTwo(width) || !IsPowerOfTwo(height) || !IsPowerOfTwo(depth)) {
+    ConvertLinearOrder(dest, const_cast<uint8_t *>(source), width, height, depth, row_pitch, slice_pitch,
+                       bytes_per_pixel, false, 0, depth);
+    return;
+  }
+
+  std::vector<uint32_t> low_table;
+  std::vector<uint32_t> high_table;
+  BuildSwizzleOffsetTables(width, height, depth, row_pitch, slice_pitch, bytes_per_pixel, low_table, high_table);
+
+  switch (bytes_per_pixel) {
+    case 1:
+      UnswizzleSequential(source, dest, low_table, high_table);
+      break;
+    case 2:
+      UnswizzleSequential(reinterpret_cast<const uint16_t *>(source), dest, low_table, high_table);
+      break;
+    case 4:
+      UnswizzleSequential(reinterpret_cast<const uint32_t *>(source), dest, low_table, high_table);
+      break;
+    default:
+      UnswizzleSequentialGeneric(source, dest, low_table, high_table, bytes_per_pixel);
+      break;
+  }
+}
+
+void SwizzleSlice(const uint8_t *source, uint32_t width, uint32_t height, uint32_t depth, uint32_t slice, uint8_t *dest,
+                  uint32_t row_pitch, uint32_t bytes_per_pixel) {
+  if (!width || !height || slice >= depth) {
+    return;
+  }
+
+  // The texels of a slice are interleaved with those of the other slices, so they are scattered in linear order.
+  ConvertLinearOrder(const_cast<uint8_t *>(source), dest, width, height, depth, row_pitch, 0, bytes_per_pixel, true,
+                     slice, slice + 1);
+}
+
+void BuildSwizzleOffsetTables(uint32_t width, uint32_t height, uint32_t depth, uint32_t row_pitch, uint32_t slice_pitch,
+                              uint32_t bytes_per_pixel, std::vector<uint32_t> &low_offsets,
+                              std::vector<uint32_t> &high_offsets) {
+  const SwizzleLayout layout = BuildLayout(width, height, depth, row_pitch, slice_pitch, bytes_per_pixel);
+  const uint32_t low_bits = (layout.num_bits + 1) / 2;
+  BuildOffsetTable(layout, 0, low_bits, low_offsets);
+  BuildOffsetTable(layout, low_bits, layout.num_bits - low_bits, high_offsets);
+}
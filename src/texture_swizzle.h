@@ -0,0 +1,49 @@
+#ifndef NXDK_PGRAPH_TESTS_TEXTURE_SWIZZLE_H
+#define NXDK_PGRAPH_TESTS_TEXTURE_SWIZZLE_H
+
+#include <cstdint>
+#include <vector>
+
+// Conversion between linear images and the swizzled (Morton ordered) layout used by nv2a textures.
+//
+// The swizzled index of a texel interleaves the bits of its x, y, and z coordinates, so the linear offset of the texel
+// at a given swizzled index is the sum of independent contributions from each bit of the index. The engine splits the
+// index into a low and a high half and precomputes the linear offset of every value of each half, so walking the
+// swizzled image in order costs two table lookups per texel. The swizzled side is always accessed sequentially, which
+// suits the write-combined texture memory allocated by TestHost.
+//
+// Images whose dimensions are not powers of two are converted via per-axis offset tables in linear order instead.
+//
+// Results are identical to swizzle_box/unswizzle_box in third_party/swizzle.c. tools/swizzle_bench compares the two.
+
+// Swizzles a `depth` slice image with the given linear row and slice pitches (in bytes) into `dest`.
+void SwizzleBox(const uint8_t *source, uint32_t width, uint32_t height, uint32_t depth, uint8_t *dest,
+                uint32_t row_pitch, uint32_t slice_pitch, uint32_t bytes_per_pixel);
+
+// Converts a swizzled image into a linear image with the given row and slice pitches (in bytes).
+void UnswizzleBox(const uint8_t *source, uint32_t width, uint32_t height, uint32_t depth, uint8_t *dest,
+                  uint32_t row_pitch, uint32_t slice_pitch, uint32_t bytes_per_pixel);
+
+// Swizzles the `width` x `height` linear image at `source` into the texels of slice `slice` of a `depth` slice image in
+// `dest`, leaving the other slices untouched. Allows volumes to be swizzled one slice at a time.
+void SwizzleSlice(const uint8_t *source, uint32_t width, uint32_t height, uint32_t depth, uint32_t slice, uint8_t *dest,
+                  uint32_t row_pitch, uint32_t bytes_per_pixel);
+
+// Computes the linear byte offset of every texel of a power of two image in swizzled order, for use by callers that
+// produce swizzled data directly. Texel i of the swizzled image is located at
+// high_offsets[i / low_offsets.size()] + low_offsets[i % low_offsets.size()].
+void BuildSwizzleOffsetTables(uint32_t width, uint32_t height, uint32_t depth, uint32_t row_pitch, uint32_t slice_pitch,
+                              uint32_t bytes_per_pixel, std::vector<uint32_t> &low_offsets,
+                              std::vector<uint32_t> &high_offsets);
+
+inline void SwizzleRect(const uint8_t *source, uint32_t width, uint32_t height, uint8_t *dest, uint32_t pitch,
+                        uint32_t bytes_per_pixel) {
+  SwizzleBox(source, width, height, 1, dest, pitch, 0, bytes_per_pixel);
+}
+
+inline void UnswizzleRect(const uint8_t *source, uint32_t width, uint32_t height, uint8_t *dest, uint32_t pitch,
+                          uint32_t bytes_per_pixel) {
+  UnswizzleBox(source, width, height, 1, dest, pitch, 0, bytes_per_pixel);
+}
+
+#endif  // NXDK_PGRAPH_TESTS_TEXTURE_SWIZZLE_H
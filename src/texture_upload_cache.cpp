@@ -0,0 +1,62 @@
+#include "texture_upload_cache.h"
+
+#include <cstring>
+
+static uint32_t GetSourceSize(const TextureUploadCache::SourceRows *sources, uint32_t num_sources) {
+  uint32_t size = 0;
+  for (uint32_t i = 0; i < num_sources; ++i) {
+    size += sources[i].row_size * sources[i].rows;
+  }
+  return size;
+}
+
+bool TextureUploadCache::Lookup(uint32_t stage, const Key &key, const SourceRows *sources, uint32_t num_sources) {
+  bool hit = valid_[stage] && entries_[stage] == key && texels_[stage].size() == GetSourceSize(sources, num_sources);
+
+  const uint8_t *retained = texels_[stage].data();
+  for (uint32_t i = 0; hit && i < num_sources; ++i) {
+    const SourceRows &source = sources[i];
+    const uint8_t *row = source.data;
+    for (uint32_t y = 0; hit && y < source.rows; ++y, row += source.pitch, retained += source.row_size) {
+      hit = !memcmp(row, retained, source.row_size);
+    }
+  }
+
+  if (hit) {
+    ++hits_;
+    return true;
+  }
+
+  ++misses_;
+  valid_[stage] = false;
+  return false;
+}
+
+void TextureUploadCache::Store(uint32_t stage, const Key &key, const SourceRows *sources, uint32_t num_sources) {
+  const uint32_t size = GetSourceSize(sources, num_sources);
+  auto &texels = texels_[stage];
+  if (size > kMaxRetainedSize) {
+    std::vector<uint8_t>().swap(texels);
+    valid_[stage] = false;
+    return;
+  }
+
+  texels.resize(size);
+  uint8_t *retained = texels.data();
+  for (uint32_t i = 0; i < num_sources; ++i) {
+    const SourceRows &source = sources[i];
+    const uint8_t *row = source.data;
+    for (uint32_t y = 0; y < source.rows; ++y, row += source.pitch, retained += source.row_size) {
+      memcpy(retained, row, source.row_size);
+    }
+  }
+
+  entries_[stage] = key;
+  valid_[stage] = true;
+}
+
+void TextureUploadCache::InvalidateAll() {
+  for (auto &valid : valid_) {
+    valid = false;
+  }
+}
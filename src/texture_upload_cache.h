@@ -0,0 +1,85 @@
+#ifndef NXDK_PGRAPH_TESTS_TEXTURE_UPLOAD_CACHE_H
+#define NXDK_PGRAPH_TESTS_TEXTURE_UPLOAD_CACHE_H
+
+#include <cstdint>
+#include <vector>
+
+// Tracks the content most recently uploaded into the texture memory of each texture stage so that TestHost can skip
+// the conversion and copy when the same image is uploaded again with the same parameters.
+//
+// Entries are keyed on every parameter that affects the converted result and keep a copy of the source texels, which
+// must match byte for byte for an upload to be skipped. Anything that may write to texture memory other than the
+// uploads themselves must invalidate the affected entries.
+class TextureUploadCache {
+ public:
+  static constexpr uint32_t kNumStages = 4;
+  // Uploads with more source texels than this are not cached, to bound the memory used by the retained copies.
+  static constexpr uint32_t kMaxRetainedSize = 1024 * 1024;
+
+  enum UploadType {
+    UPLOAD_SURFACE,
+    UPLOAD_VOLUMETRIC,
+    UPLOAD_CUBEMAP,
+    UPLOAD_RAW,
+  };
+
+  struct Key {
+    UploadType type;
+    // The nv2a format the texels are converted into and the SDL format they are converted from (0 for raw uploads).
+    uint32_t xbox_format;
+    uint32_t source_format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t pitch;
+    uint32_t bytes_per_pixel;
+    bool swizzle;
+    // The number of levels generated and the filter used to generate them (1 and 0 for raw uploads).
+    uint32_t mipmap_levels;
+    uint32_t mipmap_filter;
+
+    bool operator==(const Key &other) const {
+      return type == other.type && xbox_format == other.xbox_format &&
+             source_format == other.source_format && width == other.width && height == other.height &&
+             depth == other.depth && pitch == other.pitch && bytes_per_pixel == other.bytes_per_pixel &&
+             swizzle == other.swizzle && mipmap_levels == other.mipmap_levels &&
+             mipmap_filter == other.mipmap_filter;
+    }
+  };
+
+  // `rows` rows of `row_size` source bytes, `pitch` bytes apart. Padding between rows is not compared.
+  struct SourceRows {
+    const uint8_t *data;
+    uint32_t row_size;
+    uint32_t rows;
+    uint32_t pitch;
+  };
+
+  // Returns true if the texture memory of `stage` already holds the upload described by `key` and the concatenation
+  // of the `num_sources` source blocks. A miss discards the entry of the stage, as the caller is expected to overwrite
+  // its memory.
+  bool Lookup(uint32_t stage, const Key &key, const SourceRows *sources, uint32_t num_sources = 1);
+
+  // Records that `key` and the given source texels have been uploaded into the texture memory of `stage`.
+  void Store(uint32_t stage, const Key &key, const SourceRows *sources, uint32_t num_sources = 1);
+
+  void Invalidate(uint32_t stage) { valid_[stage] = false; }
+  void InvalidateAll();
+
+  uint32_t GetHitCount() const { return hits_; }
+  uint32_t GetMissCount() const { return misses_; }
+  void ResetCounters() {
+    hits_ = 0;
+    misses_ = 0;
+  }
+
+ private:
+  Key entries_[kNumStages]{};
+  std::vector<uint8_t> texels_[kNumStages];
+  bool valid_[kNumStages]{};
+
+  uint32_t hits_{0};
+  uint32_t misses_{0};
+};
+
+#endif  // NXDK_PGRAPH_TESTS_TEXTURE_UPLOAD_CACHE_H
@@ -1,11 +1,16 @@
 #include "vertex_buffer.h"
 
-#include <xboxkrnl/xboxkrnl.h>
+#include <pbkit/pbkit.h>
 
+#include <cmath>
+#include <cstddef>
 #include <memory>
 
 #include "debug_output.h"
+#include "nxdk_ext.h"
 #include "pbkit_ext.h"
+#include "pushbuffer_recorder.h"
+#include "vertex_memory_pool.h"
 
 void Vertex::Translate(float x, float y, float z, float w) {
   pos[0] += x;
@@ -15,17 +20,21 @@ void Vertex::Translate(float x, float y, float z, float w) {
 }
 
 VertexBuffer::VertexBuffer(uint32_t num_vertices) : num_vertices_(num_vertices) {
-  uint32_t buffer_size = sizeof(Vertex) * num_vertices;
-  normalized_vertex_buffer_ = static_cast<Vertex *>(
-      MmAllocateContiguousMemoryEx(buffer_size, 0, MAXRAM, 0, PAGE_WRITECOMBINE | PAGE_READWRITE));
+  normalized_vertex_buffer_ = static_cast<Vertex *>(VertexMemoryPool::Allocate(sizeof(Vertex) * num_vertices));
+  ASSERT(normalized_vertex_buffer_ && "Failed to allocate vertex buffer.");
 }
 
 VertexBuffer::~VertexBuffer() {
-  if (linear_vertex_buffer_) {
-    MmFreeContiguousMemory(linear_vertex_buffer_);
+  FreeCompactVertices();
+  for (auto &linear : linear_texcoords_) {
+    if (linear.data) {
+      PushBufferRecorder::UntrackMemory(linear.data);
+      VertexMemoryPool::Free(linear.data, GetLinearTexCoordsSize());
+    }
   }
   if (normalized_vertex_buffer_) {
-    MmFreeContiguousMemory(normalized_vertex_buffer_);
+    PushBufferRecorder::UntrackMemory(normalized_vertex_buffer_);
+    VertexMemoryPool::Free(normalized_vertex_buffer_, sizeof(Vertex) * num_vertices_);
   }
 }
 
@@ -36,18 +45,65 @@ Vertex *VertexBuffer::Lock() {
 
 void VertexBuffer::Unlock() {}
 
-void VertexBuffer::Linearize(float texture_width, float texture_height) {
-  uint32_t buffer_size = sizeof(Vertex) * num_vertices_;
-  if (!linear_vertex_buffer_) {
-    linear_vertex_buffer_ = static_cast<Vertex *>(
-        MmAllocateContiguousMemoryEx(buffer_size, 0, MAXRAM, 0, PAGE_WRITECOMBINE | PAGE_READWRITE));
+void VertexBuffer::Linearize(uint32_t stage, float texture_width, float texture_height) {
+  ASSERT(stage < 4 && "Invalid texture stage.");
+  auto &linear = linear_texcoords_[stage];
+  if (!linear.data) {
+    linear.data = static_cast<float *>(VertexMemoryPool::Allocate(GetLinearTexCoordsSize()));
+    ASSERT(linear.data && "Failed to allocate linearized texture coordinates.");
+  } else if (linear.width == texture_width && linear.height == texture_height) {
+    return;
+  }
+
+  linear.width = texture_width;
+  linear.height = texture_height;
+  linear.valid = false;
+  cache_valid_ = false;
+}
+
+uint32_t VertexBuffer::GetTexCoordCount(uint32_t stage) const {
+  switch (stage) {
+    case 0:
+      return tex0_coord_count_;
+    case 1:
+      return tex1_coord_count_;
+    case 2:
+      return tex2_coord_count_;
+    default:
+      return tex3_coord_count_;
+  }
+}
+
+const float *VertexBuffer::GetLinearTexCoords(uint32_t stage) {
+  auto &linear = linear_texcoords_[stage];
+  const uint32_t count = GetTexCoordCount(stage);
+  if (!linear.data || (linear.valid && linear.count == count)) {
+    return linear.data;
   }
 
-  memcpy(linear_vertex_buffer_, normalized_vertex_buffer_, buffer_size);
+  // Only the texture coordinates are read from the vertices, the other attributes are fetched from the normalized
+  // buffer directly.
+  static constexpr uint32_t kTexCoordOffsets[] = {offsetof(Vertex, texcoord0), offsetof(Vertex, texcoord1),
+                                                  offsetof(Vertex, texcoord2), offsetof(Vertex, texcoord3)};
+  float *out = linear.data;
+  for (uint32_t i = 0; i < num_vertices_; ++i, out += count) {
+    float texcoord[4];
+    memcpy(texcoord, reinterpret_cast<const uint8_t *>(normalized_vertex_buffer_ + i) + kTexCoordOffsets[stage],
+           sizeof(texcoord));
+    texcoord[0] *= linear.width;
+    texcoord[1] *= linear.height;
+    memcpy(out, texcoord, count * sizeof(float));
+  }
 
-  for (int i = 0; i < num_vertices_; i++) {
-    linear_vertex_buffer_[i].texcoord0[0] *= static_cast<float>(texture_width);
-    linear_vertex_buffer_[i].texcoord0[1] *= static_cast<float>(texture_height);
+  linear.count = count;
+  linear.valid = true;
+  return linear.data;
+}
+
+void VertexBuffer::InvalidateDerivedVertices() {
+  compact_vertices_.valid = false;
+  for (auto &linear : linear_texcoords_) {
+    linear.valid = false;
   }
 }
 
@@ -263,38 +319,6 @@ void VertexBuffer::SetSpecular(uint32_t vertex_index, const Color &color) {
   normalized_vertex_buffer_[vertex_index].specular[3] = color.a;
 }
 
-std::shared_ptr<VertexBuffer> VertexBuffer::ConvertFromTriangleStripToTriangles() const {
-  auto num_triangles = num_vertices_ - 2;
-  auto ret = std::make_shared<VertexBuffer>(num_triangles * 3);
-
-  auto src = normalized_vertex_buffer_;
-  auto dst = ret->normalized_vertex_buffer_;
-
-  memcpy(dst, src, sizeof(*dst) * 3);
-  dst += 3;
-  src += 2;
-
-  auto copy_triangle = [&src, &dst](bool is_odd) {
-    if (is_odd) {
-      memcpy(dst++, src, sizeof(*dst));
-      memcpy(dst++, src - 1, sizeof(*dst));
-      ++src;
-      memcpy(dst++, src, sizeof(*dst));
-    } else {
-      memcpy(dst++, src - 1, sizeof(*dst));
-      memcpy(dst++, src, sizeof(*dst));
-      ++src;
-      memcpy(dst++, src, sizeof(*dst));
-    }
-  };
-
-  for (auto i = 1; i < num_triangles; ++i) {
-    copy_triangle(i & 0x01);
-  }
-
-  return ret;
-}
-
 void VertexBuffer::Translate(float x, float y, float z, float w) {
   auto vertex = Lock();
   for (auto i = 0; i < num_vertices_; ++i, ++vertex) {
@@ -302,3 +326,175 @@ void VertexBuffer::Translate(float x, float y, float z, float w) {
   }
   Unlock();
 }
+
+// Converts a color channel in [0, 1] to an unsigned byte.
+static uint32_t ToUnsignedByte(float value) {
+  value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+  return static_cast<uint32_t>(value * 255.0f + 0.5f);
+}
+
+// Converts a value in [-1, 1] to a signed normalized integer with `bits` bits.
+static uint32_t ToSignedNormalized(float value, uint32_t bits) {
+  value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+  const auto max = static_cast<float>((1 << (bits - 1)) - 1);
+  return static_cast<uint32_t>(static_cast<int32_t>(lrintf(value * max))) & ((1 << bits) - 1);
+}
+
+static uint32_t ToD3DColor(const float *rgba) {
+  return (ToUnsignedByte(rgba[3]) << 24) | (ToUnsignedByte(rgba[0]) << 16) | (ToUnsignedByte(rgba[1]) << 8) |
+         ToUnsignedByte(rgba[2]);
+}
+
+void VertexBuffer::SetCompactLayout(uint32_t fields, uint32_t flags) {
+  ASSERT(fields && !(fields & ~kCompactLayoutFields) && "Unsupported attribute in compact layout.");
+  FreeCompactVertices();
+  compact_fields_ = fields;
+  compact_flags_ = flags;
+  cache_valid_ = false;
+}
+
+void VertexBuffer::ClearCompactLayout() {
+  FreeCompactVertices();
+  compact_fields_ = 0;
+  compact_flags_ = 0;
+  cache_valid_ = false;
+}
+
+void VertexBuffer::FreeCompactVertices() {
+  if (compact_vertices_.data) {
+    PushBufferRecorder::UntrackMemory(compact_vertices_.data);
+    VertexMemoryPool::Free(compact_vertices_.data, compact_vertices_.capacity);
+  }
+  compact_vertices_ = CompactVertices();
+}
+
+const VertexBuffer::CompactVertices &VertexBuffer::GetCompactVertices() {
+  ASSERT(HasCompactLayout() && "Vertex buffer does not have a compact layout.");
+  if (!compact_vertices_.valid) {
+    BuildCompactVertices();
+  }
+  return compact_vertices_;
+}
+
+void VertexBuffer::BuildCompactVertices() {
+  const Vertex *source = normalized_vertex_buffer_;
+  CompactVertices &dest = compact_vertices_;
+  struct Field {
+    uint32_t index;
+    uint32_t offset;  // Within Vertex.
+    uint32_t count;
+  };
+  const Field fields[] = {
+      {NV2A_VERTEX_ATTR_POSITION, offsetof(Vertex, pos), position_count_},
+      {NV2A_VERTEX_ATTR_WEIGHT, offsetof(Vertex, weight), 1},
+      {NV2A_VERTEX_ATTR_NORMAL, offsetof(Vertex, normal), 3},
+      {NV2A_VERTEX_ATTR_DIFFUSE, offsetof(Vertex, diffuse), 4},
+      {NV2A_VERTEX_ATTR_SPECULAR, offsetof(Vertex, specular), 4},
+      {NV2A_VERTEX_ATTR_FOG_COORD, offsetof(Vertex, fog_coord), 1},
+      {NV2A_VERTEX_ATTR_POINT_SIZE, offsetof(Vertex, point_size), 1},
+      {NV2A_VERTEX_ATTR_TEXTURE0, offsetof(Vertex, texcoord0), tex0_coord_count_},
+      {NV2A_VERTEX_ATTR_TEXTURE1, offsetof(Vertex, texcoord1), tex1_coord_count_},
+      {NV2A_VERTEX_ATTR_TEXTURE2, offsetof(Vertex, texcoord2), tex2_coord_count_},
+      {NV2A_VERTEX_ATTR_TEXTURE3, offsetof(Vertex, texcoord3), tex3_coord_count_},
+  };
+
+  auto field_values = [source](const Field &field, uint32_t vertex) {
+    return reinterpret_cast<const float *>(reinterpret_cast<const uint8_t *>(source + vertex) + field.offset);
+  };
+
+  // Attributes are packed in index order so that the vertices can also be sent as inline arrays.
+  uint32_t offset = 0;
+  uint32_t max_stride = 0;
+  for (auto &field : fields) {
+    auto &attribute = dest.attributes[field.index];
+    attribute = {};
+    if (!(compact_fields_ & (1 << field.index))) {
+      continue;
+    }
+
+    attribute.format = NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_F;
+    attribute.size = field.count;
+    attribute.bytes = field.count * sizeof(float);
+    max_stride += attribute.bytes;
+
+    if (field.index == NV2A_VERTEX_ATTR_NORMAL && (compact_flags_ & COMPACT_PACKED_NORMALS)) {
+      attribute.format = NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_CMP;
+      attribute.size = 1;
+      attribute.bytes = 4;
+    } else if ((field.index == NV2A_VERTEX_ATTR_DIFFUSE || field.index == NV2A_VERTEX_ATTR_SPECULAR) &&
+               (compact_flags_ & COMPACT_D3DCOLOR)) {
+      attribute.format = NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_UB_D3D;
+      attribute.bytes = 4;
+    } else if (field.index >= NV2A_VERTEX_ATTR_TEXTURE0 && (compact_flags_ & COMPACT_NORMALIZED_TEXCOORDS)) {
+      bool normalized = true;
+      for (uint32_t i = 0; i < num_vertices_ && normalized; ++i) {
+        auto values = field_values(field, i);
+        for (uint32_t component = 0; component < field.count; ++component) {
+          normalized = normalized && values[component] >= -1.0f && values[component] <= 1.0f;
+        }
+      }
+      if (normalized) {
+        attribute.format = NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_S1;
+        attribute.bytes = (field.count * sizeof(int16_t) + 3) & ~3;
+      }
+    }
+
+    attribute.offset = offset;
+    offset += attribute.bytes;
+  }
+  dest.stride = offset;
+
+  // Storage is sized for the largest possible encoding so that it is only reallocated if a component count grows.
+  const uint32_t required_capacity = max_stride * num_vertices_;
+  if (required_capacity > dest.capacity) {
+    if (dest.data) {
+      PushBufferRecorder::UntrackMemory(dest.data);
+      VertexMemoryPool::Free(dest.data, dest.capacity);
+    }
+    dest.capacity = required_capacity;
+    dest.data = static_cast<uint8_t *>(VertexMemoryPool::Allocate(dest.capacity));
+    ASSERT(dest.data && "Failed to allocate compact vertex buffer.");
+  }
+
+  // Each vertex is assembled in cached memory and then written in one pass to the write-combined buffer.
+  uint32_t packed[sizeof(Vertex) / sizeof(uint32_t)];
+  uint8_t *out = dest.data;
+  for (uint32_t i = 0; i < num_vertices_; ++i, out += dest.stride) {
+    for (auto &field : fields) {
+      const auto &attribute = dest.attributes[field.index];
+      if (!attribute.size) {
+        continue;
+      }
+
+      auto values = field_values(field, i);
+      auto target = reinterpret_cast<uint8_t *>(packed) + attribute.offset;
+      switch (attribute.format) {
+        case NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_CMP: {
+          const uint32_t normal = ToSignedNormalized(values[0], 11) | (ToSignedNormalized(values[1], 11) << 11) |
+                                  (ToSignedNormalized(values[2], 10) << 22);
+          memcpy(target, &normal, sizeof(normal));
+        } break;
+
+        case NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_UB_D3D: {
+          const uint32_t color = ToD3DColor(values);
+          memcpy(target, &color, sizeof(color));
+        } break;
+
+        case NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_S1: {
+          memset(target, 0, attribute.bytes);
+          for (uint32_t component = 0; component < field.count; ++component) {
+            const auto value = static_cast<uint16_t>(ToSignedNormalized(values[component], 16));
+            memcpy(target + component * sizeof(value), &value, sizeof(value));
+          }
+        } break;
+
+        default:
+          memcpy(target, values, attribute.bytes);
+          break;
+      }
+    }
+    memcpy(out, packed, dest.stride);
+  }
+
+  dest.valid = true;
+}
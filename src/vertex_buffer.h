@@ -2,6 +2,7 @@
 #define NXDK_PGRAPH_TESTS__VERTEX_BUFFER_H_
 
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 #define TO_BGRA(float_vals)                                                                      \
@@ -197,14 +198,28 @@ struct Color {
 class TestHost;
 
 class VertexBuffer {
+ public:
+  // Encodings used by compact layouts (see SetCompactLayout).
+  enum CompactLayoutFlags {
+    // Diffuse and specular colors are stored as D3DCOLOR DWORDs.
+    COMPACT_D3DCOLOR = 1 << 0,
+    // Texture coordinates whose components are all within [-1, 1] are stored as normalized 16-bit values. Others
+    // remain floats. Linearized coordinates are never compacted.
+    COMPACT_NORMALIZED_TEXCOORDS = 1 << 1,
+    // Normals are stored as a single DWORD of signed 11:11:10 components.
+    COMPACT_PACKED_NORMALS = 1 << 2,
+
+    COMPACT_ALL = COMPACT_D3DCOLOR | COMPACT_NORMALIZED_TEXCOORDS | COMPACT_PACKED_NORMALS,
+  };
+
+  // Attributes that may be part of a compact layout, as TestHost::VertexAttribute bits: position, weight, normal,
+  // diffuse, specular, fog coordinate, point size and the four texture coordinates.
+  static constexpr uint32_t kCompactLayoutFields = 0x1E7F;
+
  public:
   explicit VertexBuffer(uint32_t num_vertices);
   ~VertexBuffer();
 
-  // Returns a new VertexBuffer containing vertices suitable for rendering as triangles by treating the contents of this
-  // buffer as a triangle strip.
-  std::shared_ptr<VertexBuffer> ConvertFromTriangleStripToTriangles() const;
-
   Vertex* Lock();
   void Unlock();
 
@@ -213,7 +228,12 @@ class VertexBuffer {
   void SetCacheValid(bool valid = true) { cache_valid_ = valid; }
   bool IsCacheValid() const { return cache_valid_; }
 
-  void Linearize(float texture_width, float texture_height);
+  // Scales texture coordinates 0 to texel units when stage 0 samples a linear texture.
+  void Linearize(float texture_width, float texture_height) { Linearize(0, texture_width, texture_height); }
+  // Scales the texture coordinates of `stage` to texel units when that stage samples a linear texture. The scaled
+  // coordinates are kept in a separate array that is only computed when drawn, and again only after the vertices or
+  // the dimensions change.
+  void Linearize(uint32_t stage, float texture_width, float texture_height);
 
   // Defines a triangle with the give 3-element vertices.
   void DefineTriangleCCW(uint32_t start_index, const float* one, const float* two, const float* three);
@@ -261,20 +281,85 @@ class VertexBuffer {
   void SetDiffuse(uint32_t vertex_index, const Color& color);
   void SetSpecular(uint32_t vertex_index, const Color& color);
 
-  inline void SetPositionIncludesW(bool enabled = true) { position_count_ = enabled ? 4 : 3; }
-  inline void SetTexCoord0Count(uint32_t val) { tex0_coord_count_ = val; }
-  inline void SetTexCoord1Count(uint32_t val) { tex1_coord_count_ = val; }
-  inline void SetTexCoord2Count(uint32_t val) { tex2_coord_count_ = val; }
-  inline void SetTexCoord3Count(uint32_t val) { tex3_coord_count_ = val; }
+  // Component counts determine the layout of derived vertex data, so changing them forces it to be rebuilt.
+  inline void SetPositionIncludesW(bool enabled = true) {
+    position_count_ = enabled ? 4 : 3;
+    cache_valid_ = false;
+  }
+  inline void SetTexCoord0Count(uint32_t val) {
+    tex0_coord_count_ = val;
+    cache_valid_ = false;
+  }
+  inline void SetTexCoord1Count(uint32_t val) {
+    tex1_coord_count_ = val;
+    cache_valid_ = false;
+  }
+  inline void SetTexCoord2Count(uint32_t val) {
+    tex2_coord_count_ = val;
+    cache_valid_ = false;
+  }
+  inline void SetTexCoord3Count(uint32_t val) {
+    tex3_coord_count_ = val;
+    cache_valid_ = false;
+  }
 
   void Translate(float x, float y, float z, float w = 0.0f);
 
+  // Causes array draws to fetch only the attributes in `fields` (TestHost::VertexAttribute bits), packed together in
+  // the encodings selected by `flags`, instead of complete Vertex structures. The compact vertices are rebuilt from
+  // the Vertex data whenever it changes. Attributes outside of `fields` may not be enabled for a draw.
+  void SetCompactLayout(uint32_t fields, uint32_t flags = COMPACT_ALL);
+  void ClearCompactLayout();
+  bool HasCompactLayout() const { return compact_fields_ != 0; }
+  uint32_t GetCompactLayoutFields() const { return compact_fields_; }
+
  private:
   friend class TestHost;
 
+  struct CompactAttribute {
+    uint32_t format;  // NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE_*
+    uint32_t size;    // Number of components, 0 if the attribute is not present.
+    uint32_t offset;  // From the start of the vertex.
+    uint32_t bytes;   // Including padding to a DWORD boundary.
+  };
+
+  // Vertex data encoded with a compact layout.
+  struct CompactVertices {
+    CompactAttribute attributes[16]{};  // Indexed by NV2A_VERTEX_ATTR_*.
+    uint32_t stride{0};
+    uint8_t* data{nullptr};
+    uint32_t capacity{0};  // Size of the allocation at `data`.
+    bool valid{false};
+  };
+
+  // Texture coordinates of a stage scaled to texel units.
+  struct LinearTexCoords {
+    float width{0.0f};
+    float height{0.0f};
+    float* data{nullptr};  // Holds up to 4 components per vertex.
+    uint32_t count{0};     // Number of components per vertex packed into `data`.
+    bool valid{false};
+  };
+
+  // Returns the compact form of the vertices, rebuilding it if the Vertex data has changed.
+  const CompactVertices& GetCompactVertices();
+  void BuildCompactVertices();
+  void FreeCompactVertices();
+
+  // Returns the texture coordinates of `stage` scaled to texel units, recomputing them if the Vertex data or the
+  // stage's texture coordinate count has changed, or nullptr if the stage has not been linearized.
+  const float* GetLinearTexCoords(uint32_t stage);
+  // Returns the number of components per vertex in the array returned by GetLinearTexCoords.
+  uint32_t GetLinearTexCoordCount(uint32_t stage) const { return linear_texcoords_[stage].count; }
+  uint32_t GetTexCoordCount(uint32_t stage) const;
+  uint32_t GetLinearTexCoordsSize() const { return num_vertices_ * 4 * sizeof(float); }
+
+  // Marks the data derived from the Vertex array as stale.
+  void InvalidateDerivedVertices();
+
   uint32_t num_vertices_;
-  Vertex* linear_vertex_buffer_ = nullptr;      // texcoords 0 to kFramebufferWidth/kFramebufferHeight
   Vertex* normalized_vertex_buffer_ = nullptr;  // texcoords normalized 0 to 1
+  LinearTexCoords linear_texcoords_[4];
 
   // Number of components in the vertex position (3 or 4).
   uint32_t position_count_ = 3;
@@ -286,6 +371,10 @@ class VertexBuffer {
   uint32_t tex3_coord_count_ = 2;
 
   bool cache_valid_{false};  // Indicates whether the HW should be forced to reload this buffer.
+
+  uint32_t compact_fields_{0};
+  uint32_t compact_flags_{0};
+  CompactVertices compact_vertices_;
 };
 
 #endif  // NXDK_PGRAPH_TESTS__VERTEX_BUFFER_H_
@@ -0,0 +1,112 @@
+#include "vertex_memory_pool.h"
+
+#ifdef NXDK
+#include <xboxkrnl/xboxkrnl.h>
+#else
+#include <cstdlib>
+#endif
+
+#include <vector>
+
+#ifdef NXDK
+#include "pbkit_ext.h"
+#endif
+
+static constexpr uint32_t kMinClassShift = 12;
+static constexpr uint32_t kNumClasses = 11;
+static_assert(VertexMemoryPool::kMinClassSize == 1 << kMinClassShift, "kMinClassShift does not match kMinClassSize.");
+static_assert(VertexMemoryPool::kMaxClassSize == VertexMemoryPool::kMinClassSize << (kNumClasses - 1),
+              "kNumClasses does not match kMaxClassSize.");
+
+static std::vector<void *> free_lists[kNumClasses];
+static VertexMemoryPool::Stats stats;
+
+static void *SystemAllocate(uint32_t size) {
+  ++stats.system_allocations;
+#ifdef NXDK
+  return MmAllocateContiguousMemoryEx(size, 0, MAXRAM, 0, PAGE_WRITECOMBINE | PAGE_READWRITE);
+#else
+  return aligned_alloc(VertexMemoryPool::kMinClassSize, size);
+#endif
+}
+
+static void SystemFree(void *block) {
+  ++stats.system_frees;
+#ifdef NXDK
+  MmFreeContiguousMemory(block);
+#else
+  free(block);
+#endif
+}
+
+// Returns the size class of a request, or kNumClasses if it is too large to be pooled.
+static uint32_t GetSizeClass(uint32_t size) {
+  uint32_t size_class = 0;
+  while (size_class < kNumClasses && (VertexMemoryPool::kMinClassSize << size_class) < size) {
+    ++size_class;
+  }
+  return size_class;
+}
+
+// Returns the number of bytes actually reserved for a request.
+static uint32_t GetBlockSize(uint32_t size) {
+  const uint32_t size_class = GetSizeClass(size);
+  if (size_class < kNumClasses) {
+    return VertexMemoryPool::kMinClassSize << size_class;
+  }
+  return (size + VertexMemoryPool::kMinClassSize - 1) & ~(VertexMemoryPool::kMinClassSize - 1);
+}
+
+void *VertexMemoryPool::Allocate(uint32_t size) {
+  ++stats.allocations;
+  const uint32_t size_class = GetSizeClass(size);
+  const uint32_t block_size = GetBlockSize(size);
+
+  void *block = nullptr;
+  if (size_class < kNumClasses && !free_lists[size_class].empty()) {
+    block = free_lists[size_class].back();
+    free_lists[size_class].pop_back();
+    stats.cached_size -= block_size;
+    ++stats.reused_allocations;
+  } else {
+    block = SystemAllocate(block_size);
+    if (!block) {
+      return nullptr;
+    }
+  }
+
+  stats.used_size += block_size;
+  const uint32_t reserved_size = stats.used_size + stats.cached_size;
+  if (reserved_size > stats.peak_reserved_size) {
+    stats.peak_reserved_size = reserved_size;
+  }
+  return block;
+}
+
+void VertexMemoryPool::Free(void *block, uint32_t size) {
+  if (!block) {
+    return;
+  }
+
+  const uint32_t size_class = GetSizeClass(size);
+  const uint32_t block_size = GetBlockSize(size);
+  stats.used_size -= block_size;
+
+  if (size_class < kNumClasses && stats.cached_size + block_size <= kMaxCachedSize) {
+    free_lists[size_class].push_back(block);
+    stats.cached_size += block_size;
+    return;
+  }
+
+  SystemFree(block);
+}
+
+const VertexMemoryPool::Stats &VertexMemoryPool::GetStats() { return stats; }
+
+void VertexMemoryPool::ResetCounters() {
+  stats.allocations = 0;
+  stats.reused_allocations = 0;
+  stats.system_allocations = 0;
+  stats.system_frees = 0;
+  stats.peak_reserved_size = stats.used_size + stats.cached_size;
+}
@@ -0,0 +1,48 @@
+#ifndef NXDK_PGRAPH_TESTS_VERTEX_MEMORY_POOL_H
+#define NXDK_PGRAPH_TESTS_VERTEX_MEMORY_POOL_H
+
+#include <cstdint>
+
+// Reuses blocks of contiguous, write-combined memory for vertex data.
+//
+// Requests are rounded up to a power of two size class between kMinClassSize and kMaxClassSize. Freed blocks are kept
+// on a free list for their class and handed out again by later requests of the same class instead of being returned
+// to the kernel, so suites that rebuild their geometry for every test do not repeatedly allocate contiguous pages and
+// fragment the physical address space. At most kMaxCachedSize bytes are held on the free lists. Requests larger than
+// kMaxClassSize are passed through to the kernel.
+//
+// When built for the host (NXDK is not defined) blocks are page aligned heap allocations, which allows
+// tools/vertex_pool_bench to exercise the pool.
+class VertexMemoryPool {
+ public:
+  static constexpr uint32_t kMinClassSize = 4096;
+  static constexpr uint32_t kMaxClassSize = 4 * 1024 * 1024;
+  static constexpr uint32_t kMaxCachedSize = 8 * 1024 * 1024;
+
+  struct Stats {
+    // Number of calls to Allocate() and how many of them were served from a free list.
+    uint32_t allocations{0};
+    uint32_t reused_allocations{0};
+    // Number of blocks obtained from and returned to the kernel.
+    uint32_t system_allocations{0};
+    uint32_t system_frees{0};
+
+    // Bytes in blocks handed out to callers, including the rounding up to the size class.
+    uint32_t used_size{0};
+    // Bytes in blocks held on the free lists.
+    uint32_t cached_size{0};
+    // Largest sum of used_size and cached_size.
+    uint32_t peak_reserved_size{0};
+  };
+
+  // Returns a block of at least `size` bytes, or nullptr if the kernel is out of contiguous memory.
+  static void *Allocate(uint32_t size);
+  // Releases a block returned by Allocate(). `size` must be the value passed to Allocate().
+  static void Free(void *block, uint32_t size);
+
+  static const Stats &GetStats();
+  // Resets the call counters and the peak, leaving the current sizes intact.
+  static void ResetCounters();
+};
+
+#endif  // NXDK_PGRAPH_TESTS_VERTEX_MEMORY_POOL_H
@@ -0,0 +1,156 @@
+// Compresses synthetic images with each DXT format and quality mode and reports the resulting error and the throughput
+// on a single thread and on every core.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "texture_compression.h"
+
+static constexpr uint32_t kWidth = 1024;
+static constexpr uint32_t kHeight = 1024;
+
+struct Image {
+  const char *name;
+  std::function<uint32_t(uint32_t x, uint32_t y)> texel;
+};
+
+static uint32_t Hash(uint32_t value) {
+  value ^= value >> 16;
+  value *= 0x7FEB352D;
+  value ^= value >> 15;
+  value *= 0x846CA68B;
+  return value ^ (value >> 16);
+}
+
+static const Image kImages[] = {
+    {"gradient",
+     [](uint32_t x, uint32_t y) {
+       return PackTexel(x * 255 / kWidth, y * 255 / kHeight, (x + y) * 255 / (kWidth + kHeight),
+                        255 - y * 255 / kHeight);
+     }},
+    {"smooth",
+     [](uint32_t x, uint32_t y) {
+       const float u = static_cast<float>(x) / 64.0f;
+       const float v = static_cast<float>(y) / 48.0f;
+       auto wave = [](float value) { return static_cast<uint8_t>(127.5f + 127.5f * std::sin(value)); };
+       return PackTexel(wave(u), wave(v + u * 0.5f), wave(u * 0.7f - v), wave(u + v));
+     }},
+    {"noise",
+     [](uint32_t x, uint32_t y) { return Hash(y * kWidth + x); }},
+    {"cutout",
+     [](uint32_t x, uint32_t y) {
+       const int32_t dx = static_cast<int32_t>(x % 64) - 32;
+       const int32_t dy = static_cast<int32_t>(y % 64) - 32;
+       const bool inside = dx * dx + dy * dy < 24 * 24;
+       return PackTexel(x * 255 / kWidth, 128, y * 255 / kHeight, inside ? 255 : 0);
+     }},
+};
+
+struct Format {
+  const char *name;
+  DXTFormat format;
+};
+
+static constexpr Format kFormats[] = {
+    {"DXT1", DXT_FORMAT_DXT1},
+    {"DXT3", DXT_FORMAT_DXT3},
+    {"DXT5", DXT_FORMAT_DXT5},
+};
+
+template <typename Function>
+static double TimeMillisecondsPerCall(Function &&function) {
+  // Repeat until enough time has passed to give a stable measurement.
+  uint32_t iterations = 0;
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::milli> elapsed{};
+  do {
+    function();
+    ++iterations;
+    elapsed = std::chrono::steady_clock::now() - start;
+  } while (elapsed.count() < 300.0);
+  return elapsed.count() / iterations;
+}
+
+static double PSNR(double squared_error, uint32_t samples) {
+  if (!squared_error) {
+    return INFINITY;
+  }
+  return 10.0 * std::log10(255.0 * 255.0 * samples / squared_error);
+}
+
+int main() {
+  const uint32_t cores = std::thread::hardware_concurrency();
+  printf("%-10s %-6s %-5s %10s %10s %12s %12s %8s\n", "image", "format", "mode", "RGB PSNR", "A PSNR", "1 thread",
+         "all threads", "scaling");
+
+  std::vector<uint32_t> texels(kWidth * kHeight);
+  std::vector<uint8_t> compressed(kWidth * kHeight);
+  const auto source = reinterpret_cast<const uint8_t *>(texels.data());
+
+  for (auto &image : kImages) {
+    for (uint32_t y = 0; y < kHeight; ++y) {
+      for (uint32_t x = 0; x < kWidth; ++x) {
+        texels[y * kWidth + x] = image.texel(x, y);
+      }
+    }
+
+    for (auto &format : kFormats) {
+      for (auto quality : {DXT_QUALITY_FAST, DXT_QUALITY_HIGH}) {
+        CompressDXTImage(source, kWidth, kHeight, kWidth * 4, kPackedTexelLayout, format.format, quality,
+                         compressed.data());
+
+        // DXT1 stores only whether each texel is transparent, so alpha is compared against that.
+        double rgb_error = 0.0;
+        double alpha_error = 0.0;
+        uint32_t samples = 0;
+        const uint32_t block_size = GetDXTBlockSize(format.format);
+        for (uint32_t block_y = 0; block_y < kHeight / 4; ++block_y) {
+          for (uint32_t block_x = 0; block_x < kWidth / 4; ++block_x) {
+            uint32_t decoded[16];
+            DecompressDXTBlock(compressed.data() + (block_y * (kWidth / 4) + block_x) * block_size, format.format,
+                               decoded);
+            for (uint32_t i = 0; i < 16; ++i) {
+              const uint32_t original = texels[(block_y * 4 + i / 4) * kWidth + block_x * 4 + i % 4];
+              uint32_t original_alpha = original >> 24;
+              if (format.format == DXT_FORMAT_DXT1) {
+                original_alpha = original_alpha < 128 ? 0 : 255;
+                if (!original_alpha) {
+                  // Transparent texels are always decoded as black.
+                  continue;
+                }
+              }
+              ++samples;
+              for (uint32_t shift = 0; shift < 24; shift += 8) {
+                const double difference =
+                    static_cast<double>((original >> shift) & 0xFF) - static_cast<double>((decoded[i] >> shift) & 0xFF);
+                rgb_error += difference * difference;
+              }
+              const double difference = static_cast<double>(original_alpha) - static_cast<double>(decoded[i] >> 24);
+              alpha_error += difference * difference;
+            }
+          }
+        }
+
+        const double single = TimeMillisecondsPerCall([&]() {
+          CompressDXTImage(source, kWidth, kHeight, kWidth * 4, kPackedTexelLayout, format.format, quality,
+                           compressed.data(), 1);
+        });
+        const double all = TimeMillisecondsPerCall([&]() {
+          CompressDXTImage(source, kWidth, kHeight, kWidth * 4, kPackedTexelLayout, format.format, quality,
+                           compressed.data(), cores);
+        });
+
+        printf("%-10s %-6s %-5s %8.2fdB %8.2fdB %10.2fms %10.2fms %7.1fx\n", image.name, format.name,
+               quality == DXT_QUALITY_FAST ? "fast" : "high", PSNR(rgb_error, samples * 3),
+               PSNR(alpha_error, samples), single, all, single / all);
+      }
+    }
+  }
+
+  return 0;
+}
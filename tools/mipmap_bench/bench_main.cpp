@@ -0,0 +1,211 @@
+// Checks the mipmap filters in texture_mipmap.cpp against straightforward per-channel implementations and compares
+// the cost of generating and converting a complete chain with the cost of converting the base level alone.
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "texture_conversion.h"
+#include "texture_mipmap.h"
+
+struct Image {
+  uint32_t width;
+  uint32_t height;
+  std::vector<uint32_t> texels;
+
+  uint32_t Channel(int32_t x, int32_t y, uint32_t channel) const {
+    x = x < 0 ? 0 : (x >= static_cast<int32_t>(width) ? width - 1 : x);
+    y = y < 0 ? 0 : (y >= static_cast<int32_t>(height) ? height - 1 : y);
+    return (texels[y * width + x] >> (channel * 8)) & 0xFF;
+  }
+};
+
+static uint32_t Hash(uint32_t value) {
+  value ^= value >> 16;
+  value *= 0x7FEB352D;
+  value ^= value >> 15;
+  value *= 0x846CA68B;
+  return value ^ (value >> 16);
+}
+
+static float ToLinear(uint32_t value) {
+  const float normalized = static_cast<float>(value) / 255.0f;
+  return normalized <= 0.04045f ? normalized / 12.92f : powf((normalized + 0.055f) / 1.055f, 2.4f);
+}
+
+static uint32_t ToSRGB(float linear) {
+  const float value = linear <= 0.0031308f ? linear * 12.92f : 1.055f * powf(linear, 1.0f / 2.4f) - 0.055f;
+  return static_cast<uint32_t>(value * 255.0f + 0.5f);
+}
+
+// Computes the next level one channel at a time. Gamma correct filtering is done in floating point, with alpha in the
+// top byte.
+static Image ReferenceMipmap(const Image &source, MipmapFilter filter) {
+  Image dest{GetMipmapDimension(source.width, 1), GetMipmapDimension(source.height, 1), {}};
+  dest.texels.resize(dest.width * dest.height);
+  static constexpr uint32_t kTentWeights[4] = {1, 3, 3, 1};
+  const int32_t right = source.width > 1 ? 1 : 0;
+
+  for (uint32_t y = 0; y < dest.height; ++y) {
+    for (uint32_t x = 0; x < dest.width; ++x) {
+      const int32_t left = static_cast<int32_t>(x * 2);
+      const int32_t top = static_cast<int32_t>(y * 2);
+      uint32_t texel = 0;
+      for (uint32_t channel = 0; channel < 4; ++channel) {
+        uint32_t value = 0;
+        if (filter == MIPMAP_FILTER_TENT) {
+          uint32_t sum = 0;
+          for (int32_t j = 0; j < 4; ++j) {
+            for (int32_t i = 0; i < 4; ++i) {
+              sum += kTentWeights[i] * kTentWeights[j] * source.Channel(left - 1 + i, top - 1 + j, channel);
+            }
+          }
+          value = (sum + 32) >> 6;
+        } else if (filter == MIPMAP_FILTER_GAMMA_CORRECT && channel != 3) {
+          const float sum = ToLinear(source.Channel(left, top, channel)) +
+                            ToLinear(source.Channel(left + right, top, channel)) +
+                            ToLinear(source.Channel(left, top + 1, channel)) +
+                            ToLinear(source.Channel(left + right, top + 1, channel));
+          value = ToSRGB(sum / 4.0f);
+        } else {
+          value = (source.Channel(left, top, channel) + source.Channel(left + right, top, channel) +
+                   source.Channel(left, top + 1, channel) + source.Channel(left + right, top + 1, channel) + 2) >>
+                  2;
+        }
+        texel |= value << (channel * 8);
+      }
+      dest.texels[y * dest.width + x] = texel;
+    }
+  }
+  return dest;
+}
+
+static Image Generate(const Image &source, MipmapFilter filter) {
+  Image dest{GetMipmapDimension(source.width, 1), GetMipmapDimension(source.height, 1), {}};
+  dest.texels.resize(dest.width * dest.height);
+  GenerateMipmap(reinterpret_cast<const uint8_t *>(source.texels.data()), source.width, source.height,
+                 source.width * 4, kPackedTexelLayout, filter, dest.texels.data());
+  return dest;
+}
+
+// Returns the largest difference between any channel of the two images.
+static uint32_t MaxDifference(const Image &a, const Image &b) {
+  uint32_t difference = 0;
+  for (uint32_t i = 0; i < a.texels.size(); ++i) {
+    for (uint32_t shift = 0; shift < 32; shift += 8) {
+      const int32_t delta =
+          static_cast<int32_t>((a.texels[i] >> shift) & 0xFF) - static_cast<int32_t>((b.texels[i] >> shift) & 0xFF);
+      const uint32_t magnitude = delta < 0 ? -delta : delta;
+      difference = magnitude > difference ? magnitude : difference;
+    }
+  }
+  return difference;
+}
+
+struct Filter {
+  const char *name;
+  MipmapFilter filter;
+  // Gamma correct filtering uses lookup tables of limited precision.
+  uint32_t tolerance;
+};
+
+static constexpr Filter kFilters[] = {
+    {"box", MIPMAP_FILTER_BOX, 0},
+    {"tent", MIPMAP_FILTER_TENT, 0},
+    {"gamma", MIPMAP_FILTER_GAMMA_CORRECT, 1},
+};
+
+template <typename Function>
+static double TimeMillisecondsPerCall(Function &&function) {
+  // Repeat until enough time has passed to give a stable measurement.
+  uint32_t iterations = 0;
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::milli> elapsed{};
+  do {
+    function();
+    ++iterations;
+    elapsed = std::chrono::steady_clock::now() - start;
+  } while (elapsed.count() < 200.0);
+  return elapsed.count() / iterations;
+}
+
+int main() {
+  printf("Filter implementation: %s\n", GetMipmapImplementation());
+
+  static constexpr uint32_t kSizes[][2] = {{256, 256}, {64, 16}, {255, 17}, {1, 64}, {64, 1}, {3, 3}, {1, 1}};
+  int failures = 0;
+  for (auto &filter : kFilters) {
+    for (auto &size : kSizes) {
+      Image level{size[0], size[1], {}};
+      level.texels.resize(size[0] * size[1]);
+      for (uint32_t i = 0; i < level.texels.size(); ++i) {
+        level.texels[i] = Hash(i + size[0] * 977);
+      }
+
+      // Each level is computed from the reference result for the previous one so that differences do not compound.
+      for (uint32_t index = 1; index < GetMaxMipmapLevels(size[0], size[1]); ++index) {
+        const Image expected = ReferenceMipmap(level, filter.filter);
+        const Image actual = Generate(level, filter.filter);
+        const uint32_t difference = MaxDifference(expected, actual);
+        if (difference > filter.tolerance) {
+          printf("%-6s %ux%u level %u differs by %u\n", filter.name, size[0], size[1], index, difference);
+          ++failures;
+          break;
+        }
+        level = expected;
+      }
+    }
+  }
+
+  // Flat images must be unchanged by every filter.
+  for (auto &filter : kFilters) {
+    for (uint32_t value = 0; value < 256; ++value) {
+      Image flat{8, 8, std::vector<uint32_t>(64, value * 0x01010101)};
+      const Image result = Generate(flat, filter.filter);
+      if (result.texels[0] != flat.texels[0]) {
+        printf("%-6s changes a flat image of 0x%02X\n", filter.name, value);
+        ++failures;
+        break;
+      }
+    }
+  }
+
+  // The cost of a complete 256x256 chain compared with converting the base level from ABGR8888 to A8R8G8B8.
+  static constexpr uint32_t kBaseSize = 256;
+  static constexpr PackedTexelFormat kA8R8G8B8{0, 16, 0, 8, 0, 0, 0, 24, 4};
+  std::vector<uint32_t> base(kBaseSize * kBaseSize);
+  for (uint32_t i = 0; i < base.size(); ++i) {
+    base[i] = Hash(i);
+  }
+  std::vector<uint32_t> chain(base.size());
+  std::vector<uint8_t> converted(base.size() * 4 * 2);
+
+  const double base_time = TimeMillisecondsPerCall(
+      [&]() { ConvertTexelsToPacked(base.data(), base.size(), kPackedTexelLayout, kA8R8G8B8, converted.data()); });
+  printf("\n%-6s %12s %12s %8s\n", "filter", "base level", "other levels", "ratio");
+  for (auto &filter : kFilters) {
+    const double chain_time = TimeMillisecondsPerCall([&]() {
+      const uint32_t *previous = base.data();
+      uint32_t *level = chain.data();
+      uint8_t *dest = converted.data() + base.size() * 4;
+      for (uint32_t size = kBaseSize; size > 1; size >>= 1) {
+        GenerateMipmap(reinterpret_cast<const uint8_t *>(previous), size, size, size * 4, kPackedTexelLayout,
+                       filter.filter, level);
+        const uint32_t texels = (size / 2) * (size / 2);
+        ConvertTexelsToPacked(level, texels, kPackedTexelLayout, kA8R8G8B8, dest);
+        previous = level;
+        level += texels;
+        dest += texels * 4;
+      }
+    });
+    printf("%-6s %10.3fms %10.3fms %7.2fx\n", filter.name, base_time, chain_time, chain_time / base_time);
+  }
+
+  if (failures) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,396 @@
+// Offline disassembler and statistics tool for push buffer traces produced by PushBufferRecorder.
+//
+// Usage: pbtrace_dis [-d] [-n top_methods] [-t test_filter] [-b subchannel=class] trace_file
+//   -d  Print a disassembly of every packet in addition to the statistics.
+//   -n  Number of methods to list per test, sorted by bytes pushed (default 10, 0 to list all).
+//   -t  Only process tests whose "<output_directory>/<name>" contains the given string.
+//   -b  Sets the object class (hex) initially bound to a subchannel, e.g., -b 2=62. May be repeated.
+//
+// Commands are attributed to the next test that completes (the next FinishDraw), so per-suite initialization is
+// charged to the first test of each suite.
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "nv2a_disassembler.h"
+#include "trace_reader.h"
+
+namespace {
+
+constexpr uint32_t kNumSubchannels = 8;
+
+struct MethodStats {
+  uint64_t writes{0};
+  uint64_t packets{0};
+  uint64_t bytes{0};
+};
+
+struct TestStats {
+  std::string name;
+  uint64_t packets{0};
+  uint64_t non_increasing_packets{0};
+  uint64_t control_flow_commands{0};
+  uint64_t bytes{0};
+  // Texture and vertex data captured alongside the commands.
+  uint64_t memory_bytes{0};
+  // Keyed by (object_class << 16) | method.
+  std::unordered_map<uint32_t, MethodStats> methods;
+
+  void Accumulate(const TestStats &other) {
+    packets += other.packets;
+    non_increasing_packets += other.non_increasing_packets;
+    control_flow_commands += other.control_flow_commands;
+    bytes += other.bytes;
+    memory_bytes += other.memory_bytes;
+    for (auto &entry : other.methods) {
+      auto &stats = methods[entry.first];
+      stats.writes += entry.second.writes;
+      stats.packets += entry.second.packets;
+      stats.bytes += entry.second.bytes;
+    }
+  }
+};
+
+// A test and the offset of the FinishDraw record that ends it.
+struct TestRange {
+  size_t end_offset;
+  std::string name;
+  bool selected;
+};
+
+struct Options {
+  bool disassemble{false};
+  uint32_t top_methods{10};
+  const char *test_filter{nullptr};
+  uint32_t subchannel_classes[kNumSubchannels]{kClassKelvin, 0, 0, kClassImageBlit, kClassSurfaces2DNV10, 0, 0, 0};
+};
+
+class TraceProcessor {
+ public:
+  TraceProcessor(const MappedPushBufferTrace &trace, const Options &options) : trace_(trace), options_(options) {
+    memcpy(subchannel_classes_, options.subchannel_classes, sizeof(subchannel_classes_));
+  }
+
+  void Run();
+
+ private:
+  void FindTests();
+  void ProcessCommands(const MappedPushBufferTrace::Record &record);
+  void ProcessParameter(size_t offset, uint32_t value);
+  void CompleteTest();
+  void PrintStats(const TestStats &stats) const;
+
+  bool IsSelected() const { return test_index_ >= tests_.size() || tests_[test_index_].selected; }
+
+ private:
+  const MappedPushBufferTrace &trace_;
+  const Options &options_;
+
+  std::vector<TestRange> tests_;
+  size_t test_index_{0};
+
+  uint32_t subchannel_classes_[kNumSubchannels];
+
+  // State of the packet currently being decoded, which may continue into the next command record.
+  uint32_t remaining_params_{0};
+  uint32_t packet_method_{0};
+  uint32_t packet_class_{0};
+  bool packet_non_increasing_{false};
+
+  TestStats current_;
+  TestStats total_;
+};
+
+void TraceProcessor::FindTests() {
+  size_t cursor = 0;
+  MappedPushBufferTrace::Record record{};
+  while (trace_.NextRecord(cursor, record)) {
+    if (record.type != kTraceRecordFinishDraw) {
+      continue;
+    }
+
+    // Payload is "<output_directory>\0<name>\0".
+    auto payload = reinterpret_cast<const char *>(record.payload);
+    std::string directory(payload, strnlen(payload, record.size));
+    std::string name;
+    if (directory.size() + 1 < record.size) {
+      auto name_start = payload + directory.size() + 1;
+      name.assign(name_start, strnlen(name_start, record.size - directory.size() - 1));
+    }
+
+    std::string full_name = directory + "/" + name;
+    bool selected = !options_.test_filter || full_name.find(options_.test_filter) != std::string::npos;
+    tests_.push_back({record.offset, full_name, selected});
+  }
+}
+
+void TraceProcessor::Run() {
+  FindTests();
+
+  size_t cursor = 0;
+  MappedPushBufferTrace::Record record{};
+  while (trace_.NextRecord(cursor, record)) {
+    switch (record.type) {
+      case kTraceRecordCommands:
+        ProcessCommands(record);
+        break;
+
+      case kTraceRecordPrepareDraw:
+        if (options_.disassemble && IsSelected()) {
+          printf("%08zx: ---- PrepareDraw\n", record.offset);
+        }
+        break;
+
+      case kTraceRecordFinishDraw:
+        if (options_.disassemble && IsSelected()) {
+          printf("%08zx: ---- FinishDraw %s\n\n", record.offset, tests_[test_index_].name.c_str());
+        }
+        CompleteTest();
+        break;
+
+      case kTraceRecordBindSubchannel: {
+        if (record.size < sizeof(PushBufferTraceBindSubchannel)) {
+          break;
+        }
+        uint32_t subchannel = ReadTraceDWORD(record.payload);
+        uint32_t object_class = ReadTraceDWORD(record.payload + 4);
+        if (subchannel < kNumSubchannels) {
+          subchannel_classes_[subchannel] = object_class;
+        }
+        if (options_.disassemble && IsSelected()) {
+          printf("%08zx: ---- BindSubchannel %u = NV%03X\n", record.offset, subchannel, object_class);
+        }
+      } break;
+
+      case kTraceRecordMemoryRegion: {
+        if (record.size < sizeof(PushBufferTraceMemoryRegion)) {
+          break;
+        }
+        static constexpr const char *kKindNames[] = {"texture", "palette", "vertex"};
+        uint32_t kind = ReadTraceDWORD(record.payload);
+        if (options_.disassemble && IsSelected()) {
+          printf("%08zx: ---- MemoryRegion %s 0x%08X size %u\n", record.offset, kind < 3 ? kKindNames[kind] : "unknown",
+                 ReadTraceDWORD(record.payload + 4), ReadTraceDWORD(record.payload + 8));
+        }
+      } break;
+
+      case kTraceRecordMemoryData:
+        if (record.size < sizeof(PushBufferTraceMemoryData)) {
+          break;
+        }
+        current_.memory_bytes += record.size - sizeof(PushBufferTraceMemoryData);
+        if (options_.disassemble && IsSelected()) {
+          printf("%08zx: ---- MemoryData 0x%08X size %zu\n", record.offset, ReadTraceDWORD(record.payload),
+                 record.size - sizeof(PushBufferTraceMemoryData));
+        }
+        break;
+
+      default:
+        // Unknown records are skipped so that older tools can read newer traces.
+        break;
+    }
+  }
+
+  if (current_.packets || current_.memory_bytes) {
+    current_.name = "(commands after the last test)";
+    PrintStats(current_);
+    total_.Accumulate(current_);
+  }
+
+  total_.name = "Total";
+  PrintStats(total_);
+}
+
+void TraceProcessor::ProcessCommands(const MappedPushBufferTrace::Record &record) {
+  const size_t num_dwords = record.size / 4;
+  const size_t base_offset = record.offset + sizeof(PushBufferTraceRecordHeader);
+  const bool print = options_.disassemble && IsSelected();
+
+  for (size_t i = 0; i < num_dwords; ++i) {
+    const size_t offset = base_offset + i * 4;
+    const uint32_t value = ReadTraceDWORD(record.payload + i * 4);
+
+    if (remaining_params_) {
+      ProcessParameter(offset, value);
+      continue;
+    }
+
+    // Control flow commands are emitted by pbkit itself but are decoded for completeness.
+    if (TraceCommandIsControlFlow(value)) {
+      ++current_.control_flow_commands;
+      current_.bytes += 4;
+      if (print) {
+        const char *type = value == 0x00020000 ? "RETURN" : ((value & 0x03) == 0x02 ? "CALL" : "JUMP");
+        printf("%08zx: %08X  %s 0x%08X\n", offset, value, type, value & 0x1FFFFFFC);
+      }
+      continue;
+    }
+
+    const uint32_t subchannel = TraceCommandSubchannel(value);
+    packet_method_ = TraceCommandMethod(value);
+    packet_class_ = subchannel_classes_[subchannel];
+    packet_non_increasing_ = TraceCommandIsNonIncreasing(value);
+    remaining_params_ = TraceCommandCount(value);
+
+    auto &test = current_;
+    ++test.packets;
+    test.bytes += 4;
+    if (packet_non_increasing_) {
+      ++test.non_increasing_packets;
+    }
+    auto &method_stats = test.methods[(packet_class_ << 16) | packet_method_];
+    ++method_stats.packets;
+    method_stats.bytes += 4;
+
+    if (print) {
+      printf("%08zx: %08X  subch %u %s%s x%u\n", offset, value, subchannel,
+             GetNV2AMethodName(packet_class_, packet_method_).c_str(),
+             packet_non_increasing_ ? " (non-increasing)" : "", remaining_params_);
+    }
+  }
+}
+
+void TraceProcessor::ProcessParameter(size_t offset, uint32_t value) {
+  auto &method_stats = current_.methods[(packet_class_ << 16) | packet_method_];
+  ++method_stats.writes;
+  method_stats.bytes += 4;
+  current_.bytes += 4;
+
+  if (options_.disassemble && IsSelected()) {
+    std::string description = DescribeNV2AParameter(packet_class_, packet_method_, value);
+    printf("%08zx: %08X    %s%s%s\n", offset, value, GetNV2AMethodName(packet_class_, packet_method_).c_str(),
+           description.empty() ? "" : " = ", description.c_str());
+  }
+
+  --remaining_params_;
+  if (!packet_non_increasing_) {
+    packet_method_ += 4;
+  }
+}
+
+void TraceProcessor::CompleteTest() {
+  if (test_index_ < tests_.size()) {
+    if (tests_[test_index_].selected) {
+      current_.name = tests_[test_index_].name;
+      PrintStats(current_);
+      total_.Accumulate(current_);
+    }
+    ++test_index_;
+  }
+  current_ = TestStats();
+}
+
+void TraceProcessor::PrintStats(const TestStats &stats) const {
+  // Fold array elements and multi-DWORD parameters into their base method.
+  struct NamedStats {
+    std::string name;
+    MethodStats stats;
+  };
+  std::map<std::string, MethodStats> by_name;
+  for (auto &entry : stats.methods) {
+    uint32_t object_class = entry.first >> 16;
+    uint32_t method = entry.first & 0xFFFF;
+    uint32_t element;
+    uint32_t component;
+    auto info = LookupNV2AMethod(object_class, method, element, component);
+    auto &named = by_name[info ? info->name : GetNV2AMethodName(object_class, method)];
+    named.writes += entry.second.writes;
+    named.packets += entry.second.packets;
+    named.bytes += entry.second.bytes;
+  }
+
+  std::vector<NamedStats> sorted;
+  sorted.reserve(by_name.size());
+  for (auto &entry : by_name) {
+    sorted.push_back({entry.first, entry.second});
+  }
+  std::sort(sorted.begin(), sorted.end(),
+            [](const NamedStats &a, const NamedStats &b) { return a.stats.bytes > b.stats.bytes; });
+
+  printf("%s: %" PRIu64 " bytes, %" PRIu64 " packets (%" PRIu64 " non-increasing), %zu methods", stats.name.c_str(),
+         stats.bytes, stats.packets, stats.non_increasing_packets, sorted.size());
+  if (stats.control_flow_commands) {
+    printf(", %" PRIu64 " jumps/calls", stats.control_flow_commands);
+  }
+  if (stats.memory_bytes) {
+    printf(", %" PRIu64 " bytes of memory data", stats.memory_bytes);
+  }
+  printf("\n");
+
+  size_t count = options_.top_methods ? std::min<size_t>(options_.top_methods, sorted.size()) : sorted.size();
+  if (!count) {
+    return;
+  }
+
+  printf("  %12s %12s %10s  %s\n", "bytes", "writes", "packets", "method");
+  for (size_t i = 0; i < count; ++i) {
+    auto &entry = sorted[i];
+    printf("  %12" PRIu64 " %12" PRIu64 " %10" PRIu64 "  %s\n", entry.stats.bytes, entry.stats.writes,
+           entry.stats.packets, entry.name.c_str());
+  }
+  printf("\n");
+}
+
+void PrintUsage(const char *program) {
+  fprintf(stderr, "Usage: %s [-d] [-n top_methods] [-t test_filter] [-b subchannel=class] trace_file\n", program);
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "dn:t:b:h")) != -1) {
+    switch (opt) {
+      case 'd':
+        options.disassemble = true;
+        break;
+
+      case 'n':
+        options.top_methods = strtoul(optarg, nullptr, 0);
+        break;
+
+      case 't':
+        options.test_filter = optarg;
+        break;
+
+      case 'b': {
+        char *separator = strchr(optarg, '=');
+        uint32_t subchannel = strtoul(optarg, nullptr, 0);
+        if (!separator || subchannel >= kNumSubchannels) {
+          PrintUsage(argv[0]);
+          return 1;
+        }
+        options.subchannel_classes[subchannel] = strtoul(separator + 1, nullptr, 16);
+      } break;
+
+      default:
+        PrintUsage(argv[0]);
+        return 1;
+    }
+  }
+
+  if (optind != argc - 1) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  MappedPushBufferTrace trace;
+  if (!trace.Open(argv[optind])) {
+    return 1;
+  }
+
+  TraceProcessor processor(trace, options);
+  processor.Run();
+  return 0;
+}
@@ -0,0 +1,33 @@
+#ifndef NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_HOST_PBKIT_H
+#define NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_HOST_PBKIT_H
+
+// Host stand-in for the subset of pbkit needed to build push buffer producing code on Linux. Commands are written to
+// a RAM backed push buffer and never submitted to hardware.
+
+#include <pbkit/nv_objects.h>
+#include <pbkit/nv_regs.h>
+
+#include <cstdint>
+
+#include "windows.h"
+
+#define SUBCH_3D 0
+
+// Note: Function names are parenthesized so that these declarations are unaffected by pushbuffer_recorder_hooks.h.
+uint32_t *(pb_begin)(void);
+void (pb_end)(uint32_t *p);
+
+void pb_push_to(DWORD subchannel, uint32_t *p, DWORD command, DWORD nparam);
+void pb_push(uint32_t *p, DWORD command, DWORD nparam);
+uint32_t *pb_push1(uint32_t *p, DWORD command, DWORD param1);
+uint32_t *pb_push2(uint32_t *p, DWORD command, DWORD param1, DWORD param2);
+uint32_t *pb_push3(uint32_t *p, DWORD command, DWORD param1, DWORD param2, DWORD param3);
+uint32_t *pb_push4(uint32_t *p, DWORD command, DWORD param1, DWORD param2, DWORD param3, DWORD param4);
+uint32_t *pb_push4f(uint32_t *p, DWORD command, float param1, float param2, float param3, float param4);
+
+int pb_busy(void);
+int pb_finished(void);
+void pb_reset(void);
+void pb_wait_for_vbl(void);
+
+#endif  // NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_HOST_PBKIT_H
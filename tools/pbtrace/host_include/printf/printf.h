@@ -0,0 +1,10 @@
+#ifndef NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_HOST_PRINTF_H
+#define NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_HOST_PRINTF_H
+
+// The host C library provides the functionality of third_party/printf.
+
+#include <cstdio>
+
+#define snprintf_ snprintf
+
+#endif  // NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_HOST_PRINTF_H
@@ -0,0 +1,13 @@
+#ifndef NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_HOST_WINDOWS_H
+#define NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_HOST_WINDOWS_H
+
+// Host stand-in for the Xbox types and kernel functions referenced by the shared sources.
+
+#include <cstdint>
+
+typedef uint32_t DWORD;
+
+extern "C" unsigned long DbgPrint(const char *format, ...);
+void Sleep(DWORD milliseconds);
+
+#endif  // NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_HOST_WINDOWS_H
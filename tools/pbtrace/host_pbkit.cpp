@@ -0,0 +1,94 @@
+#include <pbkit/pbkit.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "debug_output.h"
+
+// Matches the default push buffer size used by pbkit.
+static constexpr uint32_t kPushBufferDWORDs = 512 * 1024 / 4;
+// Spans may begin anywhere before this point, leaving room for the largest span written by the tests.
+static constexpr uint32_t kPushBufferWrapDWORDs = kPushBufferDWORDs - 16 * 1024;
+
+static uint32_t push_buffer[kPushBufferDWORDs];
+static uint32_t *put = push_buffer;
+
+uint32_t *(pb_begin)(void) { return put; }
+
+void (pb_end)(uint32_t *p) {
+  ASSERT(p >= put && p < push_buffer + kPushBufferDWORDs && "Push buffer overrun.");
+  put = p;
+  if (put >= push_buffer + kPushBufferWrapDWORDs) {
+    put = push_buffer;
+  }
+}
+
+void pb_push_to(DWORD subchannel, uint32_t *p, DWORD command, DWORD nparam) {
+  *p = (nparam << 18) | (subchannel << 13) | command;
+}
+
+void pb_push(uint32_t *p, DWORD command, DWORD nparam) { pb_push_to(SUBCH_3D, p, command, nparam); }
+
+uint32_t *pb_push1(uint32_t *p, DWORD command, DWORD param1) {
+  pb_push_to(SUBCH_3D, p, command, 1);
+  p[1] = param1;
+  return p + 2;
+}
+
+uint32_t *pb_push2(uint32_t *p, DWORD command, DWORD param1, DWORD param2) {
+  pb_push_to(SUBCH_3D, p, command, 2);
+  p[1] = param1;
+  p[2] = param2;
+  return p + 3;
+}
+
+uint32_t *pb_push3(uint32_t *p, DWORD command, DWORD param1, DWORD param2, DWORD param3) {
+  pb_push_to(SUBCH_3D, p, command, 3);
+  p[1] = param1;
+  p[2] = param2;
+  p[3] = param3;
+  return p + 4;
+}
+
+uint32_t *pb_push4(uint32_t *p, DWORD command, DWORD param1, DWORD param2, DWORD param3, DWORD param4) {
+  pb_push_to(SUBCH_3D, p, command, 4);
+  p[1] = param1;
+  p[2] = param2;
+  p[3] = param3;
+  p[4] = param4;
+  return p + 5;
+}
+
+uint32_t *pb_push4f(uint32_t *p, DWORD command, float param1, float param2, float param3, float param4) {
+  pb_push_to(SUBCH_3D, p, command, 4);
+  memcpy(p + 1, &param1, 4);
+  memcpy(p + 2, &param2, 4);
+  memcpy(p + 3, &param3, 4);
+  memcpy(p + 4, &param4, 4);
+  return p + 5;
+}
+
+int pb_busy(void) { return 0; }
+
+int pb_finished(void) { return 0; }
+
+void pb_reset(void) { put = push_buffer; }
+
+void pb_wait_for_vbl(void) {}
+
+extern "C" unsigned long DbgPrint(const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+  vfprintf(stderr, format, args);
+  va_end(args);
+  return 0;
+}
+
+void Sleep(DWORD milliseconds) {}
+
+void PrintAssertAndWaitForever(const char *assert_code, const char *filename, uint32_t line) {
+  fprintf(stderr, "ASSERT FAILED: '%s' at %s:%d\n", assert_code, filename, line);
+  abort();
+}
@@ -0,0 +1,710 @@
+#include "nv2a_disassembler.h"
+
+#include <pbkit/pbkit.h>
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "nxdk_ext.h"
+
+namespace {
+
+struct EnumName {
+  uint32_t value;
+  const char *name;
+};
+
+#define ENUM_NAME(prefix, suffix) \
+  { prefix##suffix, #suffix }
+
+template <size_t N>
+const char *LookupName(const EnumName (&names)[N], uint32_t value) {
+  for (auto &entry : names) {
+    if (entry.value == value) {
+      return entry.name;
+    }
+  }
+  return nullptr;
+}
+
+// Extracts the field described by `mask`, mirroring the MASK()/SET_MASK() macros used to build the values.
+uint32_t GetField(uint32_t value, uint32_t mask) {
+  if (!mask) {
+    return 0;
+  }
+  return (value & mask) >> __builtin_ctz(mask);
+}
+
+void AppendField(std::string &out, const char *label, uint32_t value) {
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%s%s=%u", out.empty() ? "" : " ", label, value);
+  out += buf;
+}
+
+void AppendField(std::string &out, const char *label, const char *value_name, uint32_t value) {
+  if (!value_name) {
+    AppendField(out, label, value);
+    return;
+  }
+  if (!out.empty()) {
+    out += " ";
+  }
+  out += label;
+  out += "=";
+  out += value_name;
+}
+
+void AppendFlag(std::string &out, const char *label, bool enabled) {
+  if (!enabled) {
+    return;
+  }
+  if (!out.empty()) {
+    out += " ";
+  }
+  out += label;
+}
+
+// clang-format off
+constexpr EnumName kSurfaceColorFormats[] = {
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_COLOR_LE_, X1R5G5B5_Z1R5G5B5),
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_COLOR_LE_, X1R5G5B5_O1R5G5B5),
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_COLOR_LE_, R5G6B5),
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_COLOR_LE_, X8R8G8B8_Z8R8G8B8),
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_COLOR_LE_, X8R8G8B8_O8R8G8B8),
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_COLOR_LE_, X1A7R8G8B8_Z1A7R8G8B8),
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_COLOR_LE_, X1A7R8G8B8_O1A7R8G8B8),
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_COLOR_LE_, A8R8G8B8),
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_COLOR_LE_, B8),
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_COLOR_LE_, G8B8),
+};
+
+constexpr EnumName kSurfaceZetaFormats[] = {
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_ZETA_, Z16),
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_ZETA_, Z24S8),
+};
+
+constexpr EnumName kSurfaceTypes[] = {
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_TYPE_, PITCH),
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_TYPE_, SWIZZLE),
+};
+
+constexpr EnumName kSurfaceAntiAliasing[] = {
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_ANTI_ALIASING_, CENTER_1),
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_ANTI_ALIASING_, CENTER_CORNER_2),
+    ENUM_NAME(NV097_SET_SURFACE_FORMAT_ANTI_ALIASING_, SQUARE_OFFSET_4),
+};
+
+constexpr EnumName kTextureColorFormats[] = {
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_Y8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_AY8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_A1R5G5B5),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_X1R5G5B5),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_A4R4G4B4),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_R5G6B5),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_A8R8G8B8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_X8R8G8B8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_I8_A8R8G8B8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, L_DXT1_A1R5G5B5),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, L_DXT23_A8R8G8B8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, L_DXT45_A8R8G8B8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_A1R5G5B5),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_R5G6B5),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_A8R8G8B8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_Y8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_A8Y8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_AY8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_X1R5G5B5),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_A4R4G4B4),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_X8R8G8B8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_R8B8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_G8B8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_R8B8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_G8B8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LC_IMAGE_CR8YB8CB8YA8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LC_IMAGE_YB8CR8YA8CB8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_DEPTH_Y16_FIXED),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_DEPTH_X8_Y24_FIXED),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_DEPTH_Y16_FIXED),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_DEPTH_Y16_FLOAT),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_Y16),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_A8B8G8R8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_B8G8R8A8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, SZ_R8G8B8A8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_A8B8G8R8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_B8G8R8A8),
+    ENUM_NAME(NV097_SET_TEXTURE_FORMAT_COLOR_, LU_IMAGE_R8G8B8A8),
+};
+
+constexpr EnumName kPrimitives[] = {
+    ENUM_NAME(NV097_SET_BEGIN_END_OP_, END),
+    ENUM_NAME(NV097_SET_BEGIN_END_OP_, POINTS),
+    ENUM_NAME(NV097_SET_BEGIN_END_OP_, LINES),
+    ENUM_NAME(NV097_SET_BEGIN_END_OP_, LINE_LOOP),
+    ENUM_NAME(NV097_SET_BEGIN_END_OP_, LINE_STRIP),
+    ENUM_NAME(NV097_SET_BEGIN_END_OP_, TRIANGLES),
+    ENUM_NAME(NV097_SET_BEGIN_END_OP_, TRIANGLE_STRIP),
+    ENUM_NAME(NV097_SET_BEGIN_END_OP_, TRIANGLE_FAN),
+    ENUM_NAME(NV097_SET_BEGIN_END_OP_, QUADS),
+    ENUM_NAME(NV097_SET_BEGIN_END_OP_, QUAD_STRIP),
+    ENUM_NAME(NV097_SET_BEGIN_END_OP_, POLYGON),
+};
+// clang-format on
+
+// See TestHost::CombinerSource.
+constexpr const char *kCombinerRegisters[] = {
+    "ZERO", "C0", "C1", "FOG", "DIFFUSE", "SPECULAR", "6", "7", "TEX0", "TEX1", "TEX2", "TEX3", "R0", "R1",
+    "SPEC_R0_SUM", "EF_PROD",
+};
+
+// See TestHost::CombinerMapping.
+constexpr const char *kCombinerMappings[] = {
+    "UNSIGNED_IDENTITY", "UNSIGNED_INVERT", "EXPAND_NORMAL",   "EXPAND_NEGATE",
+    "HALFBIAS_NORMAL",   "HALFBIAS_NEGATE", "SIGNED_IDENTITY", "SIGNED_NEGATE",
+};
+
+// See TestHost::CombinerOutOp.
+constexpr const char *kCombinerOutputOps[] = {
+    "IDENTITY", "BIAS", "SHIFT_LEFT_1", "SHIFT_LEFT_1_BIAS", "SHIFT_LEFT_2", "5", "SHIFT_RIGHT_1", "7",
+};
+
+void DecodeSurfaceFormat(uint32_t value, std::string &out) {
+  uint32_t color = GetField(value, NV097_SET_SURFACE_FORMAT_COLOR);
+  AppendField(out, "COLOR", LookupName(kSurfaceColorFormats, color), color);
+  uint32_t zeta = GetField(value, NV097_SET_SURFACE_FORMAT_ZETA);
+  AppendField(out, "ZETA", LookupName(kSurfaceZetaFormats, zeta), zeta);
+  uint32_t type = GetField(value, NV097_SET_SURFACE_FORMAT_TYPE);
+  AppendField(out, "TYPE", LookupName(kSurfaceTypes, type), type);
+  uint32_t aa = GetField(value, NV097_SET_SURFACE_FORMAT_ANTI_ALIASING);
+  AppendField(out, "AA", LookupName(kSurfaceAntiAliasing, aa), aa);
+  AppendField(out, "LOG_WIDTH", GetField(value, NV097_SET_SURFACE_FORMAT_WIDTH));
+  AppendField(out, "LOG_HEIGHT", GetField(value, NV097_SET_SURFACE_FORMAT_HEIGHT));
+}
+
+void DecodeSurfacePitch(uint32_t value, std::string &out) {
+  AppendField(out, "COLOR", GetField(value, NV097_SET_SURFACE_PITCH_COLOR));
+  AppendField(out, "ZETA", GetField(value, NV097_SET_SURFACE_PITCH_ZETA));
+}
+
+// Decodes the (origin | (size << 16)) layout used by the clip and clear rect methods.
+void DecodeRange(uint32_t value, std::string &out) {
+  AppendField(out, "START", value & 0xFFFF);
+  AppendField(out, "SIZE", value >> 16);
+}
+
+void DecodeClearRect(uint32_t value, std::string &out) {
+  AppendField(out, "START", value & 0xFFFF);
+  AppendField(out, "END", value >> 16);
+}
+
+void DecodeCombinerInputs(uint32_t value, bool alpha_combiner, bool final_combiner, std::string &out) {
+  static constexpr const char *kLabels[] = {"A", "B", "C", "D"};
+  for (uint32_t i = 0; i < 4; ++i) {
+    uint32_t channel = (value >> (24 - i * 8)) & 0xFF;
+    uint32_t source = channel & 0x0F;
+    bool alpha = channel & 0x10;
+    uint32_t mapping = channel >> 5;
+
+    char buf[96];
+    const char *swizzle = alpha ? ".a" : (alpha_combiner ? ".b" : ".rgb");
+    if (final_combiner) {
+      snprintf(buf, sizeof(buf), "%s%s=%s%s%s", out.empty() ? "" : " ", kLabels[i], mapping ? "1-" : "",
+               kCombinerRegisters[source], swizzle);
+    } else {
+      snprintf(buf, sizeof(buf), "%s%s=%s%s:%s", out.empty() ? "" : " ", kLabels[i], kCombinerRegisters[source],
+               swizzle, kCombinerMappings[mapping]);
+    }
+    out += buf;
+  }
+}
+
+void DecodeColorICW(uint32_t value, std::string &out) { DecodeCombinerInputs(value, false, false, out); }
+void DecodeAlphaICW(uint32_t value, std::string &out) { DecodeCombinerInputs(value, true, false, out); }
+void DecodeFinalCW0(uint32_t value, std::string &out) { DecodeCombinerInputs(value, false, true, out); }
+
+void DecodeFinalCW1(uint32_t value, std::string &out) {
+  static constexpr const char *kLabels[] = {"E", "F", "G"};
+  for (uint32_t i = 0; i < 3; ++i) {
+    uint32_t channel = (value >> (24 - i * 8)) & 0xFF;
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s%s=%s%s%s", out.empty() ? "" : " ", kLabels[i], (channel >> 5) ? "1-" : "",
+             kCombinerRegisters[channel & 0x0F], (channel & 0x10) ? ".a" : ".rgb");
+    out += buf;
+  }
+  AppendFlag(out, "SPECULAR_ADD_INVERT_R5", value & NV097_SET_COMBINER_SPECULAR_FOG_CW1_SPECULAR_ADD_INVERT_R5);
+  AppendFlag(out, "SPECULAR_ADD_INVERT_R12", value & NV097_SET_COMBINER_SPECULAR_FOG_CW1_SPECULAR_ADD_INVERT_R12);
+  AppendFlag(out, "SPECULAR_CLAMP", value & NV097_SET_COMBINER_SPECULAR_FOG_CW1_SPECULAR_CLAMP);
+}
+
+void DecodeCombinerOutputs(uint32_t value, bool color_combiner, std::string &out) {
+  AppendField(out, "AB", kCombinerRegisters[(value >> 4) & 0x0F], 0);
+  AppendField(out, "CD", kCombinerRegisters[value & 0x0F], 0);
+  AppendField(out, "SUM", kCombinerRegisters[(value >> 8) & 0x0F], 0);
+  AppendFlag(out, "CD_DOT", value & (1 << 12));
+  AppendFlag(out, "AB_DOT", value & (1 << 13));
+  AppendFlag(out, "MUX", value & (1 << 14));
+  AppendField(out, "OP", kCombinerOutputOps[(value >> 15) & 0x07], 0);
+  if (color_combiner) {
+    AppendFlag(out, "CD_BLUE_TO_ALPHA", value & (1 << 18));
+    AppendFlag(out, "AB_BLUE_TO_ALPHA", value & (1 << 19));
+  }
+}
+
+void DecodeColorOCW(uint32_t value, std::string &out) { DecodeCombinerOutputs(value, true, out); }
+void DecodeAlphaOCW(uint32_t value, std::string &out) { DecodeCombinerOutputs(value, false, out); }
+
+void DecodeCombinerControl(uint32_t value, std::string &out) {
+  AppendField(out, "ITERATION_COUNT", GetField(value, NV097_SET_COMBINER_CONTROL_ITERATION_COUNT));
+  AppendFlag(out, "FACTOR0_EACH_STAGE", GetField(value, NV097_SET_COMBINER_CONTROL_FACTOR0) ==
+                                            NV097_SET_COMBINER_CONTROL_FACTOR0_EACH_STAGE);
+  AppendFlag(out, "FACTOR1_EACH_STAGE", GetField(value, NV097_SET_COMBINER_CONTROL_FACTOR1) ==
+                                            NV097_SET_COMBINER_CONTROL_FACTOR1_EACH_STAGE);
+  AppendFlag(out, "MUX_SELECT_MSB",
+             GetField(value, NV097_SET_COMBINER_CONTROL_MUX_SELECT) == NV097_SET_COMBINER_CONTROL_MUX_SELECT_MSB);
+}
+
+void DecodeControl0(uint32_t value, std::string &out) {
+  uint32_t z_format = GetField(value, NV097_SET_CONTROL0_Z_FORMAT);
+  AppendField(out, "Z_FORMAT", z_format == NV097_SET_CONTROL0_Z_FORMAT_FLOAT ? "FLOAT" : "FIXED", z_format);
+  AppendFlag(out, "STENCIL_WRITE_ENABLE", value & NV097_SET_CONTROL0_STENCIL_WRITE_ENABLE);
+  AppendFlag(out, "COLOR_SPACE_CONVERT_CRYCB_TO_RGB", GetField(value, NV097_SET_CONTROL0_COLOR_SPACE_CONVERT) ==
+                                                          NV097_SET_CONTROL0_COLOR_SPACE_CONVERT_CRYCB_TO_RGB);
+}
+
+void DecodeTextureFormat(uint32_t value, std::string &out) {
+  AppendField(out, "CONTEXT_DMA", GetField(value, NV097_SET_TEXTURE_FORMAT_CONTEXT_DMA));
+  AppendFlag(out, "CUBEMAP", GetField(value, NV097_SET_TEXTURE_FORMAT_CUBEMAP_ENABLE));
+  AppendField(out, "BORDER_SOURCE", GetField(value, NV097_SET_TEXTURE_FORMAT_BORDER_SOURCE));
+  AppendField(out, "DIMENSIONALITY", GetField(value, NV097_SET_TEXTURE_FORMAT_DIMENSIONALITY));
+  uint32_t color = GetField(value, NV097_SET_TEXTURE_FORMAT_COLOR);
+  AppendField(out, "COLOR", LookupName(kTextureColorFormats, color), color);
+  AppendField(out, "MIPMAP_LEVELS", GetField(value, NV097_SET_TEXTURE_FORMAT_MIPMAP_LEVELS));
+  AppendField(out, "LOG_U", GetField(value, NV097_SET_TEXTURE_FORMAT_BASE_SIZE_U));
+  AppendField(out, "LOG_V", GetField(value, NV097_SET_TEXTURE_FORMAT_BASE_SIZE_V));
+  AppendField(out, "LOG_P", GetField(value, NV097_SET_TEXTURE_FORMAT_BASE_SIZE_P));
+}
+
+void DecodeTextureControl0(uint32_t value, std::string &out) {
+  AppendFlag(out, "ENABLE", value & NV097_SET_TEXTURE_CONTROL0_ENABLE);
+  AppendField(out, "MIN_LOD_CLAMP", GetField(value, NV097_SET_TEXTURE_CONTROL0_MIN_LOD_CLAMP));
+  AppendField(out, "MAX_LOD_CLAMP", GetField(value, NV097_SET_TEXTURE_CONTROL0_MAX_LOD_CLAMP));
+  AppendFlag(out, "ALPHA_KILL", value & NV097_SET_TEXTURE_CONTROL0_ALPHA_KILL_ENABLE);
+}
+
+void DecodeTextureControl1(uint32_t value, std::string &out) { AppendField(out, "PITCH", value >> 16); }
+
+void DecodeTextureAddress(uint32_t value, std::string &out) {
+  AppendField(out, "U", GetField(value, NV097_SET_TEXTURE_ADDRESS_U));
+  AppendField(out, "V", GetField(value, NV097_SET_TEXTURE_ADDRESS_V));
+  AppendField(out, "P", GetField(value, NV097_SET_TEXTURE_ADDRESS_P));
+  AppendFlag(out, "CYLINDERWRAP_U", GetField(value, NV097_SET_TEXTURE_ADDRESS_CYLINDERWRAP_U));
+  AppendFlag(out, "CYLINDERWRAP_V", GetField(value, NV097_SET_TEXTURE_ADDRESS_CYLINDERWRAP_V));
+  AppendFlag(out, "CYLINDERWRAP_P", GetField(value, NV097_SET_TEXTURE_ADDRESS_CYLINDERWRAP_P));
+  AppendFlag(out, "CYLINDERWRAP_Q", GetField(value, NV097_SET_TEXTURE_ADDRESS_CYLINDERWRAP_Q));
+}
+
+void DecodeTextureFilter(uint32_t value, std::string &out) {
+  AppendField(out, "LOD_BIAS", GetField(value, NV097_SET_TEXTURE_FILTER_MIPMAP_LOD_BIAS));
+  AppendField(out, "CONVOLUTION_KERNEL", GetField(value, NV097_SET_TEXTURE_FILTER_CONVOLUTION_KERNEL));
+  AppendField(out, "MIN", GetField(value, NV097_SET_TEXTURE_FILTER_MIN));
+  AppendField(out, "MAG", GetField(value, NV097_SET_TEXTURE_FILTER_MAG));
+  AppendFlag(out, "ASIGNED", value & NV097_SET_TEXTURE_FILTER_ASIGNED);
+  AppendFlag(out, "RSIGNED", value & NV097_SET_TEXTURE_FILTER_RSIGNED);
+  AppendFlag(out, "GSIGNED", value & NV097_SET_TEXTURE_FILTER_GSIGNED);
+  AppendFlag(out, "BSIGNED", value & NV097_SET_TEXTURE_FILTER_BSIGNED);
+}
+
+void DecodeTextureImageRect(uint32_t value, std::string &out) {
+  AppendField(out, "WIDTH", value >> 16);
+  AppendField(out, "HEIGHT", value & 0xFFFF);
+}
+
+void DecodeTexturePalette(uint32_t value, std::string &out) {
+  AppendField(out, "CONTEXT_DMA", GetField(value, NV097_SET_TEXTURE_PALETTE_CONTEXT_DMA));
+  AppendField(out, "LENGTH", GetField(value, NV097_SET_TEXTURE_PALETTE_LENGTH));
+  char buf[32];
+  snprintf(buf, sizeof(buf), " OFFSET=0x%08X", value & ~0x3F);
+  out += buf;
+}
+
+void DecodeVertexDataArrayFormat(uint32_t value, std::string &out) {
+  AppendField(out, "TYPE", GetField(value, NV097_SET_VERTEX_DATA_ARRAY_FORMAT_TYPE));
+  AppendField(out, "SIZE", GetField(value, NV097_SET_VERTEX_DATA_ARRAY_FORMAT_SIZE));
+  AppendField(out, "STRIDE", GetField(value, NV097_SET_VERTEX_DATA_ARRAY_FORMAT_STRIDE));
+}
+
+void DecodeBeginEnd(uint32_t value, std::string &out) { AppendField(out, "OP", LookupName(kPrimitives, value), value); }
+
+void DecodeDrawArrays(uint32_t value, std::string &out) {
+  AppendField(out, "START_INDEX", GetField(value, NV097_DRAW_ARRAYS_START_INDEX));
+  // The hardware field holds the count minus one.
+  AppendField(out, "COUNT", GetField(value, NV097_DRAW_ARRAYS_COUNT) + 1);
+}
+
+void DecodeArrayElement16(uint32_t value, std::string &out) {
+  AppendField(out, "INDEX0", value & 0xFFFF);
+  AppendField(out, "INDEX1", value >> 16);
+}
+
+void DecodeTransformExecutionMode(uint32_t value, std::string &out) {
+  uint32_t mode = GetField(value, NV097_SET_TRANSFORM_EXECUTION_MODE_MODE);
+  AppendField(out, "MODE", mode == NV097_SET_TRANSFORM_EXECUTION_MODE_MODE_PROGRAM ? "PROGRAM" : "FIXED", mode);
+  uint32_t range_mode = GetField(value, NV097_SET_TRANSFORM_EXECUTION_MODE_RANGE_MODE);
+  AppendField(out, "RANGE_MODE", range_mode == NV097_SET_TRANSFORM_EXECUTION_MODE_RANGE_MODE_PRIV ? "PRIV" : "USER",
+              range_mode);
+}
+
+void DecodeShaderStageProgram(uint32_t value, std::string &out) {
+  AppendField(out, "STAGE0", GetField(value, NV097_SET_SHADER_STAGE_PROGRAM_STAGE0));
+  AppendField(out, "STAGE1", GetField(value, NV097_SET_SHADER_STAGE_PROGRAM_STAGE1));
+  AppendField(out, "STAGE2", GetField(value, NV097_SET_SHADER_STAGE_PROGRAM_STAGE2));
+  AppendField(out, "STAGE3", GetField(value, NV097_SET_SHADER_STAGE_PROGRAM_STAGE3));
+}
+
+void DecodeShaderOtherStageInput(uint32_t value, std::string &out) {
+  AppendField(out, "STAGE1", GetField(value, NV097_SET_SHADER_OTHER_STAGE_INPUT_STAGE1));
+  AppendField(out, "STAGE2", GetField(value, NV097_SET_SHADER_OTHER_STAGE_INPUT_STAGE2));
+  AppendField(out, "STAGE3", GetField(value, NV097_SET_SHADER_OTHER_STAGE_INPUT_STAGE3));
+}
+
+void DecodePoint(uint32_t value, std::string &out) {
+  AppendField(out, "X", value & 0xFFFF);
+  AppendField(out, "Y", value >> 16);
+}
+
+void DecodeSize(uint32_t value, std::string &out) {
+  AppendField(out, "WIDTH", value & 0xFFFF);
+  AppendField(out, "HEIGHT", value >> 16);
+}
+
+void DecodePitch2D(uint32_t value, std::string &out) {
+  AppendField(out, "SOURCE", value & 0xFFFF);
+  AppendField(out, "DESTINATION", value >> 16);
+}
+
+#define METHOD(name, ...) \
+  { #name, name, __VA_ARGS__ }
+
+// Parameter formats: <num_dwords>, <num_elements>, <stride>, <is_float>, <decoder>
+constexpr NV2AMethodInfo kKelvinMethods[] = {
+    METHOD(NV097_NO_OPERATION, 1, 1, 0, false, nullptr),
+    METHOD(NV097_WAIT_FOR_IDLE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_CONTEXT_DMA_A, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_CONTEXT_DMA_COLOR, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_CONTEXT_DMA_ZETA, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_SURFACE_CLIP_HORIZONTAL, 1, 1, 0, false, DecodeRange),
+    METHOD(NV097_SET_SURFACE_CLIP_VERTICAL, 1, 1, 0, false, DecodeRange),
+    METHOD(NV097_SET_SURFACE_FORMAT, 1, 1, 0, false, DecodeSurfaceFormat),
+    METHOD(NV097_SET_SURFACE_PITCH, 1, 1, 0, false, DecodeSurfacePitch),
+    METHOD(NV097_SET_SURFACE_COLOR_OFFSET, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_SURFACE_ZETA_OFFSET, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_COMBINER_ALPHA_ICW, 1, 8, 4, false, DecodeAlphaICW),
+    METHOD(NV097_SET_COMBINER_SPECULAR_FOG_CW0, 1, 1, 0, false, DecodeFinalCW0),
+    METHOD(NV097_SET_COMBINER_SPECULAR_FOG_CW1, 1, 1, 0, false, DecodeFinalCW1),
+    METHOD(NV097_SET_WINDOW_CLIP_HORIZONTAL, 1, 8, 4, false, DecodeClearRect),
+    METHOD(NV097_SET_WINDOW_CLIP_VERTICAL, 1, 8, 4, false, DecodeClearRect),
+    METHOD(NV097_SET_CONTROL0, 1, 1, 0, false, DecodeControl0),
+    METHOD(NV097_SET_LIGHT_CONTROL, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_COLOR_MATERIAL, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_FOG_MODE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_FOG_GEN_MODE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_FOG_ENABLE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_FOG_COLOR, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_ALPHA_TEST_ENABLE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_BLEND_ENABLE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_CULL_FACE_ENABLE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_DEPTH_TEST_ENABLE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_LIGHTING_ENABLE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_POINT_PARAMS_ENABLE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_POINT_SMOOTH_ENABLE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_STENCIL_TEST_ENABLE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_BLEND_FUNC_SFACTOR, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_BLEND_FUNC_DFACTOR, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_BLEND_EQUATION, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_DEPTH_FUNC, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_COLOR_MASK, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_DEPTH_MASK, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_STENCIL_MASK, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_CLIP_MIN, 1, 1, 0, true, nullptr),
+    METHOD(NV097_SET_CLIP_MAX, 1, 1, 0, true, nullptr),
+    METHOD(NV097_SET_CULL_FACE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_FRONT_FACE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_NORMALIZATION_ENABLE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_MATERIAL_EMISSION, 3, 1, 0, true, nullptr),
+    METHOD(NV097_SET_MATERIAL_ALPHA, 1, 1, 0, true, nullptr),
+    METHOD(NV097_SET_SPECULAR_ENABLE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_LIGHT_ENABLE_MASK, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_TEXGEN_S, 1, 4, 16, false, nullptr),
+    METHOD(NV097_SET_TEXGEN_T, 1, 4, 16, false, nullptr),
+    METHOD(NV097_SET_TEXGEN_R, 1, 4, 16, false, nullptr),
+    METHOD(NV097_SET_TEXGEN_Q, 1, 4, 16, false, nullptr),
+    METHOD(NV097_SET_TEXTURE_MATRIX_ENABLE, 1, 4, 4, false, nullptr),
+    METHOD(NV097_SET_POINT_SIZE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_MODEL_VIEW_MATRIX, 16, 4, 64, true, nullptr),
+    METHOD(NV097_SET_INVERSE_MODEL_VIEW_MATRIX, 16, 4, 64, true, nullptr),
+    METHOD(NV097_SET_COMPOSITE_MATRIX, 16, 1, 0, true, nullptr),
+    METHOD(NV097_SET_TEXTURE_MATRIX, 16, 4, 64, true, nullptr),
+    METHOD(NV097_SET_FOG_PARAMS, 3, 1, 0, true, nullptr),
+    METHOD(NV097_SET_VIEWPORT_OFFSET, 4, 1, 0, true, nullptr),
+    METHOD(NV097_SET_VIEWPORT_SCALE, 4, 1, 0, true, nullptr),
+    METHOD(NV097_SET_EYE_VECTOR, 3, 1, 0, true, nullptr),
+    METHOD(NV097_SET_SCENE_AMBIENT_COLOR, 3, 1, 0, true, nullptr),
+    METHOD(NV097_SET_TRANSFORM_PROGRAM, 32, 1, 0, false, nullptr),
+    METHOD(NV097_SET_TRANSFORM_CONSTANT, 32, 1, 0, true, nullptr),
+    METHOD(NV097_SET_COMBINER_FACTOR0, 1, 8, 4, false, nullptr),
+    METHOD(NV097_SET_COMBINER_FACTOR1, 1, 8, 4, false, nullptr),
+    METHOD(NV097_SET_COMBINER_ALPHA_OCW, 1, 8, 4, false, DecodeAlphaOCW),
+    METHOD(NV097_SET_COMBINER_COLOR_ICW, 1, 8, 4, false, DecodeColorICW),
+    METHOD(NV097_SET_SPECULAR_PARAMS, 6, 1, 0, true, nullptr),
+    METHOD(NV097_SET_LIGHT_AMBIENT_COLOR, 3, 8, 128, true, nullptr),
+    METHOD(NV097_SET_LIGHT_DIFFUSE_COLOR, 3, 8, 128, true, nullptr),
+    METHOD(NV097_SET_LIGHT_SPECULAR_COLOR, 3, 8, 128, true, nullptr),
+    METHOD(NV097_SET_LIGHT_LOCAL_RANGE, 1, 8, 128, true, nullptr),
+    METHOD(NV097_SET_LIGHT_INFINITE_HALF_VECTOR, 3, 8, 128, true, nullptr),
+    METHOD(NV097_SET_LIGHT_INFINITE_DIRECTION, 3, 8, 128, true, nullptr),
+    METHOD(NV097_SET_VERTEX3F, 3, 1, 0, true, nullptr),
+    METHOD(NV097_SET_VERTEX4F, 4, 1, 0, true, nullptr),
+    METHOD(NV097_SET_NORMAL3F, 3, 1, 0, true, nullptr),
+    METHOD(NV097_SET_NORMAL3S, 2, 1, 0, false, nullptr),
+    METHOD(NV097_SET_DIFFUSE_COLOR4F, 4, 1, 0, true, nullptr),
+    METHOD(NV097_SET_DIFFUSE_COLOR3F, 3, 1, 0, true, nullptr),
+    METHOD(NV097_SET_DIFFUSE_COLOR4I, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_SPECULAR_COLOR4F, 4, 1, 0, true, nullptr),
+    METHOD(NV097_SET_SPECULAR_COLOR3F, 3, 1, 0, true, nullptr),
+    METHOD(NV097_SET_SPECULAR_COLOR4I, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_TEXCOORD0_2F, 2, 1, 0, true, nullptr),
+    METHOD(NV097_SET_TEXCOORD0_2S, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_TEXCOORD0_4F, 4, 1, 0, true, nullptr),
+    METHOD(NV097_SET_TEXCOORD0_4S, 2, 1, 0, false, nullptr),
+    METHOD(NV097_SET_TEXCOORD1_2F, 2, 1, 0, true, nullptr),
+    METHOD(NV097_SET_TEXCOORD1_2S, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_TEXCOORD1_4F, 4, 1, 0, true, nullptr),
+    METHOD(NV097_SET_TEXCOORD1_4S, 2, 1, 0, false, nullptr),
+    METHOD(NV097_SET_TEXCOORD2_2F, 2, 1, 0, true, nullptr),
+    METHOD(NV097_SET_TEXCOORD2_2S, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_TEXCOORD2_4F, 4, 1, 0, true, nullptr),
+    METHOD(NV097_SET_TEXCOORD2_4S, 2, 1, 0, false, nullptr),
+    METHOD(NV097_SET_TEXCOORD3_2F, 2, 1, 0, true, nullptr),
+    METHOD(NV097_SET_TEXCOORD3_2S, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_TEXCOORD3_4F, 4, 1, 0, true, nullptr),
+    METHOD(NV097_SET_TEXCOORD3_4S, 2, 1, 0, false, nullptr),
+    METHOD(NV097_SET_FOG_COORD, 1, 1, 0, true, nullptr),
+    METHOD(NV097_SET_WEIGHT1F, 1, 1, 0, true, nullptr),
+    METHOD(NV097_SET_WEIGHT4F, 4, 1, 0, true, nullptr),
+    METHOD(NV097_SET_VERTEX_DATA_ARRAY_OFFSET, 1, 16, 4, false, nullptr),
+    METHOD(NV097_SET_VERTEX_DATA_ARRAY_FORMAT, 1, 16, 4, false, DecodeVertexDataArrayFormat),
+    METHOD(NV097_SET_BEGIN_END, 1, 1, 0, false, DecodeBeginEnd),
+    METHOD(NV097_ARRAY_ELEMENT16, 1, 1, 0, false, DecodeArrayElement16),
+    METHOD(NV097_ARRAY_ELEMENT32, 1, 1, 0, false, nullptr),
+    METHOD(NV097_BREAK_VERTEX_BUFFER_CACHE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_DRAW_ARRAYS, 1, 1, 0, false, DecodeDrawArrays),
+    METHOD(NV097_INLINE_ARRAY, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_VERTEX_DATA2F_M, 2, 16, 8, true, nullptr),
+    METHOD(NV097_SET_VERTEX_DATA4F_M, 4, 16, 16, true, nullptr),
+    METHOD(NV097_SET_VERTEX_DATA2S, 1, 16, 4, false, nullptr),
+    METHOD(NV097_SET_VERTEX_DATA4UB, 1, 16, 4, false, nullptr),
+    METHOD(NV097_SET_VERTEX_DATA4S_M, 2, 16, 8, false, nullptr),
+    METHOD(NV097_SET_TEXTURE_OFFSET, 1, 4, 64, false, nullptr),
+    METHOD(NV097_SET_TEXTURE_FORMAT, 1, 4, 64, false, DecodeTextureFormat),
+    METHOD(NV097_SET_TEXTURE_ADDRESS, 1, 4, 64, false, DecodeTextureAddress),
+    METHOD(NV097_SET_TEXTURE_CONTROL0, 1, 4, 64, false, DecodeTextureControl0),
+    METHOD(NV097_SET_TEXTURE_CONTROL1, 1, 4, 64, false, DecodeTextureControl1),
+    METHOD(NV097_SET_TEXTURE_FILTER, 1, 4, 64, false, DecodeTextureFilter),
+    METHOD(NV097_SET_TEXTURE_IMAGE_RECT, 1, 4, 64, false, DecodeTextureImageRect),
+    METHOD(NV097_SET_TEXTURE_PALETTE, 1, 4, 64, false, DecodeTexturePalette),
+    METHOD(NV097_SET_TEXTURE_BORDER_COLOR, 1, 4, 64, false, nullptr),
+    METHOD(NV097_SET_TEXTURE_SET_BUMP_ENV_MAT, 4, 4, 64, true, nullptr),
+    METHOD(NV097_SET_TEXTURE_SET_BUMP_ENV_SCALE, 1, 4, 64, true, nullptr),
+    METHOD(NV097_SET_TEXTURE_SET_BUMP_ENV_OFFSET, 1, 4, 64, true, nullptr),
+    METHOD(NV097_SET_SHADOW_COMPARE_FUNC, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_COLOR_CLEAR_VALUE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_ZSTENCIL_CLEAR_VALUE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_CLEAR_RECT_HORIZONTAL, 1, 1, 0, false, DecodeClearRect),
+    METHOD(NV097_SET_CLEAR_RECT_VERTICAL, 1, 1, 0, false, DecodeClearRect),
+    METHOD(NV097_CLEAR_SURFACE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_SHADER_STAGE_PROGRAM, 1, 1, 0, false, DecodeShaderStageProgram),
+    METHOD(NV097_SET_SHADER_OTHER_STAGE_INPUT, 1, 1, 0, false, DecodeShaderOtherStageInput),
+    METHOD(NV097_SET_TRANSFORM_EXECUTION_MODE, 1, 1, 0, false, DecodeTransformExecutionMode),
+    METHOD(NV097_SET_TRANSFORM_PROGRAM_CXT_WRITE_EN, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_TRANSFORM_PROGRAM_LOAD, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_TRANSFORM_PROGRAM_START, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_TRANSFORM_CONSTANT_LOAD, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_COMBINER_COLOR_OCW, 1, 8, 4, false, DecodeColorOCW),
+    METHOD(NV097_SET_COMBINER_CONTROL, 1, 1, 0, false, DecodeCombinerControl),
+    METHOD(NV097_SET_SPECULAR_FOG_FACTOR, 1, 2, 4, false, nullptr),
+    METHOD(NV097_SET_COMPRESS_ZBUFFER_EN, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_FRONT_POLYGON_MODE, 1, 1, 0, false, nullptr),
+    METHOD(NV097_SET_BACK_POLYGON_MODE, 1, 1, 0, false, nullptr),
+    METHOD(NV20_TCL_PRIMITIVE_3D_LIGHT_MODEL_TWO_SIDE_ENABLE, 1, 1, 0, false, nullptr),
+    // Software methods used by pbkit_ext to patch DMA objects.
+    METHOD(NV20_TCL_PRIMITIVE_3D_WAIT_MAKESPACE, 1, 1, 0, false, nullptr),
+    METHOD(NV20_TCL_PRIMITIVE_3D_PARAMETER_A, 2, 1, 0, false, nullptr),
+    METHOD(NV20_TCL_PRIMITIVE_3D_FIRE_INTERRUPT, 1, 1, 0, false, nullptr),
+};
+
+constexpr NV2AMethodInfo kClipRectangleMethods[] = {
+    METHOD(NV01_CONTEXT_CLIP_RECTANGLE_SET_POINT, 1, 1, 0, false, DecodePoint),
+    METHOD(NV01_CONTEXT_CLIP_RECTANGLE_SET_SIZE, 1, 1, 0, false, DecodeSize),
+};
+
+constexpr NV2AMethodInfo kBetaMethods[] = {
+    METHOD(NV012_SET_BETA, 1, 1, 0, false, nullptr),
+};
+
+constexpr NV2AMethodInfo kBeta4Methods[] = {
+    METHOD(NV072_SET_BETA, 1, 1, 0, false, nullptr),
+};
+
+constexpr NV2AMethodInfo kSurfaces2DMethods[] = {
+    METHOD(NV04_CONTEXT_SURFACES_2D_SET_DMA_IMAGE_DST, 1, 1, 0, false, nullptr),
+    METHOD(NV042_SET_COLOR_FORMAT, 1, 1, 0, false, nullptr),
+    METHOD(NV042_SET_PITCH, 1, 1, 0, false, DecodePitch2D),
+};
+
+constexpr NV2AMethodInfo kSolidLineMethods[] = {
+    METHOD(NV04_SOLID_LINE_SURFACE, 1, 1, 0, false, nullptr),
+    METHOD(NV04_SOLID_LINE_OPERATION, 1, 1, 0, false, nullptr),
+    METHOD(NV04_SOLID_LINE_COLOR_FORMAT, 1, 1, 0, false, nullptr),
+    METHOD(NV04_SOLID_LINE_COLOR_VALUE, 1, 1, 0, false, nullptr),
+    METHOD(NV04_SOLID_LINE_START, 1, 1, 0, false, DecodePoint),
+    METHOD(NV04_SOLID_LINE_END, 1, 1, 0, false, DecodePoint),
+};
+
+constexpr NV2AMethodInfo kSurfaces2DNV10Methods[] = {
+    METHOD(NV10_CONTEXT_SURFACES_2D_SET_DMA_IN_MEMORY0, 1, 1, 0, false, nullptr),
+    METHOD(NV10_CONTEXT_SURFACES_2D_SET_DMA_IN_MEMORY1, 1, 1, 0, false, nullptr),
+    METHOD(NV062_SET_COLOR_FORMAT, 1, 1, 0, false, nullptr),
+    METHOD(NV062_SET_PITCH, 1, 1, 0, false, DecodePitch2D),
+    METHOD(NV062_SET_OFFSET_SOURCE, 1, 1, 0, false, nullptr),
+    METHOD(NV062_SET_OFFSET_DESTIN, 1, 1, 0, false, nullptr),
+};
+
+constexpr NV2AMethodInfo kImageBlitMethods[] = {
+    METHOD(NV_IMAGE_BLIT_COLOR_KEY, 1, 1, 0, false, nullptr),
+    METHOD(NV_IMAGE_BLIT_CLIP_RECTANGLE, 1, 1, 0, false, nullptr),
+    METHOD(NV_IMAGE_BLIT_PATTERN, 1, 1, 0, false, nullptr),
+    METHOD(NV_IMAGE_BLIT_ROP5, 1, 1, 0, false, nullptr),
+    METHOD(NV_IMAGE_BLIT_SET_BETA, 1, 1, 0, false, nullptr),
+    METHOD(NV_IMAGE_BLIT_SET_BETA4, 1, 1, 0, false, nullptr),
+    METHOD(NV_IMAGE_BLIT_OPERATION, 1, 1, 0, false, nullptr),
+    METHOD(NV09F_CONTROL_POINT_IN, 1, 1, 0, false, DecodePoint),
+    METHOD(NV09F_CONTROL_POINT_OUT, 1, 1, 0, false, DecodePoint),
+    METHOD(NV09F_SIZE, 1, 1, 0, false, DecodeSize),
+};
+
+#undef METHOD
+
+// Method 0 binds an object to the subchannel for every class.
+constexpr NV2AMethodInfo kSetObject{"SET_OBJECT", NV20_TCL_PRIMITIVE_SET_MAIN_OBJECT, 1, 1, 0, false, nullptr};
+
+// Methods are 4 byte aligned within the 0x2000 byte method space of each subchannel.
+static constexpr uint32_t kNumMethodSlots = 0x2000 / 4;
+
+// Maps every method slot of a class to the entry that covers it so lookups are constant time.
+class MethodMap {
+ public:
+  template <size_t N>
+  explicit MethodMap(const NV2AMethodInfo (&methods)[N]) : slots_(kNumMethodSlots, nullptr) {
+    Add(&kSetObject);
+    for (auto &info : methods) {
+      Add(&info);
+    }
+  }
+
+  const NV2AMethodInfo *Lookup(uint32_t method) const {
+    if (method >= 0x2000) {
+      return nullptr;
+    }
+    return slots_[method >> 2];
+  }
+
+ private:
+  void Add(const NV2AMethodInfo *info) {
+    for (uint32_t element = 0; element < info->num_elements; ++element) {
+      for (uint32_t i = 0; i < info->num_dwords; ++i) {
+        uint32_t slot = (info->method + element * info->stride + i * 4) >> 2;
+        if (slot < kNumMethodSlots && !slots_[slot]) {
+          slots_[slot] = info;
+        }
+      }
+    }
+  }
+
+  std::vector<const NV2AMethodInfo *> slots_;
+};
+
+const MethodMap *GetMethodMap(uint32_t object_class) {
+  static const std::map<uint32_t, MethodMap> maps = {
+      {kClassKelvin, MethodMap(kKelvinMethods)},
+      {kClassClipRectangle, MethodMap(kClipRectangleMethods)},
+      {kClassBeta, MethodMap(kBetaMethods)},
+      {kClassBeta4, MethodMap(kBeta4Methods)},
+      {kClassSurfaces2D, MethodMap(kSurfaces2DMethods)},
+      {kClassSolidLine, MethodMap(kSolidLineMethods)},
+      {kClassSurfaces2DNV10, MethodMap(kSurfaces2DNV10Methods)},
+      {kClassImageBlit, MethodMap(kImageBlitMethods)},
+  };
+
+  auto it = maps.find(object_class);
+  return it == maps.end() ? nullptr : &it->second;
+}
+
+}  // namespace
+
+const NV2AMethodInfo *LookupNV2AMethod(uint32_t object_class, uint32_t method, uint32_t &element, uint32_t &component) {
+  auto map = GetMethodMap(object_class);
+  const NV2AMethodInfo *info = map ? map->Lookup(method) : nullptr;
+  if (!info && method == NV20_TCL_PRIMITIVE_SET_MAIN_OBJECT) {
+    info = &kSetObject;
+  }
+  if (!info) {
+    return nullptr;
+  }
+
+  uint32_t offset = method - info->method;
+  element = info->stride ? offset / info->stride : 0;
+  component = (info->stride ? offset % info->stride : offset) / 4;
+  return info;
+}
+
+std::string GetNV2AMethodName(uint32_t object_class, uint32_t method) {
+  char buf[128];
+  uint32_t element;
+  uint32_t component;
+  auto info = LookupNV2AMethod(object_class, method, element, component);
+  if (!info) {
+    snprintf(buf, sizeof(buf), "NV%03X_UNKNOWN_%04X", object_class, method);
+    return buf;
+  }
+
+  std::string ret = info->name;
+  if (info->num_elements > 1) {
+    snprintf(buf, sizeof(buf), "[%u]", element);
+    ret += buf;
+  }
+  if (component) {
+    snprintf(buf, sizeof(buf), "+%u", component);
+    ret += buf;
+  }
+  return ret;
+}
+
+std::string DescribeNV2AParameter(uint32_t object_class, uint32_t method, uint32_t value) {
+  char buf[64];
+  uint32_t element;
+  uint32_t component;
+  auto info = LookupNV2AMethod(object_class, method, element, component);
+  if (info && info->is_float) {
+    float float_value;
+    memcpy(&float_value, &value, sizeof(float_value));
+    snprintf(buf, sizeof(buf), "%g", float_value);
+    return buf;
+  }
+
+  std::string decoded;
+  if (info && info->decode) {
+    info->decode(value, decoded);
+  }
+  return decoded;
+}
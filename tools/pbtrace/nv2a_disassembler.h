@@ -0,0 +1,44 @@
+#ifndef NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_NV2A_DISASSEMBLER_H
+#define NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_NV2A_DISASSEMBLER_H
+
+#include <cstdint>
+#include <string>
+
+// Graphics object classes that the test harness binds to subchannels.
+static constexpr uint32_t kClassClipRectangle = 0x19;
+static constexpr uint32_t kClassBeta = 0x12;
+static constexpr uint32_t kClassSurfaces2D = 0x42;
+static constexpr uint32_t kClassSolidLine = 0x5C;
+static constexpr uint32_t kClassSurfaces2DNV10 = 0x62;
+static constexpr uint32_t kClassBeta4 = 0x72;
+static constexpr uint32_t kClassKelvin = 0x97;
+static constexpr uint32_t kClassImageBlit = 0x9F;
+
+// Describes a method, or an array of identically structured methods, of a graphics object class.
+struct NV2AMethodInfo {
+  typedef void (*Decoder)(uint32_t value, std::string &out);
+
+  const char *name;
+  uint32_t method;
+  // Number of parameter DWORDs in each element.
+  uint32_t num_dwords;
+  // Number of elements in the array (1 for scalar methods) and the distance in bytes between them.
+  uint32_t num_elements;
+  uint32_t stride;
+  // Parameters are displayed as floats rather than hexadecimal.
+  bool is_float;
+  // Optional bitfield decoder.
+  Decoder decode;
+};
+
+// Returns the description of `method` in `object_class`, or nullptr if it is unknown. `element` is set to the array
+// index and `component` to the index of the parameter DWORD within the element.
+const NV2AMethodInfo *LookupNV2AMethod(uint32_t object_class, uint32_t method, uint32_t &element, uint32_t &component);
+
+// Returns a human readable name for `method`, e.g. "NV097_SET_COMBINER_COLOR_ICW[3]" or "NV097_SET_VERTEX4F+2".
+std::string GetNV2AMethodName(uint32_t object_class, uint32_t method);
+
+// Returns a human readable description of a parameter written to `method`.
+std::string DescribeNV2AParameter(uint32_t object_class, uint32_t method, uint32_t value);
+
+#endif  // NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_NV2A_DISASSEMBLER_H
@@ -0,0 +1,68 @@
+// Host driver for the push buffer recorder.
+//
+// Runs push buffer producing code against the RAM backed pbkit in host_pbkit.cpp and writes the resulting trace, which
+// allows the recorder and downstream trace tools to be exercised without Xbox hardware. Additional host portable
+// sources may be linked in via the HOST_SRCS variable in the Makefile and invoked from RecordTests().
+
+#include <pbkit/pbkit.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "pushbuffer_recorder.h"
+#include "shadow_register_file.h"
+
+static void RecordTriangle(float left, float top, float right, float bottom) {
+  auto p = pb_begin();
+  p = pb_push1(p, NV097_SET_BEGIN_END, NV097_SET_BEGIN_END_OP_TRIANGLES);
+  p = pb_push4f(p, NV097_SET_VERTEX4F, left, bottom, 0.0f, 1.0f);
+  p = pb_push4f(p, NV097_SET_VERTEX4F, (left + right) * 0.5f, top, 0.0f, 1.0f);
+  p = pb_push4f(p, NV097_SET_VERTEX4F, right, bottom, 0.0f, 1.0f);
+  p = pb_push1(p, NV097_SET_BEGIN_END, NV097_SET_BEGIN_END_OP_END);
+  pb_end(p);
+}
+
+static void RecordTests(ShadowRegisterFile &shadow) {
+  static constexpr uint32_t kWidth = 640;
+  static constexpr uint32_t kHeight = 480;
+
+  // Stand-in for texture memory. The whole block is captured before the first draw and only the modified block
+  // before the second.
+  static uint8_t texture_memory[64 * 1024];
+  PushBufferRecorder::TrackMemory(kTraceMemoryTexture, texture_memory, sizeof(texture_memory));
+
+  for (uint32_t i = 0; i < 2; ++i) {
+    texture_memory[8192 + i] = 0xFF;
+
+    pb_reset();
+    PushBufferRecorder::MarkPrepareDraw();
+
+    auto p = pb_begin();
+    p = shadow.Push1(p, NV097_SET_SURFACE_CLIP_HORIZONTAL, kWidth << 16);
+    p = shadow.Push1(p, NV097_SET_SURFACE_CLIP_VERTICAL, kHeight << 16);
+    p = shadow.Push1f(p, NV097_SET_CLIP_MIN, 0.0f);
+    p = shadow.Push1f(p, NV097_SET_CLIP_MAX, static_cast<float>(0x00FFFFFF));
+    pb_end(p);
+
+    RecordTriangle(100.0f + i * 50.0f, 100.0f, 300.0f + i * 50.0f, 300.0f);
+
+    char name[32];
+    snprintf(name, sizeof(name), "Triangle%u", i);
+    PushBufferRecorder::MarkFinishDraw("host", name);
+  }
+}
+
+int main(int argc, const char *argv[]) {
+  const char *output_path = argc > 1 ? argv[1] : "pushbuffer.trace";
+  if (!PushBufferRecorder::Open(output_path)) {
+    return 1;
+  }
+
+  ShadowRegisterFile shadow;
+  shadow.SetEnabled();
+  RecordTests(shadow);
+
+  PushBufferRecorder::Close();
+  printf("Wrote %s (%u redundant pushes dropped)\n", output_path, shadow.GetDroppedPushCount());
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include "trace_reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+MappedPushBufferTrace::~MappedPushBufferTrace() { Close(); }
+
+bool MappedPushBufferTrace::Open(const char *path) {
+  Close();
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Failed to open '%s': %s\n", path, strerror(errno));
+    return false;
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) || static_cast<size_t>(st.st_size) < sizeof(PushBufferTraceFileHeader)) {
+    fprintf(stderr, "'%s' is not a push buffer trace\n", path);
+    close(fd);
+    return false;
+  }
+
+  void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    fprintf(stderr, "Failed to map '%s': %s\n", path, strerror(errno));
+    return false;
+  }
+  madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+
+  data_ = static_cast<const uint8_t *>(mapping);
+  size_ = st.st_size;
+
+  PushBufferTraceFileHeader header;
+  memcpy(&header, data_, sizeof(header));
+  if (memcmp(header.magic, kTraceMagic, sizeof(header.magic)) != 0 || header.header_size < sizeof(header) ||
+      header.header_size > size_) {
+    fprintf(stderr, "'%s' is not a push buffer trace\n", path);
+    Close();
+    return false;
+  }
+  if (header.version != kTraceVersion) {
+    fprintf(stderr, "Warning: '%s' has unsupported version %u, expected %u\n", path, header.version, kTraceVersion);
+  }
+
+  first_record_ = header.header_size;
+  return true;
+}
+
+void MappedPushBufferTrace::Close() {
+  if (data_) {
+    munmap(const_cast<uint8_t *>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  first_record_ = 0;
+}
+
+bool MappedPushBufferTrace::NextRecord(size_t &cursor, Record &record) const {
+  if (!cursor) {
+    cursor = first_record_;
+  }
+
+  if (size_ - cursor < sizeof(PushBufferTraceRecordHeader)) {
+    return false;
+  }
+
+  PushBufferTraceRecordHeader header;
+  memcpy(&header, data_ + cursor, sizeof(header));
+
+  size_t payload_offset = cursor + sizeof(header);
+  if (size_ - payload_offset < header.size) {
+    fprintf(stderr, "Trace is truncated at offset %zu\n", cursor);
+    return false;
+  }
+
+  record.type = static_cast<PushBufferTraceRecordType>(header.type);
+  record.offset = cursor;
+  record.payload = data_ + payload_offset;
+  record.size = header.size;
+
+  cursor = payload_offset + header.size;
+  return true;
+}
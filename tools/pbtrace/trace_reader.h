@@ -0,0 +1,47 @@
+#ifndef NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_TRACE_READER_H
+#define NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_TRACE_READER_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pushbuffer_trace.h"
+
+// Read only, memory mapped view of a push buffer trace (see pushbuffer_trace.h). Pages are faulted in on demand, so
+// traces far larger than available memory can be processed in a single sequential pass.
+class MappedPushBufferTrace {
+ public:
+  struct Record {
+    PushBufferTraceRecordType type;
+    // Offset of the record header from the start of the file.
+    size_t offset;
+    // Payload of the record. Note that the payload is not necessarily aligned.
+    const uint8_t *payload;
+    uint32_t size;
+  };
+
+ public:
+  MappedPushBufferTrace() = default;
+  ~MappedPushBufferTrace();
+
+  // Maps the given file, returning false if it cannot be mapped or is not a push buffer trace.
+  bool Open(const char *path);
+  void Close();
+
+  // Advances `cursor` (initially 0) to the next record. Returns false at the end of the trace or if the trace is
+  // truncated.
+  bool NextRecord(size_t &cursor, Record &record) const;
+
+  size_t GetSize() const { return size_; }
+
+ private:
+  const uint8_t *data_{nullptr};
+  size_t size_{0};
+  size_t first_record_{0};
+};
+
+// Reads the unaligned little endian DWORD at `data`.
+inline uint32_t ReadTraceDWORD(const uint8_t *data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+#endif  // NXDK_PGRAPH_TESTS_TOOLS_PBTRACE_TRACE_READER_H
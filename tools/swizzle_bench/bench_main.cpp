@@ -0,0 +1,129 @@
+// Verifies that SwizzleBox/UnswizzleBox match third_party/swizzle.c and reports the throughput of both. SwizzleSlice is
+// checked against SwizzleBox.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "swizzle.h"
+#include "texture_swizzle.h"
+
+struct Case {
+  uint32_t width;
+  uint32_t height;
+  uint32_t depth;
+  uint32_t bytes_per_pixel;
+};
+
+static constexpr Case kCases[] = {
+    {64, 64, 1, 1},     {256, 256, 1, 1}, {256, 256, 1, 2}, {256, 256, 1, 4}, {1024, 1024, 1, 4},
+    {512, 128, 1, 4},   {32, 32, 32, 2},  {128, 128, 16, 4}, {64, 64, 64, 4},  {256, 256, 1, 3},
+    {100, 60, 1, 4},    {17, 9, 5, 2},
+};
+
+template <typename Function>
+static double TimeMillisecondsPerCall(Function &&function) {
+  // Repeat until enough time has passed to give a stable measurement.
+  uint32_t iterations = 0;
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::milli> elapsed{};
+  do {
+    function();
+    ++iterations;
+    elapsed = std::chrono::steady_clock::now() - start;
+  } while (elapsed.count() < 200.0);
+  return elapsed.count() / iterations;
+}
+
+int main() {
+  printf("%-16s %4s %12s %12s %8s %12s %12s %8s\n", "size", "bpp", "swizzle_ref", "swizzle_new", "speedup",
+         "unswz_ref", "unswz_new", "speedup");
+
+  int failures = 0;
+  for (auto &test : kCases) {
+    const uint32_t row_pitch = test.width * test.bytes_per_pixel;
+    const uint32_t slice_pitch = row_pitch * test.height;
+    const uint32_t size = slice_pitch * test.depth;
+
+    // The swizzled image of a non power of two texture spans the next power of two in each dimension.
+    uint32_t swizzled_size = test.bytes_per_pixel;
+    for (uint32_t dimension : {test.width, test.height, test.depth}) {
+      uint32_t rounded = 1;
+      while (rounded < dimension) {
+        rounded <<= 1;
+      }
+      swizzled_size *= rounded;
+    }
+
+    std::vector<uint8_t> linear(size);
+    for (uint32_t i = 0; i < size; ++i) {
+      linear[i] = static_cast<uint8_t>(i * 2654435761u >> 13);
+    }
+
+    std::vector<uint8_t> expected(swizzled_size);
+    std::vector<uint8_t> actual(swizzled_size);
+    swizzle_box(linear.data(), test.width, test.height, test.depth, expected.data(), row_pitch, slice_pitch,
+                test.bytes_per_pixel);
+    SwizzleBox(linear.data(), test.width, test.height, test.depth, actual.data(), row_pitch, slice_pitch,
+               test.bytes_per_pixel);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%ux%ux%u", test.width, test.height, test.depth);
+    if (expected != actual) {
+      printf("%-16s %4u MISMATCH (swizzle)\n", name, test.bytes_per_pixel);
+      ++failures;
+      continue;
+    }
+
+    std::vector<uint8_t> sliced(swizzled_size);
+    for (uint32_t z = 0; z < test.depth; ++z) {
+      SwizzleSlice(linear.data() + z * slice_pitch, test.width, test.height, test.depth, z, sliced.data(), row_pitch,
+                   test.bytes_per_pixel);
+    }
+    if (expected != sliced) {
+      printf("%-16s %4u MISMATCH (slice)\n", name, test.bytes_per_pixel);
+      ++failures;
+      continue;
+    }
+
+    std::vector<uint8_t> expected_linear(size);
+    std::vector<uint8_t> actual_linear(size);
+    unswizzle_box(expected.data(), test.width, test.height, test.depth, expected_linear.data(), row_pitch,
+                  slice_pitch, test.bytes_per_pixel);
+    UnswizzleBox(expected.data(), test.width, test.height, test.depth, actual_linear.data(), row_pitch, slice_pitch,
+                 test.bytes_per_pixel);
+    if (expected_linear != actual_linear || actual_linear != linear) {
+      printf("%-16s %4u MISMATCH (unswizzle)\n", name, test.bytes_per_pixel);
+      ++failures;
+      continue;
+    }
+
+    const double swizzle_ref = TimeMillisecondsPerCall([&]() {
+      swizzle_box(linear.data(), test.width, test.height, test.depth, expected.data(), row_pitch, slice_pitch,
+                  test.bytes_per_pixel);
+    });
+    const double swizzle_new = TimeMillisecondsPerCall([&]() {
+      SwizzleBox(linear.data(), test.width, test.height, test.depth, actual.data(), row_pitch, slice_pitch,
+                 test.bytes_per_pixel);
+    });
+    const double unswizzle_ref = TimeMillisecondsPerCall([&]() {
+      unswizzle_box(expected.data(), test.width, test.height, test.depth, expected_linear.data(), row_pitch,
+                    slice_pitch, test.bytes_per_pixel);
+    });
+    const double unswizzle_new = TimeMillisecondsPerCall([&]() {
+      UnswizzleBox(expected.data(), test.width, test.height, test.depth, actual_linear.data(), row_pitch,
+                   slice_pitch, test.bytes_per_pixel);
+    });
+
+    printf("%-16s %4u %10.3fms %10.3fms %7.1fx %10.3fms %10.3fms %7.1fx\n", name, test.bytes_per_pixel, swizzle_ref,
+           swizzle_new, swizzle_ref / swizzle_new, unswizzle_ref, unswizzle_new, unswizzle_ref / unswizzle_new);
+  }
+
+  if (failures) {
+    printf("%d case(s) did not match the reference implementation\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,311 @@
+// Checks the kernels in texture_conversion.cpp against the per-texel conversions that they replaced for every 24-bit
+// color, and reports the throughput of both.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "texture_conversion.h"
+
+// The conversions previously performed per texel by TextureStage.
+static uint8_t ReferenceLuminance(uint8_t red, uint8_t green, uint8_t blue) {
+  return static_cast<uint8_t>(0.299f * red + 0.587f * green + 0.114f * blue);
+}
+
+static void ReferenceYUVPair(uint8_t R0, uint8_t G0, uint8_t B0, uint8_t R1, uint8_t G1, uint8_t B1, bool is_yuy2,
+                             uint8_t *dest) {
+  const uint8_t Y0 = (0.257f * R0) + (0.504f * G0) + (0.098f * B0) + 16;
+  const uint8_t U = -(0.148f * R1) - (0.291f * G1) + (0.439f * B1) + 128;
+  const uint8_t Y1 = (0.257f * R1) + (0.504f * G1) + (0.098f * B1) + 16;
+  const uint8_t V = (0.439f * R1) - (0.368f * G1) - (0.071f * B1) + 128;
+  if (is_yuy2) {
+    dest[0] = Y0;
+    dest[1] = U;
+    dest[2] = Y1;
+    dest[3] = V;
+  } else {
+    dest[0] = U;
+    dest[1] = Y0;
+    dest[2] = V;
+    dest[3] = Y1;
+  }
+}
+
+// Copy of float_to_z16 in src/pbkit_ext.cpp.
+static uint16_t ReferenceFloatToZ16(float val) {
+  if (val == 0.0f) {
+    return 0;
+  }
+
+  auto int_val = reinterpret_cast<uint32_t *>(&val);
+  return (*int_val >> 11) - 0x3F8000;
+}
+
+struct Channels {
+  uint8_t red;
+  uint8_t green;
+  uint8_t blue;
+  uint8_t alpha;
+};
+
+static Channels Unpack(uint32_t texel, const TexelChannelLayout &layout) {
+  return {static_cast<uint8_t>(texel >> layout.red_shift), static_cast<uint8_t>(texel >> layout.green_shift),
+          static_cast<uint8_t>(texel >> layout.blue_shift),
+          static_cast<uint8_t>(layout.has_alpha ? texel >> layout.alpha_shift : 0xFF)};
+}
+
+using Converter = std::function<void(const uint32_t *, uint32_t, const TexelChannelLayout &, uint8_t *)>;
+
+struct Format {
+  const char *name;
+  uint32_t bytes_per_texel;
+  Converter reference;
+  Converter kernel;
+};
+
+static void ReferenceYUV(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest,
+                         bool is_yuy2) {
+  for (uint32_t i = 0; i + 1 < count; i += 2, dest += 4) {
+    auto first = Unpack(texels[i], layout);
+    auto second = Unpack(texels[i + 1], layout);
+    ReferenceYUVPair(first.red, first.green, first.blue, second.red, second.green, second.blue, is_yuy2, dest);
+  }
+}
+
+// Formats that TextureStage previously converted per texel via SDL_MapRGBA.
+static constexpr PackedTexelFormat kA8R8G8B8{0, 16, 0, 8, 0, 0, 0, 24, 4};
+static constexpr PackedTexelFormat kR5G6B5{3, 11, 2, 5, 3, 0, 8, 0, 2};
+static constexpr PackedTexelFormat kA1R5G5B5{3, 10, 3, 5, 3, 0, 7, 15, 2};
+static constexpr PackedTexelFormat kA4R4G4B4{4, 8, 4, 4, 4, 0, 4, 12, 2};
+static constexpr PackedTexelFormat kR6G5B5{2, 10, 3, 5, 3, 0, 8, 0, 2};
+static constexpr PackedTexelFormat kA8{8, 0, 8, 0, 8, 0, 0, 0, 1};
+
+static void ReferencePacked(const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout,
+                            const PackedTexelFormat &format, uint8_t *dest) {
+  // SDL_MapRGBA drops channels that are not present in the format by masking them.
+  const uint32_t alpha_mask = format.alpha_loss == 8 ? 0 : (0xFF >> format.alpha_loss) << format.alpha_shift;
+  for (uint32_t i = 0; i < count; ++i, dest += format.bytes_per_texel) {
+    auto c = Unpack(texels[i], layout);
+    const uint32_t pixel = ((c.red >> format.red_loss) << format.red_shift) |
+                           ((c.green >> format.green_loss) << format.green_shift) |
+                           ((c.blue >> format.blue_loss) << format.blue_shift) |
+                           (((c.alpha >> format.alpha_loss) << format.alpha_shift) & alpha_mask);
+    memcpy(dest, &pixel, format.bytes_per_texel);
+  }
+}
+
+static Format MakePackedFormat(const char *name, const PackedTexelFormat &format) {
+  return {name, format.bytes_per_texel,
+          [&format](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+            ReferencePacked(texels, count, layout, format, dest);
+          },
+          [&format](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+            ConvertTexelsToPacked(texels, count, layout, format, dest);
+          }};
+}
+
+static const Format kFormats[] = {
+    MakePackedFormat("A8R8G8B8", kA8R8G8B8),
+    MakePackedFormat("R5G6B5", kR5G6B5),
+    MakePackedFormat("A1R5G5B5", kA1R5G5B5),
+    MakePackedFormat("A4R4G4B4", kA4R4G4B4),
+    MakePackedFormat("R6G5B5", kR6G5B5),
+    MakePackedFormat("A8", kA8),
+    {"Y8", 1,
+     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+       for (uint32_t i = 0; i < count; ++i) {
+         auto c = Unpack(texels[i], layout);
+         dest[i] = ReferenceLuminance(c.red, c.green, c.blue);
+       }
+     },
+     ConvertTexelsToY8},
+    {"A8Y8", 2,
+     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+       for (uint32_t i = 0; i < count; ++i) {
+         auto c = Unpack(texels[i], layout);
+         dest[i * 2] = ReferenceLuminance(c.red, c.green, c.blue);
+         dest[i * 2 + 1] = c.alpha;
+       }
+     },
+     ConvertTexelsToA8Y8},
+    {"Y16", 2,
+     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+       for (uint32_t i = 0; i < count; ++i) {
+         auto c = Unpack(texels[i], layout);
+         uint32_t y_value = ReferenceLuminance(c.red, c.green, c.blue);
+         y_value = static_cast<uint32_t>(static_cast<float>(y_value) / 255.0f * 65535.0f);
+         dest[i * 2] = y_value & 0xFF;
+         dest[i * 2 + 1] = (y_value >> 8) & 0xFF;
+       }
+     },
+     ConvertTexelsToY16},
+    {"Y16F", 2,
+     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+       for (uint32_t i = 0; i < count; ++i) {
+         auto c = Unpack(texels[i], layout);
+         const float depth = static_cast<float>(ReferenceLuminance(c.red, c.green, c.blue)) * (kZ16FloatMax / 255.0f);
+         const uint16_t z16 = ReferenceFloatToZ16(depth);
+         memcpy(dest + i * 2, &z16, sizeof(z16));
+       }
+     },
+     ConvertTexelsToY16Float},
+    {"G8B8", 2,
+     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+       for (uint32_t i = 0; i < count; ++i) {
+         auto c = Unpack(texels[i], layout);
+         dest[i * 2] = c.blue;
+         dest[i * 2 + 1] = c.green;
+       }
+     },
+     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+       ConvertTexelsToChannelPair(texels, count, layout.blue_shift, layout.green_shift, dest);
+     }},
+    {"R8B8", 2,
+     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+       for (uint32_t i = 0; i < count; ++i) {
+         auto c = Unpack(texels[i], layout);
+         dest[i * 2] = c.blue;
+         dest[i * 2 + 1] = c.red;
+       }
+     },
+     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+       ConvertTexelsToChannelPair(texels, count, layout.blue_shift, layout.red_shift, dest);
+     }},
+    {"YUY2", 2,
+     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+       ReferenceYUV(texels, count, layout, dest, true);
+     },
+     ConvertTexelsToYUY2},
+    {"UYVY", 2,
+     [](const uint32_t *texels, uint32_t count, const TexelChannelLayout &layout, uint8_t *dest) {
+       ReferenceYUV(texels, count, layout, dest, false);
+     },
+     ConvertTexelsToUYVY},
+};
+
+struct Layout {
+  const char *name;
+  TexelChannelLayout layout;
+};
+
+static constexpr Layout kLayouts[] = {
+    {"ABGR8888", kPackedTexelLayout},
+    {"RGBA8888", {24, 16, 8, 0, true}},
+    {"XRGB8888", {16, 8, 0, 24, false}},
+};
+
+template <typename Function>
+static double TimeMillisecondsPerCall(Function &&function) {
+  // Repeat until enough time has passed to give a stable measurement.
+  uint32_t iterations = 0;
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::milli> elapsed{};
+  do {
+    function();
+    ++iterations;
+    elapsed = std::chrono::steady_clock::now() - start;
+  } while (elapsed.count() < 200.0);
+  return elapsed.count() / iterations;
+}
+
+int main() {
+  printf("Kernel implementation: %s\n", GetTexelConversionImplementation());
+
+  // Every 24-bit color, with a varying alpha.
+  static constexpr uint32_t kNumColors = 1 << 24;
+  std::vector<uint32_t> colors(kNumColors);
+  std::vector<uint8_t> expected(kNumColors * 4);
+  std::vector<uint8_t> actual(kNumColors * 4);
+
+  // The throughput is measured on a 256x256 texture, which fits in the cache of the host.
+  static constexpr uint32_t kTimedTexels = 256 * 256;
+
+  printf("%-10s %-8s %12s %12s %8s %14s\n", "layout", "format", "reference", "kernel", "speedup", "kernel Mtex/s");
+
+  int failures = 0;
+  for (auto &layout : kLayouts) {
+    for (uint32_t i = 0; i < kNumColors; ++i) {
+      const uint8_t red = i >> 16;
+      const uint8_t green = i >> 8;
+      const uint8_t blue = i;
+      const uint8_t alpha = (i * 2654435761u) >> 24;
+      // Layouts without alpha still fill the unused bits to check that they are ignored.
+      colors[i] = (red << layout.layout.red_shift) | (green << layout.layout.green_shift) |
+                  (blue << layout.layout.blue_shift) | (alpha << layout.layout.alpha_shift);
+    }
+
+    for (auto &format : kFormats) {
+      // The chroma of a YUV pair comes from its second texel, so the colors are also converted with an offset of one
+      // to cover every color in both positions. Odd counts exercise the scalar tails of the vector kernels.
+      bool matched = true;
+      for (uint32_t offset = 0; offset < 2 && matched; ++offset) {
+        const uint32_t count = kNumColors - 2 - offset * 2 + (format.bytes_per_texel == 1 ? 1 : 0);
+        const uint32_t size = count * format.bytes_per_texel;
+        memset(expected.data(), 0, size);
+        memset(actual.data(), 0xCC, size);
+        format.reference(colors.data() + offset, count, layout.layout, expected.data());
+        format.kernel(colors.data() + offset, count, layout.layout, actual.data());
+        matched = !memcmp(expected.data(), actual.data(), size);
+      }
+
+      if (!matched) {
+        printf("%-10s %-8s MISMATCH\n", layout.name, format.name);
+        ++failures;
+        continue;
+      }
+
+      const uint32_t *timed_texels = colors.data() + (kNumColors / 2);
+      const double reference = TimeMillisecondsPerCall(
+          [&]() { format.reference(timed_texels, kTimedTexels, layout.layout, expected.data()); });
+      const double kernel =
+          TimeMillisecondsPerCall([&]() { format.kernel(timed_texels, kTimedTexels, layout.layout, actual.data()); });
+
+      printf("%-10s %-8s %10.3fms %10.3fms %7.1fx %14.1f\n", layout.name, format.name, reference, kernel,
+             reference / kernel, kTimedTexels / kernel / 1000.0);
+    }
+  }
+
+  // ConvertFloatsToZ16 is checked against float_to_z16 for 2^24 bit patterns covering every sign and exponent,
+  // including zeros, denormals, infinities and NaNs.
+  std::vector<float> values(kNumColors);
+  for (uint32_t i = 0; i < kNumColors; ++i) {
+    const uint32_t bits = (i << 8) | ((i * 2654435761u) >> 24);
+    memcpy(&values[i], &bits, sizeof(bits));
+  }
+  values[0] = 0.0f;
+  values[1] = -0.0f;
+  values[2] = kZ16FloatMax;
+
+  const uint32_t float_count = kNumColors - 1;
+  for (uint32_t i = 0; i < float_count; ++i) {
+    const uint16_t z16 = ReferenceFloatToZ16(values[i]);
+    memcpy(expected.data() + i * 2, &z16, sizeof(z16));
+  }
+  memset(actual.data(), 0xCC, float_count * 2);
+  ConvertFloatsToZ16(values.data(), float_count, actual.data());
+  if (memcmp(expected.data(), actual.data(), float_count * 2)) {
+    printf("%-10s %-8s MISMATCH\n", "float", "Z16F");
+    ++failures;
+  } else {
+    const float *timed_values = values.data() + (kNumColors / 2);
+    const double reference = TimeMillisecondsPerCall([&]() {
+      for (uint32_t i = 0; i < kTimedTexels; ++i) {
+        const uint16_t z16 = ReferenceFloatToZ16(timed_values[i]);
+        memcpy(expected.data() + i * 2, &z16, sizeof(z16));
+      }
+    });
+    const double kernel =
+        TimeMillisecondsPerCall([&]() { ConvertFloatsToZ16(timed_values, kTimedTexels, actual.data()); });
+    printf("%-10s %-8s %10.3fms %10.3fms %7.1fx %14.1f\n", "float", "Z16F", reference, kernel, reference / kernel,
+           kTimedTexels / kernel / 1000.0);
+  }
+
+  if (failures) {
+    printf("%d conversion(s) did not match the reference implementation\n", failures);
+    return 1;
+  }
+  return 0;
+}
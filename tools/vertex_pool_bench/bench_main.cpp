@@ -0,0 +1,129 @@
+// Replays the vertex memory traffic of a run of test suites through the pool in src/vertex_memory_pool.cpp, checks
+// that the blocks it hands out are usable and that its statistics add up, and compares the number of blocks requested
+// from the system with and without pooling.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "vertex_buffer.h"
+#include "vertex_memory_pool.h"
+
+static constexpr uint32_t kVertexSize = sizeof(Vertex);
+
+// Vertex counts of the geometry created by typical suites: quads, cubes, tessellated planes and large meshes.
+static constexpr uint32_t kVertexCounts[] = {4, 6, 36, 96, 384, 1536, 6144, 24576};
+
+static constexpr uint32_t kNumSuites = 40;
+static constexpr uint32_t kTestsPerSuite = 64;
+
+static uint32_t Hash(uint32_t value) {
+  value ^= value >> 16;
+  value *= 0x7FEB352D;
+  value ^= value >> 15;
+  value *= 0x846CA68B;
+  return value ^ (value >> 16);
+}
+
+struct Buffer {
+  uint8_t *data;
+  uint32_t size;
+};
+
+// Each suite uses geometry up to a different size. Each test recreates the geometry, as CreateGeometry does, optionally
+// with a second buffer derived from it such as a compact or linearized copy. Returns the number of failed checks.
+template <typename Allocate, typename Free>
+static int RunSuites(Allocate &&allocate, Free &&free_buffer) {
+  int failures = 0;
+  for (uint32_t suite = 0; suite < kNumSuites; ++suite) {
+    std::vector<Buffer> live;
+    for (uint32_t test = 0; test < kTestsPerSuite; ++test) {
+      for (auto &buffer : live) {
+        free_buffer(buffer.data, buffer.size);
+      }
+      live.clear();
+
+      const uint32_t hash = Hash(suite * kTestsPerSuite + test);
+      const uint32_t num_buffers = 1 + (hash & 1);
+      for (uint32_t i = 0; i < num_buffers; ++i) {
+        const uint32_t vertices = kVertexCounts[(hash >> (4 + i * 4)) % (suite % 8 + 1)];
+        const uint32_t size = vertices * (i ? 16 : kVertexSize);
+        auto data = static_cast<uint8_t *>(allocate(size));
+        if (!data || reinterpret_cast<uintptr_t>(data) % VertexMemoryPool::kMinClassSize) {
+          printf("Bad block for %u bytes\n", size);
+          return failures + 1;
+        }
+        memset(data, static_cast<int>(i + 1), size);
+        live.push_back({data, size});
+      }
+
+      // Blocks that are live at the same time must not overlap.
+      for (auto &buffer : live) {
+        for (uint32_t offset = 0; offset < buffer.size; offset += 64) {
+          if (buffer.data[offset] != (&buffer - live.data()) + 1) {
+            printf("Suite %u test %u: block overlaps another\n", suite, test);
+            ++failures;
+            break;
+          }
+        }
+      }
+    }
+    for (auto &buffer : live) {
+      free_buffer(buffer.data, buffer.size);
+    }
+  }
+  return failures;
+}
+
+int main() {
+  int failures = 0;
+
+  uint32_t direct_allocations = 0;
+  auto start = std::chrono::steady_clock::now();
+  failures += RunSuites(
+      [&](uint32_t size) {
+        ++direct_allocations;
+        const uint32_t aligned = (size + VertexMemoryPool::kMinClassSize - 1) & ~(VertexMemoryPool::kMinClassSize - 1);
+        return aligned_alloc(VertexMemoryPool::kMinClassSize, aligned);
+      },
+      [](void *block, uint32_t) { free(block); });
+  const std::chrono::duration<double, std::milli> direct_time = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  failures += RunSuites(VertexMemoryPool::Allocate, VertexMemoryPool::Free);
+  const std::chrono::duration<double, std::milli> pooled_time = std::chrono::steady_clock::now() - start;
+
+  const auto &stats = VertexMemoryPool::GetStats();
+  if (stats.used_size) {
+    printf("%u bytes still in use after every block was freed\n", stats.used_size);
+    ++failures;
+  }
+  if (stats.allocations != direct_allocations) {
+    printf("Pool counted %u allocations, expected %u\n", stats.allocations, direct_allocations);
+    ++failures;
+  }
+  if (stats.system_allocations + stats.reused_allocations != stats.allocations) {
+    printf("Reused and system allocations do not add up to %u\n", stats.allocations);
+    ++failures;
+  }
+  if (stats.cached_size > VertexMemoryPool::kMaxCachedSize) {
+    printf("%u bytes cached, limit is %u\n", stats.cached_size, VertexMemoryPool::kMaxCachedSize);
+    ++failures;
+  }
+
+  printf("%-8s %14s %10s\n", "", "system allocs", "time");
+  printf("%-8s %14u %8.3fms\n", "direct", direct_allocations, direct_time.count());
+  printf("%-8s %14u %8.3fms\n", "pooled", stats.system_allocations, pooled_time.count());
+  printf("\n%u of %u allocations reused, %u blocks returned to the system, peak %u bytes reserved, %u cached\n",
+         stats.reused_allocations, stats.allocations, stats.system_frees, stats.peak_reserved_size,
+         stats.cached_size);
+
+  if (failures) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}